@@ -0,0 +1,207 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilter.h"
+
+#include <algorithm>
+
+#include "commons/tinyformat.h"
+#include "crypto/hash.h"
+#include "crypto/siphash.h"
+
+namespace {
+
+// Writes the bits of the Golomb-Rice codes, the most significant bit first
+class CBitWriter {
+public:
+    explicit CBitWriter(vector<uint8_t> &dataIn) : data(dataIn), buffer(0), offset(0) {}
+
+    void Write(uint64_t value, int nbits) {
+        while (nbits > 0) {
+            int bits = std::min(8 - offset, nbits);
+            buffer |= ((value >> (nbits - bits)) & ((1U << bits) - 1)) << (8 - offset - bits);
+            offset += bits;
+            nbits -= bits;
+            if (offset == 8)
+                Flush();
+        }
+    }
+
+    void Flush() {
+        if (offset == 0)
+            return;
+        data.push_back(buffer);
+        buffer = 0;
+        offset = 0;
+    }
+
+private:
+    vector<uint8_t> &data;
+    uint8_t buffer;
+    int offset;  // the bits used in the buffer
+};
+
+class CBitReader {
+public:
+    CBitReader(const vector<uint8_t> &dataIn, size_t posIn) : data(dataIn), pos(posIn), offset(0) {}
+
+    bool Read(int nbits, uint64_t &value) {
+        value = 0;
+        while (nbits > 0) {
+            if (pos >= data.size())
+                return false;
+
+            int bits = std::min(8 - offset, nbits);
+            value = (value << bits) | ((data[pos] >> (8 - offset - bits)) & ((1U << bits) - 1));
+            offset += bits;
+            nbits -= bits;
+            if (offset == 8) {
+                pos++;
+                offset = 0;
+            }
+        }
+        return true;
+    }
+
+private:
+    const vector<uint8_t> &data;
+    size_t pos;
+    int offset;  // the bits read from data[pos]
+};
+
+void GolombRiceEncode(CBitWriter &writer, uint64_t value) {
+    uint64_t quotient = value >> BLOCK_FILTER_P;
+    for (; quotient > 0; quotient--)
+        writer.Write(1, 1);
+    writer.Write(0, 1);
+    writer.Write(value, BLOCK_FILTER_P);
+}
+
+bool GolombRiceDecode(CBitReader &reader, uint64_t &value) {
+    uint64_t quotient = 0;
+    uint64_t bit;
+    while (true) {
+        if (!reader.Read(1, bit))
+            return false;
+        if (bit == 0)
+            break;
+        quotient++;
+    }
+
+    uint64_t remainder;
+    if (!reader.Read(BLOCK_FILTER_P, remainder))
+        return false;
+
+    value = (quotient << BLOCK_FILTER_P) + remainder;
+    return true;
+}
+
+}  // namespace
+
+CGCSFilter::CGCSFilter(uint64_t k0In, uint64_t k1In, const GCSElementSet &elements)
+    : k0(k0In), k1(k1In), n(elements.size()), f((uint64_t)n * BLOCK_FILTER_M) {
+    CDataStream ss(SER_NETWORK, 0);
+    WriteCompactSize(ss, n);
+    encoded.assign(ss.begin(), ss.end());
+    if (n == 0)
+        return;
+
+    encoded.reserve(encoded.size() + (n * (BLOCK_FILTER_P + 2) + 7) / 8);
+    CBitWriter writer(encoded);
+    uint64_t lastValue = 0;
+    for (auto value : BuildHashedSet(elements)) {
+        GolombRiceEncode(writer, value - lastValue);
+        lastValue = value;
+    }
+    writer.Flush();
+}
+
+CGCSFilter::CGCSFilter(uint64_t k0In, uint64_t k1In, const vector<uint8_t> &encodedIn)
+    : k0(k0In), k1(k1In), n(0), f(0), encoded(encodedIn) {
+    if (encoded.empty())
+        return;
+
+    try {
+        CDataStream ss(encoded, SER_NETWORK, 0);
+        uint64_t size = ReadCompactSize(ss);
+        if (size <= std::numeric_limits<uint32_t>::max()) {
+            n = size;
+            f = (uint64_t)n * BLOCK_FILTER_M;
+        }
+    } catch (const std::ios_base::failure &) {
+        // leaves the filter empty
+    }
+}
+
+uint64_t CGCSFilter::HashToRange(const GCSElement &element) const {
+    uint64_t hash = CSipHasher(k0, k1).Write(element.data(), element.size()).Finalize();
+    // map the hash to [0, f) uniformly without a division
+    return (uint64_t)(((unsigned __int128)hash * f) >> 64);
+}
+
+vector<uint64_t> CGCSFilter::BuildHashedSet(const GCSElementSet &elements) const {
+    vector<uint64_t> hashes;
+    hashes.reserve(elements.size());
+    for (const auto &element : elements)
+        hashes.push_back(HashToRange(element));
+
+    std::sort(hashes.begin(), hashes.end());
+    return hashes;
+}
+
+bool CGCSFilter::MatchInternal(const vector<uint64_t> &queries) const {
+    CDataStream ss(SER_NETWORK, 0);
+    WriteCompactSize(ss, n);
+    CBitReader reader(encoded, ss.size());
+
+    uint64_t value = 0;
+    auto it = queries.begin();
+    for (uint32_t i = 0; i < n && it != queries.end(); i++) {
+        uint64_t delta;
+        if (!GolombRiceDecode(reader, delta))
+            return false;
+
+        value += delta;
+        while (it != queries.end() && *it < value)
+            ++it;
+        if (it != queries.end() && *it == value)
+            return true;
+    }
+    return false;
+}
+
+bool CGCSFilter::Match(const GCSElement &element) const {
+    if (n == 0)
+        return false;
+
+    return MatchInternal({HashToRange(element)});
+}
+
+bool CGCSFilter::MatchAny(const GCSElementSet &elements) const {
+    if (n == 0 || elements.empty())
+        return false;
+
+    return MatchInternal(BuildHashedSet(elements));
+}
+
+CBlockFilter::CBlockFilter(const uint256 &blockHash, const GCSElementSet &elements)
+    : block_hash(blockHash), filter(GetKey0(blockHash), GetKey1(blockHash), elements) {}
+
+CBlockFilter::CBlockFilter(const uint256 &blockHash, const vector<uint8_t> &encoded)
+    : block_hash(blockHash), filter(GetKey0(blockHash), GetKey1(blockHash), encoded) {}
+
+uint256 CBlockFilter::GetHash() const {
+    const vector<uint8_t> &encoded = filter.GetEncoded();
+    return Hash(encoded.begin(), encoded.end());
+}
+
+uint256 CBlockFilter::ComputeHeader(const uint256 &prevHeader) const {
+    uint256 filterHash = GetHash();
+    return Hash(filterHash.begin(), filterHash.end(), prevHeader.begin(), prevHeader.end());
+}
+
+string CBlockFilter::ToString() const {
+    return strprintf("block_hash=%s, n=%u, size=%u", block_hash.ToString(), filter.GetN(),
+                     filter.GetEncoded().size());
+}
@@ -0,0 +1,103 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CHAIN_BLOCKFILTER_H
+#define CHAIN_BLOCKFILTER_H
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include "commons/serialize.h"
+#include "commons/uint256.h"
+
+using namespace std;
+
+/** The Golomb-Rice coding parameter of the block filters */
+static const uint8_t BLOCK_FILTER_P = 19;
+/** The inverse false positive rate of the block filters, per queried element */
+static const uint32_t BLOCK_FILTER_M = 784931;
+
+typedef vector<uint8_t> GCSElement;
+typedef set<GCSElement> GCSElementSet;
+
+/**
+ * Golomb-coded set, a compact probabilistic set of elements.
+ *
+ * The elements are hashed with SipHash into [0, N * M), sorted, and the deltas between
+ * the hashes are Golomb-Rice coded with P bits of remainder, ~P + 2 bits per element.
+ * A queried element which is not in the set matches with a probability of 1/M.
+ * The encoded data starts with N as a compact size.
+ */
+class CGCSFilter {
+public:
+    CGCSFilter() : k0(0), k1(0), n(0), f(0) {}
+    CGCSFilter(uint64_t k0In, uint64_t k1In, const GCSElementSet &elements);
+    // the encoded data comes from the disk or the network, a bad one never matches
+    CGCSFilter(uint64_t k0In, uint64_t k1In, const vector<uint8_t> &encodedIn);
+
+    uint32_t GetN() const { return n; }
+    const vector<uint8_t> &GetEncoded() const { return encoded; }
+
+    bool Match(const GCSElement &element) const;
+    bool MatchAny(const GCSElementSet &elements) const;
+
+private:
+    uint64_t k0;
+    uint64_t k1;
+    uint32_t n;
+    uint64_t f;  // N * M
+    vector<uint8_t> encoded;
+
+    uint64_t HashToRange(const GCSElement &element) const;
+    vector<uint64_t> BuildHashedSet(const GCSElementSet &elements) const;
+    // the query hashes must be sorted
+    bool MatchInternal(const vector<uint64_t> &queries) const;
+};
+
+/**
+ * The compact filter of a block, over the key ids, regids and nick ids of the senders and the
+ * contracts carried by its txs. The SipHash key is derived from the block hash.
+ */
+class CBlockFilter {
+public:
+    uint256 block_hash;
+    CGCSFilter filter;
+
+    CBlockFilter() {}
+    CBlockFilter(const uint256 &blockHash, const GCSElementSet &elements);
+    CBlockFilter(const uint256 &blockHash, const vector<uint8_t> &encoded);
+
+    // hash of the encoded filter
+    uint256 GetHash() const;
+    // the filter headers chain the filters of a chain: Hash(filter hash, prev filter header)
+    uint256 ComputeHeader(const uint256 &prevHeader) const;
+
+    bool IsEmpty() const { return block_hash.IsNull(); }
+    void SetEmpty() { *this = CBlockFilter(); }
+    string ToString() const;
+
+    unsigned int GetSerializeSize(int nType, int nVersion) const {
+        return ::GetSerializeSize(block_hash, nType, nVersion) +
+               ::GetSerializeSize(filter.GetEncoded(), nType, nVersion);
+    }
+
+    template <typename Stream>
+    void Serialize(Stream &s, int nType, int nVersion) const {
+        s << block_hash << filter.GetEncoded();
+    }
+
+    template <typename Stream>
+    void Unserialize(Stream &s, int nType, int nVersion) {
+        vector<uint8_t> encoded;
+        s >> block_hash >> encoded;
+        *this = CBlockFilter(block_hash, encoded);
+    }
+
+private:
+    static uint64_t GetKey0(const uint256 &blockHash) { return blockHash.GetUint64(0); }
+    static uint64_t GetKey1(const uint256 &blockHash) { return blockHash.GetUint64(1); }
+};
+
+#endif  // CHAIN_BLOCKFILTER_H
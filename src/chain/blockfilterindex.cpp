@@ -0,0 +1,206 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilterindex.h"
+
+#include "main.h"
+#include "persistence/blockfilterdb.h"
+#include "tx/cointransfertx.h"
+#include "tx/coinutxotx.h"
+#include "tx/contracttx.h"
+#include "tx/delegatetx.h"
+#include "tx/mulsigtx.h"
+#include "tx/wasmcontracttx.h"
+
+CBlockFilterIndex *pBlockFilterIndex = nullptr;
+
+// Only the ids carried by the block are taken, the state of the tip is not the one the block was
+// connected on. A query resolves the address to both its key id and its regid.
+static void AddUserIdElement(const CUserID &uid, GCSElementSet &elements) {
+    if (uid.is<CRegID>()) {
+        elements.insert(uid.get<CRegID>().GetRegIdRaw());
+    } else if (uid.is<CPubKey>() || uid.is<CKeyID>()) {
+        CKeyID keyId = uid.is<CPubKey>() ? uid.get<CPubKey>().GetKeyId() : uid.get<CKeyID>();
+        elements.insert(GCSElement(keyId.begin(), keyId.end()));
+    } else if (uid.is<CNickID>()) {
+        CDataStream ds(SER_DISK, CLIENT_VERSION);
+        ds << uid.get<CNickID>();
+        elements.insert(GCSElement(ds.begin(), ds.end()));
+    }
+}
+
+void GetBlockFilterElements(const CBlock &block, GCSElementSet &elements) {
+    for (const auto &pBaseTx : block.vptx) {
+        if (pBaseTx->nTxType == UCOIN_TRANSFER_MTX) {
+            for (const auto &signaturePair : ((CMulsigTx *)pBaseTx.get())->signaturePairs)
+                AddUserIdElement(CUserID(signaturePair.regid), elements);
+        } else {
+            AddUserIdElement(pBaseTx->txUid, elements);
+        }
+
+        // the receivers, as the tx carries them
+        switch (pBaseTx->nTxType) {
+            case BCOIN_TRANSFER_TX:
+                AddUserIdElement(((CBaseCoinTransferTx *)pBaseTx.get())->toUid, elements);
+                break;
+            case UCOIN_TRANSFER_TX:
+                for (const auto &transfer : ((CCoinTransferTx *)pBaseTx.get())->transfers)
+                    AddUserIdElement(transfer.to_uid, elements);
+                break;
+            case UCOIN_TRANSFER_MTX:
+                for (const auto &transfer : ((CMulsigTx *)pBaseTx.get())->transfers)
+                    AddUserIdElement(transfer.to_uid, elements);
+                break;
+            case UTXO_TRANSFER_TX:
+                for (const auto &vout : ((CCoinUtxoTx *)pBaseTx.get())->vouts) {
+                    for (const auto &cond : vout.conds) {
+                        if (cond.IsEmpty())
+                            continue;
+                        if (cond.utxoCondPtr->cond_type == UtxoCondType::OP2SA)
+                            AddUserIdElement(((CSingleAddressCondOut *)cond.utxoCondPtr.get())->uid, elements);
+                        else if (cond.utxoCondPtr->cond_type == UtxoCondType::OP2MA)
+                            AddUserIdElement(((CMultiSignAddressCondOut *)cond.utxoCondPtr.get())->uid, elements);
+                    }
+                }
+                break;
+            case DELEGATE_VOTE_TX:
+                for (const auto &vote : ((CDelegateVoteTx *)pBaseTx.get())->candidateVotes)
+                    AddUserIdElement(vote.GetCandidateUid(), elements);
+                break;
+            case LCONTRACT_INVOKE_TX:
+                AddUserIdElement(((CLuaContractInvokeTx *)pBaseTx.get())->app_uid, elements);
+                break;
+            case UCONTRACT_INVOKE_TX:
+                AddUserIdElement(((CUniversalContractInvokeTx *)pBaseTx.get())->app_uid, elements);
+                break;
+            case WASM_CONTRACT_TX:
+                for (const auto &trx : ((CWasmContractTx *)pBaseTx.get())->inline_transactions)
+                    AddUserIdElement(CUserID(CNickID(trx.contract)), elements);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+CBlockFilterIndex::CBlockFilterIndex(bool fReIndex) : pBestIndex(nullptr), unflushedCount(0) {
+    pDbAccess = new CDBAccess(GetDataDir() / "blocks", DBNameType::BLOCKFILTER, false, fReIndex);
+    pDbCache  = new CBlockFilterDBCache(pDbAccess);
+}
+
+CBlockFilterIndex::~CBlockFilterIndex() {
+    Flush();
+    delete pDbCache;    pDbCache = nullptr;
+    delete pDbAccess;   pDbAccess = nullptr;
+}
+
+bool CBlockFilterIndex::Init() {
+    LOCK2(cs_main, cs_filterindex);
+
+    uint256 tipHash;
+    if (!pDbCache->GetTip(tipHash))
+        return true;
+
+    auto it = mapBlockIndex.find(tipHash);
+    if (it == mapBlockIndex.end() || !pDbCache->GetFilterHeader(tipHash, bestHeader)) {
+        LogPrint(BCLog::INFO, "CBlockFilterIndex::Init, unknown index tip %s, rebuild the index\n", tipHash.GetHex());
+        bestHeader = uint256();
+        return true;
+    }
+
+    pBestIndex = it->second;
+    LogPrint(BCLog::INFO, "CBlockFilterIndex::Init, index tip height=%d, hash=%s\n", pBestIndex->height,
+             tipHash.GetHex());
+    return true;
+}
+
+bool CBlockFilterIndex::SyncNextBlocks(uint32_t maxCount) {
+    uint32_t count = 0;
+    for (; count < maxCount; count++) {
+        boost::this_thread::interruption_point();
+        LOCK2(cs_main, cs_filterindex);
+
+        // rewind to the fork point after a reorg
+        while (pBestIndex && !chainActive.Contains(pBestIndex)) {
+            pBestIndex = pBestIndex->pprev;
+            if (pBestIndex && !pDbCache->GetFilterHeader(pBestIndex->GetBlockHash(), bestHeader))
+                pBestIndex = nullptr;
+        }
+        if (!pBestIndex)
+            bestHeader = uint256();
+
+        const CBlockIndex *pIndex = pBestIndex ? chainActive.Next(pBestIndex) : chainActive.Genesis();
+        if (!pIndex) {
+            // caught up with the tip
+            if (unflushedCount > 0) {
+                pDbCache->Flush();
+                unflushedCount = 0;
+            }
+            break;
+        }
+
+        CBlock block;
+        if (!ReadBlockFromDisk(pIndex, block))
+            return ERRORMSG("CBlockFilterIndex::SyncNextBlocks, read block %s failed",
+                            pIndex->GetBlockHash().GetHex());
+
+        GCSElementSet elements;
+        GetBlockFilterElements(block, elements);
+
+        CBlockFilter filter(pIndex->GetBlockHash(), elements);
+        uint256 header = filter.ComputeHeader(bestHeader);
+        pDbCache->SetBlockFilter(filter, header);
+        pDbCache->SetTip(pIndex->GetBlockHash());
+        pBestIndex = pIndex;
+        bestHeader = header;
+
+        if (++unflushedCount >= BLOCK_FILTER_FLUSH_INTERVAL) {
+            pDbCache->Flush();
+            unflushedCount = 0;
+        }
+    }
+    return count > 0;
+}
+
+void CBlockFilterIndex::Flush() {
+    LOCK(cs_filterindex);
+    pDbCache->Flush();
+    unflushedCount = 0;
+}
+
+int32_t CBlockFilterIndex::GetHeight() const {
+    LOCK(cs_filterindex);
+    return pBestIndex ? pBestIndex->height : -1;
+}
+
+bool CBlockFilterIndex::LookupFilter(const CBlockIndex *pIndex, CBlockFilter &filter, uint256 &header) const {
+    LOCK(cs_filterindex);
+    if (!pBestIndex || pIndex->height > pBestIndex->height)
+        return false;
+
+    return pDbCache->GetBlockFilter(pIndex->GetBlockHash(), filter) &&
+           pDbCache->GetFilterHeader(pIndex->GetBlockHash(), header);
+}
+
+void ThreadBlockFilterIndex() {
+    RenameThread("coin-filteridx");
+    LogPrint(BCLog::INFO, "ThreadBlockFilterIndex started, index height=%d\n", pBlockFilterIndex->GetHeight());
+
+    int64_t nStart = GetTimeMillis();
+    bool fSynced   = false;
+    while (true) {
+        if (pBlockFilterIndex->SyncNextBlocks(BLOCK_FILTER_FLUSH_INTERVAL)) {
+            fSynced = false;
+            continue;
+        }
+
+        if (!fSynced) {
+            fSynced = true;
+            LogPrint(BCLog::INFO, "ThreadBlockFilterIndex synced to height=%d (%dms)\n",
+                     pBlockFilterIndex->GetHeight(), GetTimeMillis() - nStart);
+        }
+        MilliSleep(1000);
+        nStart = GetTimeMillis();
+    }
+}
@@ -0,0 +1,62 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CHAIN_BLOCKFILTERINDEX_H
+#define CHAIN_BLOCKFILTERINDEX_H
+
+#include "blockfilter.h"
+#include "sync.h"
+
+class CBlock;
+class CBlockIndex;
+class CDBAccess;
+class CBlockFilterDBCache;
+
+/** Default for -blockfilterindex */
+static const bool DEFAULT_BLOCKFILTERINDEX = false;
+/** The max number of filters requested by one getcfilters message */
+static const uint32_t MAX_GETCFILTERS_SIZE = 1000;
+/** The number of blocks indexed between two flushes of the filter db */
+static const uint32_t BLOCK_FILTER_FLUSH_INTERVAL = 1000;
+
+/**
+ * Index of the compact filters of the blocks of the active chain.
+ *
+ * The index is built by a background thread following the tip, so it can be enabled on a
+ * synced node or catch up while the node syncs. The filters are keyed by the block hash,
+ * the filters of the blocks disconnected by a reorg stay in the db and are overwritten
+ * only if the blocks get connected again.
+ */
+class CBlockFilterIndex {
+public:
+    CBlockFilterIndex(bool fReIndex);
+    ~CBlockFilterIndex();
+
+    // load the tip of the index, requires the block index being loaded
+    bool Init();
+    // index up to maxCount blocks past the index tip, false if nothing was indexed
+    bool SyncNextBlocks(uint32_t maxCount);
+    void Flush();
+
+    // the height of the last indexed block of the active chain, -1 if none
+    int32_t GetHeight() const;
+    bool LookupFilter(const CBlockIndex *pIndex, CBlockFilter &filter, uint256 &header) const;
+
+private:
+    mutable CCriticalSection cs_filterindex;
+    CDBAccess *pDbAccess;
+    CBlockFilterDBCache *pDbCache;
+    const CBlockIndex *pBestIndex;  // the last indexed block
+    uint256 bestHeader;
+    uint32_t unflushedCount;
+};
+
+// the key ids, regids and nick ids of the senders, the receivers and the contracts carried by the txs of the block
+void GetBlockFilterElements(const CBlock &block, GCSElementSet &elements);
+
+void ThreadBlockFilterIndex();
+
+extern CBlockFilterIndex *pBlockFilterIndex;
+
+#endif  // CHAIN_BLOCKFILTERINDEX_H
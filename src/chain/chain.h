@@ -48,7 +48,7 @@ public:
     CBlockLocator GetLocator(const CBlockIndex *pIndex = nullptr) const;
 
     /** Find the last common block between this chain and a locator. */
-    CBlockIndex *FindFork(map<uint256, CBlockIndex *> &mapBlockIndex, const CBlockLocator &locator) const;
+    CBlockIndex *FindFork(const BlockMap &mapBlockIndex, const CBlockLocator &locator) const;
 
 }; //end of CChain
 
@@ -0,0 +1,485 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "eventpublisher.h"
+
+#include "commons/json/json_spirit_reader_template.h"
+#include "commons/json/json_spirit_writer_template.h"
+#include "commons/metrics.h"
+#include "main.h"
+#include "netbase.h"
+#include "persistence/txreceiptdb.h"
+#include "rpc/core/rpccommons.h"
+
+#ifndef WIN32
+#include <fcntl.h>
+#endif
+
+#if !defined(HAVE_MSG_NOSIGNAL) && !defined(MSG_NOSIGNAL)
+#define MSG_NOSIGNAL 0
+#endif
+
+CEventPublisher *pEventPublisher = nullptr;
+
+static const string kEventTopicNames[EVENT_TOPIC_COUNT] = {
+    "blockconnected", "blockdisconnected", "txaccepted", "txremoved", "receipts", "accountchanged",
+};
+
+const string &GetEventTopicName(EventTopic topic) { return kEventTopicNames[topic]; }
+
+bool ParseEventTopic(const string &name, EventTopic &topic) {
+    for (uint8_t i = 0; i < EVENT_TOPIC_COUNT; i++) {
+        if (kEventTopicNames[i] == name) {
+            topic = (EventTopic)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+string WriteEventFrame(const string &payload) {
+    string frame;
+    frame.reserve(4 + payload.size());
+    for (int32_t shift = 24; shift >= 0; shift -= 8)
+        frame.push_back((char)((payload.size() >> shift) & 0xff));
+    frame.append(payload);
+    return frame;
+}
+
+int64_t ReadEventFrame(const string &buffer, string &payload) {
+    if (buffer.size() < 4)
+        return 0;
+
+    const auto *pSize = (const unsigned char *)buffer.data();
+    uint32_t size     = (pSize[0] << 24) | (pSize[1] << 16) | (pSize[2] << 8) | pSize[3];
+    if (size > MAX_EVENT_REQUEST_SIZE)
+        return -1;
+    if (buffer.size() < 4 + size)
+        return 0;
+
+    payload = buffer.substr(4, size);
+    return 4 + size;
+}
+
+// the json of an event after its seq, the seq is counted by each subscriber
+static string GetEventBody(const string &topicName, const Value &data) {
+    Object obj;
+    obj.push_back(Pair("topic", topicName));
+    obj.push_back(Pair("data",  data));
+    return write_string(Value(obj), false).substr(1);
+}
+
+static Object GetBlockEventObj(const CBlock &block, const CBlockIndex *pIndex) {
+    Array txids;
+    for (const auto &pTx : block.vptx)
+        txids.push_back(pTx->GetHash().GetHex());
+
+    Object obj;
+    obj.push_back(Pair("hash",      pIndex->GetBlockHash().GetHex()));
+    obj.push_back(Pair("height",    pIndex->height));
+    obj.push_back(Pair("time",      (int64_t)block.GetTime()));
+    obj.push_back(Pair("prev_hash", block.GetPrevBlockHash().GetHex()));
+    obj.push_back(Pair("txids",     txids));
+    return obj;
+}
+
+CEventPublisher::CEventPublisher()
+    : droppedCounts(), fWatchAllAddresses(false), topicMask(0), hListenSocket(INVALID_SOCKET),
+      maxSendBuffer(SysCfg().GetArg("-eventsendbuffer", DEFAULT_EVENT_SEND_BUFFER) * 1000) {}
+
+CEventPublisher::~CEventPublisher() {
+    for (auto &spSubscriber : subscribers)
+        closesocket(spSubscriber->hSocket);
+
+    if (hListenSocket != INVALID_SOCKET)
+        closesocket(hListenSocket);
+}
+
+bool CEventPublisher::Bind(const CService &addrBind, string &strError) {
+    int32_t nOne = 1;
+    struct sockaddr_storage sockaddr;
+    socklen_t len = sizeof(sockaddr);
+    if (!addrBind.GetSockAddr((struct sockaddr *)&sockaddr, &len)) {
+        strError = strprintf("bind address family for %s not supported", addrBind.ToString());
+        return false;
+    }
+
+    hListenSocket = socket(((struct sockaddr *)&sockaddr)->sa_family, SOCK_STREAM, IPPROTO_TCP);
+    if (hListenSocket == INVALID_SOCKET) {
+        strError = strprintf("couldn't open socket (socket returned error %s)", NetworkErrorString(WSAGetLastError()));
+        return false;
+    }
+
+#ifdef SO_NOSIGPIPE
+    setsockopt(hListenSocket, SOL_SOCKET, SO_NOSIGPIPE, (void *)&nOne, sizeof(int32_t));
+#endif
+
+#ifdef WIN32
+    if (ioctlsocket(hListenSocket, FIONBIO, (u_long *)&nOne) == SOCKET_ERROR)
+#else
+    setsockopt(hListenSocket, SOL_SOCKET, SO_REUSEADDR, (void *)&nOne, sizeof(int32_t));
+    if (fcntl(hListenSocket, F_SETFL, O_NONBLOCK) == SOCKET_ERROR)
+#endif
+    {
+        strError = strprintf("couldn't set the socket non-blocking (error %s)", NetworkErrorString(WSAGetLastError()));
+        return false;
+    }
+
+    if (::bind(hListenSocket, (struct sockaddr *)&sockaddr, len) == SOCKET_ERROR) {
+        strError = strprintf("unable to bind to %s (bind returned error %s)", addrBind.ToString(),
+                             NetworkErrorString(WSAGetLastError()));
+        return false;
+    }
+
+    if (listen(hListenSocket, SOMAXCONN) == SOCKET_ERROR) {
+        strError = strprintf("listening failed (listen returned error %s)", NetworkErrorString(WSAGetLastError()));
+        return false;
+    }
+
+    LogPrint(BCLog::INFO, "Publishing the events on %s\n", addrBind.ToString());
+    return true;
+}
+
+void CEventPublisher::BlockConnected(const CBlock &block, const CBlockIndex *pIndex,
+                                     const CDbStateDeltaMap &stateDeltas) {
+    if (HasSubscribers(EVENT_BLOCK_CONNECTED))
+        Publish(EVENT_BLOCK_CONNECTED, GetBlockEventObj(block, pIndex));
+
+    if (HasSubscribers(EVENT_RECEIPTS)) {
+        for (const auto &pTx : block.vptx) {
+            vector<CReceipt> receipts;
+            if (!pCdMan->pReceiptCache->GetTxReceipts(pTx->GetHash(), receipts) || receipts.empty())
+                continue;
+
+            Object obj;
+            obj.push_back(Pair("txid",       pTx->GetHash().GetHex()));
+            obj.push_back(Pair("block_hash", pIndex->GetBlockHash().GetHex()));
+            obj.push_back(Pair("height",     pIndex->height));
+            obj.push_back(Pair("receipts",   JSON::ToJson(*pCdMan->pAccountCache, receipts)));
+            Publish(EVENT_RECEIPTS, obj);
+        }
+    }
+
+    if (HasSubscribers(EVENT_ACCOUNT_CHANGED)) {
+        // an account changes by its info or by its token entries
+        set<CKeyID> keyIds;
+        auto it = stateDeltas.find(dbk::KEYID_ACCOUNT_INFO);
+        if (it != stateDeltas.end()) {
+            for (const auto &item : it->second) {
+                CKeyID keyId;
+                if (dbk::ParseDbKey(item.first, dbk::KEYID_ACCOUNT_INFO, keyId))
+                    keyIds.insert(keyId);
+            }
+        }
+        it = stateDeltas.find(dbk::KEYID_ACCOUNT_TOKEN);
+        if (it != stateDeltas.end()) {
+            for (const auto &item : it->second) {
+                pair<CKeyID, TokenSymbol> tokenKey;
+                if (dbk::ParseDbKey(item.first, dbk::KEYID_ACCOUNT_TOKEN, tokenKey))
+                    keyIds.insert(tokenKey.first);
+            }
+        }
+
+        for (const auto &keyId : keyIds) {
+            string address = keyId.ToAddress();
+            if (!IsAddressWatched(address))
+                continue;
+
+            Object obj;
+            obj.push_back(Pair("address",    address));
+            obj.push_back(Pair("block_hash", pIndex->GetBlockHash().GetHex()));
+            obj.push_back(Pair("height",     pIndex->height));
+            CAccount account;
+            if (pCdMan->pAccountCache->GetAccount(keyId, account))
+                obj.push_back(Pair("account", account.ToJsonObj()));
+            Publish(EVENT_ACCOUNT_CHANGED, obj, address);
+        }
+    }
+}
+
+void CEventPublisher::BlockDisconnected(const CBlock &block, const CBlockIndex *pIndex) {
+    if (HasSubscribers(EVENT_BLOCK_DISCONNECTED))
+        Publish(EVENT_BLOCK_DISCONNECTED, GetBlockEventObj(block, pIndex));
+}
+
+void CEventPublisher::TxAccepted(const CBaseTx &tx) {
+    if (HasSubscribers(EVENT_TX_ACCEPTED))
+        Publish(EVENT_TX_ACCEPTED, tx.ToJson(*pCdMan->pAccountCache));
+}
+
+void CEventPublisher::TxRemoved(const uint256 &txid, const string &reason) {
+    if (!HasSubscribers(EVENT_TX_REMOVED))
+        return;
+
+    Object obj;
+    obj.push_back(Pair("txid",   txid.GetHex()));
+    obj.push_back(Pair("reason", reason));
+    Publish(EVENT_TX_REMOVED, obj);
+}
+
+void CEventPublisher::Publish(EventTopic topic, const Value &data, const string &address) {
+    auto spBody = make_shared<const string>(GetEventBody(GetEventTopicName(topic), data));
+
+    LOCK(cs_events);
+    if (events.size() >= MAX_EVENT_QUEUE_SIZE) {
+        droppedCounts[events.front().topic]++;
+        events.pop_front();
+        metrics::events_dropped.Inc();
+    }
+    events.push_back({topic, address, spBody});
+}
+
+bool CEventPublisher::IsAddressWatched(const string &address) const {
+    LOCK(cs_events);
+    return fWatchAllAddresses || watchedAddresses.count(address);
+}
+
+void CEventPublisher::ProcessSubscribers(int64_t timeoutMillis) {
+    struct timeval timeout;
+    timeout.tv_sec  = timeoutMillis / 1000;
+    timeout.tv_usec = (timeoutMillis % 1000) * 1000;
+
+    fd_set fdsetRecv;
+    fd_set fdsetError;
+    FD_ZERO(&fdsetRecv);
+    FD_ZERO(&fdsetError);
+    SOCKET hSocketMax = hListenSocket;
+    FD_SET(hListenSocket, &fdsetRecv);
+    for (const auto &spSubscriber : subscribers) {
+        FD_SET(spSubscriber->hSocket, &fdsetRecv);
+        FD_SET(spSubscriber->hSocket, &fdsetError);
+        hSocketMax = max(hSocketMax, spSubscriber->hSocket);
+    }
+
+    int32_t nSelect = select(hSocketMax + 1, &fdsetRecv, nullptr, &fdsetError, &timeout);
+    boost::this_thread::interruption_point();
+    if (nSelect == SOCKET_ERROR) {
+        LogPrint(BCLog::NET, "CEventPublisher::ProcessSubscribers, select failed, error %s\n",
+                 NetworkErrorString(WSAGetLastError()));
+        FD_ZERO(&fdsetRecv);
+        FD_ZERO(&fdsetError);
+    }
+
+    if (FD_ISSET(hListenSocket, &fdsetRecv))
+        AcceptSubscriber();
+
+    bool fSubscriptionsChanged = false;
+    for (auto &spSubscriber : subscribers) {
+        if (FD_ISSET(spSubscriber->hSocket, &fdsetRecv) || FD_ISSET(spSubscriber->hSocket, &fdsetError)) {
+            ReceiveRequests(*spSubscriber);
+            fSubscriptionsChanged = true;
+        }
+    }
+
+    DispatchEvents();
+
+    for (auto it = subscribers.begin(); it != subscribers.end();) {
+        CEventSubscriber &subscriber = **it;
+        if (!subscriber.fDisconnect)
+            SendEvents(subscriber);
+
+        if (subscriber.fDisconnect) {
+            LogPrint(BCLog::NET, "CEventPublisher::ProcessSubscribers, disconnect the subscriber %s\n",
+                     subscriber.addrName);
+            closesocket(subscriber.hSocket);
+            it = subscribers.erase(it);
+            fSubscriptionsChanged = true;
+            continue;
+        }
+        ++it;
+    }
+
+    if (fSubscriptionsChanged)
+        UpdateSubscriptions();
+}
+
+void CEventPublisher::AcceptSubscriber() {
+    struct sockaddr_storage sockaddr;
+    socklen_t len  = sizeof(sockaddr);
+    SOCKET hSocket = accept(hListenSocket, (struct sockaddr *)&sockaddr, &len);
+    if (hSocket == INVALID_SOCKET)
+        return;
+
+    CService addr;
+    addr.SetSockAddr((const struct sockaddr *)&sockaddr);
+    if (subscribers.size() >= MAX_EVENT_SUBSCRIBERS) {
+        LogPrint(BCLog::NET, "CEventPublisher::AcceptSubscriber, too many subscribers, refuse %s\n", addr.ToString());
+        closesocket(hSocket);
+        return;
+    }
+
+    LogPrint(BCLog::NET, "CEventPublisher::AcceptSubscriber, accepted %s\n", addr.ToString());
+    AddSubscriber(make_shared<CEventSubscriber>(hSocket, addr.ToString()));
+}
+
+void CEventPublisher::AddSubscriber(const shared_ptr<CEventSubscriber> &spSubscriber) {
+    subscribers.push_back(spSubscriber);
+    UpdateSubscriptions();
+}
+
+void CEventPublisher::ReceiveRequests(CEventSubscriber &subscriber) {
+    char pchBuf[0x1000];
+    int32_t nBytes = recv(subscriber.hSocket, pchBuf, sizeof(pchBuf), MSG_DONTWAIT);
+    if (nBytes <= 0) {
+        int32_t nErr = WSAGetLastError();
+        if (nBytes == 0 || (nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS))
+            subscriber.fDisconnect = true;
+        return;
+    }
+
+    subscriber.recvBuffer.append(pchBuf, nBytes);
+    while (true) {
+        string request;
+        int64_t frameSize = ReadEventFrame(subscriber.recvBuffer, request);
+        if (frameSize < 0) {
+            LogPrint(BCLog::NET, "CEventPublisher::ReceiveRequests, oversized request of %s\n", subscriber.addrName);
+            subscriber.fDisconnect = true;
+            return;
+        }
+        if (frameSize == 0)
+            return;
+
+        if (!ProcessRequest(subscriber, request)) {
+            LogPrint(BCLog::NET, "CEventPublisher::ReceiveRequests, invalid request of %s\n", subscriber.addrName);
+            subscriber.fDisconnect = true;
+            return;
+        }
+        subscriber.recvBuffer.erase(0, frameSize);
+    }
+}
+
+bool CEventPublisher::ProcessRequest(CEventSubscriber &subscriber, const string &request) {
+    Value value;
+    if (!read_string(request, value) || value.type() != obj_type)
+        return false;
+
+    uint32_t newTopicMask = 0;
+    set<string> newAddresses;
+    for (const auto &pair : value.get_obj()) {
+        if (pair.value_.type() != array_type)
+            return false;
+
+        for (const auto &item : pair.value_.get_array()) {
+            if (item.type() != str_type)
+                return false;
+
+            EventTopic topic;
+            if (pair.name_ == "topics") {
+                if (!ParseEventTopic(item.get_str(), topic))
+                    return false;
+                newTopicMask |= 1 << topic;
+            } else if (pair.name_ == "addresses") {
+                newAddresses.insert(item.get_str());
+            }
+        }
+    }
+
+    subscriber.topicMask = newTopicMask;
+    subscriber.addresses.swap(newAddresses);
+    LogPrint(BCLog::NET, "CEventPublisher::ProcessRequest, %s subscribed to topics 0x%x, %d addresses\n",
+             subscriber.addrName, newTopicMask, subscriber.addresses.size());
+    return true;
+}
+
+void CEventPublisher::DispatchEvents() {
+    deque<CEvent> pendingEvents;
+    uint64_t pendingDroppedCounts[EVENT_TOPIC_COUNT];
+    {
+        LOCK(cs_events);
+        pendingEvents.swap(events);
+        copy(begin(droppedCounts), end(droppedCounts), begin(pendingDroppedCounts));
+        fill(begin(droppedCounts), end(droppedCounts), 0);
+    }
+
+    // the dropped events come before the ones still queued
+    for (auto &spSubscriber : subscribers) {
+        CEventSubscriber &subscriber = *spSubscriber;
+        uint64_t droppedCount = 0;
+        for (uint8_t topic = 0; topic < EVENT_TOPIC_COUNT; topic++) {
+            if ((subscriber.topicMask >> topic) & 1)
+                droppedCount += pendingDroppedCounts[topic];
+        }
+        if (droppedCount > 0 && !subscriber.fDisconnect) {
+            Object obj;
+            obj.push_back(Pair("count", droppedCount));
+            QueueFrame(subscriber, GetEventBody("dropped", obj));
+        }
+    }
+
+    for (const auto &event : pendingEvents) {
+        for (auto &spSubscriber : subscribers) {
+            CEventSubscriber &subscriber = *spSubscriber;
+            if (subscriber.fDisconnect || !((subscriber.topicMask >> event.topic) & 1))
+                continue;
+            if (event.topic == EVENT_ACCOUNT_CHANGED && !subscriber.addresses.count("*") &&
+                !subscriber.addresses.count(event.address))
+                continue;
+
+            QueueFrame(subscriber, *event.spBody);
+        }
+    }
+}
+
+void CEventPublisher::QueueFrame(CEventSubscriber &subscriber, const string &body) {
+    auto spFrame = make_shared<const string>(WriteEventFrame(strprintf("{\"seq\":%d,", subscriber.nextSeq++) + body));
+    subscriber.sendQueue.push_back(spFrame);
+    subscriber.queuedBytes += spFrame->size();
+    if (subscriber.queuedBytes > maxSendBuffer) {
+        LogPrint(BCLog::NET, "CEventPublisher::QueueFrame, subscriber %s fell behind by %d bytes\n",
+                 subscriber.addrName, subscriber.queuedBytes);
+        metrics::event_subscribers_dropped.Inc();
+        subscriber.fDisconnect = true;
+    }
+}
+
+void CEventPublisher::SendEvents(CEventSubscriber &subscriber) {
+    while (!subscriber.sendQueue.empty()) {
+        const string &frame = *subscriber.sendQueue.front();
+        int32_t nBytes      = send(subscriber.hSocket, frame.data() + subscriber.sendOffset,
+                                   frame.size() - subscriber.sendOffset, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (nBytes <= 0) {
+            int32_t nErr = WSAGetLastError();
+            if (nBytes < 0 && nErr != WSAEWOULDBLOCK && nErr != WSAEMSGSIZE && nErr != WSAEINTR && nErr != WSAEINPROGRESS)
+                subscriber.fDisconnect = true;
+            return;
+        }
+
+        subscriber.sendOffset += nBytes;
+        subscriber.queuedBytes -= nBytes;
+        if (subscriber.sendOffset == frame.size()) {
+            subscriber.sendQueue.pop_front();
+            subscriber.sendOffset = 0;
+        }
+    }
+}
+
+void CEventPublisher::UpdateSubscriptions() {
+    uint32_t newTopicMask = 0;
+    set<string> newAddresses;
+    bool fAllAddresses = false;
+    for (const auto &spSubscriber : subscribers) {
+        newTopicMask |= spSubscriber->topicMask;
+        if (!((spSubscriber->topicMask >> EVENT_ACCOUNT_CHANGED) & 1))
+            continue;
+
+        if (spSubscriber->addresses.count("*"))
+            fAllAddresses = true;
+        else
+            newAddresses.insert(spSubscriber->addresses.begin(), spSubscriber->addresses.end());
+    }
+
+    LOCK(cs_events);
+    watchedAddresses.swap(newAddresses);
+    fWatchAllAddresses = fAllAddresses;
+    topicMask.store(newTopicMask, std::memory_order_relaxed);
+}
+
+void ThreadEventPublisher() {
+    RenameThread("coin-events");
+    LogPrint(BCLog::INFO, "ThreadEventPublisher started\n");
+
+    while (true) {
+        pEventPublisher->ProcessSubscribers(50);
+    }
+}
@@ -0,0 +1,146 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CHAIN_EVENTPUBLISHER_H
+#define CHAIN_EVENTPUBLISHER_H
+
+#include "commons/compat/compat.h"
+#include "commons/json/json_spirit_value.h"
+#include "commons/uint256.h"
+#include "persistence/leveldbwrapper.h"
+#include "sync.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace json_spirit;
+
+class CBaseTx;
+class CBlock;
+class CBlockIndex;
+class CService;
+
+/** Default for -eventbind, the events are served to the local host only */
+static const char DEFAULT_EVENT_BIND[] = "127.0.0.1";
+/** Default for -eventsendbuffer, the max KB of events queued for one subscriber */
+static const uint32_t DEFAULT_EVENT_SEND_BUFFER = 16 * 1000;
+/** The max number of events waiting for the publisher thread, the oldest are dropped beyond */
+static const uint32_t MAX_EVENT_QUEUE_SIZE = 10000;
+/** The max number of connected subscribers */
+static const uint32_t MAX_EVENT_SUBSCRIBERS = 64;
+/** The max size of a subscribe request */
+static const uint32_t MAX_EVENT_REQUEST_SIZE = 64 * 1024;
+
+enum EventTopic : uint8_t {
+    EVENT_BLOCK_CONNECTED    = 0,
+    EVENT_BLOCK_DISCONNECTED = 1,
+    EVENT_TX_ACCEPTED        = 2,
+    EVENT_TX_REMOVED         = 3,
+    EVENT_RECEIPTS           = 4,
+    EVENT_ACCOUNT_CHANGED    = 5,
+    EVENT_TOPIC_COUNT
+};
+
+const string &GetEventTopicName(EventTopic topic);
+bool ParseEventTopic(const string &name, EventTopic &topic);
+
+/** The frame of the payload: its 4-byte big-endian size followed by it */
+string WriteEventFrame(const string &payload);
+/**
+ * Read the payload of the first frame of the buffer, return the bytes of the frame, 0 while it's
+ * incomplete, or -1 for a frame over MAX_EVENT_REQUEST_SIZE
+ */
+int64_t ReadEventFrame(const string &buffer, string &payload);
+
+struct CEventSubscriber {
+    SOCKET hSocket;
+    string addrName;
+    uint32_t topicMask;       // the bits of the subscribed topics
+    set<string> addresses;    // the addresses of the account changed events, "*" for all
+    string recvBuffer;
+    deque<shared_ptr<const string>> sendQueue;
+    size_t sendOffset;        // the bytes of the front frame already sent
+    size_t queuedBytes;
+    uint64_t nextSeq;         // the seq of the next frame sent to the subscriber
+    bool fDisconnect;
+
+    CEventSubscriber(SOCKET hSocketIn, const string &addrNameIn)
+        : hSocket(hSocketIn), addrName(addrNameIn), topicMask(0), sendOffset(0), queuedBytes(0), nextSeq(0),
+          fDisconnect(false) {}
+};
+
+/**
+ * Publisher of the chain, mempool and account events to the local subscribers.
+ *
+ * A subscriber connects to -eventport and sends a frame of {"topics":[...],"addresses":[...]},
+ * then it receives a frame per event. A frame is the 4-byte big-endian size of the json text
+ * followed by the text {"seq":n,"topic":"...","data":{...}}; a later request replaces the
+ * subscription. The producers only append the events to a bounded queue, and build nothing
+ * for the topics nobody follows. The subscribers are served by one thread with non-blocking
+ * writes, a subscriber falling behind by more than -eventsendbuffer is disconnected.
+ * seq counts the frames of each subscriber with no gap. The events dropped from a full queue are
+ * told by a frame of the topic "dropped" with {"count":n}, n the dropped events of the topics of
+ * the subscriber, the account changed events counted whatever their address.
+ */
+class CEventPublisher {
+public:
+    CEventPublisher();
+    ~CEventPublisher();
+
+    bool Bind(const CService &addrBind, string &strError);
+
+    bool HasSubscribers(EventTopic topic) const { return (topicMask.load(std::memory_order_relaxed) >> topic) & 1; }
+
+    // the producers, called under cs_main after the chain state is flushed
+    void BlockConnected(const CBlock &block, const CBlockIndex *pIndex, const CDbStateDeltaMap &stateDeltas);
+    void BlockDisconnected(const CBlock &block, const CBlockIndex *pIndex);
+    void TxAccepted(const CBaseTx &tx);
+    void TxRemoved(const uint256 &txid, const string &reason);
+
+    // serve the subscribers for up to timeoutMillis, run by the publisher thread
+    void ProcessSubscribers(int64_t timeoutMillis);
+
+    // the steps of ProcessSubscribers() which need no socket
+    static bool ProcessRequest(CEventSubscriber &subscriber, const string &request);
+    void AddSubscriber(const shared_ptr<CEventSubscriber> &spSubscriber);
+    void DispatchEvents();
+
+private:
+    void Publish(EventTopic topic, const Value &data, const string &address = "");
+    bool IsAddressWatched(const string &address) const;
+
+    void AcceptSubscriber();
+    void ReceiveRequests(CEventSubscriber &subscriber);
+    void QueueFrame(CEventSubscriber &subscriber, const string &body);
+    void SendEvents(CEventSubscriber &subscriber);
+    void UpdateSubscriptions();
+
+    struct CEvent {
+        EventTopic topic;
+        string address;  // the address of the account changed events
+        shared_ptr<const string> spBody;  // the json of the event after its seq
+    };
+
+    mutable CCriticalSection cs_events;
+    deque<CEvent> events;
+    uint64_t droppedCounts[EVENT_TOPIC_COUNT];  // the events dropped from the full queue by topic
+    set<string> watchedAddresses;  // the union of the addresses of the subscribers
+    bool fWatchAllAddresses;
+    std::atomic<uint32_t> topicMask;  // the union of the topics of the subscribers
+
+    // owned by the publisher thread
+    SOCKET hListenSocket;
+    vector<shared_ptr<CEventSubscriber>> subscribers;
+    size_t maxSendBuffer;
+};
+
+void ThreadEventPublisher();
+
+extern CEventPublisher *pEventPublisher;
+
+#endif  // CHAIN_EVENTPUBLISHER_H
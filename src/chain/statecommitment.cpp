@@ -0,0 +1,284 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "statecommitment.h"
+
+#include "main.h"
+#include "persistence/cachewrapper.h"
+#include "persistence/snapshot.h"
+
+CStateCommitment *pStateCommitment = nullptr;
+
+bool CStateCommitment::IsCommittedKey(DBNameType dbName, const leveldb::Slice &key) {
+    if (std::find(kSnapshotDbNames.begin(), kSnapshotDbNames.end(), dbName) == kSnapshotDbNames.end())
+        return false;
+
+    // the best block hash is the block of the commitment, which keeps the roots by the block
+    return IsSnapshotKey(dbName, key) && key != leveldb::Slice(dbk::GetKeyPrefix(dbk::BEST_BLOCKHASH));
+}
+
+bool CStateCommitment::Init(const uint256 &bestBlockHash, bool fRebuild) {
+    AssertLockHeld(cs_main);
+    fStale = true;
+    if (bestBlockHash.IsNull())
+        return true;
+
+    if (fRebuild) {
+        LogPrint(BCLog::INFO, "CStateCommitment::Init, the state dbs changed out of the blocks, rebuild it\n");
+        return Rebuild(bestBlockHash);
+    }
+
+    CStateCommitDBCache *pDbCache = pCdMan->pStateCommitCache;
+    uint256 tipHash, root;
+    if (!pDbCache->GetTip(tipHash) || tipHash != bestBlockHash) {
+        LogPrint(BCLog::INFO, "CStateCommitment::Init, the commitment is at %s, not at the best block %s, rebuild it\n",
+                 tipHash.GetHex(), bestBlockHash.GetHex());
+        return Rebuild(bestBlockHash);
+    }
+
+    map<string, uint256> bucketHashes;
+    if (!pDbCache->GetBucketHashes(bucketHashes))
+        return ERRORMSG("CStateCommitment::Init, read the bucket hashes failed");
+
+    map<uint32_t, uint256> indexedHashes;
+    for (const auto &item : bucketHashes) {
+        if (item.first.size() != 2)
+            return ERRORMSG("CStateCommitment::Init, invalid bucket id %s", HexStr(item.first));
+
+        indexedHashes[(uint8_t)item.first[0] << 8 | (uint8_t)item.first[1]] = item.second;
+    }
+    tree.SetBucketHashes(indexedHashes);
+
+    if (!pDbCache->GetRoot(bestBlockHash, root) || root != tree.GetRoot()) {
+        LogPrint(BCLog::INFO, "CStateCommitment::Init, the root of the buckets mismatches the one of %s, rebuild it\n",
+                 bestBlockHash.GetHex());
+        return Rebuild(bestBlockHash);
+    }
+
+    fStale = false;
+    LogPrint(BCLog::INFO, "CStateCommitment::Init, state root=%s, buckets=%u, block=%s\n", root.GetHex(),
+             bucketHashes.size(), bestBlockHash.GetHex());
+    return true;
+}
+
+bool CStateCommitment::Rebuild(const uint256 &bestBlockHash) {
+    int64_t nStart = GetTimeMillis();
+
+    // the state dbs are read as they are at the best block, the old commitment is dropped but the roots
+    pCdMan->Flush();
+    CStateCommitDBCache *pDbCache = pCdMan->pStateCommitCache;
+    CDBAccess *pCommitDb          = pCdMan->pStateCommitDb;
+    pDbCache->Clear();
+    {
+        const string &rootPrefix = dbk::GetKeyPrefix(dbk::STATE_ROOT);
+        CLevelDBBatch batch;
+        auto pCursor = pCommitDb->NewIterator();
+        for (pCursor->SeekToFirst(); pCursor->Valid(); pCursor->Next()) {
+            if (!pCursor->key().starts_with(rootPrefix))
+                batch.Erase(pCursor->key().ToString());
+        }
+        if (!pCommitDb->WriteBatch(batch))
+            return ERRORMSG("CStateCommitment::Rebuild, clear the commitment db failed");
+    }
+
+    map<uint32_t, uint256> bucketHashes;
+    uint64_t leafCount = 0;
+    const uint32_t passBuckets = STATE_BUCKET_COUNT / STATE_COMMIT_REBUILD_PASSES;
+    for (uint32_t pass = 0; pass < STATE_COMMIT_REBUILD_PASSES; pass++) {
+        map<uint32_t, CStateBucket> buckets;
+        for (DBNameType dbName : kSnapshotDbNames) {
+            auto pCursor = pCdMan->GetDbAccess(dbName)->NewIterator();
+            for (pCursor->SeekToFirst(); pCursor->Valid(); pCursor->Next()) {
+                if (!IsCommittedKey(dbName, pCursor->key()))
+                    continue;
+
+                string dbKey    = pCursor->key().ToString();
+                uint256 keyHash = GetStateKeyHash(dbKey);
+                uint32_t index  = GetStateBucketIndex(keyHash);
+                if (index / passBuckets == pass)
+                    buckets[index].leaves[keyHash] = GetStateLeafHash(dbKey, pCursor->value().ToString());
+            }
+            if (!pCursor->status().ok())
+                return ERRORMSG("CStateCommitment::Rebuild, iterate the db %s failed", GetDbName(dbName));
+        }
+
+        CLevelDBBatch batch;
+        for (const auto &item : buckets) {
+            string bucketId    = GetStateBucketId(item.first);
+            uint256 bucketHash = item.second.GetHash();
+            batch.Write(dbk::GenDbKey(dbk::STATE_BUCKET, bucketId), item.second);
+            batch.Write(dbk::GenDbKey(dbk::STATE_BUCKET_HASH, bucketId), bucketHash);
+            bucketHashes[item.first] = bucketHash;
+            leafCount += item.second.leaves.size();
+        }
+        if (!pCommitDb->WriteBatch(batch))
+            return ERRORMSG("CStateCommitment::Rebuild, write the buckets failed");
+
+        boost::this_thread::interruption_point();
+    }
+
+    tree.SetBucketHashes(bucketHashes);
+    pDbCache->SetRoot(bestBlockHash, tree.GetRoot());
+    pDbCache->SetTip(bestBlockHash);
+    pDbCache->Flush();
+
+    fStale = false;
+    LogPrint(BCLog::INFO, "CStateCommitment::Rebuild, state root=%s, leaves=%llu, buckets=%u, block=%s (%dms)\n",
+             tree.GetRoot().GetHex(), leafCount, bucketHashes.size(), bestBlockHash.GetHex(),
+             GetTimeMillis() - nStart);
+    return true;
+}
+
+bool CStateCommitment::UpdateLeaves(const map<uint32_t, map<uint256, uint256>> &changes,
+                                    vector<pair<uint256, uint256>> *pUndoLeaves) {
+    CStateCommitDBCache *pDbCache = pCdMan->pStateCommitCache;
+    for (const auto &bucketItem : changes) {
+        string bucketId = GetStateBucketId(bucketItem.first);
+        CStateBucket bucket;
+        pDbCache->GetBucket(bucketId, bucket);
+
+        for (const auto &leafItem : bucketItem.second) {
+            auto it         = bucket.leaves.find(leafItem.first);
+            uint256 oldLeaf = it == bucket.leaves.end() ? uint256() : it->second;
+            if (oldLeaf == leafItem.second)
+                continue;
+
+            if (pUndoLeaves != nullptr)
+                pUndoLeaves->push_back(make_pair(leafItem.first, oldLeaf));
+
+            if (leafItem.second.IsNull())
+                bucket.leaves.erase(leafItem.first);
+            else
+                bucket.leaves[leafItem.first] = leafItem.second;
+        }
+
+        if (!pDbCache->SetBucket(bucketId, bucket))
+            return ERRORMSG("CStateCommitment::UpdateLeaves, save the bucket %u failed", bucketItem.first);
+
+        tree.SetBucketHash(bucketItem.first, bucket.GetHash());
+    }
+    return true;
+}
+
+bool CStateCommitment::ConnectBlock(const CBlockIndex *pIndex, const CDbStateDeltaMap &deltaMap) {
+    AssertLockHeld(cs_main);
+    if (fStale)
+        return false;
+
+    CStateCommitDBCache *pDbCache = pCdMan->pStateCommitCache;
+    uint256 tipHash;
+    if (pIndex->pprev == nullptr || !pDbCache->GetTip(tipHash) || tipHash != pIndex->pprev->GetBlockHash()) {
+        fStale = true;
+        return ERRORMSG("CStateCommitment::ConnectBlock, the commitment is at %s, not at the previous block of %s",
+                        tipHash.GetHex(), pIndex->GetBlockHash().GetHex());
+    }
+
+    map<uint32_t, map<uint256, uint256>> changes;
+    for (const auto &deltasItem : deltaMap) {
+        DBNameType dbName = dbk::GetDbNameEnumByPrefix(deltasItem.first);
+        for (const auto &item : deltasItem.second) {
+            if (!IsCommittedKey(dbName, item.first))
+                continue;
+
+            uint256 keyHash = GetStateKeyHash(item.first);
+            changes[GetStateBucketIndex(keyHash)][keyHash] =
+                item.second.empty() ? uint256() : GetStateLeafHash(item.first, item.second);
+        }
+    }
+
+    CStateCommitUndo undo;
+    undo.block_hash = pIndex->GetBlockHash();
+    if (!UpdateLeaves(changes, &undo.leaves)) {
+        fStale = true;
+        return false;
+    }
+
+    pDbCache->SetUndo(pIndex->height, undo);
+    if (pIndex->height > STATE_COMMIT_UNDO_DEPTH)
+        pDbCache->EraseUndo(pIndex->height - STATE_COMMIT_UNDO_DEPTH);
+
+    pDbCache->SetRoot(pIndex->GetBlockHash(), tree.GetRoot());
+    pDbCache->SetTip(pIndex->GetBlockHash());
+
+    LogPrint(BCLog::DEBUG, "CStateCommitment::ConnectBlock, block=%d, leaves=%u, buckets=%u, state root=%s\n",
+             pIndex->height, undo.leaves.size(), changes.size(), tree.GetRoot().GetHex());
+    return true;
+}
+
+bool CStateCommitment::DisconnectBlock(const CBlockIndex *pIndex) {
+    AssertLockHeld(cs_main);
+    if (fStale)
+        return false;
+
+    CStateCommitDBCache *pDbCache = pCdMan->pStateCommitCache;
+    uint256 tipHash;
+    CStateCommitUndo undo;
+    if (!pDbCache->GetTip(tipHash) || tipHash != pIndex->GetBlockHash() ||
+        !pDbCache->GetUndo(pIndex->height, undo) || undo.block_hash != pIndex->GetBlockHash()) {
+        fStale = true;
+        return ERRORMSG("CStateCommitment::DisconnectBlock, no commitment undo of the block %d %s", pIndex->height,
+                        pIndex->GetBlockHash().GetHex());
+    }
+
+    map<uint32_t, map<uint256, uint256>> changes;
+    for (const auto &item : undo.leaves)
+        changes[GetStateBucketIndex(item.first)][item.first] = item.second;
+
+    if (!UpdateLeaves(changes, nullptr)) {
+        fStale = true;
+        return false;
+    }
+
+    uint256 prevRoot;
+    if (pDbCache->GetRoot(pIndex->pprev->GetBlockHash(), prevRoot) && prevRoot != tree.GetRoot()) {
+        fStale = true;
+        return ERRORMSG("CStateCommitment::DisconnectBlock, the state root %s after the undo of %s mismatches %s",
+                        tree.GetRoot().GetHex(), pIndex->GetBlockHash().GetHex(), prevRoot.GetHex());
+    }
+
+    pDbCache->EraseUndo(pIndex->height);
+    pDbCache->SetTip(pIndex->pprev->GetBlockHash());
+    return true;
+}
+
+bool CStateCommitment::GetProof(const string &dbKey, CStateProof &proof) {
+    AssertLockHeld(cs_main);
+    if (fStale)
+        return ERRORMSG("CStateCommitment::GetProof, the commitment is stale");
+
+    auto itPrefix = dbk::gPrefixNameMap.end();
+    for (auto it = dbk::gPrefixNameMap.begin(); it != dbk::gPrefixNameMap.end(); it++) {
+        if (!it->first.empty() && dbKey.compare(0, it->first.size(), it->first) == 0 &&
+            (itPrefix == dbk::gPrefixNameMap.end() || it->first.size() > itPrefix->first.size()))
+            itPrefix = it;
+    }
+    if (itPrefix == dbk::gPrefixNameMap.end())
+        return ERRORMSG("CStateCommitment::GetProof, unknown prefix of the key %s", HexStr(dbKey));
+
+    DBNameType dbName = dbk::GetDbNameEnumByPrefix(itPrefix->second);
+    if (!IsCommittedKey(dbName, dbKey))
+        return ERRORMSG("CStateCommitment::GetProof, the key %s is not committed", HexStr(dbKey));
+
+    // the value of the tip is read through the caches, a wrapper over them leaves them as they are;
+    // a prefix of no cache is read from the db
+    proof.key   = dbKey;
+    proof.value = "";
+    CCacheWrapper cw(pCdMan);
+    DbValueFuncMap dbValueFuncMap = cw.GetDbValueFuncMap();
+    auto itFunc = dbValueFuncMap.find(itPrefix->second);
+    if (itFunc != dbValueFuncMap.end()) {
+        itFunc->second(dbKey, proof.value);
+    } else {
+        auto pCursor = pCdMan->GetDbAccess(dbName)->NewIterator();
+        pCursor->Seek(dbKey);
+        if (pCursor->Valid() && pCursor->key() == leveldb::Slice(dbKey))
+            proof.value = pCursor->value().ToString();
+    }
+
+    uint32_t index = GetStateBucketIndex(GetStateKeyHash(dbKey));
+    proof.bucket.SetEmpty();
+    pCdMan->pStateCommitCache->GetBucket(GetStateBucketId(index), proof.bucket);
+    proof.branch = tree.GetBranch(index);
+    return true;
+}
@@ -0,0 +1,57 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef CHAIN_STATECOMMITMENT_H
+#define CHAIN_STATECOMMITMENT_H
+
+#include "config/const.h"
+#include "persistence/leveldbwrapper.h"
+#include "persistence/statecommitdb.h"
+
+class CBlockIndex;
+
+/** Default for -statecommitment */
+static const bool DEFAULT_STATECOMMITMENT = false;
+/** The blocks whose commitment undo is kept, a deeper disconnect needs the commitment rebuilt */
+static const int32_t STATE_COMMIT_UNDO_DEPTH = MIN_PRUNE_DEPTH;
+/** The scans of the state dbs to rebuild the commitment, each one holds the leaves of its share of the buckets */
+static const uint32_t STATE_COMMIT_REBUILD_PASSES = 16;
+
+/**
+ * Commitment to the chain state entries, the same ones a snapshot carries, updated by the
+ * state deltas of each connected block. The root after each block is kept, outside of the
+ * consensus for now.
+ *
+ * Should the commitment fall out of step with the chain, e.g. on a disconnect deeper than the
+ * kept undo, it stops following the blocks and is rebuilt from the state dbs at the next start.
+ */
+class CStateCommitment {
+public:
+    CStateCommitment() : fStale(true) {}
+
+    // load the commitment of the state at the block, it's rebuilt if it's not at the block or fRebuild
+    bool Init(const uint256 &bestBlockHash, bool fRebuild = false);
+    bool ConnectBlock(const CBlockIndex *pIndex, const CDbStateDeltaMap &deltaMap);
+    bool DisconnectBlock(const CBlockIndex *pIndex);
+
+    bool IsStale() const { return fStale; }
+    const uint256 &GetRoot() const { return tree.GetRoot(); }
+    // the proof of the value of the key at the tip
+    bool GetProof(const string &dbKey, CStateProof &proof);
+
+    // whether the entry of the db is committed, the chain state of a snapshot but the best block hash
+    static bool IsCommittedKey(DBNameType dbName, const leveldb::Slice &key);
+
+private:
+    bool Rebuild(const uint256 &bestBlockHash);
+    // bucket index -> key hash -> the new leaf hash, null to erase the leaf
+    bool UpdateLeaves(const map<uint32_t, map<uint256, uint256>> &changes, vector<pair<uint256, uint256>> *pUndoLeaves);
+
+    bool fStale;
+    CStateBucketTree tree;
+};
+
+extern CStateCommitment *pStateCommitment;
+
+#endif  // CHAIN_STATECOMMITMENT_H
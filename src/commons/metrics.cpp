@@ -0,0 +1,149 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "metrics.h"
+
+#include "commons/tinyformat.h"
+
+const int64_t CMetricHistogram::kBucketBounds[CMetricHistogram::BUCKET_COUNT] = {
+    50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000, 10000000};
+
+namespace metrics {
+CMetricHistogram connect_block;
+CMetricHistogram check_block;
+CMetricHistogram accept_to_mempool;
+CMetricHistogram write_chain_state;
+CMetricHistogram leveldb_write;
+CMetricHistogram pbft_message;
+CMetricHistogram rpc_call;
+
+CMetricCounter rpc_errors;
+CMetricCounter cache_reads;
+CMetricCounter cache_db_reads;
+CMetricCounter leveldb_write_bytes;
+CMetricCounter leveldb_reads;
+CMetricCounter leveldb_read_bytes;
+CMetricCounter sysparam_snapshot_builds;
+CMetricCounter events_dropped;
+CMetricCounter event_subscribers_dropped;
+CMetricCounter orphan_txs_evicted;
+CMetricCounter orphan_txs_resubmitted;
+}  // namespace metrics
+
+static void RegisterMetrics(CMetricsRegistry &registry) {
+    registry.AddHistogram("coind_connect_block_seconds", "Time to connect a block", metrics::connect_block);
+    registry.AddHistogram("coind_check_block_seconds", "Time to check a block", metrics::check_block);
+    registry.AddHistogram("coind_accept_to_mempool_seconds", "Time to accept a tx to the mempool", metrics::accept_to_mempool);
+    registry.AddHistogram("coind_write_chain_state_seconds", "Time to write the chain state", metrics::write_chain_state);
+    registry.AddHistogram("coind_leveldb_write_seconds", "Time of a leveldb batch write", metrics::leveldb_write);
+    registry.AddHistogram("coind_pbft_message_seconds", "Time to handle a pbft message", metrics::pbft_message);
+    registry.AddHistogram("coind_rpc_call_seconds", "Time to execute an rpc call", metrics::rpc_call);
+
+    registry.AddCounter("coind_rpc_errors_total", "Rpc calls which failed", metrics::rpc_errors);
+    registry.AddCounter("coind_cache_reads_total", "Lookups of the cache layers", metrics::cache_reads);
+    registry.AddCounter("coind_cache_db_reads_total", "Lookups which missed all the cache layers and read leveldb",
+                        metrics::cache_db_reads);
+    registry.AddCounter("coind_leveldb_write_bytes_total", "Bytes written to leveldb in batches", metrics::leveldb_write_bytes);
+    registry.AddCounter("coind_leveldb_reads_total", "Point reads of leveldb", metrics::leveldb_reads);
+    registry.AddCounter("coind_leveldb_read_bytes_total", "Bytes read from leveldb by point reads", metrics::leveldb_read_bytes);
+    registry.AddCounter("coind_sysparam_snapshot_builds_total", "Builds of the sys param snapshot after a write to the params",
+                        metrics::sysparam_snapshot_builds);
+    registry.AddCounter("coind_events_dropped_total", "Events dropped from the full queue of the event publisher",
+                        metrics::events_dropped);
+    registry.AddCounter("coind_event_subscribers_dropped_total", "Event subscribers disconnected for falling behind",
+                        metrics::event_subscribers_dropped);
+    registry.AddCounter("coind_orphan_txs_evicted_total", "Orphan txs evicted from the full orphan pool",
+                        metrics::orphan_txs_evicted);
+    registry.AddCounter("coind_orphan_txs_resubmitted_total", "Orphan txs resubmitted after their dependencies were met",
+                        metrics::orphan_txs_resubmitted);
+}
+
+void CMetricsRegistry::AddCounter(const std::string &name, const std::string &help, CMetricCounter &counter) {
+    std::lock_guard<std::mutex> lock(cs);
+    entries.push_back({name, help, MetricType::COUNTER, &counter, nullptr, nullptr});
+}
+
+void CMetricsRegistry::AddHistogram(const std::string &name, const std::string &help, CMetricHistogram &histogram) {
+    std::lock_guard<std::mutex> lock(cs);
+    entries.push_back({name, help, MetricType::HISTOGRAM, nullptr, &histogram, nullptr});
+}
+
+void CMetricsRegistry::AddGauge(const std::string &name, const std::string &help, std::function<int64_t()> getter) {
+    std::lock_guard<std::mutex> lock(cs);
+    entries.push_back({name, help, MetricType::GAUGE, nullptr, nullptr, getter});
+}
+
+std::vector<CMetricSample> CMetricsRegistry::GetSamples() const {
+    std::vector<CEntry> entriesCopy;
+    {
+        std::lock_guard<std::mutex> lock(cs);
+        entriesCopy = entries;
+    }
+
+    // the gauge getters may take the locks of what they sample, so they run without the registry lock
+    std::vector<CMetricSample> samples;
+    samples.reserve(entriesCopy.size());
+    for (const auto &entry : entriesCopy) {
+        CMetricSample sample;
+        sample.name = entry.name;
+        sample.help = entry.help;
+        sample.type = entry.type;
+        switch (entry.type) {
+            case MetricType::COUNTER:
+                sample.value = entry.pCounter->Get();
+                break;
+            case MetricType::GAUGE:
+                sample.value = entry.getter();
+                break;
+            case MetricType::HISTOGRAM:
+                for (uint32_t i = 0; i <= CMetricHistogram::BUCKET_COUNT; i++) {
+                    sample.buckets.push_back(entry.pHistogram->GetBucket(i));
+                    sample.count += sample.buckets.back();
+                }
+                sample.sum = entry.pHistogram->GetSum();
+                break;
+        }
+        samples.push_back(sample);
+    }
+    return samples;
+}
+
+static std::string GetTypeName(MetricType type) {
+    switch (type) {
+        case MetricType::COUNTER:   return "counter";
+        case MetricType::GAUGE:     return "gauge";
+        case MetricType::HISTOGRAM: return "histogram";
+    }
+    return "untyped";
+}
+
+std::string CMetricsRegistry::ToText() const {
+    std::string text;
+    for (const auto &sample : GetSamples()) {
+        text += strprintf("# HELP %s %s\n", sample.name, sample.help);
+        text += strprintf("# TYPE %s %s\n", sample.name, GetTypeName(sample.type));
+        if (sample.type != MetricType::HISTOGRAM) {
+            text += strprintf("%s %d\n", sample.name, sample.value);
+            continue;
+        }
+
+        uint64_t cumulative = 0;
+        for (uint32_t i = 0; i < CMetricHistogram::BUCKET_COUNT; i++) {
+            cumulative += sample.buckets[i];
+            text += strprintf("%s_bucket{le=\"%g\"} %u\n", sample.name,
+                              CMetricHistogram::kBucketBounds[i] / 1000000.0, cumulative);
+        }
+        text += strprintf("%s_bucket{le=\"+Inf\"} %u\n", sample.name, sample.count);
+        text += strprintf("%s_sum %.6f\n", sample.name, sample.sum / 1000000.0);
+        text += strprintf("%s_count %u\n", sample.name, sample.count);
+    }
+    return text;
+}
+
+CMetricsRegistry &GetMetricsRegistry() {
+    static CMetricsRegistry registry;
+    static std::once_flag registered;
+    std::call_once(registered, RegisterMetrics, std::ref(registry));
+    return registry;
+}
@@ -0,0 +1,132 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef COMMONS_METRICS_H
+#define COMMONS_METRICS_H
+
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * In-process metrics. The counters and histograms are updated with relaxed atomics only, so the
+ * hot paths never take a lock; the registry lock is only taken to register and to read them.
+ * The gauges are sampled by their getters when read, so the measured paths don't update them.
+ */
+enum class MetricType { COUNTER, GAUGE, HISTOGRAM };
+
+class CMetricCounter {
+public:
+    void Inc(uint64_t n = 1) { value.fetch_add(n, std::memory_order_relaxed); }
+    uint64_t Get() const { return value.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> value{0};
+};
+
+/** Latency histogram with fixed buckets, in microseconds */
+class CMetricHistogram {
+public:
+    static const uint32_t BUCKET_COUNT = 14;
+    //! upper bounds of the buckets, the last bucket (+Inf) holds the rest
+    static const int64_t kBucketBounds[BUCKET_COUNT];
+
+    void Observe(int64_t micros) {
+        uint32_t i = 0;
+        while (i < BUCKET_COUNT && micros > kBucketBounds[i])
+            i++;
+        counts[i].fetch_add(1, std::memory_order_relaxed);
+        sum.fetch_add(micros, std::memory_order_relaxed);
+    }
+
+    uint64_t GetBucket(uint32_t i) const { return counts[i].load(std::memory_order_relaxed); }
+    int64_t GetSum() const { return sum.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<uint64_t> counts[BUCKET_COUNT + 1] = {};
+    std::atomic<int64_t> sum{0};
+};
+
+/** Observes the lifetime of the scope into a histogram */
+class CMetricTimer {
+public:
+    explicit CMetricTimer(CMetricHistogram &histogramIn)
+        : histogram(histogramIn), start(std::chrono::steady_clock::now()) {}
+
+    ~CMetricTimer() {
+        histogram.Observe(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count());
+    }
+
+private:
+    CMetricHistogram &histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+/** A metric read from the registry */
+struct CMetricSample {
+    std::string name;
+    std::string help;
+    MetricType type;
+    int64_t value = 0;              //!< counter or gauge
+    std::vector<uint64_t> buckets;  //!< histogram, not cumulative, the last one is +Inf
+    int64_t sum = 0;                //!< histogram, in microseconds
+    uint64_t count = 0;             //!< histogram
+};
+
+class CMetricsRegistry {
+public:
+    void AddCounter(const std::string &name, const std::string &help, CMetricCounter &counter);
+    void AddHistogram(const std::string &name, const std::string &help, CMetricHistogram &histogram);
+    void AddGauge(const std::string &name, const std::string &help, std::function<int64_t()> getter);
+
+    std::vector<CMetricSample> GetSamples() const;
+    //! the Prometheus text exposition format, the latencies are in seconds
+    std::string ToText() const;
+
+private:
+    struct CEntry {
+        std::string name;
+        std::string help;
+        MetricType type;
+        CMetricCounter *pCounter;
+        CMetricHistogram *pHistogram;
+        std::function<int64_t()> getter;
+    };
+
+    mutable std::mutex cs;
+    std::vector<CEntry> entries;
+};
+
+CMetricsRegistry &GetMetricsRegistry();
+
+/** The metrics of the node, registered with the registry of GetMetricsRegistry() */
+namespace metrics {
+extern CMetricHistogram connect_block;
+extern CMetricHistogram check_block;
+extern CMetricHistogram accept_to_mempool;
+extern CMetricHistogram write_chain_state;
+extern CMetricHistogram leveldb_write;
+extern CMetricHistogram pbft_message;
+extern CMetricHistogram rpc_call;
+
+extern CMetricCounter rpc_errors;
+extern CMetricCounter cache_reads;
+extern CMetricCounter cache_db_reads;
+extern CMetricCounter leveldb_write_bytes;
+extern CMetricCounter leveldb_reads;
+extern CMetricCounter leveldb_read_bytes;
+extern CMetricCounter sysparam_snapshot_builds;
+extern CMetricCounter events_dropped;
+extern CMetricCounter event_subscribers_dropped;
+extern CMetricCounter orphan_txs_evicted;
+extern CMetricCounter orphan_txs_resubmitted;
+}  // namespace metrics
+
+#endif  // COMMONS_METRICS_H
@@ -32,6 +32,7 @@
 #include <fcntl.h>
 #include <sys/resource.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <algorithm>
 
 #else
@@ -778,6 +779,16 @@ int RaiseFileDescriptorLimit(int nMinFD) {
 #endif
 }
 
+uint64_t GetResidentMemory() {
+#if defined(__linux__)
+    std::ifstream statm("/proc/self/statm");
+    uint64_t sizePages = 0, residentPages = 0;
+    if (statm >> sizePages >> residentPages)
+        return residentPages * sysconf(_SC_PAGESIZE);
+#endif
+    return 0;
+}
+
 // this function tries to make a particular range of a file allocated (corresponding to disk space)
 // it is advisory, and the range specified in the arguments will never contain live data
 void AllocateFileRange(FILE* file, unsigned int offset, unsigned int length) {
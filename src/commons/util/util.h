@@ -138,6 +138,8 @@ bool WildcardMatch(const string& str, const string& mask);
 void FileCommit(FILE* fileout);
 bool TruncateFile(FILE* file, unsigned int length);
 int RaiseFileDescriptorLimit(int nMinFD);
+// resident memory of the process in bytes, 0 if unknown on the platform
+uint64_t GetResidentMemory();
 void AllocateFileRange(FILE* file, unsigned int offset, unsigned int length);
 bool RenameOver(boost::filesystem::path src, boost::filesystem::path dest);
 bool TryCreateDirectory(const boost::filesystem::path& p);
@@ -122,6 +122,10 @@ static const uint32_t MAX_BLOCKFILE_SIZE = 0x8000000;  // 128 MiB
 static const uint32_t BLOCKFILE_CHUNK_SIZE = 0x1000000;  // 16 MiB
 /** The pre-allocation chunk size for rev?????.dat files (since 0.8) */
 static const uint32_t UNDOFILE_CHUNK_SIZE = 0x100000;  // 1 MiB
+/** The min retention depth of -prune, a day of blocks, well above the tx memory cache and the reorgs */
+static const uint32_t MIN_PRUNE_DEPTH = 28800;
+/** The tip blocks a state snapshot carries with their data and undo, as many as a pruned node keeps */
+static const uint32_t SNAPSHOT_BLOCK_DEPTH = MIN_PRUNE_DEPTH;
 /** -dbcache default (MiB) */
 static const int64_t DEFAULT_DB_CACHE = 100;
 /** max. -dbcache in (MiB) */
@@ -100,6 +100,24 @@ public:
         return *this;
     }
 
+    bool operator==(const CAccountToken &other) const {
+        return free_amount == other.free_amount && frozen_amount == other.frozen_amount &&
+               staked_amount == other.staked_amount && voted_amount == other.voted_amount &&
+               pledged_amount == other.pledged_amount;
+    }
+    bool operator!=(const CAccountToken &other) const { return !(*this == other); }
+
+    bool IsEmpty() const {
+        return free_amount == 0 && frozen_amount == 0 && staked_amount == 0 && voted_amount == 0 &&
+               pledged_amount == 0;
+    }
+    void SetEmpty() { *this = CAccountToken(); }
+
+    string ToString() const {
+        return strprintf("free=%llu, frozen=%llu, staked=%llu, voted=%llu, pledged=%llu", free_amount,
+                         frozen_amount, staked_amount, voted_amount, pledged_amount);
+    }
+
     IMPLEMENT_SERIALIZE(
         READWRITE(VARINT(free_amount));
         READWRITE(VARINT(frozen_amount));
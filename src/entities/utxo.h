@@ -311,19 +311,19 @@ struct CUtxoCondStorageBean {
 
             case UtxoCondType::OP2SA: {
                 utxoCondPtr = std::make_shared<CSingleAddressCondOut>();
-                ::Unserialize(is, *((CSingleAddressCondIn *)(utxoCondPtr.get())), nType, nVersion);
+                ::Unserialize(is, *((CSingleAddressCondOut *)(utxoCondPtr.get())), nType, nVersion);
                 break;
             }
 
             case UtxoCondType::OP2MA: {
                 utxoCondPtr = std::make_shared<CMultiSignAddressCondOut>();
-                ::Unserialize(is, *((CMultiSignAddressCondIn *)(utxoCondPtr.get())), nType, nVersion);
+                ::Unserialize(is, *((CMultiSignAddressCondOut *)(utxoCondPtr.get())), nType, nVersion);
                 break;
             }
 
             case UtxoCondType::OP2PH: {
                 utxoCondPtr = std::make_shared<CPasswordHashLockCondOut>();
-                ::Unserialize(is, *((CPasswordHashLockCondIn *)(utxoCondPtr.get())), nType, nVersion);
+                ::Unserialize(is, *((CPasswordHashLockCondOut *)(utxoCondPtr.get())), nType, nVersion);
                 break;
             }
             
@@ -347,4 +347,55 @@ struct CUtxoCondStorageBean {
     }
 
 };
+
+/**
+ * UTXO set entry, keyed by (txid, vout_index)
+ *
+ * Carries everything needed to validate the spending input, so that the previous utxo tx
+ * does not need to be loaded from the block files.
+ * The legacy entries were stored as a single byte of 1, which is parsed as an entry of
+ * UTXO_ENTRY_LEGACY_VERSION without the output data.
+ */
+static const uint8_t UTXO_ENTRY_LEGACY_VERSION  = 1;
+static const uint8_t UTXO_ENTRY_CURRENT_VERSION = 2;
+
+struct CUtxoEntry {
+    uint8_t version;                            // 0: empty
+    CUserID owner_uid;                          // txUid of the utxo tx
+    TokenSymbol coin_symbol;
+    uint64_t coin_amount;
+    std::vector<CUtxoCondStorageBean> conds;    // conds of the utxo vout
+
+    CUtxoEntry() : version(0), coin_amount(0) {}
+
+    CUtxoEntry(const CUserID &ownerUid, const TokenSymbol &coinSymbol, const CUtxoOutput &output)
+        : version(UTXO_ENTRY_CURRENT_VERSION), owner_uid(ownerUid), coin_symbol(coinSymbol),
+          coin_amount(output.coin_amount), conds(output.conds) {}
+
+    bool IsLegacy() const { return version == UTXO_ENTRY_LEGACY_VERSION; }
+
+    bool IsEmpty() const { return version == 0; }
+    void SetEmpty() {
+        version = 0;
+        owner_uid.SetEmpty();
+        coin_symbol.clear();
+        coin_amount = 0;
+        conds.clear();
+    }
+
+    string ToString() const {
+        return strprintf("version=%d, owner_uid=%s, coin_symbol=%s, coin_amount=%llu, conds_size=%u", version,
+                         owner_uid.ToString(), coin_symbol, coin_amount, conds.size());
+    }
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(version);
+        if (version >= UTXO_ENTRY_CURRENT_VERSION) {
+            READWRITE(owner_uid);
+            READWRITE(coin_symbol);
+            READWRITE(VARINT(coin_amount));
+            READWRITE(conds);
+        }
+    )
+};
 #endif  // ENTITIES_UTXO_H
\ No newline at end of file
@@ -24,7 +24,11 @@
 #include "persistence/accountdb.h"
 #include "persistence/txdb.h"
 #include "persistence/contractdb.h"
+#include "chain/blockfilterindex.h"
+#include "chain/eventpublisher.h"
+#include "chain/statecommitment.h"
 #include "tx/tx.h"
+#include "tx/txorphanpool.h"
 #include "commons/util/util.h"
 #include "commons/util/time.h"
 #ifdef USE_UPNP
@@ -150,6 +154,21 @@ void Shutdown() {
             bitdb.Flush(true);
         }
 
+        if (pBlockFilterIndex != nullptr) {
+            delete pBlockFilterIndex;
+            pBlockFilterIndex = nullptr;
+        }
+
+        if (pEventPublisher != nullptr) {
+            delete pEventPublisher;
+            pEventPublisher = nullptr;
+        }
+
+        if (pStateCommitment != nullptr) {
+            delete pStateCommitment;
+            pStateCommitment = nullptr;
+        }
+
         if (pCdMan != nullptr) {
             pCdMan->Flush();
             delete pCdMan;
@@ -213,10 +232,19 @@ string HelpMessage() {
 #endif
     strUsage += "  -datadir=<dir>         " + _("Specify data directory") + "\n";
     strUsage += "  -dbcache=<n>           " + strprintf(_("Set database cache size in megabytes (%d to %d, default: %d)"), MIN_DB_CACHE, MAX_DB_CACHE, DEFAULT_DB_CACHE) + "\n";
+    strUsage += "  -eventport=<port>      " + _("Publish the block, mempool and account events to the subscribers on <port> (default: 0, disabled)") + "\n";
+    strUsage += "  -eventbind=<addr>      " + strprintf(_("Bind the event publisher to the given address (default: %s)"), DEFAULT_EVENT_BIND) + "\n";
+    strUsage += "  -eventsendbuffer=<n>   " + strprintf(_("Maximum KB of events queued for a subscriber before it is disconnected (default: %u)"), DEFAULT_EVENT_SEND_BUFFER) + "\n";
     strUsage += "  -loadblock=<file>      " + _("Imports blocks from external blk000??.dat file") + " " + _("on startup") + "\n";
     strUsage += "  -pid=<file>            " + _("Specify pid file (default: coin.pid)") + "\n";
     strUsage += "  -reindex               " + _("Rebuild block chain index from current blk000??.dat files") + " " + _("on startup") + "\n";
+    strUsage += "  -prune=<n>             " + strprintf(_("Delete the block and undo files older than the last <n> blocks and the global finality block (0 = disabled, default: 0, min: %u)"), MIN_PRUNE_DEPTH) + "\n";
+    strUsage += "  -loadsnapshot=<file>   " + _("Bootstrap an empty datadir from the state snapshot of exportsnapshot, the node is a pruned one") + "\n";
+    strUsage += "  -snapshothash=<hash>   " + _("The state hash the snapshot of -loadsnapshot must have, get it from a node you trust") + "\n";
+    strUsage += "  -replay=<from>:<to>    " + _("Replay the blocks <from>..<to> of the active chain in memory, log their timings and exit") + "\n";
     strUsage += "  -txindex               " + _("Maintain a full transaction index (default: 0)") + "\n";
+    strUsage += "  -statecommitment       " + strprintf(_("Maintain the commitment to the chain state and its root after each block (default: %u)"), DEFAULT_STATECOMMITMENT) + "\n";
+    strUsage += "  -blockfilterindex      " + strprintf(_("Maintain the compact block filters for light clients in the background, not on a pruned node (default: %u)"), DEFAULT_BLOCKFILTERINDEX) + "\n";
     strUsage += "  -logfailures           " + _("Log failures into level db in detail (default: 0)") + "\n";
     strUsage += "  -genreceipt               " + _("Whether generate receipt(default: 0)") + "\n";
 
@@ -235,6 +263,8 @@ string HelpMessage() {
     strUsage += "  -maxconnections=<n>    " + _("Maintain at most <n> connections to peers (default: 125)") + "\n";
     strUsage += "  -maxreceivebuffer=<n>  " + _("Maximum per-connection receive buffer, <n>*1000 bytes (default: 5000)") + "\n";
     strUsage += "  -maxsendbuffer=<n>     " + _("Maximum per-connection send buffer, <n>*1000 bytes (default: 1000)") + "\n";
+    strUsage += "  -maxorphantx=<n>       " + strprintf(_("Keep at most <n> transactions waiting for their accounts, regids or contracts (default: %u)"), DEFAULT_MAX_ORPHAN_TRANSACTIONS) + "\n";
+    strUsage += "  -maxorphantxsize=<n>   " + strprintf(_("Keep at most <n>*1000 bytes of transactions waiting for their dependencies (default: %u)"), DEFAULT_MAX_ORPHAN_TX_SIZE) + "\n";
     strUsage += "  -onion=<ip:port>       " + _("Use separate SOCKS5 proxy to reach peers via Tor hidden services (default: -proxy)") + "\n";
     strUsage += "  -onlynet=<net>         " + _("Only connect to nodes in network <net> (IPv4, IPv6 or Tor)") + "\n";
     strUsage += "  -port=<port>           " + _("Listen for connections on <port> (default: 8333 or testnet: 18333)") + "\n";
@@ -243,6 +273,7 @@ string HelpMessage() {
     strUsage += "  -seednode=<ip>         " + _("Connect to a node to retrieve peer addresses, and disconnect") + "\n";
     strUsage += "  -socks=<n>             " + _("Select SOCKS version for -proxy (4 or 5, default: 5)") + "\n";
     strUsage += "  -timeout=<n>           " + _("Specify connection timeout in milliseconds (default: 5000)") + "\n";
+    strUsage += "  -txreconciliation      " + _("Reconcile the tx announcements with the supporting peers instead of flooding invs (default: 0)") + "\n";
 #ifdef USE_UPNP
 #if USE_UPNP
     strUsage += "  -upnp                  " + _("Use UPnP to map the listening port (default: 1 when listening)") + "\n";
@@ -301,6 +332,7 @@ string HelpMessage() {
 
     strUsage += "\n" + _("Block creation options:") + "\n";
     strUsage += "  -blockmaxsize=<n>      " + strprintf(_("Set maximum block size in bytes (default: %d)"), DEFAULT_BLOCK_MAX_SIZE) + "\n";
+    strUsage += "  -prebuildblock         " + _("Pack transactions into the block template ahead of the producer's slot (default: 1)") + "\n";
 
     strUsage += "\n" + _("RPC server options:") + "\n";
     strUsage += "  -rpcserver             " + _("Accept command line and JSON-RPC commands") + "\n";
@@ -309,6 +341,7 @@ string HelpMessage() {
     strUsage += "  -rpcport=<port>        " + _("Listen for JSON-RPC connections on <port> (default: 8332 or testnet: 18332)") + "\n";
     strUsage += "  -rpcallowip=<ip>       " + _("Allow JSON-RPC connections from specified IP address") + "\n";
     strUsage += "  -rpcthreads=<n>        " + _("Set the number of threads to service RPC calls (default: 4)") + "\n";
+    strUsage += "  -metrics               " + _("Serve the metrics in the Prometheus text format at /metrics of the RPC port, without authentication (default: 0)") + "\n";
 
     strUsage += "\n" + _("RPC SSL options: (see the Coin Wiki for SSL setup instructions)") + "\n";
     strUsage += "  -rpcssl                                  " + _("Use OpenSSL (https) for JSON-RPC connections") + "\n";
@@ -505,6 +538,8 @@ bool AppInit(boost::thread_group &threadGroup) {
 
     SysCfg().SetBenchMark(SysCfg().GetBoolArg("-benchmark", false));
     mempool.SetSanityCheck(SysCfg().GetBoolArg("-checkmempool", RegTest()));
+    orphanTxPool.SetLimits(max<int64_t>(SysCfg().GetArg("-maxorphantx", DEFAULT_MAX_ORPHAN_TRANSACTIONS), 0),
+                           max<int64_t>(SysCfg().GetArg("-maxorphantxsize", DEFAULT_MAX_ORPHAN_TX_SIZE), 0) * 1000);
 
     setvbuf(stdout, nullptr, _IOLBF, 0);
 
@@ -674,12 +709,62 @@ bool AppInit(boost::thread_group &threadGroup) {
         filesystem::create_directories(blocksDir);
     }
 
-    try {
-        pWalletMain = CWallet::GetInstance();
-        RegisterWallet(pWalletMain);
-        pWalletMain->LoadWallet(false);
-    } catch (std::exception &e) {
-        std::cout << "load wallet failed: " << e.what() << std::endl;
+    int64_t nPrune = SysCfg().GetArg("-prune", 0);
+    if (nPrune < 0 || (nPrune > 0 && nPrune < MIN_PRUNE_DEPTH))
+        return InitError(strprintf(_("-prune must be 0 or at least %u blocks"), MIN_PRUNE_DEPTH));
+
+    nPruneDepth = nPrune;
+    if (nPruneDepth > 0) {
+        // the peers can download the recent blocks only
+        nLocalServices = (nLocalServices & ~NODE_NETWORK) | NODE_NETWORK_LIMITED;
+        LogPrint(BCLog::INFO, "Prune mode: keeping the block files of the last %u blocks\n", nPruneDepth);
+    }
+
+    // -replay only reads the datadir, the state is rolled back and replayed in memory
+    bool fReplay = SysCfg().IsArgCount("-replay");
+    int32_t nReplayFrom = 0, nReplayTo = 0;
+    if (fReplay) {
+        string strReplay = SysCfg().GetArg("-replay", "");
+        if (sscanf(strReplay.c_str(), "%d:%d", &nReplayFrom, &nReplayTo) != 2 || nReplayFrom < 1 ||
+            nReplayFrom > nReplayTo)
+            return InitError(strprintf(_("Invalid -replay range: '%s'"), strReplay));
+
+        if (SysCfg().IsReindex())
+            return InitError(_("-replay can't be used with -reindex"));
+    }
+
+    // -loadsnapshot only applies to an empty datadir, the state hash is the trust anchor of the snapshot
+    string strSnapshotFile = SysCfg().GetArg("-loadsnapshot", "");
+    uint256 snapshotHash;
+    if (!strSnapshotFile.empty()) {
+        string strSnapshotHash = SysCfg().GetArg("-snapshothash", "");
+        if (strSnapshotHash.size() != 64 || !IsHex(strSnapshotHash))
+            return InitError(_("-loadsnapshot needs the state hash of the snapshot in -snapshothash"));
+
+        if (SysCfg().IsReindex() || fReplay)
+            return InitError(_("-loadsnapshot can't be used with -reindex or -replay"));
+
+        snapshotHash.SetHex(strSnapshotHash);
+    }
+
+    // the block filter index is built from the genesis block, which a pruned node has no more
+    bool fBlockFilterIndex = SysCfg().GetBoolArg("-blockfilterindex", DEFAULT_BLOCKFILTERINDEX);
+    if (fBlockFilterIndex && (nPruneDepth > 0 || !strSnapshotFile.empty()))
+        return InitError(_("-blockfilterindex can't be used with -prune or -loadsnapshot"));
+
+    // the reindex reads the block files from blk00000.dat on, so the pruned ones can't be reindexed
+    if (SysCfg().IsReindex() && !filesystem::exists(blocksDir / "blk00000.dat") &&
+        filesystem::exists(blocksDir / "blk00001.dat"))
+        return InitError(_("The block files were pruned, remove the blocks directory to resync instead of -reindex"));
+
+    if (!fReplay) {
+        try {
+            pWalletMain = CWallet::GetInstance();
+            RegisterWallet(pWalletMain);
+            pWalletMain->LoadWallet(false);
+        } catch (std::exception &e) {
+            std::cout << "load wallet failed: " << e.what() << std::endl;
+        }
     }
 
     int64_t nStart = GetTimeMillis();
@@ -700,6 +785,17 @@ bool AppInit(boost::thread_group &threadGroup) {
 
                 mempool.SetMemPoolCache();
 
+                if (!strSnapshotFile.empty()) {
+                    if (pCdMan->pBlockCache->GetBestBlockHash().IsNull()) {
+                        if (!LoadStateSnapshot(strSnapshotFile, snapshotHash))
+                            return InitError(strprintf(_("Failed to load the snapshot %s, see the log for the details"),
+                                                       strSnapshotFile));
+                    } else {
+                        LogPrint(BCLog::INFO, "The datadir has a chain already, -loadsnapshot is ignored\n");
+                    }
+                    strSnapshotFile.clear();
+                }
+
                 if (!LoadBlockIndex()) {
                     strLoadError = _("Error loading block database");
                     break;
@@ -756,7 +852,87 @@ bool AppInit(boost::thread_group &threadGroup) {
         return false;
     }
 
-    LogPrint(BCLog::INFO, "Build %lu block indexes into memory (%lldms)\n", mapBlockIndex.size(), GetTimeMillis() - nStart);
+    LogPrint(BCLog::INFO, "Build %lu block indexes into memory (%lldms), resident memory %lluMB\n", mapBlockIndex.size(),
+             GetTimeMillis() - nStart, GetResidentMemory() >> 20);
+
+    // a node of pruned block files, by -prune or by a snapshot, serves the recent blocks only
+    if (fHavePruned)
+        nLocalServices = (nLocalServices & ~NODE_NETWORK) | NODE_NETWORK_LIMITED;
+
+    if (fReplay) {
+        CBlockReplayStats stats;
+        if (!ReplayBlocks(nReplayFrom, nReplayTo, stats))
+            return InitError(strprintf(_("Failed to replay the blocks %d..%d, see the log for the details"),
+                                       nReplayFrom, nReplayTo));
+
+        LogPrint(BCLog::INFO, "%s", stats.ToString());
+        StartShutdown();
+        return true;
+    }
+
+    // Rewrite the legacy utxo entries which carry no vout data, the state commitment is built
+    // again below when any moved
+    uint32_t migratedUtxoCount = 0;
+    if (SysCfg().IsTxIndex()) {
+        nStart = GetTimeMillis();
+        if (!pCdMan->pUtxoCache->MigrateLegacyUtxos(migratedUtxoCount))
+            return InitError(_("Failed to migrate the legacy utxo entries"));
+
+        if (migratedUtxoCount > 0)
+            LogPrint(BCLog::INFO, "Migrated %u legacy utxo entries (%lldms)\n", migratedUtxoCount, GetTimeMillis() - nStart);
+    }
+
+    // Split the legacy accounts into their info and token entries
+    nStart = GetTimeMillis();
+    uint32_t migratedAccountCount = 0;
+    if (!pCdMan->pAccountCache->MigrateLegacyAccounts(migratedAccountCount))
+        return InitError(_("Failed to migrate the legacy accounts"));
+
+    if (migratedAccountCount > 0)
+        LogPrint(BCLog::INFO, "Migrated %u legacy accounts (%lldms)\n", migratedAccountCount, GetTimeMillis() - nStart);
+
+    // Sum the account stats of an account db written before they were kept, migrated or marked for rebuild
+    nStart = GetTimeMillis();
+    if (!pCdMan->pAccountCache->BuildAccountStats(migratedAccountCount > 0))
+        return InitError(_("Failed to build the account stats"));
+    LogPrint(BCLog::INFO, "Checked the account stats (%lldms)\n", GetTimeMillis() - nStart);
+
+    // the commitment is built from the state dbs on the first start, then follows the blocks;
+    // the migrations above rewrote the committed entries, so it's built again after them
+    if (SysCfg().GetBoolArg("-statecommitment", DEFAULT_STATECOMMITMENT)) {
+        LOCK(cs_main);
+        fRecordStateDeltas = true;
+        pStateCommitment = new CStateCommitment();
+        if (!pStateCommitment->Init(chainActive.Tip() ? chainActive.Tip()->GetBlockHash() : uint256(),
+                                    migratedUtxoCount > 0 || migratedAccountCount > 0))
+            return InitError(_("Failed to load the state commitment"));
+    }
+
+    if (fBlockFilterIndex) {
+        if (fHavePruned)
+            return InitError(_("-blockfilterindex can't be used on a node of pruned block files"));
+
+        pBlockFilterIndex = new CBlockFilterIndex(SysCfg().IsReindex());
+        if (!pBlockFilterIndex->Init())
+            return InitError(_("Failed to load the block filter index"));
+
+        nLocalServices |= NODE_COMPACT_FILTERS;
+    }
+
+    // the events are published from the blocks connected after the start
+    int32_t nEventPort = SysCfg().GetArg("-eventport", 0);
+    if (nEventPort > 0) {
+        CService addrBind;
+        string strBind = SysCfg().GetArg("-eventbind", DEFAULT_EVENT_BIND);
+        if (!Lookup(strBind.c_str(), addrBind, nEventPort, false))
+            return InitError(strprintf(_("Cannot resolve -eventbind address: '%s'"), strBind));
+
+        string strError;
+        fRecordStateDeltas = true;
+        pEventPublisher = new CEventPublisher();
+        if (!pEventPublisher->Bind(addrBind, strError))
+            return InitError(strprintf(_("Failed to start the event publisher: %s"), strError));
+    }
 
     if (SysCfg().GetBoolArg("-printblockindex", false) || SysCfg().GetBoolArg("-printblocktree", false)) {
         PrintBlockTree();
@@ -766,7 +942,7 @@ bool AppInit(boost::thread_group &threadGroup) {
     if (SysCfg().IsArgCount("-printblock")) {
         string strMatch = SysCfg().GetArg("-printblock", "");
         int32_t nFound      = 0;
-        for (map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi) {
+        for (BlockMap::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi) {
             uint256 hash = (*mi).first;
             if (strncmp(hash.ToString().c_str(), strMatch.c_str(), strMatch.size()) == 0) {
                 CBlockIndex *pIndex = (*mi).second;
@@ -828,6 +1004,9 @@ bool AppInit(boost::thread_group &threadGroup) {
     }
     LogPrint(BCLog::INFO, "Added the latest %d blocks to price point memory cache (%dms)\n", nCount, GetTimeMillis() - nStart);
 
+    if (pWalletMain)
+        pWalletMain->BuildTxIndex();
+
     vector<boost::filesystem::path> vImportFiles;
     if (SysCfg().IsArgCount("-loadblock")) {
         vector<string> tmp = SysCfg().GetMultiArgs("-loadblock");
@@ -838,6 +1017,12 @@ bool AppInit(boost::thread_group &threadGroup) {
     }
     threadGroup.create_thread(boost::bind(&ThreadImport, vImportFiles));
 
+    if (pBlockFilterIndex != nullptr)
+        threadGroup.create_thread(&ThreadBlockFilterIndex);
+
+    if (pEventPublisher != nullptr)
+        threadGroup.create_thread(&ThreadEventPublisher);
+
 
     nStart = GetTimeMillis();
     {
@@ -854,6 +1039,7 @@ bool AppInit(boost::thread_group &threadGroup) {
 
     RandAddSeedPerfmon();
 
+    RegisterNodeMetrics();
     StartNode(threadGroup);
 
     if (SysCfg().IsServer()) {
@@ -17,6 +17,8 @@
 #include "miner/miner.h"
 #include "net.h"
 #include "tx/merkletx.h"
+#include "tx/txorphanpool.h"
+#include "commons/metrics.h"
 #include "commons/util/util.h"
 
 #include "commons/json/json_spirit_utils.h"
@@ -26,9 +28,13 @@
 #include "p2p/processmessage.hpp"
 #include "p2p/sendmessage.hpp"
 #include "chain/blockdelegates.h"
+#include "chain/eventpublisher.h"
+#include "chain/statecommitment.h"
 #include "persistence/blockundo.h"
+#include "persistence/snapshot.h"
 #include "tx/txserializer.h"
 
+#include <atomic>
 #include <sstream>
 #include <algorithm>
 #include <boost/algorithm/string/replace.hpp>
@@ -53,8 +59,11 @@ using namespace boost;
 CCacheDBManager *pCdMan = nullptr;
 CCriticalSection cs_main;
 CTxMemPool mempool;
-map<uint256, CBlockIndex *> mapBlockIndex;
+BlockMap mapBlockIndex;
+CBlockIndexArena blockIndexArena;
 int32_t nSyncTipHeight = 0;
+uint32_t nPruneDepth   = 0;
+bool fHavePruned       = false;
 string publicIp;
 map<uint256/* blockhash */, std::shared_ptr<CCacheWrapper>> mapForkCache;
 CSignatureCache signatureCache;
@@ -67,7 +76,11 @@ extern CPBFTMan pbftMan;
 
 map<uint256/* blockhash */, COrphanBlock *> mapOrphanBlocks;
 multimap<uint256/* blockhash */, COrphanBlock *> mapOrphanBlocksByPrev;
-map<uint256/* blockhash */, std::shared_ptr<CBaseTx> > mapOrphanTransactions;
+// copies of the tip height and the orphan block count for the metrics, updated under cs_main
+static std::atomic<int32_t> nMetricsTipHeight(-1);
+static std::atomic<uint32_t> nMetricsOrphanBlocks(0);
+// execution results of the self-produced block being processed, guarded by cs_main
+static std::shared_ptr<CBlockExecResult> spMinedBlockExecResult;
 extern CPBFTContext pbftContext ;
 const string strMessageMagic = "Coin Signed Message:\n";
 
@@ -97,6 +110,9 @@ namespace {
             mapBlocksToDownload.erase(hash);
 
         mapNodeState.erase(nodeid);
+
+        txReconTracker.Forget(nodeid);
+        orphanTxPool.EraseForPeer(nodeid);
     }
 
     struct CBlockIndexWorkComparator {
@@ -253,6 +269,7 @@ bool VerifySignature(const uint256 &sigHash, const std::vector<uint8_t> &signatu
 bool AcceptToMemoryPool(CTxMemPool &pool, CValidationState &state, CBaseTx *pBaseTx,
                         bool fLimitFree, bool fRejectInsaneFee) {
     AssertLockHeld(cs_main);
+    CMetricTimer timer(metrics::accept_to_mempool);
 
     // is it already in the memory pool?
     uint256 hash = pBaseTx->GetHash();
@@ -312,7 +329,55 @@ bool AcceptToMemoryPool(CTxMemPool &pool, CValidationState &state, CBaseTx *pBas
     if (fRejectInsaneFee && nFees > SysCfg().GetMaxFee())
         return ERRORMSG("AcceptToMemoryPool() : txid: %s pay insane fees, %d > %d", hash.GetHex(), nFees, SysCfg().GetMaxFee());
 
-    return pool.AddUnchecked(hash, entry, state);
+    if (!pool.AddUnchecked(hash, entry, state))
+        return false;
+
+    if (pEventPublisher != nullptr)
+        pEventPublisher->TxAccepted(*pBaseTx);
+
+    return true;
+}
+
+void ProcessOrphanTransactions(bool fBlockConnected) {
+    AssertLockHeld(cs_main);
+    orphanTxPool.Expire(GetTime());
+
+    // an accepted orphan may make the account another orphan waits for
+    bool fAccepted = true;
+    while (fAccepted && orphanTxPool.Size() > 0) {
+        fAccepted = false;
+        vector<COrphanTx> resolved;
+        orphanTxPool.TakeResolved(
+            [&](const COrphanTxDependency &dependency) {
+                if (!fBlockConnected && dependency.type != ORPHAN_DEPEND_ACCOUNT)
+                    return false;
+                return IsDependencyMet(dependency, *mempool.cw);
+            },
+            resolved);
+
+        for (const auto &orphan : resolved) {
+            uint256 txid = orphan.pTx->GetHash();
+            CValidationState state;
+            if (AcceptToMemoryPool(mempool, state, orphan.pTx.get(), true)) {
+                metrics::orphan_txs_resubmitted.Inc();
+                RelayTransaction(orphan.pTx.get(), txid);
+                LogPrint(BCLog::NET, "ProcessOrphanTransactions() : accepted orphan tx %s of peer=%d\n", txid.ToString(),
+                         orphan.fromPeer);
+                fAccepted = true;
+                continue;
+            }
+
+            // waits again if it misses another dependency
+            vector<COrphanTxDependency> dependencies;
+            if (IsMissingDependencyReject(state.GetRejectCode(), state.GetRejectReason()))
+                GetMissingDependencies(*orphan.pTx, *mempool.cw, dependencies);
+            if (dependencies.empty() ||
+                !orphanTxPool.AddTx(orphan.pTx, orphan.fromPeer, dependencies, orphan.nExpireTime)) {
+                LogPrint(BCLog::NET, "ProcessOrphanTransactions() : drop orphan tx %s of peer=%d: %s\n", txid.ToString(),
+                         orphan.fromPeer, state.GetRejectReason());
+            }
+        }
+    }
 }
 
 int32_t CMerkleTx::GetDepthInMainChainINTERNAL(CBlockIndex *&pindexRet) const {
@@ -322,7 +387,7 @@ int32_t CMerkleTx::GetDepthInMainChainINTERNAL(CBlockIndex *&pindexRet) const {
     AssertLockHeld(cs_main);
 
     // Find the block it claims to be in
-    map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(blockHash);
+    BlockMap::iterator mi = mapBlockIndex.find(blockHash);
     if (mi == mapBlockIndex.end())
         return 0;
 
@@ -446,6 +511,7 @@ bool static PruneOrphanBlocks(int32_t height) {
         ++beg;
     }
     mapOrphanBlocks.erase(hash);
+    nMetricsOrphanBlocks = mapOrphanBlocks.size();
     delete pOrphanBlock;
     return true;
 }
@@ -487,7 +553,7 @@ void CheckForkWarningConditions() {
             string strCmd = SysCfg().GetArg("-alertnotify", "");
             if (!strCmd.empty()) {
                 string warning = string("'Warning: Large-work fork detected, forking after block ") +
-                                 pIndexBestForkBase->pBlockHash->ToString() + string("'");
+                                 pIndexBestForkBase->GetBlockHash().ToString() + string("'");
                 boost::replace_all(strCmd, "%s", warning);
                 boost::thread t(runCommand, strCmd);  // thread runs free
             }
@@ -497,8 +563,8 @@ void CheckForkWarningConditions() {
                      "CheckForkWarningConditions: Warning: Large valid fork found\n"
                      "  forking from height %d (%s)\n"
                      "  lasting to   height %d (%s)\n",
-                     pIndexBestForkBase->height, pIndexBestForkBase->pBlockHash->ToString(),
-                     pIndexBestForkTip->height, pIndexBestForkTip->pBlockHash->ToString());
+                     pIndexBestForkBase->height, pIndexBestForkBase->GetBlockHash().ToString(),
+                     pIndexBestForkTip->height, pIndexBestForkTip->GetBlockHash().ToString());
 
             fLargeWorkForkFound = true;
         } else {
@@ -644,8 +710,8 @@ bool ReconsiderBlock(CValidationState &state, CBlockIndex *pIndex) {
     AssertLockHeld(cs_main);
 
     // Remove the invalidity flag from this block and all its descendants.
-    map<uint256, CBlockIndex *>::const_iterator it = mapBlockIndex.begin();
-    int32_t height                                    = pIndex->height;
+    BlockMap::const_iterator it = mapBlockIndex.begin();
+    int32_t height              = pIndex->height;
     while (it != mapBlockIndex.end()) {
         if (it->second->nStatus & BLOCK_FAILED_MASK && it->second->GetAncestor(height) == pIndex) {
             it->second->nStatus &= ~BLOCK_FAILED_MASK;
@@ -1009,15 +1075,32 @@ static bool ComputeVoteStakingInterestAndRevokeVotes(const int32_t currHeight, c
     return true;
 }
 
-bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValidationState &state, bool fJustCheck) {
+// the stats of the running ReplayBlocks(), guarded by cs_main
+static CBlockReplayStats *pReplayStats = nullptr;
+
+bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValidationState &state, bool fJustCheck,
+                  const CBlockExecResult *pExecResult, CDbStateDeltaMap *pStateDeltas) {
     AssertLockHeld(cs_main);
+    CMetricTimer timer(metrics::connect_block);
 
     bool isGensisBlock = block.GetHeight() == 0 && block.GetHash() == SysCfg().GetGenesisBlockHash();
 
-    // Check it again in case a previous version let a bad block in
-    if (!isGensisBlock && !CheckBlock(block, state, cw, !fJustCheck, !fJustCheck))
+    // Check it again in case a previous version let a bad block in.
+    // Txs executed by the miner have been checked already when packing.
+    bool fCheckTx = !fJustCheck && pExecResult == nullptr;
+    if (!isGensisBlock && !CheckBlock(block, state, cw, fCheckTx, !fJustCheck))
         return state.DoS(100, ERRORMSG("ConnectBlock() : check block error"), REJECT_INVALID, "check-block-error");
 
+    // but the reward tx is made after packing
+    if (!isGensisBlock && !fJustCheck && pExecResult != nullptr) {
+        // the same context the reward tx is executed with below
+        uint32_t prevBlockTime = pIndex->pprev != nullptr ? pIndex->pprev->GetBlockTime() : pIndex->GetBlockTime();
+        CTxExecuteContext context(pIndex->height, 0, pIndex->nFuelRate, pIndex->nTime, prevBlockTime, &cw, &state);
+        if (!block.vptx[0]->CheckTx(context))
+            return state.DoS(100, ERRORMSG("ConnectBlock() : CheckTx failed, txid: %s",
+                             block.vptx[0]->GetHash().GetHex()), REJECT_INVALID, "bad-reward-tx");
+    }
+
     if (!fJustCheck) {
         // Verify that the cache's current state corresponds to the previous block
         uint256 hashPrevBlock = pIndex->pprev == nullptr ? uint256() : pIndex->pprev->GetBlockHash();
@@ -1071,14 +1154,15 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
 
     // Re-compute reward values and total fuel
     uint64_t totalFuel                 = 0;
+    uint64_t totalRunStep              = 0;
     map<TokenSymbol, uint64_t> rewards = {{SYMB::WICC, 0}, {SYMB::WUSD, 0}};  // Only allow WICC/WUSD as fees type.
+    map<TokenSymbol, uint64_t> totalFees;
 
     if (block.vptx.size() > 1) {
         assert(mapBlockIndex.count(cw.blockCache.GetBestBlockHash()));
         int32_t curHeight     = mapBlockIndex[cw.blockCache.GetBestBlockHash()]->height;
         int32_t validHeight   = SysCfg().GetTxCacheHeight();
         uint32_t fuelRate     = block.GetFuelRate();
-        uint64_t totalRunStep = 0;
 
         for (int32_t index = 1; index < (int32_t)block.vptx.size(); ++index) {
             std::shared_ptr<CBaseTx> &pBaseTx = block.vptx[index];
@@ -1091,15 +1175,27 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
                                  pBaseTx->GetHash().GetHex()), REJECT_INVALID, "tx-invalid-height");
 
             pBaseTx->nFuelRate = fuelRate;
-            CTxUndoOpLogger opLogger(cw, pBaseTx->GetHash(), blockUndo);
+            if (pExecResult != nullptr) {
+                // executed by the miner on the same state, the changes are in the base cache of cw already
+                blockUndo.vtxundo.push_back(pExecResult->block_undo.vtxundo[index - 1]);
+            } else {
+                CTxUndoOpLogger opLogger(cw, pBaseTx->GetHash(), blockUndo);
+
+                int64_t nTxStart = pReplayStats != nullptr ? GetTimeMicros() : 0;
+                uint32_t prevBlockTime = pIndex->pprev != nullptr ? pIndex->pprev->GetBlockTime() : pIndex->GetBlockTime();
+                CTxExecuteContext context(pIndex->height, index, fuelRate, pIndex->nTime, prevBlockTime, &cw, &state);
+                if (!pBaseTx->ExecuteTx(context)) {
+                    pCdMan->pLogCache->SetExecuteFail(pIndex->height, pBaseTx->GetHash(), state.GetRejectCode(),
+                                                      state.GetRejectReason());
+                    return state.DoS(100, ERRORMSG("ConnectBlock() : txid=%s execute failed, in detail: %s",
+                                     pBaseTx->GetHash().GetHex(), pBaseTx->ToString(cw.accountCache)), REJECT_INVALID, "tx-execute-failed");
+                }
 
-            uint32_t prevBlockTime = pIndex->pprev != nullptr ? pIndex->pprev->GetBlockTime() : pIndex->GetBlockTime();
-            CTxExecuteContext context(pIndex->height, index, fuelRate, pIndex->nTime, prevBlockTime, &cw, &state);
-            if (!pBaseTx->ExecuteTx(context)) {
-                pCdMan->pLogCache->SetExecuteFail(pIndex->height, pBaseTx->GetHash(), state.GetRejectCode(),
-                                                  state.GetRejectReason());
-                return state.DoS(100, ERRORMSG("ConnectBlock() : txid=%s execute failed, in detail: %s",
-                                 pBaseTx->GetHash().GetHex(), pBaseTx->ToString(cw.accountCache)), REJECT_INVALID, "tx-execute-failed");
+                if (pReplayStats != nullptr) {
+                    auto &timing = pReplayStats->tx_types[pBaseTx->nTxType];
+                    timing.count++;
+                    timing.time += GetTimeMicros() - nTxStart;
+                }
             }
 
             vPos.push_back(make_pair(pBaseTx->GetHash(), pos));
@@ -1117,6 +1213,7 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
             auto fees = std::get<1>(pBaseTx->GetFees());
             assert(fees >= fuel);
             rewards[fees_symbol] += (fees - fuel);
+            totalFees[fees_symbol] += fees;
 
             pos.nTxOffset += ::GetSerializeSize(pBaseTx, SER_DISK, CLIENT_VERSION);
 
@@ -1249,6 +1346,22 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
             return state.Abort(_("ConnectBlock() : failed to write block index"));
     }
 
+    if (!pIndex->HasSummary()) {
+        CBlockSummary summary;
+        summary.fees           = totalFees;
+        summary.reward_fees    = rewards;
+        summary.run_steps      = totalRunStep;
+        summary.block_size     = ::GetSerializeSize(block, SER_DISK, CLIENT_VERSION);
+        if (block.vptx[0]->nTxType == UCOIN_BLOCK_REWARD_TX)
+            summary.inflated_bcoins = ((CUCoinBlockRewardTx *)block.vptx[0].get())->inflated_bcoins;
+        for (const auto &pBaseTx : block.vptx)
+            summary.tx_type_counts[pBaseTx->nTxType]++;
+
+        if (!pCdMan->pBlockIndexDb->WriteBlockSummary(pIndex->GetBlockHash(), summary))
+            return state.Abort(_("ConnectBlock() : failed to write block summary"));
+        pIndex->SetSummary(summary);
+    }
+
     if (!cw.txCache.AddBlockTx(block)) {
         return state.Abort(_("ConnectBlock() : failed add block into transaction memory cache"));
     }
@@ -1294,11 +1407,21 @@ bool ConnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValida
     // Set best block to current account cache.
     cw.blockCache.SetBestBlock(pIndex->GetBlockHash());
 
+    if (pStateDeltas != nullptr) {
+        for (const auto &txUndo : blockUndo.vtxundo) {
+            for (const auto &deltasItem : txUndo.dbOpLogMap.GetStateDeltas()) {
+                for (const auto &item : deltasItem.second)
+                    (*pStateDeltas)[deltasItem.first][item.first] = item.second;
+            }
+        }
+    }
+
     return true;
 }
 
 // Update the on-disk chain state.
 bool static WriteChainState(CValidationState &state) {
+    CMetricTimer timer(metrics::write_chain_state);
     static int64_t nLastWrite = 0;
     uint32_t cacheSize        =
         pCdMan->pSysParamCache->GetCacheSize() +
@@ -1311,7 +1434,8 @@ bool static WriteChainState(CValidationState &state) {
         pCdMan->pDexCache->GetCacheSize() +
         pCdMan->pBlockCache->GetCacheSize() +
         pCdMan->pLogCache->GetCacheSize() +
-        pCdMan->pReceiptCache->GetCacheSize();
+        pCdMan->pReceiptCache->GetCacheSize() +
+        pCdMan->pStateCommitCache->GetCacheSize();
 
     if (!IsInitialBlockDownload() || cacheSize > SysCfg().GetCacheSize() ||
         GetTimeMicros() > nLastWrite + 60 * 1000000) {
@@ -1324,6 +1448,8 @@ bool static WriteChainState(CValidationState &state) {
             return state.Error("out of disk space");
 
         FlushBlockFile();
+        if (nPruneDepth > 0 && !PruneBlockFiles())
+            return state.Abort(_("Failed to prune the block files"));
         // pCdMan->pBlockCache->Sync();
         pCdMan->Flush();
         mapForkCache.clear();
@@ -1335,6 +1461,7 @@ bool static WriteChainState(CValidationState &state) {
 // Update chainActive and related internal data structures.
 void static UpdateTip(CBlockIndex *pIndexNew, const CBlock &block) {
     chainActive.SetTip(pIndexNew);
+    nMetricsTipHeight = chainActive.Height();
 
     SyncTransaction(uint256(), nullptr, &block);
 
@@ -1386,6 +1513,10 @@ bool static DisconnectTip(CValidationState &state) {
         // Need to re-sync all to global cache layer.
         spCW->Flush();
 
+        // outside of the consensus, a failure leaves the commitment stale till the next start
+        if (pStateCommitment != nullptr)
+            pStateCommitment->DisconnectBlock(pIndexDelete);
+
         // Attention: need to reset the lastest block price median
         CBlockIndex *pPreBlockIndex = pIndexDelete->pprev;
         CBlock preBlock;
@@ -1402,6 +1533,8 @@ bool static DisconnectTip(CValidationState &state) {
         return false;
     // Update chainActive and related variables.
     UpdateTip(pIndexDelete->pprev, block);
+    if (pEventPublisher != nullptr)
+        pEventPublisher->BlockDisconnected(block, pIndexDelete);
     // Resurrect mempool transactions from the disconnected block.
     for (const auto &pTx : block.vptx) {
         list<std::shared_ptr<CBaseTx> > removed;
@@ -1421,18 +1554,35 @@ bool static DisconnectTip(CValidationState &state) {
 // Connect a new block to chainActive.
 bool static ConnectTip(CValidationState &state, CBlockIndex *pIndexNew) {
     assert(pIndexNew->pprev == chainActive.Tip());
+
+    // Reuse the execution results of the miner if the block was produced by this node on the current tip.
+    std::shared_ptr<CBlockExecResult> spExecResult;
+    if (spMinedBlockExecResult && spMinedBlockExecResult->block.GetHash() == pIndexNew->GetBlockHash()) {
+        if (spMinedBlockExecResult->Verify(pIndexNew) &&
+            spMinedBlockExecResult->prev_block_hash == pCdMan->pBlockCache->GetBestBlockHash()) {
+            spExecResult = spMinedBlockExecResult;
+        } else {
+            LogPrint(BCLog::INFO, "ConnectTip() : mismatched execution results of mined block %s, execute it again\n",
+                     pIndexNew->GetBlockHash().ToString());
+        }
+    }
+
     // Read block from disk.
     CBlock block;
-    if (!ReadBlockFromDisk(pIndexNew, block))
+    if (spExecResult) {
+        block = spExecResult->block;
+    } else if (!ReadBlockFromDisk(pIndexNew, block))
         return state.Abort(strprintf("Failed to read block hash: %s", pIndexNew->GetBlockHash().GetHex()));
 
     // Apply the block automatically to the chain state.
     int64_t nStart = GetTimeMicros();
+    CDbStateDeltaMap stateDeltas;
     {
         CInv inv(MSG_BLOCK, pIndexNew->GetBlockHash());
 
-        auto spCW = std::make_shared<CCacheWrapper>(pCdMan);
-        if (!ConnectBlock(block, *spCW, pIndexNew, state)) {
+        auto spCW = spExecResult ? std::make_shared<CCacheWrapper>(spExecResult->spCW.get())
+                                 : std::make_shared<CCacheWrapper>(pCdMan);
+        if (!ConnectBlock(block, *spCW, pIndexNew, state, false, spExecResult.get(), &stateDeltas)) {
             if (state.IsInvalid()) {
                 InvalidBlockFound(pIndexNew, state);
             }
@@ -1446,6 +1596,12 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pIndexNew) {
 
         // Need to re-sync all to global cache layer.
         spCW->Flush();
+        if (spExecResult)
+            spExecResult->spCW->Flush();
+
+        // outside of the consensus, a failure leaves the commitment stale till the next start
+        if (pStateCommitment != nullptr)
+            pStateCommitment->ConnectBlock(pIndexNew, stateDeltas);
     }
 
     if (SysCfg().IsBenchmark())
@@ -1457,9 +1613,11 @@ bool static ConnectTip(CValidationState &state, CBlockIndex *pIndexNew) {
 
     // Update chainActive & related variables.
     UpdateTip(pIndexNew, block);
+    if (pEventPublisher != nullptr)
+        pEventPublisher->BlockConnected(block, pIndexNew, stateDeltas);
 
     for (auto &pTxItem : block.vptx) {
-        mempool.memPoolTxs.erase(pTxItem->GetHash());
+        mempool.Erase(pTxItem->GetHash());
     }
     return true;
 }
@@ -1622,6 +1780,8 @@ bool ActivateBestChain(CValidationState &state, CBlockIndex* pNewIndex) {
         }
 
        // chainActive.UpdateFinalityBlock();
+
+        ProcessOrphanTransactions(true);
     }
 
     return true;
@@ -1634,17 +1794,16 @@ bool AddToBlockIndex(CBlock &block, CValidationState &state, const CDiskBlockPos
         return state.Invalid(ERRORMSG("AddToBlockIndex() : %s already exists", hash.ToString()), 0, "duplicate");
 
     // Construct new block index object
-    CBlockIndex *pIndexNew = new CBlockIndex(block);
+    CBlockIndex *pIndexNew = blockIndexArena.New(block);
 
     assert(pIndexNew);
     {
         LOCK(cs_nBlockSequenceId);
         pIndexNew->nSequenceId = nBlockSequenceId++;
     }
-    map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.insert(make_pair(hash, pIndexNew)).first;
-    // LogPrint(BCLog::INFO, "in map hash:%s map size:%d\n", hash.GetHex(), mapBlockIndex.size());
-    pIndexNew->pBlockHash                        = &((*mi).first);
-    map<uint256, CBlockIndex *>::iterator miPrev = mapBlockIndex.find(block.GetPrevBlockHash());
+    pIndexNew->blockHash      = hash;
+    mapBlockIndex.insert(pIndexNew);
+    BlockMap::iterator miPrev = mapBlockIndex.find(block.GetPrevBlockHash());
     if (miPrev != mapBlockIndex.end()) {
         pIndexNew->pprev  = (*miPrev).second;
         pIndexNew->height = pIndexNew->pprev->height + 1;
@@ -1652,9 +1811,9 @@ bool AddToBlockIndex(CBlock &block, CValidationState &state, const CDiskBlockPos
     }
 
     if(block.GetHeight() == 0 )
-        pIndexNew->miner = CRegID("0-1");
+        pIndexNew->SetMiner(CRegID("0-1"));
     else
-        pIndexNew->miner = block.vptx[0]->txUid.get<CRegID>();
+        pIndexNew->SetMiner(block.vptx[0]->txUid.get<CRegID>());
     pIndexNew->nTx        = block.vptx.size();
     pIndexNew->nChainWork = pIndexNew->height;
     pIndexNew->nChainTx   = (pIndexNew->pprev ? pIndexNew->pprev->nChainTx : 0) + pIndexNew->nTx;
@@ -1887,6 +2046,7 @@ bool ProcessForkedChain(const CBlock &block, CBlockIndex *pPreBlockIndex, CValid
 }
 
 bool CheckBlock(const CBlock &block, CValidationState &state, CCacheWrapper &cw, bool fCheckTx, bool fCheckMerkleRoot) {
+    CMetricTimer timer(metrics::check_block);
     if (block.vptx.empty() || block.vptx.size() > MAX_BLOCK_SIZE ||
         ::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION) > MAX_BLOCK_SIZE)
         return state.DoS(100, ERRORMSG("CheckBlock() : size limits failed"), REJECT_INVALID, "bad-blk-length");
@@ -1980,7 +2140,7 @@ bool AcceptBlock(CBlock &block, CValidationState &state, CDiskBlockPos *dbp, boo
     CBlockIndex *pPrevBlockIndex = nullptr;
     int32_t height = 0;
     if (block.GetHeight() != 0 || blockHash != SysCfg().GetGenesisBlockHash()) {
-        map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(block.GetPrevBlockHash());
+        BlockMap::iterator mi = mapBlockIndex.find(block.GetPrevBlockHash());
         if (mi == mapBlockIndex.end())
             return state.DoS(10, ERRORMSG("AcceptBlock() : prev block not found"), 0, "bad-prevblk");
 
@@ -2039,11 +2199,16 @@ bool AcceptBlock(CBlock &block, CValidationState &state, CDiskBlockPos *dbp, boo
     CBlockIndex* pTip = chainActive.Tip() ;
     if (pTip->GetBlockHash() == blockHash) {
         {
+            // the block pushed to all the peers is encoded once
+            CEncodedMessageRef spBlockMessage;
+            if (mining)
+                spBlockMessage = CEncodedMessage::Make(NetMsgType::BLOCK, block);
+
             LOCK(cs_vNodes);
             for (auto pNode : vNodes) {
                 //p2p_xiaoyu_20191116
                 if (mining) {
-                    pNode->PushMessage(NetMsgType::BLOCK, block);
+                    pNode->PushEncodedMessage(spBlockMessage);
                     continue;
                 }
                 if (chainActive.Height() > (pNode->nStartingHeight != -1 ? pNode->nStartingHeight - 2000 : 0))
@@ -2054,6 +2219,7 @@ bool AcceptBlock(CBlock &block, CValidationState &state, CDiskBlockPos *dbp, boo
         VoteDelegateVector delegates;
         if (pCdMan->pDelegateCache->GetActiveDelegates(delegates)) {
             pbftContext.SaveMinersByHash(blockHash, delegates);
+            UpdateDelegateKeys(delegates);
         }
 
         BroadcastBlockConfirm(pTip) ;
@@ -2232,6 +2398,7 @@ bool ProcessBlock(CValidationState &state, CNode *pFrom, CBlock *pBlock, CDiskBl
                 pblock2->prevBlockHash = pBlock->GetPrevBlockHash();
                 pblock2->height        = pBlock->GetHeight();
                 mapOrphanBlocks.insert(make_pair(blockHash, pblock2));
+                nMetricsOrphanBlocks = mapOrphanBlocks.size();
                 mapOrphanBlocksByPrev.insert(make_pair(pblock2->prevBlockHash, pblock2));
                 setOrphanBlock.insert(pblock2);
             }
@@ -2285,11 +2452,23 @@ bool ProcessBlock(CValidationState &state, CNode *pFrom, CBlock *pBlock, CDiskBl
         }
         mapOrphanBlocksByPrev.erase(prevBlockHash);
     }
+    nMetricsOrphanBlocks = mapOrphanBlocks.size();
 
     LogPrint(BCLog::INFO, "ProcessBlock[%d] elapse time:%lld ms\n", pBlock->GetHeight(), GetTimeMillis() - llBeginTime);
     return true;
 }
 
+bool ProcessMinedBlock(CValidationState &state, CBlock *pBlock, const std::shared_ptr<CBlockExecResult> &spExecResult) {
+    AssertLockHeld(cs_main);
+
+    spMinedBlockExecResult = spExecResult;
+    bool ret               = ProcessBlock(state, nullptr, pBlock);
+    // the cache of the results is based on the old tip, never keep it
+    spMinedBlockExecResult = nullptr;
+
+    return ret;
+}
+
 bool AbortNode(const string &strMessage) {
     strMiscWarning = strMessage;
     LogPrint(BCLog::ERROR, "Detect abort ERROR! *** %s\n", strMessage);
@@ -2308,6 +2487,75 @@ bool CheckDiskSpace(uint64_t nAdditionalBytes) {
     return true;
 }
 
+bool PruneBlockFiles() {
+    AssertLockHeld(cs_main);
+    if (chainActive.Tip() == nullptr)
+        return true;
+
+    // the blocks of the retention depth stay for the reorgs, and no file reaches the global finality block
+    CBlockIndex *pFinIndex = pbftMan.GetGlobalFinIndex();
+    int32_t pruneHeight    = GetPruneHeight(chainActive.Height(), nPruneDepth, pFinIndex ? pFinIndex->height : -1);
+
+    // the files below it were all pruned by the previous calls
+    static int32_t nFirstUnprunedFile = 0;
+
+    set<int32_t> prunedFiles;
+    {
+        LOCK(cs_LastBlockFile);
+        vector<CBlockFileInfo> infos;
+        for (int32_t nFile = nFirstUnprunedFile; nFile < nLastBlockFile; nFile++) {
+            infos.emplace_back();
+            if (!pCdMan->pBlockIndexDb->ReadBlockFileInfo(nFile, infos.back()))
+                return ERRORMSG("%s() : read the info of block file %d failed", __func__, nFile);
+        }
+        SelectBlockFilesToPrune(infos, pruneHeight, nFirstUnprunedFile, prunedFiles);
+    }
+    if (prunedFiles.empty())
+        return true;
+
+    // the index forgets the data before the files go, so a crash in between leaves only orphan files;
+    // the pruned flag is on the disk before any of it, the cache is flushed only after the files go
+    if (!fHavePruned) {
+        if (!pCdMan->pBlockCache->WriteFlag("prunedblockfiles", true) || !pCdMan->pBlockCache->FlushFlags())
+            return ERRORMSG("%s() : write the pruned flag failed", __func__);
+        fHavePruned = true;
+    }
+    for (const auto &item : mapBlockIndex) {
+        CBlockIndex *pIndex = item.second;
+        if (pIndex == nullptr || !(pIndex->nStatus & BLOCK_HAVE_MASK) || !prunedFiles.count(pIndex->nFile))
+            continue;
+
+        pIndex->nStatus &= ~BLOCK_HAVE_MASK;
+        pIndex->nFile    = 0;
+        pIndex->nDataPos = 0;
+        pIndex->nUndoPos = 0;
+        if (!pCdMan->pBlockIndexDb->WriteBlockIndex(CDiskBlockIndex(pIndex)))
+            return ERRORMSG("%s() : write the block index %s failed", __func__, pIndex->GetIndentityString());
+    }
+    for (int32_t nFile : prunedFiles) {
+        if (!pCdMan->pBlockIndexDb->WriteBlockFileInfo(nFile, CBlockFileInfo()))
+            return ERRORMSG("%s() : write the info of block file %d failed", __func__, nFile);
+
+        RemoveBlockFiles(nFile);
+    }
+    LogPrint(BCLog::INFO, "Pruned %u block files below height %d\n", prunedFiles.size(), pruneHeight);
+
+    return true;
+}
+
+bool IsBlockPruned(const CBlockIndex *pIndex) {
+    return fHavePruned && !(pIndex->nStatus & BLOCK_HAVE_DATA);
+}
+
+bool IsBlockFilePruned(int32_t nFile) {
+    if (!fHavePruned)
+        return false;
+
+    LOCK(cs_LastBlockFile);
+    CBlockFileInfo info;
+    return nFile < nLastBlockFile && pCdMan->pBlockIndexDb->ReadBlockFileInfo(nFile, info) && info.nSize == 0;
+}
+
 bool static LoadBlockIndexDB() {
     if (!pCdMan->pBlockIndexDb->LoadBlockIndexes())
         return ERRORMSG("%s(), LoadBlockIndexes from db failed", __FUNCTION__);
@@ -2335,6 +2583,11 @@ bool static LoadBlockIndexDB() {
             pIndex->BuildSkip();
     }
 
+    // Check whether some block files were pruned
+    pCdMan->pBlockCache->ReadFlag("prunedblockfiles", fHavePruned);
+    if (fHavePruned)
+        LogPrint(BCLog::INFO, "LoadBlockIndexDB(): some block files were pruned\n");
+
     // Load block file info
     pCdMan->pBlockCache->ReadLastBlockFile(nLastBlockFile);
     LogPrint(BCLog::INFO, "LoadBlockIndexDB(): last block file = %i\n", nLastBlockFile);
@@ -2363,6 +2616,7 @@ bool static LoadBlockIndexDB() {
     }
 
     chainActive.SetTip(it->second);
+    nMetricsTipHeight = chainActive.Height();
   //  chainActive.UpdateFinalityBlock();
     LogPrint(BCLog::INFO, "LoadBlockIndexDB(): hashBestChain=%s height=%d date=%s\n",
              chainActive.Tip()->GetBlockHash().ToString(), chainActive.Height(),
@@ -2398,6 +2652,10 @@ bool VerifyDB(int32_t nCheckLevel, int32_t nCheckDepth) {
         if (pIndex->height < chainActive.Height() - nCheckDepth)
             break;
 
+        // the pruned blocks and the ones below a loaded snapshot have no data to check
+        if (IsBlockPruned(pIndex))
+            break;
+
         CBlock block;
         // check level 0: read from disk
         if (!ReadBlockFromDisk(pIndex, block))
@@ -2462,10 +2720,404 @@ bool VerifyDB(int32_t nCheckLevel, int32_t nCheckDepth) {
     return true;
 }
 
+string CBlockReplayStats::ToString() const {
+    int64_t readTime = 0, connectTime = 0;
+    uint32_t txCount = 0;
+    for (const auto &timing : blocks) {
+        readTime += timing.read_time;
+        connectTime += timing.connect_time;
+        txCount += timing.tx_count;
+    }
+
+    string str = strprintf("replayed blocks %d..%d: %u blocks, %u txs\n", from_height, to_height, blocks.size(), txCount);
+    str += strprintf("  rollback: %.2fms, %llu leveldb reads\n", 0.001 * rollback_time, rollback_db_reads);
+    str += strprintf("  read blocks: %.2fms\n", 0.001 * readTime);
+    str += strprintf("  connect blocks: %.2fms (%.3fms/block, %.3fms/tx)\n", 0.001 * connectTime,
+                     blocks.empty() ? 0 : 0.001 * connectTime / blocks.size(), txCount == 0 ? 0 : 0.001 * connectTime / txCount);
+    str += strprintf("  cache reads: %llu, missed to leveldb: %llu (hit rate %.2f%%)\n", cache_reads, cache_db_reads,
+                     cache_reads == 0 ? 0 : 100.0 * (cache_reads - cache_db_reads) / cache_reads);
+    str += strprintf("  leveldb reads: %llu, %llu bytes\n", db_reads, db_read_bytes);
+    for (const auto &item : tx_types) {
+        str += strprintf("  %-28s %8u txs %12.2fms %10.3fms/tx\n", GetTxTypeName(item.first), item.second.count,
+                         0.001 * item.second.time, 0.001 * item.second.time / item.second.count);
+    }
+    return str;
+}
+
+bool ReplayBlocks(int32_t fromHeight, int32_t toHeight, CBlockReplayStats &stats) {
+    LOCK(cs_main);
+    if (fromHeight < 1 || fromHeight > toHeight || toHeight > chainActive.Height())
+        return ERRORMSG("ReplayBlocks() : invalid range %d..%d, the active chain height is %d", fromHeight, toHeight,
+                        chainActive.Height());
+
+    stats             = CBlockReplayStats();
+    stats.from_height = fromHeight;
+    stats.to_height   = toHeight;
+    CValidationState state;
+
+    // roll the state back in memory, the same way as VerifyDB() does, on a layer reading the dbs
+    // directly: the undo writes no more than the rolled back entries, and the entries the node's
+    // caches hold already are read from the dbs again like a node catching up
+    auto spRollbackCW = std::make_shared<CCacheWrapper>();
+    spRollbackCW->ReadDbsFrom(pCdMan);
+    uint64_t dbReads  = metrics::leveldb_reads.Get();
+    int64_t nStart    = GetTimeMicros();
+    for (CBlockIndex *pIndex = chainActive.Tip(); pIndex->height >= fromHeight; pIndex = pIndex->pprev) {
+        boost::this_thread::interruption_point();
+        if (IsBlockPruned(pIndex))
+            return ERRORMSG("ReplayBlocks() : the block %d was pruned", pIndex->height);
+
+        CBlock block;
+        if (!ReadBlockFromDisk(pIndex, block))
+            return ERRORMSG("ReplayBlocks() : ReadBlockFromDisk failed at %d, hash=%s", pIndex->height,
+                            pIndex->GetBlockHash().ToString());
+
+        bool fClean = true;
+        if (!DisconnectBlock(block, *spRollbackCW, pIndex, state, &fClean) || !fClean)
+            return ERRORMSG("ReplayBlocks() : failed to disconnect the block %d, hash=%s", pIndex->height,
+                            pIndex->GetBlockHash().ToString());
+    }
+    stats.rollback_time     = GetTimeMicros() - nStart;
+    stats.rollback_db_reads = metrics::leveldb_reads.Get() - dbReads;
+
+    // connect the blocks on a layer of their own, the rolled back state stays as the base of it;
+    // both layers are thrown away, nothing reaches the dbs
+    auto spReplayCW       = std::make_shared<CCacheWrapper>(spRollbackCW.get());
+    uint64_t cacheReads   = metrics::cache_reads.Get();
+    uint64_t cacheDbReads = metrics::cache_db_reads.Get();
+    uint64_t dbReadBytes  = metrics::leveldb_read_bytes.Get();
+    dbReads               = metrics::leveldb_reads.Get();
+    pReplayStats          = &stats;
+    bool ret = true;
+    for (int32_t height = fromHeight; height <= toHeight; height++) {
+        if (ShutdownRequested()) {
+            ret = ERRORMSG("ReplayBlocks() : interrupted at %d", height);
+            break;
+        }
+
+        CBlockIndex *pIndex = chainActive[height];
+        CBlockReplayStats::CBlockTiming timing;
+        timing.height = height;
+
+        nStart = GetTimeMicros();
+        CBlock block;
+        if (!ReadBlockFromDisk(pIndex, block)) {
+            ret = ERRORMSG("ReplayBlocks() : ReadBlockFromDisk failed at %d, hash=%s", height,
+                           pIndex->GetBlockHash().ToString());
+            break;
+        }
+        timing.read_time = GetTimeMicros() - nStart;
+
+        nStart = GetTimeMicros();
+        if (!ConnectBlock(block, *spReplayCW, pIndex, state, false)) {
+            ret = ERRORMSG("ReplayBlocks() : failed to connect the block %d, hash=%s", height,
+                           pIndex->GetBlockHash().ToString());
+            break;
+        }
+        timing.connect_time = GetTimeMicros() - nStart;
+        timing.tx_count     = block.vptx.size();
+        stats.blocks.push_back(timing);
+
+        LogPrint(BCLog::INFO, "ReplayBlocks() : block %d, %u txs, read %.2fms, connect %.2fms\n", height,
+                 timing.tx_count, 0.001 * timing.read_time, 0.001 * timing.connect_time);
+    }
+    pReplayStats = nullptr;
+
+    stats.cache_reads    = metrics::cache_reads.Get() - cacheReads;
+    stats.cache_db_reads = metrics::cache_db_reads.Get() - cacheDbReads;
+    stats.db_reads       = metrics::leveldb_reads.Get() - dbReads;
+    stats.db_read_bytes  = metrics::leveldb_read_bytes.Get() - dbReadBytes;
+    return ret;
+}
+
+bool ExportStateSnapshot(const string &fileName, CSnapshotHeader &header, uint256 &stateHash) {
+    // the snapshots of the dbs are released however the export ends
+    struct CDbSnapshots {
+        vector<pair<CDBAccess *, const leveldb::Snapshot *>> items;
+        ~CDbSnapshots() {
+            for (const auto &item : items)
+                item.first->ReleaseSnapshot(item.second);
+        }
+    } dbSnapshots;
+    vector<CBlockIndex *> chain;
+
+    // the barrier: the caches go to the dbs, which are read from their snapshots of the tip afterwards
+    {
+        LOCK(cs_main);
+        if (chainActive.Tip() == nullptr)
+            return ERRORMSG("%s() : no active chain", __func__);
+
+        pCdMan->Flush();
+        for (DBNameType dbName : kSnapshotDbNames) {
+            CDBAccess *pDbAccess = pCdMan->GetDbAccess(dbName);
+            dbSnapshots.items.push_back(make_pair(pDbAccess, pDbAccess->GetSnapshot()));
+        }
+
+        header.network     = SysCfg().NetworkID();
+        header.height      = chainActive.Height();
+        header.block_hash  = chainActive.Tip()->GetBlockHash();
+        header.block_count = std::min<uint32_t>(SNAPSHOT_BLOCK_DEPTH, header.height + 1);
+        chain.resize(header.height + 1);
+        for (CBlockIndex *pIndex = chainActive.Tip(); pIndex != nullptr; pIndex = pIndex->pprev)
+            chain[pIndex->height] = pIndex;
+    }
+
+    CBlockIndex *pFirstBlockIndex = chain[header.height + 1 - header.block_count];
+    if (IsBlockPruned(pFirstBlockIndex))
+        return ERRORMSG("%s() : the block %d was pruned", __func__, pFirstBlockIndex->height);
+
+    CSnapshotWriter writer(fopen(fileName.c_str(), "wb"));
+    if (!writer)
+        return ERRORMSG("%s() : open %s failed", __func__, fileName);
+
+    try {
+        writer << header;
+
+        uint64_t entryCount = 0;
+        for (const auto &item : dbSnapshots.items) {
+            DBNameType dbName = item.first->GetDbNameType();
+            auto pCursor      = item.first->NewIterator(item.second);
+            for (pCursor->SeekToFirst(); pCursor->Valid(); pCursor->Next()) {
+                if (!IsSnapshotKey(dbName, pCursor->key()))
+                    continue;
+
+                writer.WriteEntry(CSnapshotEntry(dbName, pCursor->key().ToString(), pCursor->value().ToString()));
+                entryCount++;
+            }
+            if (!pCursor->status().ok())
+                return ERRORMSG("%s() : iterate the db %s failed", __func__, GetDbName(dbName));
+        }
+        writer.WriteEntry(CSnapshotEntry());
+
+        // the block index of a pruned node, with the positions of the local block files left out
+        for (size_t i = 0; i < chain.size(); i++) {
+            if (i % 10000 == 0)
+                boost::this_thread::interruption_point();
+
+            CDiskBlockIndex diskIndex;
+            {
+                LOCK(cs_main);
+                diskIndex = CDiskBlockIndex(chain[i]);
+            }
+            diskIndex.nStatus &= ~BLOCK_HAVE_MASK;
+            diskIndex.nFile    = 0;
+            diskIndex.nDataPos = 0;
+            diskIndex.nUndoPos = 0;
+            writer << diskIndex;
+            writer.AddStateHash(chain[i]->GetBlockHash());
+        }
+
+        for (int32_t height = header.height + 1 - header.block_count; height <= header.height; height++) {
+            CBlockIndex *pIndex = chain[height];
+            CBlock block;
+            if (!ReadBlockFromDisk(pIndex, block))
+                return ERRORMSG("%s() : read the block %d failed", __func__, height);
+
+            CBlockUndo blockUndo;
+            if (height > 0) {
+                CDiskBlockPos undoPos;
+                {
+                    LOCK(cs_main);
+                    undoPos = pIndex->GetUndoPos();
+                }
+                if (undoPos.IsNull() || !blockUndo.ReadFromDisk(undoPos, pIndex->pprev->GetBlockHash()))
+                    return ERRORMSG("%s() : read the undo of the block %d failed", __func__, height);
+            }
+            writer << block;
+            writer.WriteState(blockUndo);
+        }
+
+        stateHash = writer.Finish();
+        LogPrint(BCLog::INFO, "%s() : exported %llu state entries and %u blocks at %d, state hash %s\n", __func__,
+                 entryCount, header.block_count, header.height, stateHash.GetHex());
+    } catch (std::exception &e) {
+        return ERRORMSG("%s() : write %s failed - %s", __func__, fileName, e.what());
+    }
+
+    return true;
+}
+
+// Read a snapshot through, and write it to the empty dbs and block files with fImport
+static bool ProcessStateSnapshot(const string &fileName, bool fImport, CSnapshotHeader &header, uint256 &stateHash) {
+    CSnapshotReader reader(fopen(fileName.c_str(), "rb"));
+    if (!reader)
+        return ERRORMSG("%s() : open %s failed", __func__, fileName);
+
+    try {
+        reader >> header;
+        if (header.version != SNAPSHOT_VERSION || header.network != SysCfg().NetworkID() || header.height < 0 ||
+            header.block_count == 0 || header.block_count > (uint32_t)header.height + 1)
+            return ERRORMSG("%s() : the snapshot header is invalid or of another network", __func__);
+
+        map<DBNameType, CLevelDBBatch> batches;
+        auto writeBatch = [&](DBNameType dbName) {
+            if (!pCdMan->GetDbAccess(dbName)->WriteBatch(batches[dbName]))
+                throw runtime_error(strprintf("write the db %s failed", GetDbName(dbName)));
+            batches[dbName] = CLevelDBBatch();
+        };
+
+        CSnapshotEntry entry;
+        uint32_t dbIndex = 0;
+        bool fHaveBestBlock = false;
+        for (reader.ReadEntry(entry); !entry.IsEnd(); reader.ReadEntry(entry)) {
+            // the dbs come in order, and each of them in key order
+            while (dbIndex < kSnapshotDbNames.size() && kSnapshotDbNames[dbIndex] != entry.db_name)
+                dbIndex++;
+            if (dbIndex == kSnapshotDbNames.size() || !IsSnapshotKey((DBNameType)entry.db_name, entry.key))
+                return ERRORMSG("%s() : an unexpected entry of the db %d", __func__, entry.db_name);
+
+            // the state is the one of the block in the header
+            uint256 bestBlockHash;
+            if (GetSnapshotBestBlockHash(entry, bestBlockHash)) {
+                if (bestBlockHash != header.block_hash)
+                    return ERRORMSG("%s() : the state is of the block %s, not of the header block %s", __func__,
+                                    bestBlockHash.GetHex(), header.block_hash.GetHex());
+                fHaveBestBlock = true;
+            }
+
+            if (fImport) {
+                CLevelDBBatch &batch = batches[(DBNameType)entry.db_name];
+                batch.WriteRaw(entry.key, entry.value);
+                if (batch.GetSize() > 16 * 1024 * 1024)
+                    writeBatch((DBNameType)entry.db_name);
+            }
+        }
+        if (!fHaveBestBlock)
+            return ERRORMSG("%s() : the snapshot has no best block hash", __func__);
+
+        if (fImport) {
+            for (DBNameType dbName : kSnapshotDbNames)
+                writeBatch(dbName);
+        }
+
+        // the index entries of the tip blocks are written once their data has a position
+        int32_t firstBlockHeight = header.height + 1 - header.block_count;
+        vector<CDiskBlockIndex> tipIndexes;
+        tipIndexes.reserve(header.block_count);
+        CLevelDBBatch indexBatch;
+        uint256 prevHash;
+        for (int32_t height = 0; height <= header.height; height++) {
+            if (height % 10000 == 0)
+                boost::this_thread::interruption_point();
+
+            CDiskBlockIndex diskIndex;
+            reader >> diskIndex;
+            uint256 blockHash = diskIndex.GetBlockHash();
+            reader.AddStateHash(blockHash);
+            if (diskIndex.height != height || diskIndex.hashPrev != prevHash ||
+                (height == 0 && blockHash != SysCfg().GetGenesisBlockHash()) ||
+                (diskIndex.nStatus & BLOCK_HAVE_MASK))
+                return ERRORMSG("%s() : the block index %d of the snapshot is invalid", __func__, height);
+
+            prevHash = blockHash;
+            if (height >= firstBlockHeight) {
+                tipIndexes.push_back(diskIndex);
+            } else if (fImport) {
+                indexBatch.Write(dbk::GenDbKey(dbk::BLOCK_INDEX, blockHash), diskIndex);
+                if (indexBatch.GetSize() > 16 * 1024 * 1024) {
+                    if (!pCdMan->pBlockIndexDb->WriteBatch(indexBatch))
+                        return ERRORMSG("%s() : write the block index failed", __func__);
+                    indexBatch = CLevelDBBatch();
+                }
+            }
+        }
+        if (prevHash != header.block_hash)
+            return ERRORMSG("%s() : the block index of the snapshot doesn't end at its block", __func__);
+
+        CValidationState state;
+        auto spCW = std::make_shared<CCacheWrapper>(pCdMan);
+        for (auto &diskIndex : tipIndexes) {
+            CBlock block;
+            CBlockUndo blockUndo;
+            reader >> block;
+            reader.ReadState(blockUndo);
+            if (block.GetHash() != diskIndex.GetBlockHash() || block.BuildMerkleTree() != block.GetMerkleRootHash())
+                return ERRORMSG("%s() : the block %d of the snapshot is invalid", __func__, diskIndex.height);
+
+            if (!fImport)
+                continue;
+
+            uint32_t blockSize = ::GetSerializeSize(block, SER_DISK, CLIENT_VERSION);
+            CDiskBlockPos blockPos;
+            if (!FindBlockPos(state, blockPos, blockSize + 8, diskIndex.height, block.GetTime()) ||
+                !WriteBlockToDisk(block, blockPos))
+                return ERRORMSG("%s() : write the block %d failed", __func__, diskIndex.height);
+
+            diskIndex.nFile    = blockPos.nFile;
+            diskIndex.nDataPos = blockPos.nPos;
+            diskIndex.nStatus |= BLOCK_HAVE_DATA;
+            if (diskIndex.height > 0) {
+                CDiskBlockPos undoPos;
+                if (!FindUndoPos(state, blockPos.nFile, undoPos,
+                                 ::GetSerializeSize(blockUndo, SER_DISK, CLIENT_VERSION) + 40) ||
+                    !blockUndo.WriteToDisk(undoPos, diskIndex.hashPrev))
+                    return ERRORMSG("%s() : write the undo of the block %d failed", __func__, diskIndex.height);
+
+                diskIndex.nUndoPos = undoPos.nPos;
+                diskIndex.nStatus |= BLOCK_HAVE_UNDO;
+            }
+            indexBatch.Write(dbk::GenDbKey(dbk::BLOCK_INDEX, diskIndex.GetBlockHash()), diskIndex);
+
+            // the tx index of the blocks kept, the same as ConnectBlock() writes it
+            CDiskTxPos txPos(blockPos, GetSizeOfCompactSize(block.vptx.size()));
+            for (const auto &pBaseTx : block.vptx) {
+                if (!SaveTxIndex(pBaseTx->GetHash(), *spCW, state, txPos))
+                    return ERRORMSG("%s() : write the tx index of the block %d failed", __func__, diskIndex.height);
+                txPos.nTxOffset += ::GetSerializeSize(pBaseTx, SER_DISK, CLIENT_VERSION);
+            }
+        }
+
+        if (!reader.Finish(stateHash))
+            return false;
+
+        if (fImport) {
+            if (!pCdMan->pBlockIndexDb->WriteBatch(indexBatch))
+                return ERRORMSG("%s() : write the block index failed", __func__);
+
+            FlushBlockFile();
+            spCW->Flush();
+            if (firstBlockHeight > 0)
+                pCdMan->pBlockCache->WriteFlag("prunedblockfiles", true);
+            pCdMan->pBlockCache->WriteFlag("txindex", SysCfg().GetBoolArg("-txindex", true));
+            pCdMan->Flush();
+        }
+    } catch (std::exception &e) {
+        return ERRORMSG("%s() : read %s failed - %s", __func__, fileName, e.what());
+    }
+
+    return true;
+}
+
+bool LoadStateSnapshot(const string &fileName, const uint256 &expectedStateHash) {
+    LOCK(cs_main);
+    if (!pCdMan->pBlockCache->GetBestBlockHash().IsNull())
+        return ERRORMSG("%s() : the dbs have a chain already", __func__);
+
+    // check it through before anything is written, a bad snapshot leaves the datadir empty
+    int64_t nStart = GetTimeMillis();
+    CSnapshotHeader header;
+    uint256 stateHash;
+    if (!ProcessStateSnapshot(fileName, false, header, stateHash))
+        return false;
+
+    if (stateHash != expectedStateHash)
+        return ERRORMSG("%s() : the state hash of the snapshot is %s, not %s", __func__, stateHash.GetHex(),
+                        expectedStateHash.GetHex());
+
+    SysCfg().SetTxIndex(SysCfg().GetBoolArg("-txindex", true));
+    if (!ProcessStateSnapshot(fileName, true, header, stateHash))
+        return false;
+
+    LogPrint(BCLog::INFO, "%s() : loaded the state of the block %d %s (%dms)\n", __func__, header.height,
+             header.block_hash.GetHex(), GetTimeMillis() - nStart);
+    return true;
+}
+
 void UnloadBlockIndex() {
     mapBlockIndex.clear();
     setBlockIndexValid.clear();
     chainActive.SetTip(nullptr);
+    nMetricsTipHeight = -1;
     pIndexBestInvalid = nullptr;
 }
 
@@ -2513,11 +3165,39 @@ bool InitBlockIndex() {
     return true;
 }
 
+void RegisterNodeMetrics() {
+    CMetricsRegistry &registry = GetMetricsRegistry();
+    registry.AddGauge("coind_block_height", "Height of the active chain tip", []() -> int64_t {
+        return nMetricsTipHeight;
+    });
+    registry.AddGauge("coind_mempool_txs", "Transactions in the mempool", []() -> int64_t {
+        return mempool.Size();
+    });
+    registry.AddGauge("coind_orphan_blocks", "Orphan blocks waiting for their parents", []() -> int64_t {
+        return nMetricsOrphanBlocks;
+    });
+    registry.AddGauge("coind_peers", "Connected peers", []() -> int64_t {
+        LOCK(cs_vNodes);
+        return vNodes.size();
+    });
+    registry.AddGauge("coind_recv_queue_bytes", "Bytes of the received messages waiting to be processed",
+                      []() -> int64_t {
+        int64_t total = 0;
+        LOCK(cs_vNodes);
+        for (CNode *pNode : vNodes) {
+            TRY_LOCK(pNode->cs_vRecvMsg, lockRecv);
+            if (lockRecv)
+                total += pNode->GetTotalRecvSize();
+        }
+        return total;
+    });
+}
+
 void PrintBlockTree() {
     AssertLockHeld(cs_main);
     // pre-compute tree structure
     map<CBlockIndex *, vector<CBlockIndex *> > mapNext;
-    for (map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi) {
+    for (BlockMap::iterator mi = mapBlockIndex.begin(); mi != mapBlockIndex.end(); ++mi) {
         CBlockIndex *pIndex = (*mi).second;
         mapNext[pIndex->pprev].push_back(pIndex);
     }
@@ -2697,16 +3377,15 @@ class CMainCleanup {
     CMainCleanup() {}
     ~CMainCleanup() {
         // block headers
-        map<uint256, CBlockIndex *>::iterator it1 = mapBlockIndex.begin();
-        for (; it1 != mapBlockIndex.end(); it1++)
-            delete (*it1).second;
         mapBlockIndex.clear();
+        blockIndexArena.Clear();
 
         // orphan blocks
         map<uint256, COrphanBlock *>::iterator it2 = mapOrphanBlocks.begin();
         for (; it2 != mapOrphanBlocks.end(); it2++)
             delete (*it2).second;
         mapOrphanBlocks.clear();
+        nMetricsOrphanBlocks = 0;
         mapOrphanBlocksByPrev.clear();
         setOrphanBlock.clear();
     }
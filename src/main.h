@@ -36,8 +36,10 @@
 //#include "tx/txserializer.h"
 
 class CBloomFilter;
+class CBlockExecResult;
 class CChain;
 class CInv;
+class CSnapshotHeader;
 
 extern CCriticalSection cs_main;
 /** The currently-connected chain of blocks. */
@@ -45,7 +47,8 @@ extern CChain chainActive;
 extern CSignatureCache signatureCache;
 
 extern CTxMemPool mempool;
-extern map<uint256, CBlockIndex *> mapBlockIndex;
+extern BlockMap mapBlockIndex;
+extern CBlockIndexArena blockIndexArena;
 extern uint64_t nLastBlockTx;
 extern uint64_t nLastBlockSize;
 extern const string strMessageMagic;
@@ -92,10 +95,60 @@ void RegisterNodeSignals(CNodeSignals &nodeSignals);
 void UnregisterNodeSignals(CNodeSignals &nodeSignals);
 /** Check whether enough disk space is available for an incoming block */
 bool CheckDiskSpace(uint64_t nAdditionalBytes = 0);
+/** Delete the block and undo files older than nPruneDepth blocks and below the global finality block */
+bool PruneBlockFiles();
+/** Whether the data of the block was pruned */
+bool IsBlockPruned(const CBlockIndex *pIndex);
+/** Whether the block file was pruned */
+bool IsBlockFilePruned(int32_t nFile);
 
 /** Verify consistency of the block and coin databases */
 bool VerifyDB(int32_t nCheckLevel, int32_t nCheckDepth);
 
+/** What a replay of the blocks of the active chain measured, the times are in microseconds */
+struct CBlockReplayStats {
+    struct CBlockTiming {
+        int32_t height       = 0;
+        uint32_t tx_count    = 0;
+        int64_t read_time    = 0;
+        int64_t connect_time = 0;
+    };
+
+    struct CTxTypeTiming {
+        uint32_t count = 0;
+        int64_t time   = 0;
+    };
+
+    int32_t from_height        = 0;
+    int32_t to_height          = 0;
+    int64_t rollback_time      = 0;
+    uint64_t rollback_db_reads = 0;  //!< the leveldb reads of the rollback, which warms the caches for the replay
+    uint64_t cache_reads       = 0;
+    uint64_t cache_db_reads    = 0;  //!< the cache reads which missed all the cache layers
+    uint64_t db_reads          = 0;
+    uint64_t db_read_bytes     = 0;
+    vector<CBlockTiming> blocks;
+    map<TxType, CTxTypeTiming> tx_types;  //!< the executions of the txs, the block reward txs excluded
+
+    string ToString() const;
+};
+
+/**
+ * Replay the blocks fromHeight..toHeight of the active chain through ConnectBlock: the state is rolled
+ * back to fromHeight - 1 by a memory-only disconnect of the tip blocks on a layer reading the databases
+ * directly, so the replay starts on cold caches, and thrown away after, so the databases are left
+ * untouched. The caches of pCdMan must hold nothing the databases miss, as on the start.
+ */
+bool ReplayBlocks(int32_t fromHeight, int32_t toHeight, CBlockReplayStats &stats);
+
+/**
+ * Export the chain state at the tip to a snapshot file. Block processing only waits for the caches to
+ * be flushed and the dbs to be snapshotted, the file is written from the db snapshots after.
+ */
+bool ExportStateSnapshot(const string &fileName, CSnapshotHeader &header, uint256 &stateHash);
+/** Bootstrap the empty dbs from a snapshot file once it is checked against the trusted state hash */
+bool LoadStateSnapshot(const string &fileName, const uint256 &expectedStateHash);
+
 /** Run an instance of the script checking thread */
 void ThreadScriptCheck();
 
@@ -118,6 +171,9 @@ bool VerifySignature(const uint256 &sigHash, const std::vector<uint8_t> &signatu
 /** (try to) add transaction to memory pool **/
 bool AcceptToMemoryPool(CTxMemPool &pool, CValidationState &state, CBaseTx *pBaseTx,
                         bool fLimitFree, bool fRejectInsaneFee = false);
+/** Resubmit the orphan txs of which the dependencies are met, the regids and contracts only
+    appear with a new block **/
+void ProcessOrphanTransactions(bool fBlockConnected);
 
 struct CNodeStateStats {
     int32_t nMisbehavior;
@@ -193,6 +249,10 @@ public:
 extern CChain chainMostWork;
 extern CCacheDBManager *pCdMan;
 extern int32_t nSyncTipHeight;
+/** The retention depth of -prune in blocks, 0 when the node keeps all the block files */
+extern uint32_t nPruneDepth;
+/** Whether some block files were ever pruned */
+extern bool fHavePruned;
 extern std::tuple<bool, boost::thread *> RunCoin(int32_t argc, char *argv[]);
 extern string publicIp;
 
@@ -216,8 +276,11 @@ protected:
  *  will be true if no problems were found. Otherwise, the return value will be false in case
  *  of problems. Note that in any case, coins may be modified. */
 bool DisconnectBlock(CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValidationState &state, bool *pfClean = nullptr);
-// Apply the effects of this block (with given index) on the UTXO set represented by coins
-bool ConnectBlock   (CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValidationState &state, bool fJustCheck = false);
+// Apply the effects of this block (with given index) on the UTXO set represented by coins.
+// If pExecResult is provided, cw must be based on pExecResult->spCW and the block txs are not executed again.
+// If pStateDeltas is provided, it gets the state entries written by the block for the state commitment.
+bool ConnectBlock   (CBlock &block, CCacheWrapper &cw, CBlockIndex *pIndex, CValidationState &state, bool fJustCheck = false,
+                     const CBlockExecResult *pExecResult = nullptr, CDbStateDeltaMap *pStateDeltas = nullptr);
 
 // Add this block to the block index, and if necessary, switch the active block chain to this
 bool AddToBlockIndex(CBlock &block, CValidationState &state, const CDiskBlockPos &pos);
@@ -252,6 +315,8 @@ void PushGetBlocks(CNode *pNode, CBlockIndex *pindexBegin, uint256 hashEnd);
 void PushGetBlocksOnCondition(CNode *pNode, CBlockIndex *pindexBegin, uint256 hashEnd);
 /** Process an incoming block */
 bool ProcessBlock(CValidationState &state, CNode *pFrom, CBlock *pBlock, CDiskBlockPos *dbp = nullptr);
+/** Process a block produced by this node, reusing the execution results of the miner if provided */
+bool ProcessMinedBlock(CValidationState &state, CBlock *pBlock, const std::shared_ptr<CBlockExecResult> &spExecResult);
 /** Print the loaded block tree */
 void PrintBlockTree();
 
@@ -263,4 +328,7 @@ bool ActivateBestChain(CValidationState &state, CBlockIndex* pNewIndex = nullptr
 /** Remove invalidity status from a block and its descendants. */
 bool ReconsiderBlock(CValidationState &state, CBlockIndex *pIndex);
 
+/** Register the gauges of the chain, mempool and peer queues to the metrics registry */
+void RegisterNodeMetrics();
+
 #endif
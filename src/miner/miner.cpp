@@ -16,6 +16,7 @@
 #include "persistence/txdb.h"
 #include "persistence/contractdb.h"
 #include "persistence/cachewrapper.h"
+#include "persistence/blockundo.h"
 #include "p2p/protocol.h"
 
 #include <algorithm>
@@ -34,10 +35,15 @@ boost::circular_buffer<MinedBlockInfo> minedBlocks(MAX_MINED_BLOCK_COUNT);
 CCriticalSection csMinedBlocks;
 
 
+// the limit time for packing new block
+static int64_t GetPackBlockTimeLimitMs(int32_t blockHeight) {
+    return std::max(1000L, (int64_t)GetBlockInterval(blockHeight) * 1000L - 1000L);
+}
+
 // check the time is not exceed the limit time (2s) for packing new block
 static bool CheckPackBlockTime(int64_t startMiningMs, int32_t blockHeight) {
     int64_t nowMs  = GetTimeMillis();
-    int64_t limitedTimeMs = std::max(1000L, (int64_t)GetBlockInterval(blockHeight) * 1000L - 1000L);
+    int64_t limitedTimeMs = GetPackBlockTimeLimitMs(blockHeight);
     if (nowMs - startMiningMs > limitedTimeMs) {
         LogPrint(BCLog::MINER, "%s() : pack block time use up! height=%d, start_ms=%lld, now_ms=%lld, limited_time_ms=%lld\n",
             __FUNCTION__, blockHeight, startMiningMs, nowMs, limitedTimeMs);
@@ -82,26 +88,22 @@ uint32_t GetElementForBurn(CBlockIndex *pIndex) {
     return newFuelRate;
 }
 
+static void AddPriorityTx(int32_t height, const CTxMemPoolEntry &entry, set<TxPriority> &txPriorities,
+                          const int32_t nFuelRate) {
+    CBaseTx *pBaseTx = entry.GetTransaction().get();
+    if (!pBaseTx->IsBlockRewardTx() && !pCdMan->pTxCache->HaveTx(pBaseTx->GetHash())) {
+        uint64_t fee    = std::get<1>(entry.GetFees());
+        uint32_t txSize = entry.GetTxSize();
+        double feePerKb = double(fee - pBaseTx->GetFuel(height, nFuelRate)) / txSize * 1000.0;
+
+        txPriorities.emplace(TxPriority(entry.GetPriority(), feePerKb, entry.GetTransaction()));
+    }
+}
+
 // Sort transactions by priority and fee to decide priority orders to process transactions.
 void GetPriorityTx(int32_t height, set<TxPriority> &txPriorities, const int32_t nFuelRate) {
-    static TokenSymbol feeSymbol;
-    static uint64_t fee    = 0;
-    static uint32_t txSize = 0;
-    static double feePerKb = 0;
-    static double priority = 0;
-
-    for (map<uint256, CTxMemPoolEntry>::iterator mi = mempool.memPoolTxs.begin(); mi != mempool.memPoolTxs.end(); ++mi) {
-        CBaseTx *pBaseTx = mi->second.GetTransaction().get();
-        if (!pBaseTx->IsBlockRewardTx() && !pCdMan->pTxCache->HaveTx(pBaseTx->GetHash())) {
-            feeSymbol = std::get<0>(mi->second.GetFees());
-            fee       = std::get<1>(mi->second.GetFees());
-            txSize    = mi->second.GetTxSize();
-            feePerKb  = double(fee - pBaseTx->GetFuel(height, nFuelRate)) / txSize * 1000.0;
-            priority  = mi->second.GetPriority();
-
-            txPriorities.emplace(TxPriority(priority, feePerKb, mi->second.GetTransaction()));
-        }
-    }
+    for (map<uint256, CTxMemPoolEntry>::iterator mi = mempool.memPoolTxs.begin(); mi != mempool.memPoolTxs.end(); ++mi)
+        AddPriorityTx(height, mi->second, txPriorities, nFuelRate);
 }
 
 
@@ -290,7 +292,7 @@ bool VerifyRewardTx(const CBlock *pBlock, CCacheWrapper &cwIn, bool bNeedRunTx,
     return true;
 }
 
-static bool CreateNewBlockPreStableCoinRelease(CCacheWrapper &cwIn, std::unique_ptr<CBlock> &pBlock) {
+static bool CreateNewBlockPreStableCoinRelease(CCacheWrapper &cwIn, CBlockUndo &blockUndo, std::unique_ptr<CBlock> &pBlock) {
     pBlock->vptx.push_back(std::make_shared<CBlockRewardTx>());
 
     // Largest block you're willing to create:
@@ -332,6 +334,8 @@ static bool CreateNewBlockPreStableCoinRelease(CCacheWrapper &cwIn, std::unique_
             }
 
             auto spCW = std::make_shared<CCacheWrapper>(&cwIn);
+            CTxUndo txUndo;
+            spCW->SetDbOpLogMap(&txUndo.dbOpLogMap);
 
             try {
                 CValidationState state;
@@ -358,8 +362,13 @@ static bool CreateNewBlockPreStableCoinRelease(CCacheWrapper &cwIn, std::unique_
                 continue;
             }
 
+            spCW->SetDbOpLogMap(nullptr);
             spCW->Flush();
 
+            // keep the undo log so that connecting this block need not execute the tx again
+            txUndo.SetTxID(pBaseTx->GetHash());
+            blockUndo.vtxundo.push_back(txUndo);
+
             auto fuel        = pBaseTx->GetFuel(height, fuelRate);
             auto fees_symbol = std::get<0>(pBaseTx->GetFees());
             auto fees        = std::get<1>(pBaseTx->GetFees());
@@ -422,144 +431,241 @@ static bool CreateStableCoinGenesisBlock(std::unique_ptr<CBlock> &pBlock) {
     return true;
 }
 
-static bool CreateNewBlockStableCoinRelease(int64_t startMiningMs, CCacheWrapper &cwIn, std::unique_ptr<CBlock> &pBlock) {
-    pBlock->vptx.push_back(std::make_shared<CUCoinBlockRewardTx>());
+////////////////////////////////////////////////////////////////////////////////
+// class CBlockTemplate
+
+static CBlockTemplate blockTemplate;
+
+void CBlockTemplate::SetNull() {
+    prevBlockHash.SetNull();
+    height          = 0;
+    blockTime       = 0;
+    fuelRate        = 0;
+    spExecResult    = nullptr;
+    vptx.clear();
+    failedTxids.clear();
+    totalBlockSize  = 0;
+    totalRunStep    = 0;
+    totalFuel       = 0;
+    rewards         = {{SYMB::WICC, 0}, {SYMB::WUSD, 0}};
+    txPriorities.clear();
+    packedTxids.clear();
+    hasPriceMedianTx = false;
+    mempoolCursor    = 0;
+}
+
+bool CBlockTemplate::IsBasedOn(const CBlockIndex *pIndexPrev, const uint32_t blockTimeIn) const {
+    return !IsNull() && pIndexPrev->GetBlockHash() == prevBlockHash && blockTime == blockTimeIn &&
+           spExecResult->prev_block_hash == pCdMan->pBlockCache->GetBestBlockHash();
+}
+
+void CBlockTemplate::Reset(CBlockIndex *pIndexPrev, const uint32_t blockTimeIn) {
+    AssertLockHeld(cs_main);
+
+    SetNull();
+    prevBlockHash  = pIndexPrev->GetBlockHash();
+    height         = pIndexPrev->height + 1;
+    blockTime      = blockTimeIn;
+    fuelRate       = GetElementForBurn(pIndexPrev);
+    spExecResult   = std::make_shared<CBlockExecResult>(std::make_shared<CCacheWrapper>(pCdMan), prevBlockHash);
+
+    CBlock emptyBlock;
+    emptyBlock.vptx.push_back(std::make_shared<CUCoinBlockRewardTx>());
+    totalBlockSize = ::GetSerializeSize(emptyBlock, SER_NETWORK, PROTOCOL_VERSION);
+}
+
+bool CBlockTemplate::Update(const int64_t deadlineMs) {
+    AssertLockHeld(cs_main);
+    AssertLockHeld(mempool.cs);
+    assert(!IsNull());
 
     // Largest block you're willing to create:
     uint32_t nBlockMaxSize = SysCfg().GetArg("-blockmaxsize", DEFAULT_BLOCK_MAX_SIZE);
     // Limit to between 1K and MAX_BLOCK_SIZE-1K for sanity:
     nBlockMaxSize = std::max<uint32_t>(1000, std::min<uint32_t>((MAX_BLOCK_SIZE - 1000), nBlockMaxSize));
 
-    // Collect memory pool transactions into the block
-    {
-        LOCK2(cs_main, mempool.cs);
-
-        CBlockIndex *pIndexPrev            = chainActive.Tip();
-        uint32_t blockTime                 = pBlock->GetTime();
-        int32_t height                     = pIndexPrev->height + 1;
-        int32_t index                      = 0; // 0: block reward tx
-        uint32_t fuelRate                  = GetElementForBurn(pIndexPrev);
-        uint64_t totalBlockSize            = ::GetSerializeSize(*pBlock, SER_NETWORK, PROTOCOL_VERSION);
-        uint64_t totalRunStep              = 0;
-        uint64_t totalFees                 = 0;
-        uint64_t totalFuel                 = 0;
-        map<TokenSymbol, uint64_t> rewards = {{SYMB::WICC, 0}, {SYMB::WUSD, 0}};
+    CBlockIndex *pIndexPrev = mapBlockIndex[prevBlockHash];
+    CCacheWrapper &cwIn     = *spExecResult->spCW;
 
-        // Calculate && sort transactions from memory pool.
-        set<TxPriority> txPriorities;
-        GetPriorityTx(height, txPriorities, fuelRate);
+    // Sort the transactions which entered the memory pool since the last pass into the queue.
+    auto seqIt = mempool.txidsBySequence.lower_bound(mempoolCursor);
+    for (; seqIt != mempool.txidsBySequence.end(); ++seqIt) {
+        auto mi = mempool.memPoolTxs.find(seqIt->second);
+        if (mi != mempool.memPoolTxs.end() && !packedTxids.count(seqIt->second))
+            AddPriorityTx(height, mi->second, txPriorities, fuelRate);
+    }
+    mempoolCursor = mempool.nextSequence;
 
-        // Push block price median transaction into queue.
+    // Push block price median transaction into queue.
+    if (!hasPriceMedianTx)
         txPriorities.emplace(TxPriority(PRICE_MEDIAN_TRANSACTION_PRIORITY, 0, std::make_shared<CBlockPriceMedianTx>(height)));
 
-        LogPrint(BCLog::MINER, "CreateNewBlockStableCoinRelease() : got %lu transaction(s) sorted by priority rules\n",
-                 txPriorities.size());
+    // Collect transactions into the block, from the highest priority down.
+    uint32_t packedCount = 0;
+    for (auto itor = txPriorities.end(); itor != txPriorities.begin();) {
+        --itor;
+        if (GetTimeMillis() > deadlineMs) {
+            LogPrint(BCLog::MINER, "%s() : no time left to pack more tx, ignore! height=%d, tx_count=%u\n",
+                __FUNCTION__, height, vptx.size());
+            break;
+        }
 
-        // Collect transactions into the block.
-        for (auto itor = txPriorities.rbegin(); itor != txPriorities.rend(); ++itor) {
+        CBaseTx *pBaseTx = itor->baseTx.get();
+        // the queue drops the txs which left the memory pool
+        if (!pBaseTx->IsPriceMedianTx() && !mempool.memPoolTxs.count(pBaseTx->GetHash())) {
+            itor = txPriorities.erase(itor);
+            continue;
+        }
 
-            if (!CheckPackBlockTime(startMiningMs, height)) {
-                LogPrint(BCLog::MINER, "%s() : no time left to pack more tx, ignore! height=%d, start_ms=%lld, tx_count=%u\n",
-                    __FUNCTION__, height, startMiningMs, pBlock->vptx.size());
-                break;
-            }
+        // a failed tx is retried once more txs are packed, which may be the ones it depends on
+        auto failedIt = failedTxids.find(pBaseTx->GetHash());
+        if (!pBaseTx->IsPriceMedianTx() && failedIt != failedTxids.end() && failedIt->second == vptx.size())
+            continue;
 
-            CBaseTx *pBaseTx = itor->baseTx.get();
+        uint32_t txSize = pBaseTx->GetSerializeSize(SER_NETWORK, PROTOCOL_VERSION);
+        if (totalBlockSize + txSize >= nBlockMaxSize) {
+            LogPrint(BCLog::MINER, "CBlockTemplate::Update() : exceed max block size, txid: %s\n",
+                     pBaseTx->GetHash().GetHex());
+            continue;
+        }
 
-            uint32_t txSize = pBaseTx->GetSerializeSize(SER_NETWORK, PROTOCOL_VERSION);
-            if (totalBlockSize + txSize >= nBlockMaxSize) {
-                LogPrint(BCLog::MINER, "CreateNewBlockStableCoinRelease() : exceed max block size, txid: %s\n",
-                         pBaseTx->GetHash().GetHex());
-                continue;
-            }
+        auto spCW = std::make_shared<CCacheWrapper>(&cwIn);
+        CTxUndo txUndo;
+        spCW->SetDbOpLogMap(&txUndo.dbOpLogMap);
 
-            auto spCW = std::make_shared<CCacheWrapper>(&cwIn);
+        try {
+            CValidationState state;
 
-            try {
-                CValidationState state;
+            pBaseTx->nFuelRate = fuelRate;
 
-                pBaseTx->nFuelRate = fuelRate;
+            // Special case for price median tx,
+            if (pBaseTx->IsPriceMedianTx()) {
+                CBlockPriceMedianTx *pPriceMedianTx = (CBlockPriceMedianTx *)itor->baseTx.get();
 
-                // Special case for price median tx,
-                if (pBaseTx->IsPriceMedianTx()) {
-                    CBlockPriceMedianTx *pPriceMedianTx = (CBlockPriceMedianTx *)itor->baseTx.get();
+                PriceMap medianPrices;
+                if (!spCW->ppCache.CalcBlockMedianPrices(*spCW, height, medianPrices))
+                    return ERRORMSG("%s(), calculate block median prices error", __func__);
 
-                    PriceMap medianPrices;
-                    if (!spCW->ppCache.CalcBlockMedianPrices(*spCW, height, medianPrices))
-                        return ERRORMSG("%s(), calculate block median prices error", __func__);
+                pPriceMedianTx->SetMedianPrices(medianPrices);
+            }
 
-                    pPriceMedianTx->SetMedianPrices(medianPrices);
-                }
+            LogPrint(BCLog::MINER, "CBlockTemplate::Update() : begin to pack transaction: %s\n",
+                     pBaseTx->ToString(spCW->accountCache));
 
-                LogPrint(BCLog::MINER, "CreateNewBlockStableCoinRelease() : begin to pack transaction: %s\n",
+            uint32_t prevBlockTime = pIndexPrev->GetBlockTime();
+            CTxExecuteContext context(height, vptx.size() + 1, fuelRate, blockTime, prevBlockTime, spCW.get(), &state,
+                                      transaction_status_type::mining);
+            if (!pBaseTx->CheckTx(context) || !pBaseTx->ExecuteTx(context)) {
+                LogPrint(BCLog::MINER, "CBlockTemplate::Update() : failed to pack transaction: %s\n",
                          pBaseTx->ToString(spCW->accountCache));
 
-                uint32_t prevBlockTime = pIndexPrev->GetBlockTime();
-                CTxExecuteContext context(height, index + 1, fuelRate, blockTime, prevBlockTime, spCW.get(), &state, transaction_status_type::mining);
-                if (!pBaseTx->CheckTx(context) || !pBaseTx->ExecuteTx(context)) {
-                    LogPrint(BCLog::MINER, "CreateNewBlockStableCoinRelease() : failed to pack transaction: %s\n",
-                             pBaseTx->ToString(spCW->accountCache));
-
-                    pCdMan->pLogCache->SetExecuteFail(height, pBaseTx->GetHash(), state.GetRejectCode(),
-                                                      state.GetRejectReason());
-                    continue;
-                }
-
-                // Run step limits
-                if (totalRunStep + pBaseTx->nRunStep >= MAX_BLOCK_RUN_STEP) {
-                    LogPrint(BCLog::MINER, "CreateNewBlockStableCoinRelease() : exceed max block run steps, txid: %s\n",
-                            pBaseTx->GetHash().GetHex());
-                    continue;
-                }
-            } catch (std::exception &e) {
-                LogPrint(BCLog::ERROR, "CreateNewBlockStableCoinRelease() : unexpected exception: %s\n", e.what());
+                pCdMan->pLogCache->SetExecuteFail(height, pBaseTx->GetHash(), state.GetRejectCode(),
+                                                  state.GetRejectReason());
+                failedTxids[pBaseTx->GetHash()] = vptx.size();
+                continue;
+            }
 
+            // Run step limits
+            if (totalRunStep + pBaseTx->nRunStep >= MAX_BLOCK_RUN_STEP) {
+                LogPrint(BCLog::MINER, "CBlockTemplate::Update() : exceed max block run steps, txid: %s\n",
+                        pBaseTx->GetHash().GetHex());
                 continue;
             }
+        } catch (std::exception &e) {
+            LogPrint(BCLog::ERROR, "CBlockTemplate::Update() : unexpected exception: %s\n", e.what());
 
-            spCW->Flush();
+            continue;
+        }
 
-            auto fuel        = pBaseTx->GetFuel(height, fuelRate);
-            auto fees_symbol = std::get<0>(pBaseTx->GetFees());
-            auto fees        = std::get<1>(pBaseTx->GetFees());
-            assert(fees_symbol == SYMB::WICC || fees_symbol == SYMB::WUSD);
+        spCW->SetDbOpLogMap(nullptr);
+        spCW->Flush();
 
-            totalBlockSize += txSize;
-            totalRunStep += pBaseTx->nRunStep;
-            totalFuel += fuel;
-            totalFees += fees;
-            assert(fees >= fuel);
-            rewards[fees_symbol] += (fees - fuel);
+        // keep the undo log so that connecting this block need not execute the tx again
+        txUndo.SetTxID(pBaseTx->GetHash());
+        spExecResult->block_undo.vtxundo.push_back(txUndo);
 
-            ++index;
+        auto fuel        = pBaseTx->GetFuel(height, fuelRate);
+        auto fees_symbol = std::get<0>(pBaseTx->GetFees());
+        auto fees        = std::get<1>(pBaseTx->GetFees());
+        assert(fees_symbol == SYMB::WICC || fees_symbol == SYMB::WUSD);
 
-            pBlock->vptx.push_back(itor->baseTx);
+        totalBlockSize += txSize;
+        totalRunStep += pBaseTx->nRunStep;
+        totalFuel += fuel;
+        assert(fees >= fuel);
+        rewards[fees_symbol] += (fees - fuel);
 
-            LogPrint(BCLog::DEBUG, "miner total fuel fee:%d, tx fuel fee:%d, fuel:%d, fuelRate:%d, txid:%s\n", totalFuel,
-                     pBaseTx->GetFuel(height, fuelRate), pBaseTx->nRunStep, fuelRate, pBaseTx->GetHash().GetHex());
+        vptx.push_back(itor->baseTx);
+        packedTxids.insert(pBaseTx->GetHash());
+        hasPriceMedianTx |= pBaseTx->IsPriceMedianTx();
+        ++packedCount;
 
-        }
+        LogPrint(BCLog::DEBUG, "miner total fuel fee:%d, tx fuel fee:%d, fuel:%d, fuelRate:%d, txid:%s\n", totalFuel,
+                 pBaseTx->GetFuel(height, fuelRate), pBaseTx->nRunStep, fuelRate, pBaseTx->GetHash().GetHex());
+        itor = txPriorities.erase(itor);
+    }
 
-        nLastBlockTx                   = index + 1;
-        nLastBlockSize                 = totalBlockSize;
+    if (packedCount > 0)
+        LogPrint(BCLog::MINER, "CBlockTemplate::Update() : height=%d, packed %u new tx(s), tx=%u, totalBlockSize=%llu\n",
+                 height, packedCount, vptx.size() + 1, totalBlockSize);
 
-        ((CUCoinBlockRewardTx *)pBlock->vptx[0].get())->reward_fees = rewards;
+    return true;
+}
 
-        // Fill in header
-        pBlock->SetPrevBlockHash(pIndexPrev->GetBlockHash());
-        pBlock->SetNonce(0);
-        pBlock->SetHeight(height);
-        pBlock->SetFuel(totalFuel);
-        pBlock->SetFuelRate(fuelRate);
+void CBlockTemplate::Fill(CBlock &block) const {
+    auto spRewardTx         = std::make_shared<CUCoinBlockRewardTx>();
+    spRewardTx->reward_fees = rewards;
 
-        LogPrint(BCLog::INFO, "CreateNewBlockStableCoinRelease() : height=%d, tx=%d, totalBlockSize=%llu\n", height, index + 1,
-                 totalBlockSize);
+    block.vptx.clear();
+    block.vptx.reserve(vptx.size() + 1);
+    block.vptx.push_back(spRewardTx);
+    block.vptx.insert(block.vptx.end(), vptx.begin(), vptx.end());
+
+    // Fill in header
+    block.SetPrevBlockHash(prevBlockHash);
+    block.SetTime(blockTime);
+    block.SetNonce(0);
+    block.SetHeight(height);
+    block.SetFuel(totalFuel);
+    block.SetFuelRate(fuelRate);
+}
+
+static bool CreateNewBlockStableCoinRelease(int64_t startMiningMs, std::unique_ptr<CBlock> &pBlock,
+                                            std::shared_ptr<CBlockExecResult> &spExecResultOut,
+                                            uint64_t &prebuiltTxCountOut) {
+    // Collect memory pool transactions into the block
+    LOCK2(cs_main, mempool.cs);
+
+    CBlockIndex *pIndexPrev = chainActive.Tip();
+    if (!blockTemplate.IsBasedOn(pIndexPrev, pBlock->GetTime())) {
+        if (!blockTemplate.IsNull())
+            LogPrint(BCLog::MINER, "%s() : block template is stale, rebuild it! height=%d, tx_count=%u\n",
+                __FUNCTION__, blockTemplate.height, blockTemplate.vptx.size());
+
+        blockTemplate.Reset(pIndexPrev, pBlock->GetTime());
     }
+    prebuiltTxCountOut = blockTemplate.vptx.size();
 
-    return true;
+    int64_t deadlineMs = startMiningMs + GetPackBlockTimeLimitMs(blockTemplate.height);
+    bool success       = blockTemplate.Update(deadlineMs);
+    if (success) {
+        blockTemplate.Fill(*pBlock);
+        spExecResultOut = blockTemplate.spExecResult;
+
+        nLastBlockTx   = pBlock->vptx.size();
+        nLastBlockSize = blockTemplate.totalBlockSize;
+
+        LogPrint(BCLog::INFO, "CreateNewBlockStableCoinRelease() : height=%d, tx=%d, prebuilt_tx=%llu, totalBlockSize=%llu\n",
+                 pBlock->GetHeight(), pBlock->vptx.size(), prebuiltTxCountOut, blockTemplate.totalBlockSize);
+    }
+
+    // the template is consumed by this block, never reuse it
+    blockTemplate.SetNull();
+
+    return success;
 }
 
-bool CheckWork(CBlock *pBlock) {
+bool CheckWork(CBlock *pBlock, const std::shared_ptr<CBlockExecResult> &spExecResult) {
     // Print block information
     pBlock->Print();
 
@@ -568,7 +674,7 @@ bool CheckWork(CBlock *pBlock) {
 
     // Process this block the same as if we received it from another node
     CValidationState state;
-    if (!ProcessBlock(state, nullptr, pBlock))
+    if (!ProcessMinedBlock(state, pBlock, spExecResult))
         return ERRORMSG("CheckWork() : failed to process block");
 
     return true;
@@ -621,10 +727,51 @@ static bool GetMiner(int64_t startMiningMs, const int32_t blockHeight, Miner &mi
 }
 
 
+// Pack the transactions into the block template ahead of the slot when this node is the producer of it.
+static void PrebuildBlock(CBlockIndex *pIndexPrev, const int64_t slotTime) {
+    static uint256 checkedPrevBlockHash;
+    static int64_t checkedSlotTime = 0;
+    static bool isSlotMiner        = false;
+    static int64_t lastPackMs      = 0;
+
+    int32_t blockHeight = pIndexPrev->height + 1;
+    if (blockHeight == (int32_t)SysCfg().GetStableCoinGenesisHeight() ||
+        GetFeatureForkVersion(blockHeight) == MAJOR_VER_R1)
+        return;
+
+    if (checkedPrevBlockHash != pIndexPrev->GetBlockHash() || checkedSlotTime != slotTime) {
+        Miner miner;
+        uint32_t totalDelegateNum;
+        checkedPrevBlockHash = pIndexPrev->GetBlockHash();
+        checkedSlotTime      = slotTime;
+        isSlotMiner          = GetMiner(slotTime * 1000, blockHeight, miner, totalDelegateNum);
+    }
+
+    if (!isSlotMiner)
+        return;
+
+    int64_t nowMs = GetTimeMillis();
+    if (nowMs - lastPackMs < PREBUILD_INTERVAL_MS)
+        return;
+    lastPackMs = nowMs;
+
+    LOCK2(cs_main, mempool.cs);
+    if (pIndexPrev != chainActive.Tip())
+        return;
+
+    if (!blockTemplate.IsBasedOn(pIndexPrev, slotTime))
+        blockTemplate.Reset(pIndexPrev, slotTime);
+
+    // pack in small batches to avoid holding cs_main for long
+    int64_t deadlineMs = std::min(GetTimeMillis() + PREBUILD_BATCH_MS, slotTime * 1000);
+    blockTemplate.Update(deadlineMs);
+}
+
 static bool ProduceBlock(int64_t startMiningMs, CBlockIndex *pPrevIndex, Miner &miner, const uint32_t totalDelegateNum) {
-    int64_t lastTime    = 0;
-    bool success        = false;
-    int32_t blockHeight = 0;
+    int64_t lastTime         = 0;
+    bool success             = false;
+    int32_t blockHeight      = 0;
+    uint64_t prebuiltTxCount = 0;
     std::unique_ptr<CBlock> pBlock(new CBlock());
     if (!pBlock.get())
         throw runtime_error("ProduceBlock() : failed to create new block");
@@ -647,17 +794,19 @@ static bool ProduceBlock(int64_t startMiningMs, CBlockIndex *pPrevIndex, Miner &
             return false;
         }
 
-        lastTime  = GetTimeMillis();
-        auto spCW = std::make_shared<CCacheWrapper>(pCdMan);
+        lastTime = GetTimeMillis();
+        std::shared_ptr<CBlockExecResult> spExecResult;
 
         pBlock->SetTime(MillisToSecond(startMiningMs));  // set block time first
 
         if (blockHeight == (int32_t)SysCfg().GetStableCoinGenesisHeight()) {
             success = CreateStableCoinGenesisBlock(pBlock);  // stable coin genesis
         } else if (GetFeatureForkVersion(blockHeight) == MAJOR_VER_R1) {
-            success = CreateNewBlockPreStableCoinRelease(*spCW, pBlock); // pre-stable coin release
+            auto spCW    = std::make_shared<CCacheWrapper>(pCdMan);
+            spExecResult = std::make_shared<CBlockExecResult>(spCW, pPrevIndex->GetBlockHash());
+            success      = CreateNewBlockPreStableCoinRelease(*spCW, spExecResult->block_undo, pBlock); // pre-stable coin release
         } else {
-            success = CreateNewBlockStableCoinRelease(startMiningMs, *spCW, pBlock);    // stable coin release
+            success = CreateNewBlockStableCoinRelease(startMiningMs, pBlock, spExecResult, prebuiltTxCount); // stable coin release
         }
 
         if (!success) {
@@ -682,8 +831,12 @@ static bool ProduceBlock(int64_t startMiningMs, CBlockIndex *pPrevIndex, Miner &
             "used_time_ms=%lld\n", blockHeight, miner.account.regid.ToString(), pBlock->vptx[0]->GetHash().ToString(),
             GetTimeMillis() - lastTime);
 
+        // the stable coin genesis block is not executed when packing, nothing to reuse
+        if (spExecResult)
+            spExecResult->Finalize(*pBlock);
+
         lastTime = GetTimeMillis();
-        success  = CheckWork(pBlock.get());
+        success  = CheckWork(pBlock.get(), spExecResult);
         if (!success) {
             LogPrint(BCLog::MINER, "ProduceBlock(), fail to check work for new block, height=%d, regid=%s, "
                 "used_time_ms=%lld\n", blockHeight, miner.account.regid.ToString(), GetTimeMillis() - lastTime);
@@ -698,6 +851,8 @@ static bool ProduceBlock(int64_t startMiningMs, CBlockIndex *pPrevIndex, Miner &
     {
         LOCK(csMinedBlocks);
         miningBlockInfo.Set(pBlock.get());
+        miningBlockInfo.prebuiltTxCount = prebuiltTxCount;
+        miningBlockInfo.packTimeMs      = GetTimeMillis() - startMiningMs;
         minedBlocks.push_front(miningBlockInfo);
         miningBlockInfo.SetNull();
     }
@@ -776,6 +931,9 @@ void static ThreadProduceBlocks(CWallet *pWallet, int32_t targetHeight) {
             int64_t curMiningTime = MillisToSecond(startMiningMs);
             int64_t curSlotTime = std::max(nextSlotTime, pIndexPrev->GetBlockTime() + GetBlockInterval(blockHeight));
             if (curMiningTime < curSlotTime) {
+                if (SysCfg().GetBoolArg("-prebuildblock", true))
+                    PrebuildBlock(pIndexPrev, curSlotTime);
+
                 needSleep = true;
                 continue;
             }
@@ -839,6 +997,8 @@ void MinedBlockInfo::SetNull() {
     totalBlockSize = 0;
     hash.SetNull();
     hashPrevBlock.SetNull();
+    prebuiltTxCount = 0;
+    packTimeMs      = 0;
 }
 
 void MinedBlockInfo::Set(const CBlock *pBlock) {
@@ -19,6 +19,7 @@
 
 class CBlock;
 class CBlockIndex;
+class CBlockExecResult;
 class CWallet;
 class CBaseTx;
 class CAccountDBCache;
@@ -72,6 +73,8 @@ public:
     uint64_t totalBlockSize;  // block size(bytes)
     uint256 hash;             // block hash
     uint256 hashPrevBlock;    // prev block has
+    uint64_t prebuiltTxCount; // transaction count packed into the block template before the slot
+    int64_t packTimeMs;       // time used from the slot start to the block accepted
 
 public:
     MinedBlockInfo() { SetNull(); }
@@ -79,6 +82,44 @@ public:
     void Set(const CBlock *pBlock);
 };
 
+/** Max milliseconds of one speculative packing pass, which holds cs_main */
+static const int64_t PREBUILD_BATCH_MS = 5;
+/** Min milliseconds between two speculative packing passes */
+static const int64_t PREBUILD_INTERVAL_MS = 250;
+
+// Block template which is built on top of the current tip ahead of the producer's slot, so that
+// only the newly arrived transactions need to be packed at slot time. Guarded by cs_main.
+class CBlockTemplate {
+public:
+    uint256 prevBlockHash;
+    int32_t height;
+    uint32_t blockTime;
+    uint32_t fuelRate;
+    std::shared_ptr<CBlockExecResult> spExecResult;  // state and undo logs of the packed transactions
+    vector<std::shared_ptr<CBaseTx>> vptx;           // packed transactions, exclude block reward tx
+    map<uint256, uint32_t> failedTxids;              // failed transactions -> packed count when they failed
+    uint64_t totalBlockSize;
+    uint64_t totalRunStep;
+    uint64_t totalFuel;
+    map<TokenSymbol, uint64_t> rewards;
+    set<TxPriority> txPriorities;                    // the queue of the txs to pack, sorted once as they come
+    set<uint256> packedTxids;
+    bool hasPriceMedianTx;
+    uint64_t mempoolCursor;                          // the sequence of the next memory pool tx to queue
+
+public:
+    CBlockTemplate() { SetNull(); }
+    void SetNull();
+    bool IsNull() const { return spExecResult == nullptr; }
+
+    bool IsBasedOn(const CBlockIndex *pIndexPrev, const uint32_t blockTimeIn) const;
+    void Reset(CBlockIndex *pIndexPrev, const uint32_t blockTimeIn);
+    // queue the transactions which entered the memory pool since the last pass, and pack the queue until deadline
+    bool Update(const int64_t deadlineMs);
+    // fill the block with the reward tx, the packed transactions and the header
+    void Fill(CBlock &block) const;
+};
+
 // get the info of mined blocks. thread safe.
 vector<MinedBlockInfo> GetMinedBlocks(uint32_t count);
 
@@ -87,8 +128,8 @@ void GenerateProduceBlockThread(bool fGenerate, CWallet *pWallet, int32_t nThrea
 
 bool VerifyRewardTx(const CBlock *pBlock, CCacheWrapper &cwIn, bool bNeedRunTx, VoteDelegate &curDelegateOut, uint32_t& totalDelegateNumOut);
 
-/** Check mined block */
-bool CheckWork(CBlock *pBlock);
+/** Check mined block, spExecResult holds the execution results of packing it (could be null) */
+bool CheckWork(CBlock *pBlock, const std::shared_ptr<CBlockExecResult> &spExecResult = nullptr);
 
 /** Get burn element */
 uint32_t GetElementForBurn(CBlockIndex *pIndex);
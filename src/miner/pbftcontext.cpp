@@ -9,20 +9,60 @@
 
 CPBFTContext pbftContext ;
 
-bool CPBFTContext::GetMinerListByBlockHash(const uint256 blockHash, set<CRegID>& miners) {
+static const uint32_t MAX_BLOCK_MINER_LIST_SIZE = 500;
 
+DelegateSetPtr CPBFTContext::GetMinerListByBlockHash(const uint256 blockHash) {
+    LOCK(cs_pbftcontext);
     auto it = blockMinerListMap.find(blockHash) ;
     if(it == blockMinerListMap.end())
-        return false;
-    miners = it->second ;
-    return true ;
+        return nullptr;
+    return it->second ;
 }
 
 bool CPBFTContext::SaveMinersByHash(uint256 blockhash, VoteDelegateVector delegates) {
-    set<CRegID> miners ;
+    auto spMiners = std::make_shared<set<CRegID>>();
     for(auto delegate: delegates){
-        miners.insert(delegate.regid);
+        spMiners->insert(delegate.regid);
+    }
+
+    LOCK(cs_pbftcontext);
+    if (!blockMinerListMap.emplace(blockhash, spMiners).second)
+        return true;
+
+    blockMinerListQueue.push_back(blockhash);
+    if (blockMinerListQueue.size() > MAX_BLOCK_MINER_LIST_SIZE) {
+        blockMinerListMap.erase(blockMinerListQueue.front());
+        blockMinerListQueue.pop_front();
     }
-    blockMinerListMap.insert(std::make_pair(blockhash, miners));
     return true ;
-}
\ No newline at end of file
+}
+
+bool CPBFTContext::HasDelegateKeys(const VoteDelegateVector &delegates) {
+    LOCK(cs_pbftcontext);
+    if (delegates.size() != delegateKeysMap.size())
+        return false;
+
+    for (const auto &delegate : delegates) {
+        if (!delegateKeysMap.count(delegate.regid))
+            return false;
+    }
+    return true;
+}
+
+void CPBFTContext::SaveDelegateKeys(const map<CRegID, CDelegateKeys> &delegateKeys) {
+    LOCK(cs_pbftcontext);
+    prevDelegateKeysMap = std::move(delegateKeysMap);
+    delegateKeysMap     = delegateKeys;
+}
+
+bool CPBFTContext::GetDelegateKeys(const CRegID &regid, CDelegateKeys &keys) {
+    LOCK(cs_pbftcontext);
+    auto it = delegateKeysMap.find(regid);
+    if (it == delegateKeysMap.end()) {
+        it = prevDelegateKeysMap.find(regid);
+        if (it == prevDelegateKeysMap.end())
+            return false;
+    }
+    keys = it->second;
+    return true;
+}
@@ -7,11 +7,12 @@
 #ifndef MINER_PBFTCONTEXT_H
 #define MINER_PBFTCONTEXT_H
 
+#include <deque>
 #include <map>
+#include <memory>
 #include <set>
 #include "sync.h"
 #include "commons/uint256.h"
-#include "commons/limitedmap.h"
 #include "commons/mruset.h"
 #include "entities/vote.h"
 
@@ -20,24 +21,79 @@ class CBlockConfirmMessage ;
 class CBlockFinalityMessage;
 
 
+typedef std::shared_ptr<const set<CRegID>> DelegateSetPtr;
+
+/** Public keys of a delegate, cached to authenticate the pbft messages without accessing the account db */
+struct CDelegateKeys {
+    CPubKey owner_pubkey;
+    CPubKey miner_pubkey;
+};
+
+/** Deduplicated votes of the miners for a block, with a running count of the votes from the
+ *  delegates of the block. The count is done once the delegates are known, then kept up to date
+ *  on every new vote. */
+class CPBFTBlockTally {
+public:
+    set<CRegID> voters;
+    DelegateSetPtr spDelegates;
+    uint32_t delegateVoteCount = 0;
+
+public:
+    void SetDelegates(const DelegateSetPtr &spDelegatesIn) {
+        if (spDelegates || !spDelegatesIn)
+            return;
+
+        spDelegates = spDelegatesIn;
+        for (const auto &voter : voters) {
+            if (spDelegates->count(voter))
+                delegateVoteCount++;
+        }
+    }
+
+    // return false if the miner has voted already
+    bool AddVote(const CRegID &miner) {
+        if (!voters.insert(miner).second)
+            return false;
+
+        if (spDelegates && spDelegates->count(miner))
+            delegateVoteCount++;
+        return true;
+    }
+};
+
 template <typename MsgType>
 class CPBFTMessageMan {
 
 private:
     CCriticalSection cs_pbftmessage;
-    limitedmap<uint256, set<MsgType>> blockMessagesMap ;
+    map<uint256, CPBFTBlockTally> blockTallyMap ;
+    std::deque<uint256> blockTallyQueue ;
+    uint32_t maxTallySize ;
     mruset<uint256> broadcastedBlockHashSet ;
     mruset<MsgType> messageKnown ;
 
+    CPBFTBlockTally& GetTally(const uint256 &blockHash) {
+        auto it = blockTallyMap.find(blockHash);
+        if (it != blockTallyMap.end())
+            return it->second;
+
+        if (blockTallyQueue.size() >= maxTallySize) {
+            blockTallyMap.erase(blockTallyQueue.front());
+            blockTallyQueue.pop_front();
+        }
+        blockTallyQueue.push_back(blockHash);
+        return blockTallyMap[blockHash];
+    }
+
 public:
     CPBFTMessageMan(){
-            blockMessagesMap.max_size(500) ;
+            maxTallySize = 500 ;
             broadcastedBlockHashSet.max_size(500) ;
             messageKnown.max_size(500) ;
     }
 
     CPBFTMessageMan(const int maxSize) {
-        blockMessagesMap.max_size(maxSize) ;
+        maxTallySize = maxSize ;
         broadcastedBlockHashSet.max_size(maxSize) ;
         messageKnown.max_size(maxSize) ;
     }
@@ -62,51 +118,63 @@ public:
             return true;
     }
 
-    int  SaveMessageByBlock(const uint256 blockHash,const MsgType& msg) {
+    // save the vote of the message, spDelegates is the delegates of the block (null if unknown yet).
+    // return the vote count of the delegates of the block
+    uint32_t SaveMessageByBlock(const uint256 &blockHash, const MsgType& msg, const DelegateSetPtr &spDelegates) {
+
+            LOCK(cs_pbftmessage);
+            CPBFTBlockTally &tally = GetTally(blockHash);
+            tally.SetDelegates(spDelegates);
+            tally.AddVote(msg.miner);
+            return tally.delegateVoteCount;
+    }
 
+    // return the vote count of the delegates of the block
+    uint32_t GetVoteCount(const uint256 &blockHash, const DelegateSetPtr &spDelegates) {
             LOCK(cs_pbftmessage);
-            auto it = blockMessagesMap.find(blockHash) ;
-            if(it == blockMessagesMap.end()) {
-                    set<MsgType> messages ;
-                    messages.insert(msg) ;
-                    blockMessagesMap.insert(std::make_pair(blockHash, messages)) ;
-                    return  1 ;
-            } else {
-                    set<MsgType> v = blockMessagesMap[blockHash] ;
-                    v.insert(msg);
-                    blockMessagesMap.update(it, v);
-                    return v.size();
-            }
+            auto it = blockTallyMap.find(blockHash) ;
+            if(it == blockTallyMap.end())
+                return 0;
+            it->second.SetDelegates(spDelegates);
+            return it->second.delegateVoteCount;
     }
 
-    bool GetMessagesByBlockHash(const uint256 hash, set<MsgType>& msgs) {
-            auto it = blockMessagesMap.find(hash) ;
-            if(it == blockMessagesMap.end())
-                return false;
-            msgs = it->second ;
-            return true ;
+    uint32_t GetVoterCount(const uint256 &blockHash) {
+            LOCK(cs_pbftmessage);
+            auto it = blockTallyMap.find(blockHash) ;
+            return it == blockTallyMap.end() ? 0 : it->second.voters.size();
     }
 
 };
 
 class CPBFTContext {
 
+private:
+    CCriticalSection cs_pbftcontext;
+    map<uint256, DelegateSetPtr> blockMinerListMap ;
+    std::deque<uint256> blockMinerListQueue ;
+    map<CRegID, CDelegateKeys> delegateKeysMap ;     // keys of the active delegates
+    map<CRegID, CDelegateKeys> prevDelegateKeysMap ; // keys of the delegates before the last change
 
 public:
 
     CPBFTMessageMan<CBlockConfirmMessage> confirmMessageMan ;
     CPBFTMessageMan<CBlockFinalityMessage> finalityMessageMan ;
-    limitedmap<uint256, set<CRegID>> blockMinerListMap ;
-
-    CPBFTContext(){
-        blockMinerListMap.max_size(500) ;
 
-    }
+    CPBFTContext(){}
 
-    bool GetMinerListByBlockHash(const uint256 blockHash, set<CRegID>& delegates) ;
+    // the delegates after executing the block, i.e. the delegates of its next block. return null if unknown
+    DelegateSetPtr GetMinerListByBlockHash(const uint256 blockHash) ;
 
     bool SaveMinersByHash(uint256 blockhash, VoteDelegateVector delegates) ;
 
+    // whether the cached keys are of the delegates
+    bool HasDelegateKeys(const VoteDelegateVector &delegates) ;
+
+    // replace the cached keys when the delegates changed, the old ones are kept for the messages of the previous epoch
+    void SaveDelegateKeys(const map<CRegID, CDelegateKeys> &delegateKeys) ;
+
+    bool GetDelegateKeys(const CRegID &regid, CDelegateKeys &keys) ;
 
 };
 
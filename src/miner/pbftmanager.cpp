@@ -16,6 +16,38 @@ extern CPBFTContext pbftContext;
 extern CWallet *pWalletMain;
 extern CCacheDBManager *pCdMan;
 
+// the delegates of the block, which are saved after executing its previous block
+static DelegateSetPtr GetBlockDelegates(const CBlockIndex* pIndex) {
+    if(pIndex == nullptr || pIndex->pprev == nullptr)
+        return nullptr ;
+    return pbftContext.GetMinerListByBlockHash(pIndex->pprev->GetBlockHash()) ;
+}
+
+template <typename MsgType>
+static uint32_t GetVoteCount(CPBFTMessageMan<MsgType>& msgMan, const CBlockIndex* pIndex) {
+    return msgMan.GetVoteCount(pIndex->GetBlockHash(), GetBlockDelegates(pIndex)) ;
+}
+
+template <typename MsgType>
+static uint32_t SaveMessage(CPBFTMessageMan<MsgType>& msgMan, const MsgType& msg) {
+    // count the votes against the delegates only when the block is on chainActive, otherwise it
+    // will be done once the block is connected
+    DelegateSetPtr spDelegates ;
+    CBlockIndex* pIndex = chainActive[msg.height] ;
+    if(pIndex != nullptr && pIndex->GetBlockHash() == msg.blockHash)
+        spDelegates = GetBlockDelegates(pIndex) ;
+
+    return msgMan.SaveMessageByBlock(msg.blockHash, msg, spDelegates) ;
+}
+
+uint32_t SaveBlockConfirmMessage(const CBlockConfirmMessage& msg) {
+    return SaveMessage(pbftContext.confirmMessageMan, msg) ;
+}
+
+uint32_t SaveBlockFinalityMessage(const CBlockFinalityMessage& msg) {
+    return SaveMessage(pbftContext.finalityMessageMan, msg) ;
+}
+
 CBlockIndex* CPBFTMan::GetLocalFinIndex(){
 
     if(!localFinIndex) {
@@ -114,24 +146,8 @@ bool CPBFTMan::UpdateLocalFinBlock(const CBlockIndex* pIndex){
 
         CBlockIndex* pTemp = chainActive[height] ;
 
-        set<CBlockConfirmMessage> messageSet ;
-        set<CRegID> miners;
-
-        if(pbftContext.confirmMessageMan.GetMessagesByBlockHash(pTemp->GetBlockHash(), messageSet)
-           && pbftContext.GetMinerListByBlockHash(pTemp->pprev->GetBlockHash(),miners)){
-
-            if(messageSet.size() >= FINALITY_BLOCK_CONFIRM_MINER_COUNT){
-                int count =0;
-                for(auto msg: messageSet){
-                    if(miners.count(msg.miner))
-                        count++ ;
-                    if(count >= FINALITY_BLOCK_CONFIRM_MINER_COUNT){
-                        return UpdateLocalFinBlock( height) ;
-                    }
-                }
-            }
-
-        }
+        if(GetVoteCount(pbftContext.confirmMessageMan, pTemp) >= FINALITY_BLOCK_CONFIRM_MINER_COUNT)
+            return UpdateLocalFinBlock( height) ;
 
         height--;
 
@@ -153,23 +169,9 @@ bool CPBFTMan::UpdateLocalFinBlock(const CBlockConfirmMessage& msg){
     if(pIndex->GetBlockHash() != msg.blockHash)
         return false;
 
-    set<CBlockConfirmMessage> messageSet ;
-    set<CRegID> miners;
-
-    if(pbftContext.confirmMessageMan.GetMessagesByBlockHash(pIndex->GetBlockHash(), messageSet)
-       && pbftContext.GetMinerListByBlockHash(pIndex->pprev->GetBlockHash(),miners)) {
-        if(messageSet.size() >= FINALITY_BLOCK_CONFIRM_MINER_COUNT){
-            int count =0;
-            for(auto msg: messageSet){
-                if(miners.count(msg.miner))
-                    count++ ;
-                if(count >= FINALITY_BLOCK_CONFIRM_MINER_COUNT){
-                    return UpdateLocalFinBlock(pIndex->height) ;
-                }
-            }
-        }
+    if(GetVoteCount(pbftContext.confirmMessageMan, pIndex) >= FINALITY_BLOCK_CONFIRM_MINER_COUNT)
+        return UpdateLocalFinBlock(pIndex->height) ;
 
-    }
     return false;
 }
 
@@ -183,24 +185,8 @@ bool CPBFTMan::UpdateGlobalFinBlock(const CBlockIndex* pIndex){
 
         CBlockIndex* pTemp = chainActive[height] ;
 
-        set<CBlockFinalityMessage> messageSet ;
-        set<CRegID> miners;
-
-        if(pbftContext.finalityMessageMan.GetMessagesByBlockHash(pTemp->GetBlockHash(), messageSet)
-           && pbftContext.GetMinerListByBlockHash(pTemp->pprev->GetBlockHash(),miners)){
-
-            if(messageSet.size() >= FINALITY_BLOCK_CONFIRM_MINER_COUNT){
-                int count =0;
-                for(auto msg: messageSet){
-                    if(miners.count(msg.miner))
-                        count++ ;
-                    if(count >= FINALITY_BLOCK_CONFIRM_MINER_COUNT){
-                        return UpdateGlobalFinBlock( height) ;
-                    }
-                }
-            }
-
-        }
+        if(GetVoteCount(pbftContext.finalityMessageMan, pTemp) >= FINALITY_BLOCK_CONFIRM_MINER_COUNT)
+            return UpdateGlobalFinBlock( height) ;
 
         height--;
 
@@ -227,23 +213,9 @@ bool CPBFTMan::UpdateGlobalFinBlock(const CBlockFinalityMessage& msg){
     if(pIndex->GetBlockHash() != msg.blockHash)
         return false;
 
-    set<CBlockFinalityMessage> messageSet ;
-    set<CRegID> miners;
-
-    if(pbftContext.finalityMessageMan.GetMessagesByBlockHash(pIndex->GetBlockHash(), messageSet)
-       && pbftContext.GetMinerListByBlockHash(pIndex->pprev->GetBlockHash(),miners)) {
-        if(messageSet.size() >= FINALITY_BLOCK_CONFIRM_MINER_COUNT){
-            int count =0;
-            for(auto msg: messageSet){
-                if(miners.count(msg.miner))
-                    count++ ;
-                if(count >= FINALITY_BLOCK_CONFIRM_MINER_COUNT){
-                    return UpdateGlobalFinBlock(pIndex->height) ;
-                }
-            }
-        }
+    if(GetVoteCount(pbftContext.finalityMessageMan, pIndex) >= FINALITY_BLOCK_CONFIRM_MINER_COUNT)
+        return UpdateGlobalFinBlock(pIndex->height) ;
 
-    }
     return false;
 }
 
@@ -284,11 +256,11 @@ bool BroadcastBlockFinality(const CBlockIndex* block){
         return true ;
 
     //查找上一个区块执行过后的矿工列表
-    set<CRegID> delegates;
-
     if(block->pprev == nullptr)
         return false ;
-    pbftContext.GetMinerListByBlockHash(block->pprev->GetBlockHash(), delegates);
+    DelegateSetPtr spDelegates = GetBlockDelegates(block);
+    if(!spDelegates)
+        return false ;
 
     uint256 preHash = block->pprev == nullptr? uint256(): block->pprev->GetBlockHash();
 
@@ -297,7 +269,7 @@ bool BroadcastBlockFinality(const CBlockIndex* block){
 
     {
 
-        for(auto delegate: delegates){
+        for(auto delegate: *spDelegates){
 
             Miner miner ;
             if(!PbftFindMiner(delegate, miner))
@@ -310,13 +282,14 @@ bool BroadcastBlockFinality(const CBlockIndex* block){
             msg.SetSignature(vSign);
 
             {
+                CEncodedMessageRef spMessage = CEncodedMessage::Make(NetMsgType::FINALITYBLOCK, msg);
                 LOCK(cs_vNodes);
                 for (auto pNode : vNodes) {
-                    pNode->PushBlockFinalityMessage(msg) ;
+                    pNode->PushBlockFinalityMessage(msg, spMessage) ;
                 }
             }
 
-            msgMan.SaveMessageByBlock(msg.blockHash, msg);
+            SaveBlockFinalityMessage(msg);
 
         }
     }
@@ -343,18 +316,18 @@ bool BroadcastBlockConfirm(const CBlockIndex* block) {
         return true ;
 
     //查找上一个区块执行过后的矿工列表
-    set<CRegID> delegates;
-
     if(block->pprev == nullptr)
         return false ;
-    pbftContext.GetMinerListByBlockHash(block->pprev->GetBlockHash(), delegates);
+    DelegateSetPtr spDelegates = GetBlockDelegates(block);
+    if(!spDelegates)
+        return false ;
 
     uint256 preHash = block->pprev == nullptr? uint256(): block->pprev->GetBlockHash();
     CBlockConfirmMessage msg(block->height, block->GetBlockHash(), preHash);
 
     {
 
-        for(auto delegate: delegates){
+        for(auto delegate: *spDelegates){
             Miner miner ;
             if(!PbftFindMiner(delegate, miner))
                 continue ;
@@ -366,12 +339,13 @@ bool BroadcastBlockConfirm(const CBlockIndex* block) {
             msg.SetSignature(vSign);
 
             {
+                CEncodedMessageRef spMessage = CEncodedMessage::Make(NetMsgType::CONFIRMBLOCK, msg);
                 LOCK(cs_vNodes);
                 for (auto pNode : vNodes) {
-                    pNode->PushBlockConfirmMessage(msg) ;
+                    pNode->PushBlockConfirmMessage(msg, spMessage) ;
                 }
             }
-            msgMan.SaveMessageByBlock(msg.blockHash,msg);
+            SaveBlockConfirmMessage(msg);
 
         }
     }
@@ -383,13 +357,8 @@ bool BroadcastBlockConfirm(const CBlockIndex* block) {
 bool CheckPBFTMessageSignaturer(const CPBFTMessage& msg) {
 
     //查找上一个区块执行过后的矿工列表
-    set<CRegID> delegates;
-
-    if(pbftContext.GetMinerListByBlockHash(msg.preBlockHash, delegates)) {
-        if(delegates.count(msg.miner) > 0)
-            return true ;
-    }
-    return false ;
+    DelegateSetPtr spDelegates = pbftContext.GetMinerListByBlockHash(msg.preBlockHash);
+    return spDelegates && spDelegates->count(msg.miner) > 0 ;
 }
 
 bool CheckPBFTMessage(const int32_t msgType ,const CPBFTMessage& msg){
@@ -411,38 +380,63 @@ bool CheckPBFTMessage(const int32_t msgType ,const CPBFTMessage& msg){
         return ERRORMSG("checkPbftMessage(): block not on chainActive") ;
     }
 
-    //check signature
-    CAccount account ;
-    {
-        LOCK(cs_main) ;
-        if(!pCdMan->pAccountCache->GetAccount(msg.miner, account)) {
-            return ERRORMSG("checkPBftMessage() : the signature creator is not found!");
-        }
+    //check signature with the cached keys of the delegates, never wait for cs_main
+    CDelegateKeys keys ;
+    if(!pbftContext.GetDelegateKeys(msg.miner, keys)) {
+        return ERRORMSG("checkPBftMessage() : the signature creator is not an active delegate!");
     }
+
+    // the delegate signs with its miner key if it has one, try it first
     uint256 messageHash = msg.GetHash();
-    if (!VerifySignature(messageHash, msg.vSignature, account.owner_pubkey)) {
-        if (!VerifySignature(messageHash, msg.vSignature, account.miner_pubkey))
-            return ERRORMSG("checkPBftMessage() : verify signature error");
-    }
+    if (keys.miner_pubkey.IsValid() && VerifySignature(messageHash, msg.vSignature, keys.miner_pubkey))
+        return true ;
+
+    if (!VerifySignature(messageHash, msg.vSignature, keys.owner_pubkey))
+        return ERRORMSG("checkPBftMessage() : verify signature error");
 
     return true ;
 
 }
 
+bool UpdateDelegateKeys(const VoteDelegateVector &delegates) {
+    AssertLockHeld(cs_main);
+
+    if(pbftContext.HasDelegateKeys(delegates))
+        return true ;
+
+    map<CRegID, CDelegateKeys> delegateKeys ;
+    for(const auto &delegate: delegates) {
+        CAccount account ;
+        if(!pCdMan->pAccountCache->GetAccount(delegate.regid, account))
+            return ERRORMSG("UpdateDelegateKeys() : the delegate account is not found! regid=%s",
+                            delegate.regid.ToString());
+
+        CDelegateKeys &keys = delegateKeys[delegate.regid] ;
+        keys.owner_pubkey   = account.owner_pubkey ;
+        keys.miner_pubkey   = account.miner_pubkey ;
+    }
+
+    pbftContext.SaveDelegateKeys(delegateKeys) ;
+    LogPrint(BCLog::INFO, "UpdateDelegateKeys() : cached the keys of %u delegates\n", delegateKeys.size());
+    return true ;
+}
+
 bool RelayBlockConfirmMessage(const CBlockConfirmMessage& msg){
 
+    CEncodedMessageRef spMessage = CEncodedMessage::Make(NetMsgType::CONFIRMBLOCK, msg);
     LOCK(cs_vNodes) ;
     for(auto node:vNodes){
-        node->PushBlockConfirmMessage(msg);
+        node->PushBlockConfirmMessage(msg, spMessage);
     }
     return true ;
 }
 
 bool RelayBlockFinalityMessage(const CBlockFinalityMessage& msg){
 
+    CEncodedMessageRef spMessage = CEncodedMessage::Make(NetMsgType::FINALITYBLOCK, msg);
     LOCK(cs_vNodes);
     for(auto node:vNodes){
-        node->PushBlockFinalityMessage(msg);
+        node->PushBlockFinalityMessage(msg, spMessage);
     }
     return true ;
 }
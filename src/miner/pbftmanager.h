@@ -8,6 +8,7 @@
 #define MINER_PBFTMANAGER_H
 
 #include "chain/chain.h"
+#include "entities/vote.h"
 
 class CBlockConfirmMessage ;
 class CBlockFinalityMessage ;
@@ -45,6 +46,15 @@ bool BroadcastBlockFinality(const CBlockIndex* block) ;
 bool CheckPBFTMessage(const int32_t msgType ,const CPBFTMessage& msg) ;
 
 bool CheckPBFTMessageSignaturer(const CPBFTMessage& msg) ;
+
+// cache the public keys of the active delegates if they changed, cs_main must be held
+bool UpdateDelegateKeys(const VoteDelegateVector &delegates) ;
+
+// save the message into the tally of its block, return the vote count of the delegates of the block
+uint32_t SaveBlockConfirmMessage(const CBlockConfirmMessage& msg) ;
+
+uint32_t SaveBlockFinalityMessage(const CBlockFinalityMessage& msg) ;
+
 bool RelayBlockConfirmMessage(const CBlockConfirmMessage& msg) ;
 
 bool RelayBlockFinalityMessage(const CBlockFinalityMessage& msg) ;
@@ -15,6 +15,7 @@
 #include "tx/tx.h"
 #include "commons/util/time.h"
 #include "p2p/node.h"
+#include "p2p/txreconciliation.h"
 
 #ifdef WIN32
 #include <string.h>
@@ -78,7 +79,7 @@ CNodeSignals& GetNodeSignals() { return g_node_signals; }
 
 vector<CNode*> vNodes;
 CCriticalSection cs_vNodes;
-map<CInv, CDataStream> mapRelay;
+map<CInv, CEncodedMessageRef> mapRelay;
 deque<pair<int64_t, CInv> > vRelayExpiration;
 CCriticalSection cs_mapRelay;
 
@@ -1432,7 +1433,9 @@ bool StopNode() {
         for (int32_t i = 0; i < MAX_OUTBOUND_CONNECTIONS; i++)
             semOutbound->post();
     MilliSleep(50);
-    DumpAddresses();
+    // peers.dat was not read if the node was not started, the empty address book must not overwrite it
+    if (semOutbound)
+        DumpAddresses();
 
     return true;
 }
@@ -1490,14 +1493,27 @@ void RelayTransaction(CBaseTx* pBaseTx, const uint256& hash, const CDataStream&
             vRelayExpiration.pop_front();
         }
 
-        // Save original serialized message so newer versions are preserved
-        mapRelay.insert(make_pair(inv, ss));
+        // Save original serialized message so newer versions are preserved, encoded once for all the peers
+        if (!mapRelay.count(inv))
+            mapRelay.emplace(inv, CEncodedMessage::Make(inv.GetCommand(), ss));
         vRelayExpiration.push_back(make_pair(GetTime() + 15 * 60, inv));
     }
     LOCK(cs_vNodes);
     for (auto pNode : vNodes) {
         if (!pNode->fRelayTxes)
             continue;
+
+        // reconciling peers get the tx in the next reconciliation instead of an inv
+        if (txReconTracker.IsRegistered(pNode->GetId()) && !txReconTracker.IsFloodPeer(pNode->GetId())) {
+            bool fKnown = false;
+            {
+                LOCK(pNode->cs_inventory);
+                fKnown = pNode->setInventoryKnown.count(inv) > 0;
+            }
+            if (fKnown || txReconTracker.AddToPending(pNode->GetId(), hash))
+                continue;
+        }
+
         LOCK(pNode->cs_filter);
         if (pNode->pFilter) {
             if (pNode->pFilter->IsRelevantAndUpdate(pBaseTx, hash)) {
@@ -7,12 +7,15 @@
 #define CHAINMESSAGE_H
 
 #include "alert.h"
+#include "chain/blockfilterindex.h"
 #include "commons/uint256.h"
 #include "commons/util/util.h"
 #include "main.h"
 #include "net.h"
 #include "miner/pbftcontext.h"
 #include "miner/pbftmanager.h"
+#include "p2p/txreconciliation.h"
+#include "tx/txorphanpool.h"
 #include "tx/einvalidtxtype.h"
 
 #include <string>
@@ -86,8 +89,8 @@ inline void ProcessGetData(CNode *pFrom) {
     deque<CInv>::iterator it = pFrom->vRecvGetData.begin();
 
     vector<CInv> vNotFound;
-
-    LOCK(cs_main);
+    // the bytes of the blocks served by this pass, the rest waits for the next pass of the message handler
+    size_t nBlockBytesSent = 0;
 
     while (it != pFrom->vRecvGetData.end()) {
         // Don't bother if send buffer is too full to respond anyway
@@ -95,6 +98,8 @@ inline void ProcessGetData(CNode *pFrom) {
             LogPrint(BCLog::NET, "send buffer size: %d full for peer: %s\n", pFrom->nSendSize, pFrom->addr.ToString());
             break;
         }
+        if (nBlockBytesSent >= SendBufferSize())
+            break;
 
         const CInv &inv = *it;
         {
@@ -102,27 +107,45 @@ inline void ProcessGetData(CNode *pFrom) {
             it++;
 
             if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK) {
-                bool send                                = false;
-                map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(inv.hash);
-                if (mi != mapBlockIndex.end()) {
-                    send = true;
-                } else {
-                    LogPrint(BCLog::NET, "block %s not exist\n", inv.hash.GetHex());
+                // only the index lookup holds cs_main, the block is read from its file after it
+                bool send = false;
+                CDiskBlockPos blockPos;
+                uint256 tipBlockHash;
+                {
+                    LOCK(cs_main);
+                    BlockMap::iterator mi = mapBlockIndex.find(inv.hash);
+                    if (mi != mapBlockIndex.end() && IsBlockPruned(mi->second)) {
+                        LogPrint(BCLog::NET, "block %s was pruned\n", inv.hash.GetHex());
+                    } else if (mi != mapBlockIndex.end()) {
+                        send     = true;
+                        blockPos = mi->second->GetBlockPos();
+                    } else {
+                        LogPrint(BCLog::NET, "block %s not exist\n", inv.hash.GetHex());
+                    }
+                    if (chainActive.Tip() != nullptr)
+                        tipBlockHash = chainActive.Tip()->GetBlockHash();
                 }
 
                 if (send) {
-                    // Send block from disk
-                    CBlock block;
-                    ReadBlockFromDisk((*mi).second, block);
                     if (inv.type == MSG_BLOCK) {
-                        LogPrint(BCLog::NET, "send block[%u]: %s to peer %s\n", block.GetHeight(), block.GetHash().GetHex(),
-                                 pFrom->addr.ToString());
-                        pFrom->PushMessage(NetMsgType::BLOCK, block);
+                        // Send the block bytes from disk, they are the serialized block of the network as well
+                        vector<char> rawBlock;
+                        if (ReadRawBlockFromDisk(blockPos, inv.hash, rawBlock)) {
+                            LogPrint(BCLog::NET, "send block %s (%u bytes) to peer %s\n", inv.hash.GetHex(),
+                                     rawBlock.size(), pFrom->addr.ToString());
+                            pFrom->PushMessage(NetMsgType::BLOCK,
+                                               CFlatData(rawBlock.data(), rawBlock.data() + rawBlock.size()));
+                            nBlockBytesSent += rawBlock.size();
+                        } else {
+                            // pruned since the lookup, or a bad block file
+                            vNotFound.push_back(inv);
+                        }
                     }
                     else  // MSG_FILTERED_BLOCK)
                     {
+                        CBlock block;
                         LOCK(pFrom->cs_filter);
-                        if (pFrom->pFilter) {
+                        if (pFrom->pFilter && ReadBlockFromDisk(blockPos, block) && block.GetHash() == inv.hash) {
                             CMerkleBlock merkleBlock(block, *pFrom->pFilter);
                             pFrom->PushMessage("merkleblock", merkleBlock);
                             // CMerkleBlock just contains hashes, so also push any transactions in the block the client
@@ -134,6 +157,7 @@ inline void ProcessGetData(CNode *pFrom) {
                             for (auto &pair : merkleBlock.vMatchedTxn)
                                 if (!pFrom->setInventoryKnown.count(CInv(MSG_TX, pair.second)))
                                     pFrom->PushMessage(NetMsgType::TX, block.vptx[pair.first]);
+                            nBlockBytesSent += ::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION);
                         }
                         // else
                         // no response
@@ -145,7 +169,7 @@ inline void ProcessGetData(CNode *pFrom) {
                         // and we want it right after the last block so they don't
                         // wait for other stuff first.
                         vector<CInv> vInv;
-                        vInv.push_back(CInv(MSG_BLOCK, chainActive.Tip()->GetBlockHash()));
+                        vInv.push_back(CInv(MSG_BLOCK, tipBlockHash));
                         pFrom->PushMessage(NetMsgType::INV, vInv);
                         pFrom->hashContinue.SetNull();
                         LogPrint(BCLog::NET, "reset node hashcontinue\n");
@@ -156,9 +180,9 @@ inline void ProcessGetData(CNode *pFrom) {
                 bool pushed = false;
                 {
                     LOCK(cs_mapRelay);
-                    map<CInv, CDataStream>::iterator mi = mapRelay.find(inv);
+                    auto mi = mapRelay.find(inv);
                     if (mi != mapRelay.end()) {
-                        pFrom->PushMessage(inv.GetCommand(), (*mi).second);
+                        pFrom->PushEncodedMessage(mi->second);
                         pushed = true;
                     }
                 }
@@ -179,9 +203,6 @@ inline void ProcessGetData(CNode *pFrom) {
 
             // Track requests for our stuff.
             // g_signals.Inventory(inv.hash);
-
-            if (inv.type == MSG_BLOCK || inv.type == MSG_FILTERED_BLOCK)
-                break;
         }
     }
 
@@ -316,6 +337,10 @@ inline int32_t ProcessVersionMessage(CNode *pFrom, string strCommand, CDataStrea
 
     pFrom->fClient = !(pFrom->nServices & NODE_NETWORK);
 
+    // Offer the tx reconciliation before verack
+    if (pFrom->fRelayTxes && SysCfg().GetBoolArg("-txreconciliation", DEFAULT_TXRECONCILIATION))
+        pFrom->PushMessage(NetMsgType::SENDRECON, TXRECON_VERSION, txReconTracker.PreRegister(pFrom->GetId()));
+
     // Change version
     pFrom->PushMessage(NetMsgType::VERACK);
     pFrom->ssSend.SetVersion(min(pFrom->nVersion, PROTOCOL_VERSION));
@@ -511,6 +536,19 @@ inline bool ProcessTxMessage(CNode *pFrom, string strCommand, CDataStream &vRecv
 
         LogPrint(BCLog::INFO, "AcceptToMemoryPool: %s %s : accepted %s (poolsz %u)\n", pFrom->addr.ToString(),
                  pFrom->cleanSubVer, pBaseTx->GetHash().ToString(), mempool.memPoolTxs.size());
+
+        ProcessOrphanTransactions(false);
+    } else if (!mempool.Exists(inv.hash) && IsMissingDependencyReject(state.GetRejectCode(), state.GetRejectReason())) {
+        // kept till the accounts, regids or contracts it depends on appear, other rejects are told to the peer
+        vector<COrphanTxDependency> dependencies;
+        GetMissingDependencies(*pBaseTx, *mempool.cw, dependencies);
+        if (!dependencies.empty()) {
+            if (orphanTxPool.AddTx(pBaseTx, pFrom->GetId(), dependencies, GetTime() + ORPHAN_TX_EXPIRE_TIME))
+                LogPrint(BCLog::NET, "orphan tx %s from %s waits for %s (orphans %u)\n", inv.hash.ToString(),
+                         pFrom->addr.ToString(), dependencies[0].ToString(), orphanTxPool.Size());
+
+            return true;
+        }
     }
 
     int32_t nDoS = 0;
@@ -539,7 +577,7 @@ inline bool ProcessGetHeadersMessage(CNode *pFrom, CDataStream &vRecv) {
     CBlockIndex *pIndex = nullptr;
     if (locator.IsNull()) {
         // If locator is null, return the hashStop block
-        map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(hashStop);
+        BlockMap::iterator mi = mapBlockIndex.find(hashStop);
         if (mi == mapBlockIndex.end())
             return true;
 
@@ -592,6 +630,11 @@ inline void ProcessGetBlocksMessage(CNode *pFrom, CDataStream &vRecv) {
                 pIndex->GetIndentityString(), pFrom->addrName);
             break;
         }
+        if (IsBlockPruned(pIndex)) {
+            LogPrint(BCLog::NET, "processing getblocks stopped by pruned block! block=%s, peer=%s\n",
+                pIndex->GetIndentityString(), pFrom->addrName);
+            break;
+        }
 
         // bool forced = false;
         // if (pIndex == pStartIndex || pIndex->pprev == pStartIndex)
@@ -761,6 +804,115 @@ inline void ProcessMempoolMessage(CNode *pFrom, CDataStream &vRecv) {
     if (vInv.size() > 0) pFrom->PushMessage(NetMsgType::INV, vInv);
 }
 
+inline void PushTxInventory(CNode *pFrom, const vector<uint256> &txids) {
+    for (const auto &txid : txids)
+        pFrom->PushInventory(CInv(MSG_TX, txid));
+}
+
+inline void ProcessSendReconMessage(CNode *pFrom, CDataStream &vRecv) {
+    uint32_t reconVersion;
+    uint64_t remoteSalt;
+    vRecv >> reconVersion >> remoteSalt;
+
+    // ignored if the reconciliation was not offered to the peer
+    if (txReconTracker.Register(pFrom->GetId(), pFrom->fInbound, reconVersion, remoteSalt))
+        LogPrint(BCLog::NET, "tx reconciliation enabled, version=%d, flood=%d, peer=%s\n", reconVersion,
+                 txReconTracker.IsFloodPeer(pFrom->GetId()), pFrom->addrName);
+}
+
+inline void ProcessReqReconMessage(CNode *pFrom, CDataStream &vRecv) {
+    uint32_t remoteSetSize;
+    uint16_t q;
+    vRecv >> remoteSetSize >> q;
+
+    CTxReconSketch sketch;
+    if (!txReconTracker.HandleReqRecon(pFrom->GetId(), remoteSetSize, q, sketch)) {
+        LogPrint(BCLog::INFO, "Misbehaving: unexpected reqrecon from peer %s, Misbehavior add 20\n", pFrom->addrName);
+        Misbehaving(pFrom->GetId(), 20);
+        return;
+    }
+
+    pFrom->PushMessage(NetMsgType::SKETCH, sketch);
+}
+
+inline void ProcessSketchMessage(CNode *pFrom, CDataStream &vRecv) {
+    CTxReconSketch sketch;
+    vRecv >> sketch;
+
+    bool fSuccess = false;
+    vector<uint256> txidsToAnnounce;
+    vector<uint32_t> askShortIds;
+    if (!txReconTracker.HandleSketch(pFrom->GetId(), sketch, fSuccess, txidsToAnnounce, askShortIds)) {
+        LogPrint(BCLog::INFO, "Misbehaving: unexpected or invalid sketch from peer %s, Misbehavior add 20\n",
+                 pFrom->addrName);
+        Misbehaving(pFrom->GetId(), 20);
+        return;
+    }
+
+    LogPrint(BCLog::NET, "tx reconciliation done, success=%d, announce=%u, ask=%u, peer=%s\n", fSuccess,
+             txidsToAnnounce.size(), askShortIds.size(), pFrom->addrName);
+
+    PushTxInventory(pFrom, txidsToAnnounce);
+    pFrom->PushMessage(NetMsgType::RECONCILDIFF, fSuccess, askShortIds);
+}
+
+inline void ProcessReconcilDiffMessage(CNode *pFrom, CDataStream &vRecv) {
+    bool fSuccess;
+    vector<uint32_t> askShortIds;
+    vRecv >> fSuccess >> askShortIds;
+
+    vector<uint256> txidsToAnnounce;
+    if (!txReconTracker.HandleReconDiff(pFrom->GetId(), fSuccess, askShortIds, txidsToAnnounce)) {
+        LogPrint(BCLog::INFO, "Misbehaving: unexpected reconcildiff from peer %s, Misbehavior add 20\n",
+                 pFrom->addrName);
+        Misbehaving(pFrom->GetId(), 20);
+        return;
+    }
+
+    PushTxInventory(pFrom, txidsToAnnounce);
+}
+
+inline void ProcessGetCFiltersMessage(CNode *pFrom, CDataStream &vRecv) {
+    uint32_t startHeight;
+    uint256 stopHash;
+    vRecv >> startHeight >> stopHash;
+
+    if (pBlockFilterIndex == nullptr) {
+        LogPrint(BCLog::NET, "getcfilters from peer %s, the block filter index is disabled\n", pFrom->addrName);
+        return;
+    }
+
+    LOCK(cs_main);
+    auto it = mapBlockIndex.find(stopHash);
+    if (it == mapBlockIndex.end()) {
+        LogPrint(BCLog::NET, "getcfilters from peer %s, unknown stop block %s\n", pFrom->addrName, stopHash.GetHex());
+        return;
+    }
+
+    const CBlockIndex *pStopIndex = it->second;
+    if (startHeight > (uint32_t)pStopIndex->height || pStopIndex->height - startHeight >= MAX_GETCFILTERS_SIZE) {
+        LogPrint(BCLog::INFO, "Misbehaving: getcfilters from peer %s, bad range start=%u, stop=%d, Misbehavior add 20\n",
+                 pFrom->addrName, startHeight, pStopIndex->height);
+        Misbehaving(pFrom->GetId(), 20);
+        return;
+    }
+
+    // the requested blocks are the ancestors of the stop block
+    vector<const CBlockIndex *> indexes(pStopIndex->height - startHeight + 1);
+    for (const CBlockIndex *pIndex = pStopIndex; pIndex && pIndex->height >= (int32_t)startHeight; pIndex = pIndex->pprev)
+        indexes[pIndex->height - startHeight] = pIndex;
+
+    for (auto pIndex : indexes) {
+        CBlockFilter filter;
+        uint256 header;
+        // not indexed yet
+        if (pIndex == nullptr || !pBlockFilterIndex->LookupFilter(pIndex, filter, header))
+            break;
+
+        pFrom->PushMessage(NetMsgType::CFILTER, filter, header);
+    }
+}
+
 inline void ProcessAlertMessage(CNode *pFrom, CDataStream &vRecv) {
     CAlert alert;
     vRecv >> alert;
@@ -851,10 +1003,10 @@ bool ProcessBlockConfirmMessage(CNode *pFrom, CDataStream &vRecv) {
     }
 
     msgMan.AddMessageKnown(message);
-    int messageCount = msgMan.SaveMessageByBlock(message.blockHash, message);
+    uint32_t voteCount = SaveBlockConfirmMessage(message);
 
     bool updateFinalitySuccess = false ;
-    if(messageCount >= FINALITY_BLOCK_CONFIRM_MINER_COUNT){
+    if(voteCount >= FINALITY_BLOCK_CONFIRM_MINER_COUNT){
        updateFinalitySuccess = pbftMan.UpdateLocalFinBlock(message) ;
     }
 
@@ -895,8 +1047,8 @@ bool ProcessBlockFinalityMessage(CNode *pFrom, CDataStream &vRecv) {
     }
 
     msgMan.AddMessageKnown(message);
-    int messageCount = msgMan.SaveMessageByBlock(message.blockHash, message);
-    if(messageCount>= FINALITY_BLOCK_CONFIRM_MINER_COUNT){
+    uint32_t voteCount = SaveBlockFinalityMessage(message);
+    if(voteCount >= FINALITY_BLOCK_CONFIRM_MINER_COUNT){
         pbftMan.UpdateGlobalFinBlock(message) ;
     }
     if(CheckPBFTMessageSignaturer(message))
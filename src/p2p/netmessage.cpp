@@ -4,6 +4,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "netmessage.h"
+#include "crypto/hash.h"
 
 int32_t CNetMessage::readHeader(const char* pch, uint32_t nBytes) {
     // copy data to temporary parsing buffer
@@ -44,3 +45,23 @@ int32_t CNetMessage::readData(const char* pch, uint32_t nBytes) {
 
     return nCopy;
 }
+
+CEncodedMessageRef CEncodedMessage::FromStream(CDataStream &ss) {
+    assert(ss.size() >= CMessageHeader::HEADER_SIZE);
+
+    // Set the size
+    uint32_t nSize = ss.size() - CMessageHeader::HEADER_SIZE;
+    memcpy((char *)&ss[CMessageHeader::MESSAGE_SIZE_OFFSET], &nSize, sizeof(nSize));
+
+    // Set the checksum
+    uint256 hash       = Hash(ss.begin() + CMessageHeader::HEADER_SIZE, ss.end());
+    uint32_t nChecksum = 0;
+    memcpy(&nChecksum, &hash, sizeof(nChecksum));
+    memcpy((char *)&ss[CMessageHeader::CHECKSUM_OFFSET], &nChecksum, sizeof(nChecksum));
+
+    std::shared_ptr<CEncodedMessage> spMessage(new CEncodedMessage());
+    const char *pszCommand = &ss[MESSAGE_START_SIZE];
+    spMessage->command     = string(pszCommand, strnlen(pszCommand, CMessageHeader::COMMAND_SIZE));
+    ss.GetAndClear(spMessage->buffer);
+    return spMessage;
+}
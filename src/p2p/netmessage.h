@@ -7,8 +7,11 @@
 #define P2P_NETMESSAGE_H
 
 #include "commons/serialize.h"
+#include "config/version.h"
 #include "p2p/protocol.h"
 
+#include <memory>
+
 class CNetMessage {
 public:
     bool in_data;  // parsing header (false) or data (true)
@@ -43,5 +46,34 @@ public:
 };
 
 
+class CEncodedMessage;
+typedef std::shared_ptr<const CEncodedMessage> CEncodedMessageRef;
+
+/**
+ * A message encoded for the wire, header, payload and checksum, immutable. It's encoded once
+ * and queued as is on the send queue of every peer it's sent to.
+ */
+class CEncodedMessage {
+public:
+    template <typename T>
+    static CEncodedMessageRef Make(const char *pszCommand, const T &payload) {
+        CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+        ss << CMessageHeader(pszCommand, 0) << payload;
+        return FromStream(ss);
+    }
+
+    // the message of the stream of the header and the payload, the stream is cleared
+    static CEncodedMessageRef FromStream(CDataStream &ss);
+
+    const string &GetCommand() const { return command; }
+    const char *data() const { return buffer.data(); }
+    size_t size() const { return buffer.size(); }
+
+private:
+    CEncodedMessage() {}
+
+    string command;
+    CSerializeData buffer;
+};
 
 #endif //WAYKICHAIN_NETMESSAGE_H
@@ -36,14 +36,29 @@ CNodeState *State(NodeId pNode) {
     return &it->second;
 }
 
+// requires LOCK(cs_vSend)
+void CNode::QueueMessage(const CEncodedMessageRef &spMessage) {
+    vSendMsg.push_back(spMessage);
+    nSendSize += spMessage->size();
+
+    // If write queue empty, attempt "optimistic write"
+    if (vSendMsg.size() == 1) SocketSendData();
+}
+
+void CNode::PushEncodedMessage(const CEncodedMessageRef &spMessage) {
+    LOCK(cs_vSend);
+    LogPrint(BCLog::NET, "sending: %s (%d bytes, shared)\n", spMessage->GetCommand(), spMessage->size());
+    QueueMessage(spMessage);
+}
+
 // requires LOCK(cs_vSend)
 void CNode::SocketSendData() {
-    deque<CSerializeData>::iterator it = vSendMsg.begin();
+    deque<CEncodedMessageRef>::iterator it = vSendMsg.begin();
 
     while (it != vSendMsg.end()) {
-        const CSerializeData& data = *it;
+        const CEncodedMessage& data = **it;
         assert(data.size() > nSendOffset);
-        int32_t nBytes = send(hSocket, &data[nSendOffset], data.size() - nSendOffset,
+        int32_t nBytes = send(hSocket, data.data() + nSendOffset, data.size() - nSendOffset,
                               MSG_NOSIGNAL | MSG_DONTWAIT);
         if (nBytes > 0) {
             nLastSend = GetTime();
@@ -139,7 +139,7 @@ public:
     size_t nSendSize;    // total size of all vSendMsg entries
     size_t nSendOffset;  // offset inside the first vSendMsg already sent
     uint64_t nSendBytes;
-    deque<CSerializeData> vSendMsg;
+    deque<CEncodedMessageRef> vSendMsg;
     CCriticalSection cs_vSend;
 
     deque<CInv> vRecvGetData;  // strCommand == "getdata 保存的inv
@@ -371,18 +371,19 @@ public:
         }
     }
 
-    void PushBlockConfirmMessage(const CBlockConfirmMessage& msg) {
+    // spMessage is the msg encoded once for all the peers
+    void PushBlockConfirmMessage(const CBlockConfirmMessage& msg, const CEncodedMessageRef &spMessage) {
         LOCK(cs_blockConfirm);
         if(!setBlockConfirmMsgKnown.count(msg)){
-            PushMessage(NetMsgType::CONFIRMBLOCK, msg);
+            PushEncodedMessage(spMessage);
             setBlockConfirmMsgKnown.insert(msg);
         }
     }
 
-    void PushBlockFinalityMessage(const CBlockFinalityMessage& msg) {
+    void PushBlockFinalityMessage(const CBlockFinalityMessage& msg, const CEncodedMessageRef &spMessage) {
         LOCK(cs_blockFinality);
         if(!setBlockFinalityMsgKnown.count(msg)){
-            PushMessage(NetMsgType::FINALITYBLOCK, msg) ;
+            PushEncodedMessage(spMessage);
             setBlockFinalityMsgKnown.insert(msg);
         }
     }
@@ -452,31 +453,18 @@ public:
             if (ssSend.size() == 0)
             return;
 
-            // Set the size
-            uint32_t nSize = ssSend.size() - CMessageHeader::HEADER_SIZE;
-            memcpy((char*)&ssSend[CMessageHeader::MESSAGE_SIZE_OFFSET], &nSize, sizeof(nSize));
-
-            // Set the checksum
-            uint256 hash           = Hash(ssSend.begin() + CMessageHeader::HEADER_SIZE, ssSend.end());
-            uint32_t nChecksum = 0;
-            memcpy(&nChecksum, &hash, sizeof(nChecksum));
-            assert(ssSend.size() >= CMessageHeader::CHECKSUM_OFFSET + sizeof(nChecksum));
-            memcpy((char*)&ssSend[CMessageHeader::CHECKSUM_OFFSET], &nChecksum, sizeof(nChecksum));
-
-            LogPrint(BCLog::NET, "(%d bytes)\n", nSize);
-
-            deque<CSerializeData>::iterator it = vSendMsg.insert(vSendMsg.end(), CSerializeData());
-            ssSend.GetAndClear(*it);
-            nSendSize += (*it).size();
-
-            // If write queue empty, attempt "optimistic write"
-            if (it == vSendMsg.begin()) SocketSendData();
+            CEncodedMessageRef spMessage = CEncodedMessage::FromStream(ssSend);
+            LogPrint(BCLog::NET, "(%d bytes)\n", spMessage->size() - CMessageHeader::HEADER_SIZE);
+            QueueMessage(spMessage);
 
             LEAVE_CRITICAL_SECTION(cs_vSend);
     }
 
     void PushVersion();
 
+    // queue the message encoded already, the same one can be queued on any number of peers
+    void PushEncodedMessage(const CEncodedMessageRef &spMessage);
+
     void PushMessage(const char* pszCommand) {
         try {
             BeginMessage(pszCommand);
@@ -606,6 +594,8 @@ public:
     void CloseSocketDisconnect();
     void Cleanup();
     void SocketSendData();
+    // requires LOCK(cs_vSend)
+    void QueueMessage(const CEncodedMessageRef &spMessage);
     // Denial-of-service detection/prevention
     // The idea is to detect peers that are behaving
     // badly and disconnect/ban them, but do it in a
@@ -7,6 +7,7 @@
 #define PROCESSMESSAGE_HPP
 
 #include "main.h"
+#include "commons/metrics.h"
 
 bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv) {
     LogPrint(BCLog::NET, "received: %s (%u bytes) from peer %s\n", strCommand, vRecv.size(), pFrom->addr.ToString());
@@ -129,9 +130,26 @@ bool static ProcessMessage(CNode *pFrom, string strCommand, CDataStream &vRecv)
     else if (strCommand == NetMsgType::REJECT) {
         ProcessRejectMessage(pFrom, vRecv);
     }
+    else if (strCommand == NetMsgType::SENDRECON) {
+        ProcessSendReconMessage(pFrom, vRecv);
+    }
+    else if (strCommand == NetMsgType::REQRECON) {
+        ProcessReqReconMessage(pFrom, vRecv);
+    }
+    else if (strCommand == NetMsgType::SKETCH) {
+        ProcessSketchMessage(pFrom, vRecv);
+    }
+    else if (strCommand == NetMsgType::RECONCILDIFF) {
+        ProcessReconcilDiffMessage(pFrom, vRecv);
+    }
+    else if (strCommand == NetMsgType::GETCFILTERS) {
+        ProcessGetCFiltersMessage(pFrom, vRecv);
+    }
     else if (strCommand == NetMsgType::CONFIRMBLOCK) {
+        CMetricTimer timer(metrics::pbft_message);
         ProcessBlockConfirmMessage(pFrom, vRecv) ;
     } else if (strCommand == NetMsgType::FINALITYBLOCK) {
+        CMetricTimer timer(metrics::pbft_message);
         ProcessBlockFinalityMessage(pFrom, vRecv);
     }
     else {
@@ -36,6 +36,12 @@ namespace NetMsgType {
     const char *REJECT="reject";
     const char *CONFIRMBLOCK = "confirmblock";
     const char *FINALITYBLOCK = "finblock" ;
+    const char *SENDRECON = "sendrecon";
+    const char *REQRECON = "reqrecon";
+    const char *SKETCH = "sketch";
+    const char *RECONCILDIFF = "reconcildiff";
+    const char *GETCFILTERS = "getcfilters";
+    const char *CFILTER = "cfilter";
     // const char *SENDHEADERS="sendheaders";
     // const char *FEEFILTER="feefilter";
     // const char *SENDCMPCT="sendcmpct";
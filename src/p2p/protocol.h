@@ -62,6 +62,10 @@ class CMessageHeader
 enum
 {
     NODE_NETWORK = (1 << 0),
+    // NODE_NETWORK_LIMITED means the node is pruned and serves the recent blocks only, see -prune
+    NODE_NETWORK_LIMITED = (1 << 10),
+    // NODE_COMPACT_FILTERS means the node serves the compact block filters by getcfilters
+    NODE_COMPACT_FILTERS = (1 << 6),
 };
 
 
@@ -253,6 +257,36 @@ extern const char *BLOCKTXN;
 extern const char *CONFIRMBLOCK ;
 
 extern const char *FINALITYBLOCK ;
+
+/**
+ * Contains the tx reconciliation version and a salt of the short txids.
+ * Indicates that a node is willing to reconcile the tx announcements with the peer
+ * instead of flooding the invs, sent before verack.
+ */
+extern const char *SENDRECON;
+/**
+ * Contains the size of the initiator's reconciliation set and the q coefficient,
+ * the peer should respond with "sketch".
+ */
+extern const char *REQRECON;
+/**
+ * Contains the sketch of the responder's reconciliation set.
+ */
+extern const char *SKETCH;
+/**
+ * Contains whether the sketch is decoded and the short txids the initiator lacks.
+ */
+extern const char *RECONCILDIFF;
+/**
+ * Requests the compact filters of the blocks of the active chain from the
+ * start height to the stop hash, the peer should respond with "cfilter".
+ * Only available with service bit NODE_COMPACT_FILTERS.
+ */
+extern const char *GETCFILTERS;
+/**
+ * Contains the compact filter and the filter header of a block.
+ */
+extern const char *CFILTER;
 };
 
 enum PBFTMsgType {
@@ -201,6 +201,14 @@ bool SendMessages(CNode *pTo, bool fSendTrickle) {
         if (!vInv.empty())
             pTo->PushMessage(NetMsgType::INV, vInv);
 
+        //
+        // Message: reqrecon
+        //
+        uint32_t reconSetSize;
+        uint16_t reconQ;
+        if (txReconTracker.InitiateRecon(pTo->GetId(), GetTimeMicros(), reconSetSize, reconQ))
+            pTo->PushMessage(NetMsgType::REQRECON, reconSetSize, reconQ);
+
         // Detect stalled peers. Require that blocks are in flight, we haven't
         // received a (requested) block in one minute, and that all blocks are
         // in flight for over two minutes, since we first had a chance to
@@ -0,0 +1,330 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "txreconciliation.h"
+
+#include <algorithm>
+#include <deque>
+
+#include "commons/random.h"
+#include "crypto/hash.h"
+#include "crypto/siphash.h"
+
+CTxReconTracker txReconTracker;
+
+static const string TXRECON_SALT_TAG = "WaykiChain-txrecon";
+
+// finalizer of splitmix64, the short txids are salted already
+static inline uint64_t MixShortId(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+static inline uint32_t GetCheckSum(uint32_t shortId) { return MixShortId(shortId ^ 0x5bd1e9955bd1e995ULL); }
+
+static inline uint32_t GetCellIndex(uint32_t shortId, uint32_t hashIndex, uint32_t subTableSize) {
+    return hashIndex * subTableSize + MixShortId(shortId + hashIndex * 0x9e3779b97f4a7c15ULL) % subTableSize;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class CTxReconSketch
+
+bool CTxReconSketch::Cell::IsPure() const {
+    return (count == 1 || count == -1) && check_sum == GetCheckSum(key_sum);
+}
+
+uint32_t CTxReconSketch::GetCellCount(uint32_t capacity) {
+    capacity = std::max<uint32_t>(capacity, 1);
+    uint32_t cellCount = (capacity * 3 + 1) / 2 + HASH_COUNT * 2;
+    return (cellCount + HASH_COUNT - 1) / HASH_COUNT * HASH_COUNT;
+}
+
+bool CTxReconSketch::IsValid() const {
+    return cells.size() % HASH_COUNT == 0 &&
+           cells.size() <= GetCellCount(MAX_TXRECON_SKETCH_CAPACITY);
+}
+
+void CTxReconSketch::Add(uint32_t shortId) {
+    if (cells.empty())
+        return;
+
+    uint32_t subTableSize = cells.size() / HASH_COUNT;
+    uint32_t checkSum     = GetCheckSum(shortId);
+    for (uint32_t i = 0; i < HASH_COUNT; i++) {
+        Cell &cell = cells[GetCellIndex(shortId, i, subTableSize)];
+        cell.count++;
+        cell.key_sum ^= shortId;
+        cell.check_sum ^= checkSum;
+    }
+}
+
+bool CTxReconSketch::Subtract(const CTxReconSketch &other) {
+    if (other.cells.size() != cells.size())
+        return false;
+
+    for (uint32_t i = 0; i < cells.size(); i++) {
+        cells[i].count -= other.cells[i].count;
+        cells[i].key_sum ^= other.cells[i].key_sum;
+        cells[i].check_sum ^= other.cells[i].check_sum;
+    }
+    return true;
+}
+
+bool CTxReconSketch::Decode(vector<uint32_t> &localOnlyIds, vector<uint32_t> &remoteOnlyIds) const {
+    if (cells.empty() || !IsValid())
+        return false;
+
+    vector<Cell> peeling     = cells;
+    uint32_t subTableSize    = peeling.size() / HASH_COUNT;
+    std::deque<uint32_t> pureIndexes;
+    for (uint32_t i = 0; i < peeling.size(); i++) {
+        if (peeling[i].IsPure())
+            pureIndexes.push_back(i);
+    }
+
+    while (!pureIndexes.empty()) {
+        const Cell &pureCell = peeling[pureIndexes.front()];
+        pureIndexes.pop_front();
+        if (!pureCell.IsPure())
+            continue;
+
+        uint32_t shortId = pureCell.key_sum;
+        int16_t count    = pureCell.count;
+        if (localOnlyIds.size() + remoteOnlyIds.size() >= peeling.size())
+            return false;  // can not be more than the cells
+
+        (count > 0 ? localOnlyIds : remoteOnlyIds).push_back(shortId);
+
+        uint32_t checkSum = GetCheckSum(shortId);
+        for (uint32_t i = 0; i < HASH_COUNT; i++) {
+            uint32_t index = GetCellIndex(shortId, i, subTableSize);
+            Cell &cell     = peeling[index];
+            cell.count -= count;
+            cell.key_sum ^= shortId;
+            cell.check_sum ^= checkSum;
+            if (cell.IsPure())
+                pureIndexes.push_back(index);
+        }
+    }
+
+    for (const auto &cell : peeling) {
+        if (!cell.IsEmpty())
+            return false;
+    }
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class CTxReconState
+
+CTxReconState::CTxReconState(bool fInitiatorIn, bool fFloodIn, uint64_t localSalt, uint64_t remoteSalt)
+    : fInitiator(fInitiatorIn), fFlood(fFloodIn), q(DEFAULT_TXRECON_Q), nNextReconTime(0), fReconInProgress(false) {
+    // both sides get the same salts regardless of the order
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << TXRECON_SALT_TAG << std::min(localSalt, remoteSalt) << std::max(localSalt, remoteSalt);
+    uint256 hash = ss.GetHash();
+    k0           = hash.GetUint64(0);
+    k1           = hash.GetUint64(1);
+}
+
+uint32_t CTxReconState::GetShortId(const uint256 &txid) const { return (uint32_t)SipHashUint256(k0, k1, txid); }
+
+void CTxReconState::StartRecon() {
+    reconTxids.clear();
+    for (const auto &txid : pendingTxids)
+        reconTxids.emplace(GetShortId(txid), txid);
+
+    pendingTxids.clear();
+    fReconInProgress = true;
+}
+
+void CTxReconState::FinishRecon() {
+    reconTxids.clear();
+    fReconInProgress = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class CTxReconTracker
+
+uint64_t CTxReconTracker::PreRegister(NodeId nodeId) {
+    uint64_t localSalt = GetRandHash().GetCheapHash();
+
+    LOCK(cs_txrecon);
+    mapLocalSalts[nodeId] = localSalt;
+    return localSalt;
+}
+
+bool CTxReconTracker::Register(NodeId nodeId, bool fInbound, uint32_t peerReconVersion, uint64_t remoteSalt) {
+    LOCK(cs_txrecon);
+    auto it = mapLocalSalts.find(nodeId);
+    if (it == mapLocalSalts.end() || mapStates.count(nodeId))
+        return false;
+
+    if (peerReconVersion < TXRECON_VERSION)
+        return false;
+
+    uint32_t floodCount = 0;
+    for (const auto &item : mapStates) {
+        if (item.second.fFlood)
+            floodCount++;
+    }
+    bool fFlood = !fInbound && floodCount < MAX_TXRECON_FLOOD_OUTBOUND;
+
+    mapStates.emplace(nodeId, CTxReconState(!fInbound, fFlood, it->second, remoteSalt));
+    mapLocalSalts.erase(it);
+    return true;
+}
+
+void CTxReconTracker::Forget(NodeId nodeId) {
+    LOCK(cs_txrecon);
+    mapLocalSalts.erase(nodeId);
+    mapStates.erase(nodeId);
+}
+
+bool CTxReconTracker::IsRegistered(NodeId nodeId) const {
+    LOCK(cs_txrecon);
+    return mapStates.count(nodeId) > 0;
+}
+
+bool CTxReconTracker::IsFloodPeer(NodeId nodeId) const {
+    LOCK(cs_txrecon);
+    auto it = mapStates.find(nodeId);
+    return it != mapStates.end() && it->second.fFlood;
+}
+
+bool CTxReconTracker::AddToPending(NodeId nodeId, const uint256 &txid) {
+    LOCK(cs_txrecon);
+    auto it = mapStates.find(nodeId);
+    if (it == mapStates.end() || it->second.fFlood)
+        return false;
+
+    CTxReconState &state = it->second;
+    if (state.pendingTxids.size() >= MAX_TXRECON_SET_SIZE)
+        return false;
+
+    state.pendingTxids.insert(txid);
+    return true;
+}
+
+bool CTxReconTracker::InitiateRecon(NodeId nodeId, int64_t nNow, uint32_t &setSize, uint16_t &q) {
+    LOCK(cs_txrecon);
+    auto it = mapStates.find(nodeId);
+    if (it == mapStates.end())
+        return false;
+
+    CTxReconState &state = it->second;
+    if (!state.fInitiator || state.fReconInProgress || nNow < state.nNextReconTime)
+        return false;
+
+    state.StartRecon();
+    state.nNextReconTime = nNow + TXRECON_INTERVAL;
+    setSize              = state.reconTxids.size();
+    q                    = state.q;
+    return true;
+}
+
+bool CTxReconTracker::HandleSketch(NodeId nodeId, const CTxReconSketch &remoteSketch, bool &fSuccess,
+                                   vector<uint256> &txidsToAnnounce, vector<uint32_t> &askShortIds) {
+    LOCK(cs_txrecon);
+    auto it = mapStates.find(nodeId);
+    if (it == mapStates.end())
+        return false;
+
+    CTxReconState &state = it->second;
+    if (!state.fInitiator || !state.fReconInProgress || !remoteSketch.IsValid())
+        return false;
+
+    CTxReconSketch localSketch(remoteSketch.GetCellCount());
+    for (const auto &item : state.reconTxids)
+        localSketch.Add(item.first);
+
+    vector<uint32_t> localOnlyIds;
+    localSketch.Subtract(remoteSketch);
+    fSuccess = localSketch.Decode(localOnlyIds, askShortIds);
+
+    if (fSuccess) {
+        for (const auto &shortId : localOnlyIds) {
+            auto txidIt = state.reconTxids.find(shortId);
+            if (txidIt != state.reconTxids.end())
+                txidsToAnnounce.push_back(txidIt->second);
+        }
+
+        // q = (difference - |local size - remote size|) / min(local size, remote size)
+        uint64_t localSize  = state.reconTxids.size();
+        uint64_t remoteSize = localSize - localOnlyIds.size() + askShortIds.size();
+        uint64_t minSize    = std::min(localSize, remoteSize);
+        if (minSize > 0) {
+            uint64_t sizeDiff = localSize > remoteSize ? localSize - remoteSize : remoteSize - localSize;
+            uint64_t diff     = localOnlyIds.size() + askShortIds.size() - sizeDiff;
+            state.q = std::min<uint64_t>(diff * TXRECON_Q_PRECISION / minSize, MAX_TXRECON_Q);
+        }
+    } else {
+        askShortIds.clear();
+        for (const auto &item : state.reconTxids)
+            txidsToAnnounce.push_back(item.second);
+    }
+
+    state.FinishRecon();
+    return true;
+}
+
+bool CTxReconTracker::HandleReqRecon(NodeId nodeId, uint32_t remoteSetSize, uint16_t q, CTxReconSketch &sketch) {
+    LOCK(cs_txrecon);
+    auto it = mapStates.find(nodeId);
+    if (it == mapStates.end())
+        return false;
+
+    CTxReconState &state = it->second;
+    if (state.fInitiator || state.fReconInProgress || q > MAX_TXRECON_Q)
+        return false;
+
+    state.StartRecon();
+
+    uint64_t localSize = state.reconTxids.size();
+    uint64_t minSize   = std::min<uint64_t>(localSize, remoteSetSize);
+    uint64_t sizeDiff  = localSize > remoteSetSize ? localSize - remoteSetSize : remoteSetSize - localSize;
+    uint64_t capacity  = sizeDiff + minSize * q / TXRECON_Q_PRECISION + 1;
+
+    // the difference is the whole set of one side, an empty sketch makes both sides announce their sets
+    if (minSize == 0) {
+        sketch = CTxReconSketch(0);
+        return true;
+    }
+
+    sketch = CTxReconSketch(CTxReconSketch::GetCellCount(std::min<uint64_t>(capacity, MAX_TXRECON_SKETCH_CAPACITY)));
+    for (const auto &item : state.reconTxids)
+        sketch.Add(item.first);
+
+    return true;
+}
+
+bool CTxReconTracker::HandleReconDiff(NodeId nodeId, bool fSuccess, const vector<uint32_t> &askShortIds,
+                                      vector<uint256> &txidsToAnnounce) {
+    LOCK(cs_txrecon);
+    auto it = mapStates.find(nodeId);
+    if (it == mapStates.end())
+        return false;
+
+    CTxReconState &state = it->second;
+    if (state.fInitiator || !state.fReconInProgress || askShortIds.size() > state.reconTxids.size())
+        return false;
+
+    if (fSuccess) {
+        for (const auto &shortId : askShortIds) {
+            auto txidIt = state.reconTxids.find(shortId);
+            if (txidIt != state.reconTxids.end())
+                txidsToAnnounce.push_back(txidIt->second);
+        }
+    } else {
+        for (const auto &item : state.reconTxids)
+            txidsToAnnounce.push_back(item.second);
+    }
+
+    state.FinishRecon();
+    return true;
+}
@@ -0,0 +1,154 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef P2P_TXRECONCILIATION_H
+#define P2P_TXRECONCILIATION_H
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "commons/serialize.h"
+#include "commons/uint256.h"
+#include "sync.h"
+
+using namespace std;
+
+typedef int32_t NodeId;
+
+/** The tx reconciliation protocol version, exchanged in the sendrecon message */
+static const uint32_t TXRECON_VERSION = 1;
+/** Default for -txreconciliation */
+static const bool DEFAULT_TXRECONCILIATION = false;
+/** The interval between two reconciliations with the same peer, in microseconds */
+static const int64_t TXRECON_INTERVAL = 2 * 1000000;
+/** The number of outbound reconciling peers which still get the tx invs flooded */
+static const uint32_t MAX_TXRECON_FLOOD_OUTBOUND = 2;
+/** The max number of txs waiting for the reconciliation of one peer, the rest are flooded */
+static const uint32_t MAX_TXRECON_SET_SIZE = 4000;
+/** The max capacity (expected set difference) of a sketch */
+static const uint32_t MAX_TXRECON_SKETCH_CAPACITY = 4000;
+/** The coefficient q of the set difference estimation is transferred in fixed point */
+static const uint16_t TXRECON_Q_PRECISION = 1000;
+static const uint16_t DEFAULT_TXRECON_Q   = 250;
+static const uint16_t MAX_TXRECON_Q       = 2000;
+
+/**
+ * Invertible bloom lookup table of the short txids of a tx set.
+ *
+ * Subtracting the sketch of the peer's set from the sketch of the local set with the
+ * same cell count leaves only the symmetric difference of the two sets, which can be
+ * decoded as long as it does not exceed the capacity of the sketches.
+ */
+class CTxReconSketch {
+public:
+    static const uint32_t HASH_COUNT = 3;
+
+    // 10 bytes per cell on the wire
+    struct Cell {
+        int16_t count;
+        uint32_t key_sum;
+        uint32_t check_sum;
+
+        Cell() : count(0), key_sum(0), check_sum(0) {}
+
+        bool IsEmpty() const { return count == 0 && key_sum == 0 && check_sum == 0; }
+        bool IsPure() const;
+
+        IMPLEMENT_SERIALIZE(
+            READWRITE(count);
+            READWRITE(key_sum);
+            READWRITE(check_sum);
+        )
+    };
+
+private:
+    vector<Cell> cells;
+
+public:
+    CTxReconSketch() {}
+    explicit CTxReconSketch(uint32_t cellCount) : cells(cellCount) {}
+
+    // the cell count of the sketch which is expected to decode a set difference of capacity
+    static uint32_t GetCellCount(uint32_t capacity);
+
+    uint32_t GetCellCount() const { return cells.size(); }
+    bool IsValid() const;
+
+    void Add(uint32_t shortId);
+    bool Subtract(const CTxReconSketch &other);
+    // decode the set difference, requires the sketch of the peer being subtracted
+    bool Decode(vector<uint32_t> &localOnlyIds, vector<uint32_t> &remoteOnlyIds) const;
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(cells);
+    )
+};
+
+/** Reconciliation state of a registered peer */
+class CTxReconState {
+public:
+    bool fInitiator;                    // we initiate the reconciliations, true for the outbound peers
+    bool fFlood;                        // outbound peer which still gets the tx invs flooded
+    uint64_t k0;                        // salts of the short txids
+    uint64_t k1;
+    uint16_t q;                         // coefficient of the set difference estimation
+    int64_t nNextReconTime;
+    set<uint256> pendingTxids;          // txs waiting for the next reconciliation
+    map<uint32_t, uint256> reconTxids;  // short txid -> txid of the reconciliation in progress
+    bool fReconInProgress;
+
+    CTxReconState(bool fInitiatorIn, bool fFloodIn, uint64_t localSalt, uint64_t remoteSalt);
+
+    uint32_t GetShortId(const uint256 &txid) const;
+
+    void StartRecon();
+    void FinishRecon();
+};
+
+/**
+ * Tracks the reconciliation states of the peers.
+ *
+ * Both peers send sendrecon with a random salt before verack, and the peers which sent
+ * it are registered once the salt of the other side arrives. The outbound side initiates
+ * the reconciliations every TXRECON_INTERVAL:
+ *   initiator: reqrecon(set size, q)
+ *   responder: sketch of its set, with the capacity estimated from both set sizes
+ *   initiator: inv of the txs the responder lacks, reconcildiff(short ids it lacks)
+ *   responder: inv of the asked txs
+ * When the sketch fails to decode, both sides announce their whole sets instead.
+ */
+class CTxReconTracker {
+public:
+    CTxReconTracker() {}
+
+    // returns the local salt to be sent to the peer
+    uint64_t PreRegister(NodeId nodeId);
+    bool Register(NodeId nodeId, bool fInbound, uint32_t peerReconVersion, uint64_t remoteSalt);
+    void Forget(NodeId nodeId);
+
+    bool IsRegistered(NodeId nodeId) const;
+    bool IsFloodPeer(NodeId nodeId) const;
+    // false if the tx should be announced by inv as usual
+    bool AddToPending(NodeId nodeId, const uint256 &txid);
+
+    // initiator side
+    bool InitiateRecon(NodeId nodeId, int64_t nNow, uint32_t &setSize, uint16_t &q);
+    bool HandleSketch(NodeId nodeId, const CTxReconSketch &remoteSketch, bool &fSuccess,
+                      vector<uint256> &txidsToAnnounce, vector<uint32_t> &askShortIds);
+
+    // responder side
+    bool HandleReqRecon(NodeId nodeId, uint32_t remoteSetSize, uint16_t q, CTxReconSketch &sketch);
+    bool HandleReconDiff(NodeId nodeId, bool fSuccess, const vector<uint32_t> &askShortIds,
+                         vector<uint256> &txidsToAnnounce);
+
+private:
+    mutable CCriticalSection cs_txrecon;
+    map<NodeId, uint64_t> mapLocalSalts;
+    map<NodeId, CTxReconState> mapStates;
+};
+
+extern CTxReconTracker txReconTracker;
+
+#endif  // P2P_TXRECONCILIATION_H
@@ -4,6 +4,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "accountdb.h"
+#include "dbiterator.h"
 #include "entities/key.h"
 #include "commons/uint256.h"
 #include "commons/util/util.h"
@@ -15,12 +16,135 @@ using namespace std;
 
 extern CChain chainActive;
 
+void CAccountStats::Add(const CAccount &account) {
+    account_count++;
+    if (!account.regid.IsEmpty())
+        regid_count++;
+
+    for (const auto &item : account.tokens)
+        Add(item.first, item.second);
+}
+
+void CAccountStats::Sub(const CAccount &account) {
+    CAccountStats accountStats;
+    accountStats.Add(account);
+    Sub(accountStats);
+}
+
+void CAccountStats::Add(const CAccountInfo &info) {
+    account_count++;
+    if (!info.regid.IsEmpty())
+        regid_count++;
+}
+
+void CAccountStats::Sub(const CAccountInfo &info) {
+    CAccountStats infoStats;
+    infoStats.Add(info);
+    Sub(infoStats);
+}
+
+void CAccountStats::Add(const TokenSymbol &symbol, const CAccountToken &token) {
+    AddSupply(symbol, CTokenSupply(token));
+}
+
+void CAccountStats::Sub(const TokenSymbol &symbol, const CAccountToken &token) {
+    SubSupply(symbol, CTokenSupply(token));
+}
+
+void CAccountStats::Add(const CAccountStats &other) {
+    account_count += other.account_count;
+    regid_count += other.regid_count;
+    for (const auto &item : other.supplies)
+        AddSupply(item.first, item.second);
+    needs_rebuild |= other.needs_rebuild;
+}
+
+static uint64_t SubClamped(uint64_t &value, uint64_t amount) {
+    uint64_t subbed = std::min(value, amount);
+    value -= subbed;
+    return amount - subbed;
+}
+
+void CAccountStats::Sub(const CAccountStats &other) {
+    if (SubClamped(account_count, other.account_count) > 0 || SubClamped(regid_count, other.regid_count) > 0) {
+        LogPrint(BCLog::ERROR, "CAccountStats::Sub, %llu accounts and %llu regids are more than the kept ones, "
+                 "the stats are to be rebuilt\n", other.account_count, other.regid_count);
+        needs_rebuild = true;
+    }
+
+    for (const auto &item : other.supplies)
+        SubSupply(item.first, item.second);
+}
+
+void CAccountStats::AddSupply(const TokenSymbol &symbol, const CTokenSupply &supply) {
+    if (supply.IsEmpty())
+        return;
+
+    CTokenSupply &total = supplies[symbol];
+    total.free_amount   += supply.free_amount;
+    total.voted_amount  += supply.voted_amount;
+    total.frozen_amount += supply.frozen_amount;
+    total.staked_amount += supply.staked_amount;
+}
+
+void CAccountStats::SubSupply(const TokenSymbol &symbol, const CTokenSupply &supply) {
+    if (supply.IsEmpty())
+        return;
+
+    CTokenSupply &total = supplies[symbol];
+    uint64_t missing = SubClamped(total.free_amount, supply.free_amount) +
+                       SubClamped(total.voted_amount, supply.voted_amount) +
+                       SubClamped(total.frozen_amount, supply.frozen_amount) +
+                       SubClamped(total.staked_amount, supply.staked_amount);
+    if (missing > 0) {
+        LogPrint(BCLog::ERROR, "CAccountStats::SubSupply, %llu of the token %s is more than its kept supply, "
+                 "the stats are to be rebuilt\n", missing, symbol);
+        needs_rebuild = true;
+    }
+
+    if (total.IsEmpty())
+        supplies.erase(symbol);
+}
+
+CAccountInfo::CAccountInfo(const CAccount &account)
+    : keyid(account.keyid), regid(account.regid), nickid(account.nickid), owner_pubkey(account.owner_pubkey),
+      miner_pubkey(account.miner_pubkey), received_votes(account.received_votes),
+      last_vote_height(account.last_vote_height), last_vote_epoch(account.last_vote_epoch) {
+    for (const auto &item : account.tokens)
+        token_symbols.insert(item.first);
+}
+
+void CAccountInfo::GetAccount(CAccount &account) const {
+    account                  = CAccount(keyid, nickid, owner_pubkey);
+    account.regid            = regid;
+    account.miner_pubkey     = miner_pubkey;
+    account.received_votes   = received_votes;
+    account.last_vote_height = last_vote_height;
+    account.last_vote_epoch  = last_vote_epoch;
+}
+
+string CAccountInfo::ToString() const {
+    return strprintf("regid=%s, keyid=%s, nickid=%s, owner_pubkey=%s, miner_pubkey=%s, tokens=%s, "
+                     "received_votes=%llu, last_vote_height=%llu", regid.ToString(), keyid.GetHex(),
+                     nickid.ToString(), owner_pubkey.ToString(), miner_pubkey.ToString(),
+                     db_util::ToString(token_symbols), received_votes, last_vote_height);
+}
+
 bool CAccountDBCache::GetFcoinGenesisAccount(CAccount &fcoinGensisAccount) const {
     return GetAccount(SysCfg().GetFcoinGenesisRegId(), fcoinGensisAccount);
 }
 
 bool CAccountDBCache::GetAccount(const CKeyID &keyId, CAccount &account) const {
-    return accountCache.GetData(keyId, account);
+    CAccountInfo info;
+    if (!accountCache.GetData(keyId, info))
+        return false;
+
+    // an empty token has no row
+    info.GetAccount(account);
+    for (const auto &symbol : info.token_symbols)
+        accountTokenCache.GetData(make_pair(keyId, symbol), account.tokens[symbol]);
+
+    return true;
 }
 
 bool CAccountDBCache::GetAccount(const CRegID &regId, CAccount &account) const {
@@ -29,7 +153,7 @@ bool CAccountDBCache::GetAccount(const CRegID &regId, CAccount &account) const {
 
     CKeyID keyId;
     if (regId2KeyIdCache.GetData(regId, keyId)) {
-        return accountCache.GetData(keyId, account);
+        return GetAccount(keyId, account);
     }
 
     return false;
@@ -41,7 +165,7 @@ bool CAccountDBCache::GetAccount(const CNickID &nickId,  CAccount &account) cons
 
     std::pair<CVarIntValue<uint32_t>,CKeyID> regHeightAndKeyId ;
     if(nickId2KeyIdCache.GetData(nickId.value, regHeightAndKeyId)){
-        return accountCache.GetData(regHeightAndKeyId.second, account) ;
+        return GetAccount(regHeightAndKeyId.second, account) ;
     }
     return false ;
 }
@@ -67,15 +191,81 @@ bool CAccountDBCache::GetAccount(const CUserID &userId, CAccount &account) const
     return ret;
 }
 
+bool CAccountDBCache::WriteAccount(const CKeyID &keyId, const CAccount &account) {
+    CAccount oldAccount;
+    bool fHaveOld = GetAccount(keyId, oldAccount);
+    return WriteAccountData(keyId, account, fHaveOld ? &oldAccount : nullptr);
+}
+
+bool CAccountDBCache::WriteAccountData(const CKeyID &keyId, const CAccount &account, const CAccount *pOldAccount) {
+    CAccountInfo info(account);
+    if (pOldAccount == nullptr || info != CAccountInfo(*pOldAccount)) {
+        if (!accountCache.SetData(keyId, info))
+            return false;
+    }
+
+    for (const auto &item : account.tokens) {
+        CAccountToken oldToken;
+        if (pOldAccount != nullptr) {
+            auto it = pOldAccount->tokens.find(item.first);
+            if (it != pOldAccount->tokens.end())
+                oldToken = it->second;
+        }
+        if (item.second != oldToken)
+            accountTokenCache.SetData(make_pair(keyId, item.first), item.second);
+    }
+
+    if (pOldAccount != nullptr) {
+        for (const auto &item : pOldAccount->tokens) {
+            if (!account.tokens.count(item.first))
+                accountTokenCache.EraseData(make_pair(keyId, item.first));
+        }
+    }
+
+    // a cache over another one gives its delta when it is flushed
+    if (pBase == nullptr) {
+        if (pOldAccount != nullptr)
+            statsRemoved.Add(*pOldAccount);
+        statsAdded.Add(account);
+    }
+
+    return true;
+}
+
+void CAccountDBCache::EraseAccountData(const CKeyID &keyId, const CAccount &oldAccount) {
+    for (const auto &item : oldAccount.tokens)
+        accountTokenCache.EraseData(make_pair(keyId, item.first));
+
+    accountCache.EraseData(keyId);
+
+    if (pBase == nullptr)
+        statsRemoved.Add(oldAccount);
+}
+
+void CAccountDBCache::UndoLegacyAccounts(const CDbOpLogs &dbOpLogs) {
+    for (auto it = dbOpLogs.rbegin(); it != dbOpLogs.rend(); it++) {
+        CKeyID keyId;
+        CAccount account;
+        it->Get(keyId, account);
+
+        CAccount oldAccount;
+        bool fHaveOld = GetAccount(keyId, oldAccount);
+        if (!account.IsEmpty())
+            WriteAccountData(keyId, account, fHaveOld ? &oldAccount : nullptr);
+        else if (fHaveOld)
+            EraseAccountData(keyId, oldAccount);
+    }
+}
+
 bool CAccountDBCache::SetAccount(const CKeyID &keyId, const CAccount &account) {
-    accountCache.SetData(keyId, account);
+    WriteAccount(keyId, account);
     return true;
 }
 
 bool CAccountDBCache::SetAccount(const CRegID &regId, const CAccount &account) {
     CKeyID keyId;
     if (regId2KeyIdCache.GetData(regId, keyId)) {
-        return accountCache.SetData(keyId, account);
+        return WriteAccount(keyId, account);
     }
     return false;
 }
@@ -83,7 +273,7 @@ bool CAccountDBCache::SetAccount(const CNickID &nickId,const CAccount &account){
 
     std::pair<CVarIntValue<uint32_t>, CKeyID> heightKeyID ;
     if(nickId2KeyIdCache.GetData(nickId.value, heightKeyID)){
-        return accountCache.SetData(heightKeyID.second, account);
+        return WriteAccount(heightKeyID.second, account);
     }
     return false ;
 }
@@ -121,7 +311,12 @@ bool CAccountDBCache::HaveAccount(const CUserID &userId) const {
 }
 
 bool CAccountDBCache::EraseAccount(const CKeyID &keyId) {
-    return accountCache.EraseData(keyId);
+    CAccount oldAccount;
+    if (!GetAccount(keyId, oldAccount))
+        return accountCache.EraseData(keyId);
+
+    EraseAccountData(keyId, oldAccount);
+    return true;
 }
 
 bool CAccountDBCache::SetKeyId(const CUserID &userId, const CKeyID &keyId) {
@@ -173,7 +368,7 @@ bool CAccountDBCache::EraseKeyId(const CRegID &regId) {
 
 bool CAccountDBCache::SaveAccount(const CAccount &account) {
     regId2KeyIdCache.SetData(account.regid, account.keyid);
-    accountCache.SetData(account.keyid, account);
+    WriteAccount(account.keyid, account);
     return true ;
 }
 
@@ -208,9 +403,9 @@ bool CAccountDBCache::GetUserId(const string &addr, CUserID &userId) const {
 }
 
 bool CAccountDBCache::GetRegId(const CKeyID &keyId, CRegID &regId) const {
-    CAccount acct;
-    if (accountCache.GetData(keyId, acct)) {
-        regId = acct.regid;
+    CAccountInfo info;
+    if (accountCache.GetData(keyId, info)) {
+        regId = info.regid;
         return true;
     }
     return false;
@@ -279,55 +474,156 @@ bool CAccountDBCache::EraseKeyId(const CUserID &userId) {
 }
 
 uint64_t CAccountDBCache::GetAccountFreeAmount(const CKeyID &keyId, const TokenSymbol &tokenSymbol) {
-    CAccount account;
-    GetAccount(keyId, account);
-
-    CAccountToken accountToken = account.GetToken(tokenSymbol);
+    CAccountToken accountToken;
+    accountTokenCache.GetData(make_pair(keyId, tokenSymbol), accountToken);
     return accountToken.free_amount;
 }
 
 bool CAccountDBCache::Flush() {
+    // the base of the db cache keeps the delta of the accounts to the stats written to the db
+    if (pBase != nullptr && pBase->pBase == nullptr)
+        GetStatsDelta(pBase->statsAdded, pBase->statsRemoved);
+
+    if (pBase == nullptr && !(statsAdded.IsEmpty() && statsRemoved.IsEmpty())) {
+        CAccountStats stats;
+        accountStatsCache.GetData(stats);
+        stats.Add(statsAdded);
+        stats.Sub(statsRemoved);
+        accountStatsCache.SetData(stats);
+        statsAdded.SetEmpty();
+        statsRemoved.SetEmpty();
+    }
+
+    // the legacy accounts are erased after their new records are written
     accountCache.Flush();
+    accountTokenCache.Flush();
+    legacyAccountCache.Flush();
     regId2KeyIdCache.Flush();
     nickId2KeyIdCache.Flush();
+    accountStatsCache.Flush();
 
     return true;
 }
 
 uint32_t CAccountDBCache::GetCacheSize() const {
     return accountCache.GetCacheSize() +
+        accountTokenCache.GetCacheSize() +
+        legacyAccountCache.GetCacheSize() +
         regId2KeyIdCache.GetCacheSize() +
-        nickId2KeyIdCache.GetCacheSize();
+        nickId2KeyIdCache.GetCacheSize() +
+        accountStatsCache.GetCacheSize();
+}
+
+void CAccountDBCache::GetStatsDelta(CAccountStats &added, CAccountStats &removed) {
+    for (const auto &item : accountCache.GetMapData()) {
+        CAccountInfo oldInfo;
+        bool fHaveOld = pBase->accountCache.GetData(item.first, oldInfo);
+        bool fHaveNew = !db_util::IsEmpty(item.second);
+        if (fHaveOld == fHaveNew && (!fHaveNew || oldInfo.regid == item.second.regid))
+            continue;
+
+        if (fHaveOld)
+            removed.Add(oldInfo);
+        if (fHaveNew)
+            added.Add(item.second);
+    }
+
+    for (const auto &item : accountTokenCache.GetMapData()) {
+        CAccountToken oldToken;
+        pBase->accountTokenCache.GetData(item.first, oldToken);
+        if (oldToken == item.second)
+            continue;
+
+        removed.Add(item.first.second, oldToken);
+        added.Add(item.first.second, item.second);
+    }
 }
 
-std::tuple< uint64_t /* total regids */,
-            uint64_t /* total bcoins */,
-            uint64_t /* total soins */,
-            uint64_t /* total foins */> CAccountDBCache::TraverseAccount() {
+bool CAccountDBCache::GetAccountStats(CAccountStats &stats) {
+    stats.SetEmpty();
+    if (pBase != nullptr) {
+        CAccountStats added, removed;
+        GetStatsDelta(added, removed);
+        pBase->GetAccountStats(stats);
+        stats.Add(added);
+        stats.Sub(removed);
+        return true;
+    }
 
-    map<CKeyID, CAccount> items;
+    accountStatsCache.GetData(stats);
+    stats.Add(statsAdded);
+    stats.Sub(statsRemoved);
+    return true;
+}
 
-    accountCache.GetAllElements(items);
+bool CAccountDBCache::ComputeAccountStats(CAccountStats &stats) {
+    stats.SetEmpty();
+
+    CDBIterator<decltype(accountCache)> dbIt(accountCache);
+    for (dbIt.First(); dbIt.IsValid(); dbIt.Next()) {
+        CAccount account;
+        if (!GetAccount(dbIt.GetKey(), account))
+            return ERRORMSG("ComputeAccountStats: get account %s failed", dbIt.GetKey().ToAddress());
+
+        stats.Add(account);
+    }
+    return true;
+}
 
-    uint64_t totalRegIds = 0;
-    uint64_t totalBCoins = 0;
-    uint64_t totalSCoins = 0;
-    uint64_t totalFCoins = 0;
+bool CAccountDBCache::MigrateLegacyAccounts(uint32_t &migratedCount) {
+    migratedCount = 0;
 
+    // in rounds, each one is flushed so a new iterator sees the db without the migrated ones
+    while (true) {
+        vector<CAccount> legacyAccounts;
+        vector<CKeyID> keyIds;
+        {
+            CDBIterator<decltype(legacyAccountCache)> dbIt(legacyAccountCache);
+            for (dbIt.First(); dbIt.IsValid() && keyIds.size() < ACCOUNT_MIGRATION_BATCH_SIZE; dbIt.Next()) {
+                keyIds.push_back(dbIt.GetKey());
+                legacyAccounts.push_back(dbIt.GetValue());
+            }
+        }
+        if (keyIds.empty())
+            break;
 
-    for (auto &item : items) {
-        CAccountToken wicc = item.second.GetToken(SYMB::WICC);
-        CAccountToken wusd = item.second.GetToken(SYMB::WUSD);
-        CAccountToken wgrt = item.second.GetToken(SYMB::WGRT);
+        for (size_t i = 0; i < keyIds.size(); i++) {
+            // the new records may be there already, written by an interrupted migration
+            CAccount oldAccount;
+            bool fHaveOld = GetAccount(keyIds[i], oldAccount);
+            if (!WriteAccountData(keyIds[i], legacyAccounts[i], fHaveOld ? &oldAccount : nullptr))
+                return ERRORMSG("MigrateLegacyAccounts() : write account %s failed", keyIds[i].ToAddress());
 
-        totalRegIds++;
+            legacyAccountCache.EraseData(keyIds[i]);
+        }
 
-        totalBCoins += wicc.free_amount + wicc.voted_amount + wicc.frozen_amount + wicc.staked_amount;
-        totalSCoins += wusd.free_amount + wusd.voted_amount + wusd.frozen_amount + wusd.staked_amount;
-        totalFCoins += wgrt.free_amount + wgrt.voted_amount + wgrt.frozen_amount + wgrt.staked_amount;
+        Flush();
+        migratedCount += keyIds.size();
     }
 
-    return std::tie(totalRegIds, totalBCoins, totalSCoins, totalFCoins);
+    return true;
+}
+
+bool CAccountDBCache::BuildAccountStats(bool fRebuild) {
+    CAccountStats stats;
+    if (!fRebuild && accountStatsCache.GetData(stats) && !stats.needs_rebuild)
+        return true;
+
+    if (!ComputeAccountStats(stats))
+        return ERRORMSG("BuildAccountStats: compute account stats failed");
+
+    // the delta of the accounts written since is in the computed ones
+    statsAdded.SetEmpty();
+    statsRemoved.SetEmpty();
+    if (stats.IsEmpty())
+        accountStatsCache.EraseData();
+    else
+        accountStatsCache.SetData(stats);
+    accountStatsCache.Flush();
+
+    LogPrint(BCLog::INFO, "BuildAccountStats: %llu accounts, %llu regids, %u tokens\n", stats.account_count,
+             stats.regid_count, stats.supplies.size());
+    return true;
 }
 
 Object CAccountDBCache::ToJsonObj(dbk::PrefixType prefix) {
@@ -7,6 +7,7 @@
 #define PERSIST_ACCOUNTDB_H
 
 #include <map>
+#include <set>
 #include <string>
 #include <utility>
 #include <vector>
@@ -19,21 +20,166 @@
 class uint256;
 class CKeyID;
 
+/** The number of legacy accounts migrated between two flushes of the account db */
+static const uint32_t ACCOUNT_MIGRATION_BATCH_SIZE = 10000;
+
+/**
+ * Total amounts of a token held by all accounts, summed from the CAccountToken of each account
+ */
+class CTokenSupply {
+public:
+    uint64_t free_amount;
+    uint64_t voted_amount;
+    uint64_t frozen_amount;
+    uint64_t staked_amount;
+
+public:
+    CTokenSupply() : free_amount(0), voted_amount(0), frozen_amount(0), staked_amount(0) {}
+    explicit CTokenSupply(const CAccountToken &token)
+        : free_amount(token.free_amount), voted_amount(token.voted_amount), frozen_amount(token.frozen_amount),
+          staked_amount(token.staked_amount) {}
+
+    uint64_t GetTotal() const { return free_amount + voted_amount + frozen_amount + staked_amount; }
+
+    bool IsEmpty() const { return GetTotal() == 0; }
+
+    bool operator==(const CTokenSupply &other) const {
+        return free_amount == other.free_amount && voted_amount == other.voted_amount &&
+               frozen_amount == other.frozen_amount && staked_amount == other.staked_amount;
+    }
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(VARINT(free_amount));
+        READWRITE(VARINT(voted_amount));
+        READWRITE(VARINT(frozen_amount));
+        READWRITE(VARINT(staked_amount));
+    )
+};
+
+class CAccountInfo;
+
+/**
+ * Global account statistics, read in O(1) instead of scanning the accounts. They are derived data
+ * kept out of the undo logs: the account db adds the delta of the accounts flushed into it and
+ * writes them along with the accounts, see CAccountDBCache::Flush.
+ */
+class CAccountStats {
+public:
+    uint64_t account_count;
+    uint64_t regid_count;                       //!< accounts which have been registered
+    map<TokenSymbol, CTokenSupply> supplies;    //!< tokens with a non-zero supply
+    bool needs_rebuild;                         //!< a delta did not match, to be summed again on the start
+
+public:
+    CAccountStats() : account_count(0), regid_count(0), needs_rebuild(false) {}
+
+    void Add(const CAccount &account);
+    void Sub(const CAccount &account);
+    void Add(const CAccountInfo &info);
+    void Sub(const CAccountInfo &info);
+    void Add(const TokenSymbol &symbol, const CAccountToken &token);
+    void Sub(const TokenSymbol &symbol, const CAccountToken &token);
+    void Add(const CAccountStats &other);
+    // a count or a supply which would go below zero is clamped and marks the stats for rebuild
+    void Sub(const CAccountStats &other);
+
+    bool IsEmpty() const { return account_count == 0 && regid_count == 0 && supplies.empty() && !needs_rebuild; }
+
+    void SetEmpty() {
+        account_count = 0;
+        regid_count   = 0;
+        supplies.clear();
+        needs_rebuild = false;
+    }
+
+    bool operator==(const CAccountStats &other) const {
+        return account_count == other.account_count && regid_count == other.regid_count &&
+               supplies == other.supplies;
+    }
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(VARINT(account_count));
+        READWRITE(VARINT(regid_count));
+        READWRITE(supplies);
+        READWRITE(needs_rebuild);
+    )
+
+private:
+    void AddSupply(const TokenSymbol &symbol, const CTokenSupply &supply);
+    void SubSupply(const TokenSymbol &symbol, const CTokenSupply &supply);
+};
+
+/**
+ * The account without its token balances. The balances are kept apart by token, so a balance change
+ * rewrites the changed token only, while the symbols of the held tokens are kept here to load them.
+ */
+class CAccountInfo {
+public:
+    CKeyID  keyid;
+    CRegID  regid;
+    CNickID nickid;
+    CPubKey owner_pubkey;
+    CPubKey miner_pubkey;
+    set<TokenSymbol> token_symbols;
+    uint64_t received_votes;
+    uint64_t last_vote_height;
+    uint64_t last_vote_epoch;
+
+public:
+    CAccountInfo() : received_votes(0), last_vote_height(0), last_vote_epoch(0) {}
+    explicit CAccountInfo(const CAccount &account);
+
+    // the account with no token loaded
+    void GetAccount(CAccount &account) const;
+
+    bool operator==(const CAccountInfo &other) const {
+        return keyid == other.keyid && regid == other.regid && nickid == other.nickid &&
+               owner_pubkey == other.owner_pubkey && miner_pubkey == other.miner_pubkey &&
+               token_symbols == other.token_symbols && received_votes == other.received_votes &&
+               last_vote_height == other.last_vote_height && last_vote_epoch == other.last_vote_epoch;
+    }
+    bool operator!=(const CAccountInfo &other) const { return !(*this == other); }
+
+    bool IsEmpty() const { return keyid.IsEmpty(); }
+    void SetEmpty() { *this = CAccountInfo(); }
+    string ToString() const;
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(keyid);
+        READWRITE(regid);
+        READWRITE(nickid);
+        READWRITE(owner_pubkey);
+        READWRITE(miner_pubkey);
+        READWRITE(token_symbols);
+        READWRITE(VARINT(received_votes));
+        READWRITE(VARINT(last_vote_height));
+        READWRITE(VARINT(last_vote_epoch));
+    )
+};
+
 class CAccountDBCache {
 public:
-    CAccountDBCache() {}
+    CAccountDBCache(): pBase(nullptr) {}
 
     CAccountDBCache(CDBAccess *pDbAccess):
+        pBase(nullptr),
         regId2KeyIdCache(pDbAccess),
         nickId2KeyIdCache(pDbAccess),
-        accountCache(pDbAccess) {
+        accountCache(pDbAccess),
+        accountTokenCache(pDbAccess),
+        legacyAccountCache(pDbAccess),
+        accountStatsCache(pDbAccess) {
         assert(pDbAccess->GetDbNameType() == DBNameType::ACCOUNT);
     }
 
-    CAccountDBCache(CAccountDBCache *pBase):
-        regId2KeyIdCache(pBase->regId2KeyIdCache),
-        nickId2KeyIdCache(pBase->nickId2KeyIdCache),
-        accountCache(pBase->accountCache) {}
+    CAccountDBCache(CAccountDBCache *pBaseIn):
+        pBase(pBaseIn->pBase),
+        regId2KeyIdCache(pBaseIn->regId2KeyIdCache),
+        nickId2KeyIdCache(pBaseIn->nickId2KeyIdCache),
+        accountCache(pBaseIn->accountCache),
+        accountTokenCache(pBaseIn->accountTokenCache),
+        legacyAccountCache(pBaseIn->legacyAccountCache),
+        accountStatsCache(pBaseIn->accountStatsCache) {}
 
     ~CAccountDBCache() {}
 
@@ -74,7 +220,12 @@ public:
     bool EraseKeyId(const CRegID &regId);
     bool EraseKeyId(const CUserID &userId);
 
-    std::tuple<uint64_t, uint64_t, uint64_t, uint64_t> TraverseAccount();
+    // the stats kept along with the accounts, with the delta of the accounts not flushed yet
+    bool GetAccountStats(CAccountStats &stats);
+    // the stats summed by iterating all the accounts, to check the kept ones
+    bool ComputeAccountStats(CAccountStats &stats);
+    // builds the stats for an account db written before they were kept, or marked for rebuild
+    bool BuildAccountStats(bool fRebuild = false);
 
     bool GetUserId(const string &addr, CUserID &userId) const;
     bool GetRegId(const CKeyID &keyId, CRegID &regId) const;
@@ -83,13 +234,20 @@ public:
     bool SetNickId(const CAccount account, const uint32_t height);
     bool GetNickIdHeight(uint64_t nickIdValue,uint32_t& regHeight) ;
 
+    // rewrites the accounts of the legacy format, which kept the tokens inline
+    bool MigrateLegacyAccounts(uint32_t &migratedCount);
+
     uint32_t GetCacheSize() const;
     Object ToJsonObj(dbk::PrefixType prefix = dbk::EMPTY);
 
     void SetBaseViewPtr(CAccountDBCache *pBaseIn) {
+        pBase = pBaseIn;
         accountCache.SetBase(&pBaseIn->accountCache);
+        accountTokenCache.SetBase(&pBaseIn->accountTokenCache);
+        legacyAccountCache.SetBase(&pBaseIn->legacyAccountCache);
         regId2KeyIdCache.SetBase(&pBaseIn->regId2KeyIdCache);
         nickId2KeyIdCache.SetBase(&pBaseIn->nickId2KeyIdCache);
+        accountStatsCache.SetBase(&pBaseIn->accountStatsCache);
     };
 
     uint64_t GetAccountFreeAmount(const CKeyID &keyId, const TokenSymbol &tokenSymbol);
@@ -98,6 +256,8 @@ public:
 
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMapIn) {
         accountCache.SetDbOpLogMap(pDbOpLogMapIn);
+        accountTokenCache.SetDbOpLogMap(pDbOpLogMapIn);
+        legacyAccountCache.SetDbOpLogMap(pDbOpLogMapIn);
         regId2KeyIdCache.SetDbOpLogMap(pDbOpLogMapIn);
         nickId2KeyIdCache.SetDbOpLogMap(pDbOpLogMapIn);
     }
@@ -106,7 +266,34 @@ public:
         regId2KeyIdCache.RegisterUndoFunc(undoDataFuncMap);
         nickId2KeyIdCache.RegisterUndoFunc(undoDataFuncMap);
         accountCache.RegisterUndoFunc(undoDataFuncMap);
+        accountTokenCache.RegisterUndoFunc(undoDataFuncMap);
+        // the undo of the blocks connected before the migration restores the accounts of the new format
+        undoDataFuncMap[legacyAccountCache.GetPrefixType()] =
+            std::bind(&CAccountDBCache::UndoLegacyAccounts, this, std::placeholders::_1);
     }
+
+    void RegisterDbValueFunc(DbValueFuncMap &dbValueFuncMap) {
+        regId2KeyIdCache.RegisterDbValueFunc(dbValueFuncMap);
+        nickId2KeyIdCache.RegisterDbValueFunc(dbValueFuncMap);
+        accountCache.RegisterDbValueFunc(dbValueFuncMap);
+        accountTokenCache.RegisterDbValueFunc(dbValueFuncMap);
+    }
+
+private:
+    bool WriteAccount(const CKeyID &keyId, const CAccount &account);
+    // writes the info and the tokens which differ from the stored ones
+    bool WriteAccountData(const CKeyID &keyId, const CAccount &account, const CAccount *pOldAccount);
+    void EraseAccountData(const CKeyID &keyId, const CAccount &oldAccount);
+    void UndoLegacyAccounts(const CDbOpLogs &dbOpLogs);
+    // the delta of the stats made by the accounts of this cache over the ones of the base
+    void GetStatsDelta(CAccountStats &added, CAccountStats &removed);
+
+private:
+    CAccountDBCache *pBase;
+    // the delta of the accounts written to the db cache, added to the stats when it is flushed
+    CAccountStats statsAdded;
+    CAccountStats statsRemoved;
+
 public:
 /*  CCompositeKVCache     prefixType            key              value           variable           */
 /*  -------------------- --------------------   --------------  -------------   --------------------- */
@@ -114,8 +301,14 @@ public:
     CCompositeKVCache< dbk::REGID_KEYID,          CRegIDKey,       CKeyID >         regId2KeyIdCache;
     // <prefix$NickID -> KeyID>
     CCompositeKVCache< dbk::NICKID_KEYID,         CVarIntValue<uint64_t>,      std::pair<CVarIntValue<uint32_t>,CKeyID>>   nickId2KeyIdCache;
-    // <prefix$KeyID -> Account>
-    CCompositeKVCache< dbk::KEYID_ACCOUNT,        CKeyID,       CAccount>        accountCache;
+    // <prefix$KeyID -> AccountInfo>
+    CCompositeKVCache< dbk::KEYID_ACCOUNT_INFO,   CKeyID,       CAccountInfo>    accountCache;
+    // <prefix$KeyID$TokenSymbol -> AccountToken>
+    CCompositeKVCache< dbk::KEYID_ACCOUNT_TOKEN,  pair<CKeyID, TokenSymbol>, CAccountToken> accountTokenCache;
+    // <prefix$KeyID -> Account>, the legacy format, empty once migrated
+    CCompositeKVCache< dbk::KEYID_ACCOUNT,        CKeyID,       CAccount>        legacyAccountCache;
+    // <prefix -> AccountStats>, written by the flush of the db cache only, with no undo log
+    CSimpleKVCache< dbk::ACCOUNT_STATS,           CAccountStats>   accountStatsCache;
 
 };
 
@@ -80,6 +80,11 @@ public:
         assetTradingPairCache.RegisterUndoFunc(undoDataFuncMap);
     }
 
+    void RegisterDbValueFunc(DbValueFuncMap &dbValueFuncMap) {
+        assetCache.RegisterDbValueFunc(dbValueFuncMap);
+        assetTradingPairCache.RegisterDbValueFunc(dbValueFuncMap);
+    }
+
     shared_ptr<CUserAssetsIterator> CreateUserAssetsIterator() {
         return make_shared<CUserAssetsIterator>(assetCache);
     }
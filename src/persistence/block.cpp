@@ -24,6 +24,124 @@ uint256 CBlockHeader::ComputeSignatureHash() const {
     return ss.GetHash();
 }
 
+CBlockSummary CBlockIndex::GetSummary() const {
+    CBlockSummary summary;
+    if (summaryData.empty())
+        return summary;
+
+    try {
+        CDataStream ds(summaryData, SER_DISK, CLIENT_VERSION);
+        ds >> summary;
+    } catch (std::exception &e) {
+        LogPrint(BCLog::ERROR, "CBlockIndex::GetSummary, bad summary of block %s: %s\n", GetBlockHash().GetHex(),
+                 e.what());
+        summary.SetEmpty();
+    }
+    return summary;
+}
+
+void CBlockIndex::SetSummary(const CBlockSummary &summary) {
+    CDataStream ds(SER_DISK, CLIENT_VERSION);
+    ds << summary;
+    summaryData.assign(ds.begin(), ds.end());
+}
+
+BlockMap::const_iterator BlockMap::find(const uint256 &hash) const {
+    if (entryCount == 0)
+        return end();
+
+    for (size_t i = GetSlot(hash);; i = (i + 1) & (slots.size() - 1)) {
+        if (slots[i] == nullptr)
+            return end();
+        if (slots[i]->blockHash == hash)
+            return const_iterator(slots.data() + i, slots.data() + slots.size());
+    }
+}
+
+CBlockIndex *BlockMap::operator[](const uint256 &hash) const {
+    const_iterator it = find(hash);
+    return it != end() ? it->second : nullptr;
+}
+
+bool BlockMap::insert(CBlockIndex *pIndex) {
+    // at most 3/4 full
+    if ((entryCount + 1) * 4 > slots.size() * 3)
+        Rehash(std::max<size_t>(slots.size() * 2, 16));
+
+    size_t i = GetSlot(pIndex->blockHash);
+    for (; slots[i] != nullptr; i = (i + 1) & (slots.size() - 1)) {
+        if (slots[i]->blockHash == pIndex->blockHash)
+            return false;
+    }
+    slots[i] = pIndex;
+    entryCount++;
+    return true;
+}
+
+size_t BlockMap::erase(const uint256 &hash) {
+    if (entryCount == 0)
+        return 0;
+
+    size_t mask = slots.size() - 1;
+    size_t i    = GetSlot(hash);
+    while (slots[i] != nullptr && slots[i]->blockHash != hash)
+        i = (i + 1) & mask;
+    if (slots[i] == nullptr)
+        return 0;
+
+    // shift back the entries of the probe sequence after the erased one, no tombstones
+    slots[i] = nullptr;
+    for (size_t j = (i + 1) & mask; slots[j] != nullptr; j = (j + 1) & mask) {
+        // the entry stays if its home slot is in (i, j] cyclically
+        size_t home = GetSlot(slots[j]->blockHash);
+        if (i <= j ? (i < home && home <= j) : (i < home || home <= j))
+            continue;
+        slots[i] = slots[j];
+        slots[j] = nullptr;
+        i        = j;
+    }
+    entryCount--;
+    return 1;
+}
+
+void BlockMap::reserve(size_t entryCountIn) {
+    size_t slotCount = 16;
+    while (slotCount * 3 < entryCountIn * 4)
+        slotCount *= 2;
+    if (slotCount > slots.size())
+        Rehash(slotCount);
+}
+
+void BlockMap::clear() {
+    vector<CBlockIndex *>().swap(slots);
+    entryCount = 0;
+}
+
+void BlockMap::Rehash(size_t slotCount) {
+    vector<CBlockIndex *> oldSlots(slotCount, nullptr);
+    oldSlots.swap(slots);
+    for (CBlockIndex *pIndex : oldSlots) {
+        if (pIndex == nullptr)
+            continue;
+        size_t i = GetSlot(pIndex->blockHash);
+        while (slots[i] != nullptr)
+            i = (i + 1) & (slotCount - 1);
+        slots[i] = pIndex;
+    }
+}
+
+void CBlockIndexArena::Clear() {
+    for (size_t i = 0; i < slabs.size(); i++) {
+        size_t slabCount = (i + 1 == slabs.size()) ? used : SLAB_SIZE;
+        for (size_t j = 0; j < slabCount; j++)
+            slabs[i][j].~CBlockIndex();
+        allocator.deallocate(slabs[i], SLAB_SIZE);
+    }
+    slabs.clear();
+    used  = SLAB_SIZE;
+    count = 0;
+}
+
 uint256 CBlock::BuildMerkleTree() const {
     vMerkleTree.clear();
     for (const auto& ptx : vptx) {
@@ -185,6 +303,41 @@ bool ReadBlockFromDisk(const CBlockIndex *pIndex, CBlock &block) {
     return true;
 }
 
+bool ReadRawBlockFromDisk(const CDiskBlockPos &pos, const uint256 &blockHash, vector<char> &rawBlock) {
+    rawBlock.clear();
+    if (pos.nPos < 8)
+        return ERRORMSG("%s : invalid block pos %s", __func__, pos.ToString());
+
+    // the index header written by WriteBlockToDisk is right before the block
+    CAutoFile filein = CAutoFile(OpenBlockFile(CDiskBlockPos(pos.nFile, pos.nPos - 8), true), SER_DISK, CLIENT_VERSION);
+    if (!filein)
+        return ERRORMSG("%s : OpenBlockFile failed", __func__);
+
+    try {
+        MessageStartChars messageStart;
+        uint32_t nSize;
+        filein >> FLATDATA(messageStart) >> nSize;
+        if (memcmp(messageStart, SysCfg().MessageStart(), MESSAGE_START_SIZE) != 0 ||
+            nSize > MAX_BLOCK_SIZE)
+            return ERRORMSG("%s : bad index header at %s", __func__, pos.ToString());
+
+        rawBlock.resize(nSize);
+        filein.read(rawBlock.data(), nSize);
+
+        // the bytes are the block asked for if its header is, which is well within the first KB
+        CBlockHeader header;
+        CDataStream ssHeader(rawBlock.data(), rawBlock.data() + std::min<size_t>(rawBlock.size(), 1024), SER_DISK,
+                             CLIENT_VERSION);
+        ssHeader >> header;
+        if (header.GetHash() != blockHash)
+            return ERRORMSG("%s : the block at %s is not %s", __func__, pos.ToString(), blockHash.GetHex());
+    } catch (std::exception &e) {
+        return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+    }
+
+    return true;
+}
+
 bool ReadBaseTxFromDisk(const CTxCord txCord, std::shared_ptr<CBaseTx> &pTx) {
     auto pBlock = std::make_shared<CBlock>();
     const CBlockIndex* pBlockIndex = chainActive[ txCord.GetHeight() ];
@@ -183,6 +183,43 @@ public:
     void Print() const;
 };
 
+/**
+ * Compact summary of a connected block, kept in memory with its block index so that
+ * the explorer RPCs never read the block file. The miner, tx count and total fuel are
+ * in the block index itself.
+ */
+class CBlockSummary {
+public:
+    map<TokenSymbol, uint64_t> fees;         // fees of the non-reward txs per fee symbol
+    map<TokenSymbol, uint64_t> reward_fees;  // fees minus fuel, rewarded to the miner
+    uint64_t inflated_bcoins;                // inflation profits of the miner
+    uint64_t run_steps;                      // total run steps of the contract txs
+    map<uint8_t, uint32_t> tx_type_counts;   // tx type -> count, the reward tx included
+    uint32_t block_size;                     // serialized size of the block
+
+    CBlockSummary() : inflated_bcoins(0), run_steps(0), block_size(0) {}
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(fees);
+        READWRITE(reward_fees);
+        READWRITE(VARINT(inflated_bcoins));
+        READWRITE(VARINT(run_steps));
+        READWRITE(tx_type_counts);
+        READWRITE(VARINT(block_size));)
+
+    bool IsEmpty() const { return block_size == 0; }
+    void SetEmpty() { *this = CBlockSummary(); }
+
+    string ToString() const {
+        string feesStr;
+        for (const auto &item : fees)
+            feesStr += strprintf("%s%s:%llu", feesStr.empty() ? "" : ",", item.first, item.second);
+
+        return strprintf("fees={%s}, inflated_bcoins=%llu, run_steps=%llu, tx_types=%u, size=%u", feesStr,
+                         inflated_bcoins, run_steps, tx_type_counts.size(), block_size);
+    }
+};
+
 /** The block chain is a tree shaped structure starting with the
  * genesis block at the root, with each block potentially having multiple
  * candidates to be the next block. A blockindex may have multiple pprev pointing
@@ -190,8 +227,8 @@ public:
  */
 class CBlockIndex {
 public:
-    // pointer to the hash of the block, if any. memory is owned by this CBlockIndex
-    const uint256 *pBlockHash;
+    // hash of the block, the key of the index in mapBlockIndex
+    uint256 blockHash;
 
     // pointer to the index of the predecessor of this block
     CBlockIndex *pprev;
@@ -230,7 +267,6 @@ public:
     // block header
     int32_t nVersion;
     uint256 merkleRootHash;
-    uint256 hashPos;
     uint32_t nTime;
     uint32_t nBits;
     uint32_t nNonce;
@@ -238,10 +274,16 @@ public:
     uint32_t nFuelRate;
     vector<unsigned char> vSignature;
 
-    CRegID miner;
+    // regid of the miner, as its height and index instead of a CRegID carrying its raw bytes too
+    uint32_t minerHeight;
+    uint16_t minerIndex;
+
+    // serialized summary of the block, empty until the block is connected. Stored apart from the
+    // disk index, and only deserialized by the RPCs reading it
+    vector<uint8_t> summaryData;
 
     CBlockIndex() {
-        pBlockHash       = nullptr;
+        blockHash        = uint256();
         pprev            = nullptr;
         pskip            = nullptr;
         height           = 0;
@@ -256,17 +298,18 @@ public:
 
         nVersion       = 0;
         merkleRootHash = uint256();
-        hashPos        = uint256();
         nTime          = 0;
         nBits          = 0;
         nNonce         = 0;
         nFuel          = 0;
         nFuelRate      = INIT_FUEL_RATES;
         vSignature.clear();
+        minerHeight    = 0;
+        minerIndex     = 0;
     }
 
     CBlockIndex(const CBlock &block) {
-        pBlockHash       = nullptr;
+        blockHash        = uint256();
         pprev            = nullptr;
         pskip            = nullptr;
         height           = 0;
@@ -291,6 +334,8 @@ public:
         nFuel          = block.GetFuel();
         nFuelRate      = block.GetFuelRate();
         vSignature     = block.GetSignature();
+        minerHeight    = 0;
+        minerIndex     = 0;
       /*  if(block.GetHeight() == 0 )
             miner = CRegID("0-1");
         else
@@ -330,7 +375,15 @@ public:
         return block;
     }
 
-    uint256 GetBlockHash() const { return *pBlockHash; }
+    uint256 GetBlockHash() const { return blockHash; }
+    CRegID GetMiner() const { return CRegID(minerHeight, minerIndex); }
+    bool HasSummary() const { return !summaryData.empty(); }
+    CBlockSummary GetSummary() const;
+    void SetSummary(const CBlockSummary &summary);
+    void SetMiner(const CRegID &regid) {
+        minerHeight = regid.GetHeight();
+        minerIndex  = regid.GetIndex();
+    }
     int64_t GetBlockTime() const { return (int64_t)nTime; }
     bool CheckIndex() const { return true; }
 
@@ -360,7 +413,7 @@ public:
 
     string ToString() const {
         return strprintf("CBlockIndex(pprev=%p, height=%d, merkle=%s, blockHash=%s, chainWork=%s, regId=%s)", pprev, height,
-                         merkleRootHash.ToString(), GetBlockHash().ToString(), nChainWork.ToString(), miner.ToString());
+                         merkleRootHash.ToString(), GetBlockHash().ToString(), nChainWork.ToString(), GetMiner().ToString());
     }
 
     string GetIndentityString() const {
@@ -382,8 +435,10 @@ public:
 class CDiskBlockIndex : public CBlockIndex {
 public:
     uint256 hashPrev;
+    // never set, kept on disk only for the compatibility of the index format
+    uint256 hashPos;
 
-    CDiskBlockIndex() : hashPrev(uint256()) {}
+    CDiskBlockIndex() : hashPrev(uint256()), hashPos(uint256()) {}
 
     explicit CDiskBlockIndex(CBlockIndex *pIndex) : CBlockIndex(*pIndex) {
         hashPrev = (pprev ? pprev->GetBlockHash() : uint256());
@@ -414,7 +469,9 @@ public:
         READWRITE(nFuel);
         READWRITE(nFuelRate);
         READWRITE(vSignature);
-        READWRITE(miner);)
+        // the serialization of a CRegID
+        READWRITE(VARINT(minerHeight));
+        READWRITE(VARINT(minerIndex));)
 
 
     uint256 GetBlockHash() const {
@@ -445,6 +502,114 @@ public:
     }
 };
 
+/**
+ * The block indexes by the block hash. An open addressing table of the index pointers with linear
+ * probing: the hashes are the ones kept in the indexes, so an entry costs a pointer instead of a
+ * heap node with a copy of the hash. Unlike std::map, operator[] inserts nothing and returns
+ * nullptr for an unknown hash. Not thread safe, guarded by cs_main.
+ */
+class BlockMap {
+public:
+    class const_iterator {
+    public:
+        typedef std::pair<uint256, CBlockIndex *> value_type;
+        struct pointer {
+            value_type value;
+            const value_type *operator->() const { return &value; }
+        };
+
+        const_iterator() : pSlot(nullptr), pEnd(nullptr) {}
+        const_iterator(CBlockIndex *const *pSlotIn, CBlockIndex *const *pEndIn) : pSlot(pSlotIn), pEnd(pEndIn) {
+            SkipEmpty();
+        }
+
+        value_type operator*() const { return value_type((*pSlot)->blockHash, *pSlot); }
+        pointer operator->() const { return pointer{**this}; }
+        const_iterator &operator++() {
+            ++pSlot;
+            SkipEmpty();
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator it = *this;
+            ++*this;
+            return it;
+        }
+        bool operator==(const const_iterator &other) const { return pSlot == other.pSlot; }
+        bool operator!=(const const_iterator &other) const { return pSlot != other.pSlot; }
+
+    private:
+        CBlockIndex *const *pSlot;
+        CBlockIndex *const *pEnd;
+
+        void SkipEmpty() {
+            while (pSlot != pEnd && *pSlot == nullptr)
+                ++pSlot;
+        }
+    };
+    typedef const_iterator iterator;
+
+    BlockMap() : entryCount(0) {}
+
+    const_iterator begin() const { return const_iterator(slots.data(), slots.data() + slots.size()); }
+    const_iterator end() const { return const_iterator(slots.data() + slots.size(), slots.data() + slots.size()); }
+    const_iterator find(const uint256 &hash) const;
+    size_t count(const uint256 &hash) const { return find(hash) != end(); }
+    CBlockIndex *operator[](const uint256 &hash) const;
+
+    // keyed by pIndex->blockHash, false if an index of the hash is in already
+    bool insert(CBlockIndex *pIndex);
+    size_t erase(const uint256 &hash);
+    void reserve(size_t entryCountIn);
+    void clear();
+
+    size_t size() const { return entryCount; }
+    bool empty() const { return entryCount == 0; }
+
+private:
+    vector<CBlockIndex *> slots;  // the size is a power of 2, nullptr if empty
+    size_t entryCount;
+
+    size_t GetSlot(const uint256 &hash) const { return hash.GetCheapHash() & (slots.size() - 1); }
+    void Rehash(size_t slotCount);
+};
+
+/**
+ * Owns the block indexes. They are constructed in slabs instead of one heap allocation each,
+ * and they all live until the arena is cleared at shutdown. Not thread safe, guarded by cs_main.
+ */
+class CBlockIndexArena {
+public:
+    CBlockIndexArena() : used(SLAB_SIZE), count(0) {}
+    ~CBlockIndexArena() { Clear(); }
+
+    template <typename... Args>
+    CBlockIndex *New(Args &&... args) {
+        if (used == SLAB_SIZE) {
+            slabs.push_back(allocator.allocate(SLAB_SIZE));
+            used = 0;
+        }
+        CBlockIndex *pIndex = new (slabs.back() + used) CBlockIndex(std::forward<Args>(args)...);
+        used++;
+        count++;
+        return pIndex;
+    }
+
+    void Clear();
+    size_t Size() const { return count; }
+
+private:
+    static const size_t SLAB_SIZE = 4096;
+
+    std::allocator<CBlockIndex> allocator;
+    vector<CBlockIndex *> slabs;
+    size_t used;   // of the last slab
+    size_t count;
+
+    CBlockIndexArena(const CBlockIndexArena &);
+    void operator=(const CBlockIndexArena &);
+};
+
 /** Describes a place in the block chain to another node such that if the
  * other node doesn't have the same branch, it can find a recent common trunk.
  * The further back it is, the further before the fork it may be.
@@ -469,6 +634,8 @@ struct CBlockLocator {
 bool WriteBlockToDisk(CBlock &block, CDiskBlockPos &pos);
 bool ReadBlockFromDisk(const CDiskBlockPos &pos, CBlock &block);
 bool ReadBlockFromDisk(const CBlockIndex *pIndex, CBlock &block);
+// the serialized block at the pos as it is on disk, checked to be the block of the hash
+bool ReadRawBlockFromDisk(const CDiskBlockPos &pos, const uint256 &blockHash, vector<char> &rawBlock);
 
 
 bool ReadBaseTxFromDisk(const CTxCord txCord, std::shared_ptr<CBaseTx> &pTx);
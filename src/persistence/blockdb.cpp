@@ -10,6 +10,7 @@
 #include "main.h"
 
 #include <stdint.h>
+#include <boost/thread.hpp>
 
 using namespace std;
 
@@ -22,51 +23,127 @@ bool CBlockIndexDB::EraseBlockIndex(const uint256 &blockHash) {
     return Erase(dbk::GenDbKey(dbk::BLOCK_INDEX, blockHash));
 }
 
+bool CBlockIndexDB::WriteBlockSummary(const uint256 &blockHash, const CBlockSummary &summary) {
+    return Write(dbk::GenDbKey(dbk::BLOCK_SUMMARY, blockHash), summary);
+}
+
 bool CBlockIndexDB::LoadBlockIndexes() {
     leveldb::Iterator *pCursor = NewIterator();
     const std::string &prefix = dbk::GetKeyPrefix(dbk::BLOCK_INDEX);
-
     pCursor->Seek(prefix);
 
-    // Load mapBlockIndex
-    while (pCursor->Valid()) {
+    // the entries are read, deserialized and hashed on all the cores, then linked, batch by batch,
+    // so only a batch of raw entries is held in memory beside the indexes
+    uint32_t threadCount = std::max(1U, boost::thread::hardware_concurrency());
+    vector<uint256> keyHashes;
+    vector<string> rawIndexes;
+    vector<CDiskBlockIndex> diskIndexes;
+    vector<uint256> blockHashes;
+    while (pCursor->Valid() && pCursor->key().starts_with(prefix)) {
+        keyHashes.clear();
+        rawIndexes.clear();
+        try {
+            for (; pCursor->Valid() && pCursor->key().starts_with(prefix) && rawIndexes.size() < BLOCK_INDEX_LOAD_BATCH;
+                 pCursor->Next()) {
+                boost::this_thread::interruption_point();
+                uint256 keyHash;
+                dbk::ParseDbKey(pCursor->key(), dbk::BLOCK_INDEX, keyHash);
+                keyHashes.push_back(keyHash);
+                rawIndexes.push_back(pCursor->value().ToString());
+            }
+        } catch (std::exception &e) {
+            delete pCursor;
+            return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
+        }
+
+        diskIndexes.assign(rawIndexes.size(), CDiskBlockIndex());
+        blockHashes.assign(rawIndexes.size(), uint256());
+        uint32_t workerCount = std::min<uint32_t>(threadCount, rawIndexes.size());
+        vector<string> errors(workerCount);
+        auto deserialize = [&](uint32_t worker) {
+            for (size_t i = worker; i < rawIndexes.size() && errors[worker].empty(); i += workerCount) {
+                try {
+                    CDataStream ssValue(rawIndexes[i].data(), rawIndexes[i].data() + rawIndexes[i].size(), SER_DISK,
+                                        CLIENT_VERSION);
+                    ssValue >> diskIndexes[i];
+                    blockHashes[i] = diskIndexes[i].GetBlockHash();
+                } catch (std::exception &e) {
+                    errors[worker] = e.what();
+                }
+            }
+        };
+
+        boost::thread_group workers;
+        for (uint32_t worker = 1; worker < workerCount; worker++)
+            workers.create_thread(boost::bind<void>(deserialize, worker));
+        deserialize(0);
+        workers.join_all();
+
+        for (const auto &error : errors) {
+            if (!error.empty()) {
+                delete pCursor;
+                return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, error);
+            }
+        }
+
+        // link them to the parents
+        for (size_t i = 0; i < diskIndexes.size(); i++) {
+            CDiskBlockIndex &diskIndex = diskIndexes[i];
+            if (blockHashes[i] != keyHashes[i]) {
+                delete pCursor;
+                return ERRORMSG("%s : the block index of key %s has the hash %s", __func__, keyHashes[i].GetHex(),
+                                blockHashes[i].GetHex());
+            }
+
+            // Construct block index object
+            CBlockIndex *pIndexNew    = InsertBlockIndex(blockHashes[i]);
+            pIndexNew->pprev          = InsertBlockIndex(diskIndex.hashPrev);
+            pIndexNew->height         = diskIndex.height;
+            pIndexNew->nFile          = diskIndex.nFile;
+            pIndexNew->nDataPos       = diskIndex.nDataPos;
+            pIndexNew->nUndoPos       = diskIndex.nUndoPos;
+            pIndexNew->nVersion       = diskIndex.nVersion;
+            pIndexNew->merkleRootHash = diskIndex.merkleRootHash;
+            pIndexNew->nTime          = diskIndex.nTime;
+            pIndexNew->nBits          = diskIndex.nBits;
+            pIndexNew->nNonce         = diskIndex.nNonce;
+            pIndexNew->nStatus        = diskIndex.nStatus;
+            pIndexNew->nTx            = diskIndex.nTx;
+            pIndexNew->nFuel          = diskIndex.nFuel;
+            pIndexNew->nFuelRate      = diskIndex.nFuelRate;
+            pIndexNew->vSignature     = std::move(diskIndex.vSignature);
+            pIndexNew->minerHeight    = diskIndex.minerHeight;
+            pIndexNew->minerIndex     = diskIndex.minerIndex;
+
+            if (!pIndexNew->CheckIndex()) {
+                delete pCursor;
+                return ERRORMSG("LoadBlockIndex() : CheckIndex failed: %s", pIndexNew->ToString());
+            }
+        }
+    }
+    delete pCursor;
+
+    return LoadBlockSummaries();
+}
+
+bool CBlockIndexDB::LoadBlockSummaries() {
+    leveldb::Iterator *pCursor = NewIterator();
+    const std::string &prefix = dbk::GetKeyPrefix(dbk::BLOCK_SUMMARY);
+
+    // the blocks connected before the summaries were introduced have none
+    for (pCursor->Seek(prefix); pCursor->Valid() && pCursor->key().starts_with(prefix); pCursor->Next()) {
         boost::this_thread::interruption_point();
         try {
-            leveldb::Slice slKey = pCursor->key();
-            if (slKey.starts_with(prefix)) {
+            uint256 blockHash;
+            dbk::ParseDbKey(pCursor->key(), dbk::BLOCK_SUMMARY, blockHash);
+
+            CBlockIndex *pIndex = mapBlockIndex[blockHash];
+            if (pIndex != nullptr) {
                 leveldb::Slice slValue = pCursor->value();
-                CDataStream ssValue(slValue.data(), slValue.data() + slValue.size(), SER_DISK, CLIENT_VERSION);
-                CDiskBlockIndex diskIndex;
-                ssValue >> diskIndex;
-
-                // Construct block index object
-                CBlockIndex *pIndexNew    = InsertBlockIndex(diskIndex.GetBlockHash());
-                pIndexNew->pprev          = InsertBlockIndex(diskIndex.hashPrev);
-                pIndexNew->height         = diskIndex.height;
-                pIndexNew->nFile          = diskIndex.nFile;
-                pIndexNew->nDataPos       = diskIndex.nDataPos;
-                pIndexNew->nUndoPos       = diskIndex.nUndoPos;
-                pIndexNew->nVersion       = diskIndex.nVersion;
-                pIndexNew->merkleRootHash = diskIndex.merkleRootHash;
-                pIndexNew->hashPos        = diskIndex.hashPos;
-                pIndexNew->nTime          = diskIndex.nTime;
-                pIndexNew->nBits          = diskIndex.nBits;
-                pIndexNew->nNonce         = diskIndex.nNonce;
-                pIndexNew->nStatus        = diskIndex.nStatus;
-                pIndexNew->nTx            = diskIndex.nTx;
-                pIndexNew->nFuel          = diskIndex.nFuel;
-                pIndexNew->nFuelRate      = diskIndex.nFuelRate;
-                pIndexNew->vSignature     = diskIndex.vSignature;
-                pIndexNew->miner          = diskIndex.miner ;
-
-                if (!pIndexNew->CheckIndex())
-                    return ERRORMSG("LoadBlockIndex() : CheckIndex failed: %s", pIndexNew->ToString());
-
-                pCursor->Next();
-            } else {
-                break;  // if shutdown requested or finished loading block index
+                pIndex->summaryData.assign(slValue.data(), slValue.data() + slValue.size());
             }
         } catch (std::exception &e) {
+            delete pCursor;
             return ERRORMSG("%s : Deserialize or I/O error - %s", __func__, e.what());
         }
     }
@@ -87,16 +164,14 @@ CBlockIndex *InsertBlockIndex(uint256 hash) {
         return nullptr;
 
     // Return existing
-    map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(hash);
+    BlockMap::iterator mi = mapBlockIndex.find(hash);
     if (mi != mapBlockIndex.end())
         return (*mi).second;
 
     // Create new
-    CBlockIndex *pIndexNew = new CBlockIndex();
-    if (!pIndexNew)
-        throw runtime_error("LoadBlockIndex() : new CBlockIndex failed");
-    mi                    = mapBlockIndex.insert(make_pair(hash, pIndexNew)).first;
-    pIndexNew->pBlockHash = &((*mi).first);
+    CBlockIndex *pIndexNew = blockIndexArena.New();
+    pIndexNew->blockHash   = hash;
+    mapBlockIndex.insert(pIndexNew);
 
     return pIndexNew;
 }
@@ -199,6 +274,10 @@ bool CBlockDBCache::WriteFlag(const string &name, bool fValue) {
 bool CBlockDBCache::ReadFlag(const string &name, bool &fValue) {
     return flagCache.GetData(name, fValue);
 }
+bool CBlockDBCache::FlushFlags() {
+    flagCache.Flush();
+    return true;
+}
 bool CBlockDBCache::WriteGlobalFinBlock(const int32_t height, const uint256 hash) {
     finalityBlockCache.SetData(std::make_pair(height, hash)) ;
     return true ;
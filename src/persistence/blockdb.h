@@ -16,6 +16,9 @@
 
 #include <map>
 
+/** Block index entries read from the db and deserialized together while loading */
+static const uint32_t BLOCK_INDEX_LOAD_BATCH = 16384;
+
 /** Access to the block database (blocks/index/) */
 class CBlockIndexDB : public CLevelDBWrapper {
 private:
@@ -31,10 +34,15 @@ public:
 public:
     bool WriteBlockIndex(const CDiskBlockIndex &blockindex);
     bool EraseBlockIndex(const uint256 &blockHash);
+    bool WriteBlockSummary(const uint256 &blockHash, const CBlockSummary &summary);
     bool LoadBlockIndexes();
 
     bool ReadBlockFileInfo(int32_t nFile, CBlockFileInfo &fileinfo);
     bool WriteBlockFileInfo(int32_t nFile, const CBlockFileInfo &fileinfo);
+
+private:
+    // attaches the block summaries to the loaded block indexes
+    bool LoadBlockSummaries();
 };
 
 
@@ -101,6 +109,16 @@ public:
         finalityBlockCache.RegisterUndoFunc(undoDataFuncMap);
     }
 
+    void RegisterDbValueFunc(DbValueFuncMap &dbValueFuncMap) {
+        txDiskPosCache.RegisterDbValueFunc(dbValueFuncMap);
+        flagCache.RegisterDbValueFunc(dbValueFuncMap);
+        bestBlockHashCache.RegisterDbValueFunc(dbValueFuncMap);
+        lastBlockFileCache.RegisterDbValueFunc(dbValueFuncMap);
+        medianPricesCache.RegisterDbValueFunc(dbValueFuncMap);
+        reindexCache.RegisterDbValueFunc(dbValueFuncMap);
+        finalityBlockCache.RegisterDbValueFunc(dbValueFuncMap);
+    }
+
     bool ReadTxIndex(const uint256 &txid, CDiskTxPos &pos);
     bool SetTxIndex(const uint256 &txid, const CDiskTxPos &pos);
     bool WriteTxIndexes(const vector<pair<uint256, CDiskTxPos> > &list);
@@ -117,6 +135,8 @@ public:
 
     bool WriteFlag(const string &name, bool fValue);
     bool ReadFlag(const string &name, bool &fValue);
+    // write the flags down now, ahead of the rest of the cache
+    bool FlushFlags();
 
     bool WriteGlobalFinBlock(const int32_t height, const uint256 hash);
     bool ReadGlobalFinBlock(std::pair<int32_t,uint256>& block);
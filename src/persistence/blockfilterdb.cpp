@@ -0,0 +1,24 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockfilterdb.h"
+
+bool CBlockFilterDBCache::SetBlockFilter(const CBlockFilter &filter, const uint256 &header) {
+    return blockFilterCache.SetData(filter.block_hash, filter) &&
+           filterHeaderCache.SetData(filter.block_hash, header);
+}
+
+bool CBlockFilterDBCache::GetBlockFilter(const uint256 &blockHash, CBlockFilter &filter) {
+    return blockFilterCache.GetData(blockHash, filter);
+}
+
+bool CBlockFilterDBCache::GetFilterHeader(const uint256 &blockHash, uint256 &header) {
+    return filterHeaderCache.GetData(blockHash, header);
+}
+
+void CBlockFilterDBCache::Flush() {
+    blockFilterCache.Flush();
+    filterHeaderCache.Flush();
+    filterTipCache.Flush();
+}
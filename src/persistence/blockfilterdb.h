@@ -0,0 +1,49 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PERSIST_BLOCKFILTERDB_H
+#define PERSIST_BLOCKFILTERDB_H
+
+#include "chain/blockfilter.h"
+#include "commons/serialize.h"
+#include "dbaccess.h"
+#include "dbconf.h"
+
+using namespace std;
+
+class CBlockFilterDBCache {
+public:
+    CBlockFilterDBCache() {}
+    CBlockFilterDBCache(CDBAccess *pDbAccess)
+        : blockFilterCache(pDbAccess), filterHeaderCache(pDbAccess), filterTipCache(pDbAccess) {}
+
+public:
+    bool SetBlockFilter(const CBlockFilter &filter, const uint256 &header);
+    bool GetBlockFilter(const uint256 &blockHash, CBlockFilter &filter);
+    bool GetFilterHeader(const uint256 &blockHash, uint256 &header);
+
+    bool SetTip(const uint256 &blockHash) { return filterTipCache.SetData(blockHash); }
+    bool GetTip(uint256 &blockHash) { return filterTipCache.GetData(blockHash); }
+
+    void Flush();
+
+    uint32_t GetCacheSize() const {
+        return blockFilterCache.GetCacheSize() + filterHeaderCache.GetCacheSize() + filterTipCache.GetCacheSize();
+    }
+
+public:
+/*  CCompositeKVCache     prefixType                  key                 value                 variable      */
+/*  -------------------- --------------------------- ------------------  -------------------  -------------- */
+    // [prefix]{blockhash} --> block filter
+    CCompositeKVCache< dbk::BLOCK_FILTER,             uint256,            CBlockFilter >        blockFilterCache;
+    // [prefix]{blockhash} --> filter header
+    CCompositeKVCache< dbk::BLOCK_FILTER_HEADER,      uint256,            uint256 >             filterHeaderCache;
+
+/*  CSimpleKVCache        prefixType                  value               variable           */
+/*  -------------------- --------------------------- ------------------  ------------------ */
+    // [prefix] --> hash of the last indexed block
+    CSimpleKVCache< dbk::BLOCK_FILTER_TIP,            uint256>            filterTipCache;
+};
+
+#endif // PERSIST_BLOCKFILTERDB_H
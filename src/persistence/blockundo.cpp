@@ -90,6 +90,27 @@ string CBlockUndo::ToString() const {
     return str;
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// class CBlockExecResult
+
+void CBlockExecResult::Finalize(const CBlock &blockIn) {
+    block = blockIn;
+}
+
+bool CBlockExecResult::Verify(const CBlockIndex *pIndex) const {
+    if (pIndex == nullptr || spCW == nullptr || block.GetHash() != pIndex->GetBlockHash())
+        return false;
+
+    if (block.vptx.size() != block_undo.vtxundo.size() + 1)
+        return false;
+
+    for (size_t index = 0; index < block_undo.vtxundo.size(); ++index) {
+        if (block_undo.vtxundo[index].txid != block.vptx[index + 1]->GetHash())
+            return false;
+    }
+
+    return true;
+}
 
 ////////////////////////////////////////////////////////////////////////////////
 // class CBlockUndoExecutor
@@ -11,6 +11,7 @@
 #include "cachewrapper.h"
 #include "leveldbwrapper.h"
 #include "disk.h"
+#include "block.h"
 
 #include <stdint.h>
 #include <memory>
@@ -84,6 +85,28 @@ public:
     bool Execute();
 };
 
+/** Execution results of a block produced by this node.
+ *  The miner has already executed every tx of the block (except the block reward tx) on top of
+ *  the current tip, so connecting the block can reuse the resulting cache and undo logs instead of
+ *  executing the txs a second time. The results never leave the process and are only reused on the
+ *  state they were made on, the best block hash is compared before; Verify() only binds them to
+ *  the block, it proves nothing of the cached state itself. */
+class CBlockExecResult {
+public:
+    uint256 prev_block_hash;            // best block hash the txs were executed on
+    std::shared_ptr<CCacheWrapper> spCW; // state after executing all txs except the block reward tx
+    CBlockUndo block_undo;              // undo logs of the executed txs, in block order
+    CBlock block;                       // the produced block, including memory-only tx run steps
+
+    CBlockExecResult(std::shared_ptr<CCacheWrapper> spCWIn, const uint256 &prevBlockHashIn)
+        : prev_block_hash(prevBlockHashIn), spCW(spCWIn) {}
+
+    // bind the results to the finished block
+    void Finalize(const CBlock &blockIn);
+    // check the results are of the block to connect, tx by tx
+    bool Verify(const CBlockIndex *pIndex) const;
+};
+
 /** Open an undo file (rev?????.dat) */
 FILE *OpenUndoFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 
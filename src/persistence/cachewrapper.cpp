@@ -72,6 +72,25 @@ void CCacheWrapper::CopyFrom(CCacheDBManager* pCdMan){
     sysGovernCache = *pCdMan->pSysGovernCache ;
 }
 
+void CCacheWrapper::ReadDbsFrom(CCacheDBManager* pCdMan) {
+    sysParamCache  = CSysParamDBCache(pCdMan->pSysParamDb);
+    blockCache     = CBlockDBCache(pCdMan->pBlockDb);
+    accountCache   = CAccountDBCache(pCdMan->pAccountDb);
+    assetCache     = CAssetDBCache(pCdMan->pAssetDb);
+    contractCache  = CContractDBCache(pCdMan->pContractDb);
+    delegateCache  = CDelegateDBCache(pCdMan->pDelegateDb);
+    cdpCache       = CCdpDBCache(pCdMan->pCdpDb);
+    closedCdpCache = CClosedCdpDBCache(pCdMan->pClosedCdpDb);
+    dexCache       = CDexDBCache(pCdMan->pDexDb);
+    txReceiptCache = CTxReceiptDBCache(pCdMan->pReceiptDb);
+    txUtxoCache    = CTxUTXODBCache(pCdMan->pUtxoDb);
+
+    // the memory-only caches have no db
+    txCache.SetBaseViewPtr(pCdMan->pTxCache);
+    ppCache.SetBaseViewPtr(pCdMan->pPpCache);
+    sysGovernCache = CSysGovernDBCache(pCdMan->pSysGovernDb);
+}
+
 CCacheWrapper& CCacheWrapper::operator=(CCacheWrapper& other) {
     if (this == &other)
         return *this;
@@ -144,6 +163,23 @@ UndoDataFuncMap CCacheWrapper::GetUndoDataFuncMap() {
     return undoDataFuncMap;
 }
 
+DbValueFuncMap CCacheWrapper::GetDbValueFuncMap() {
+    DbValueFuncMap dbValueFuncMap;
+    sysParamCache.RegisterDbValueFunc(dbValueFuncMap);
+    blockCache.RegisterDbValueFunc(dbValueFuncMap);
+    accountCache.RegisterDbValueFunc(dbValueFuncMap);
+    assetCache.RegisterDbValueFunc(dbValueFuncMap);
+    contractCache.RegisterDbValueFunc(dbValueFuncMap);
+    delegateCache.RegisterDbValueFunc(dbValueFuncMap);
+    cdpCache.RegisterDbValueFunc(dbValueFuncMap);
+    closedCdpCache.RegisterDbValueFunc(dbValueFuncMap);
+    dexCache.RegisterDbValueFunc(dbValueFuncMap);
+    txReceiptCache.RegisterDbValueFunc(dbValueFuncMap);
+    txUtxoCache.RegisterDbValueFunc(dbValueFuncMap);
+    sysGovernCache.RegisterDbValueFunc(dbValueFuncMap);
+    return dbValueFuncMap;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // class CCacheDBManager
 
@@ -190,6 +226,9 @@ CCacheDBManager::CCacheDBManager(bool fReIndex, bool fMemory) {
     pSysGovernDb    = new CDBAccess(dbDir, DBNameType::SYSGOVERN, false, fReIndex);
     pSysGovernCache = new CSysGovernDBCache(pSysGovernDb);
 
+    pStateCommitDb    = new CDBAccess(dbDir, DBNameType::STATECOMMIT, false, fReIndex);
+    pStateCommitCache = new CStateCommitDBCache(pStateCommitDb);
+
     // memory-only cache
     pTxCache        = new CTxMemCache();
     pPpCache        = new CPricePointMemCache();
@@ -209,6 +248,7 @@ CCacheDBManager::~CCacheDBManager() {
     delete pReceiptCache;   pReceiptCache = nullptr;
     delete pSysGovernCache; pSysGovernCache = nullptr;
     delete pUtxoCache;      pUtxoCache = nullptr;
+    delete pStateCommitCache; pStateCommitCache = nullptr;
 
     delete pSysParamDb;     pSysParamDb = nullptr;
     delete pAccountDb;      pAccountDb = nullptr;
@@ -224,6 +264,7 @@ CCacheDBManager::~CCacheDBManager() {
     delete pReceiptDb;      pReceiptDb = nullptr;
     delete pSysGovernDb;    pSysGovernDb = nullptr;
     delete pUtxoDb;         pUtxoDb = nullptr;
+    delete pStateCommitDb;  pStateCommitDb = nullptr;
 
     // memory-only cache
     delete pTxCache;        pTxCache = nullptr;
@@ -259,6 +300,9 @@ bool CCacheDBManager::Flush() {
 
     if (pUtxoCache) pUtxoCache->Flush();
 
+    // the commitment goes last, its tip tells whether it's behind the state after a crash
+    if (pStateCommitCache) pStateCommitCache->Flush();
+
     // Memory only cache, not bother to flush.
     // if (pTxCache)
     //     pTxCache->Flush();
@@ -267,3 +311,23 @@ bool CCacheDBManager::Flush() {
 
     return true;
 }
+
+CDBAccess *CCacheDBManager::GetDbAccess(DBNameType dbNameType) {
+    switch (dbNameType) {
+        case DBNameType::SYSPARAM:  return pSysParamDb;
+        case DBNameType::ACCOUNT:   return pAccountDb;
+        case DBNameType::ASSET:     return pAssetDb;
+        case DBNameType::BLOCK:     return pBlockDb;
+        case DBNameType::CONTRACT:  return pContractDb;
+        case DBNameType::DELEGATE:  return pDelegateDb;
+        case DBNameType::CDP:       return pCdpDb;
+        case DBNameType::CLOSEDCDP: return pClosedCdpDb;
+        case DBNameType::DEX:       return pDexDb;
+        case DBNameType::LOG:       return pLogDb;
+        case DBNameType::RECEIPT:   return pReceiptDb;
+        case DBNameType::UTXO:      return pUtxoDb;
+        case DBNameType::SYSGOVERN: return pSysGovernDb;
+        case DBNameType::STATECOMMIT: return pStateCommitDb;
+        default:                    return nullptr;
+    }
+}
@@ -15,6 +15,7 @@
 #include "delegatedb.h"
 #include "dexdb.h"
 #include "pricefeeddb.h"
+#include "statecommitdb.h"
 #include "sysparamdb.h"
 #include "txdb.h"
 #include "txreceiptdb.h"
@@ -52,10 +53,13 @@ public:
     CCacheWrapper& operator=(CCacheWrapper& other);
 
     void CopyFrom(CCacheDBManager* pCdMan);
+    // read the dbs of pCdMan directly, not through its caches
+    void ReadDbsFrom(CCacheDBManager* pCdMan);
 
     void Flush();
 
     UndoDataFuncMap GetUndoDataFuncMap();
+    DbValueFuncMap GetDbValueFuncMap();
 
     void SetDbOpLogMap(CDBOpLogMap *pDbOpLogMap);
 private:
@@ -107,6 +111,8 @@ public:
     CDBAccess           *pSysGovernDb;
     CSysGovernDBCache   *pSysGovernCache;
 
+    CDBAccess           *pStateCommitDb;
+    CStateCommitDBCache *pStateCommitCache;
 
     CTxMemCache         *pTxCache;
     CPricePointMemCache *pPpCache;
@@ -117,6 +123,9 @@ public:
     ~CCacheDBManager();
 
     bool Flush();
+
+    //! the db of the name, nullptr for the block index db which is no CDBAccess
+    CDBAccess *GetDbAccess(DBNameType dbNameType);
 };  // CCacheDBManager
 
 #endif //PERSIST_CACHEWRAPPER_H
\ No newline at end of file
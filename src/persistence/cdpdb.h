@@ -62,6 +62,14 @@ public:
         cdpRatioSortedCache.RegisterUndoFunc(undoDataFuncMap);
     }
 
+    void RegisterDbValueFunc(DbValueFuncMap &dbValueFuncMap) {
+        cdpGlobalDataCache.RegisterDbValueFunc(dbValueFuncMap);
+        cdpCache.RegisterDbValueFunc(dbValueFuncMap);
+        userCdpCache.RegisterDbValueFunc(dbValueFuncMap);
+        cdpCoinPairsCache.RegisterDbValueFunc(dbValueFuncMap);
+        cdpRatioSortedCache.RegisterDbValueFunc(dbValueFuncMap);
+    }
+
     uint32_t GetCacheSize() const;
     bool Flush();
 private:
@@ -143,6 +151,11 @@ public:
         closedCdpTxCache.RegisterUndoFunc(undoDataFuncMap);
         closedTxCdpCache.RegisterUndoFunc(undoDataFuncMap);
     }
+
+    void RegisterDbValueFunc(DbValueFuncMap &dbValueFuncMap) {
+        closedCdpTxCache.RegisterDbValueFunc(dbValueFuncMap);
+        closedTxCdpCache.RegisterDbValueFunc(dbValueFuncMap);
+    }
 private:
     CdpRatioSortedCache::KeyType MakeCdpRatioSortedKey(const CUserCDP &cdp);
 public:
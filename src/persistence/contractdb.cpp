@@ -38,10 +38,6 @@ bool CContractDBCache::GetContract(const CRegID &contractRegId, CUniversalContra
     return contractCache.GetData(contractRegId, contract);
 }
 
-bool CContractDBCache::GetContracts(map<CRegIDKey, CUniversalContract> &contracts) {
-    return contractCache.GetAllElements(contracts);
-}
-
 bool CContractDBCache::SaveContract(const CRegID &contractRegId, const CUniversalContract &contract) {
     return contractCache.SetData(contractRegId, contract);
 }
@@ -100,6 +96,10 @@ uint32_t CContractDBCache::GetCacheSize() const {
 }
 
 
+shared_ptr<CDBContractIterator> CContractDBCache::CreateContractIterator() {
+    return make_shared<CDBContractIterator>(contractCache);
+}
+
 shared_ptr<CDBContractDataIterator> CContractDBCache::CreateContractDataIterator(const CRegID &contractRegid,
         const string &contractKeyPrefix) {
 
@@ -34,9 +34,13 @@ typedef dbk::CDBTailKey<MAX_CONTRACT_KEY_SIZE> CDBContractKey;
 
 /*  CCompositeKVCache     prefixType                       key                       value         variable           */
 /*  -------------------- --------------------         ----------------------------  ---------   --------------------- */
+    // contract $RegIdKey -> Contract
+typedef CCompositeKVCache< dbk::CONTRACT_DEF,         CRegIDKey,                   CUniversalContract >   DBContractCache;
     // pair<contractRegId, contractKey> -> contractData
 typedef CCompositeKVCache< dbk::CONTRACT_DATA,        pair<CRegIDKey, CDBContractKey>, string>     DBContractDataCache;
 
+typedef CDBIterator<DBContractCache> CDBContractIterator;
+
 class CDBContractDataIterator: public CDBPrefixIterator<DBContractDataCache, DBContractDataCache::KeyType> {
 private:
     typedef typename DBContractDataCache::KeyType KeyType;
@@ -82,7 +86,6 @@ public:
     bool SetContractAccount(const CRegID &contractRegId, const CAppUserAccount &appAccIn);
 
     bool GetContract(const CRegID &contractRegId, CUniversalContract &contract);
-    bool GetContracts(map<CRegIDKey, CUniversalContract> &contracts);
     bool SaveContract(const CRegID &contractRegId, const CUniversalContract &contract);
     bool HaveContract(const CRegID &contractRegId);
     bool EraseContract(const CRegID &contractRegId);
@@ -119,6 +122,15 @@ public:
         contractTracesCache.RegisterUndoFunc(undoDataFuncMap);
     }
 
+    void RegisterDbValueFunc(DbValueFuncMap &dbValueFuncMap) {
+        contractCache.RegisterDbValueFunc(dbValueFuncMap);
+        contractDataCache.RegisterDbValueFunc(dbValueFuncMap);
+        contractAccountCache.RegisterDbValueFunc(dbValueFuncMap);
+        contractTracesCache.RegisterDbValueFunc(dbValueFuncMap);
+    }
+
+    shared_ptr<CDBContractIterator> CreateContractIterator();
+
     shared_ptr<CDBContractDataIterator> CreateContractDataIterator(const CRegID &contractRegid,
         const string &contractKeyPrefix);
 
@@ -127,7 +139,7 @@ public:
 /*  ----------------   -------------------------   -----------------------  ------------------   ------------------------ */
     /////////// ContractDB
     // contract $RegIdKey -> Contract
-    CCompositeKVCache< dbk::CONTRACT_DEF,         CRegIDKey,                   CUniversalContract >   contractCache;
+    DBContractCache contractCache;
 
     // pair<contractRegId, contractKey> -> contractData
     DBContractDataCache contractDataCache;
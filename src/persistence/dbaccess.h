@@ -6,6 +6,7 @@
 #ifndef PERSIST_DB_ACCESS_H
 #define PERSIST_DB_ACCESS_H
 
+#include "commons/metrics.h"
 #include "commons/uint256.h"
 #include "dbconf.h"
 #include "leveldbwrapper.h"
@@ -259,10 +260,24 @@ namespace db_util {
         T value; SetEmpty(value);
         return value;
     }
+
+    // the value as written to the db, empty for the erased one
+    template<typename T>
+    string SerializeValue(const T *pValue) {
+        if (pValue == nullptr || IsEmpty(*pValue))
+            return string();
+
+        CDataStream ssValue(SER_DISK, CLIENT_VERSION);
+        ssValue << *pValue;
+        return ssValue.str();
+    }
 };
 
 typedef void(UndoDataFunc)(const CDbOpLogs &pDbOpLogs);
 typedef std::map<dbk::PrefixType, std::function<UndoDataFunc>> UndoDataFuncMap;
+// the serialized value of the db key read through the caches, false if the key is not set
+typedef bool(DbValueFunc)(const string &dbKey, string &value);
+typedef std::map<dbk::PrefixType, std::function<DbValueFunc>> DbValueFuncMap;
 
 class CDBAccess {
 public:
@@ -482,6 +497,15 @@ public:
     std::shared_ptr<leveldb::Iterator> NewIterator() {
         return std::shared_ptr<leveldb::Iterator>(db.NewIterator());
     }
+
+    std::shared_ptr<leveldb::Iterator> NewIterator(const leveldb::Snapshot *pSnapshot) {
+        return std::shared_ptr<leveldb::Iterator>(db.NewIterator(pSnapshot));
+    }
+
+    const leveldb::Snapshot *GetSnapshot() { return db.GetSnapshot(); }
+    void ReleaseSnapshot(const leveldb::Snapshot *pSnapshot) { db.ReleaseSnapshot(pSnapshot); }
+
+    bool WriteBatch(CLevelDBBatch &batch) { return db.WriteBatch(batch, true); }
 private:
     DBNameType dbNameType;
     mutable CLevelDBWrapper db; // // TODO: remove the mutable declare
@@ -666,6 +690,23 @@ public:
         undoDataFuncMap[GetPrefixType()] = std::bind(&CCompositeKVCache::UndoDataList, this, std::placeholders::_1);
     }
 
+    bool GetDbValue(const string &dbKey, string &value) const {
+        KeyType key;
+        if (!dbk::ParseDbKey(dbKey, PREFIX_TYPE, key))
+            return false;
+
+        ValueType data;
+        if (!GetData(key, data))
+            return false;
+        value = db_util::SerializeValue(&data);
+        return true;
+    }
+
+    void RegisterDbValueFunc(DbValueFuncMap &dbValueFuncMap) {
+        dbValueFuncMap[GetPrefixType()] = std::bind(&CCompositeKVCache::GetDbValue, this, std::placeholders::_1,
+                                                    std::placeholders::_2);
+    }
+
     dbk::PrefixType GetPrefixType() const { return PREFIX_TYPE; }
 
     CDBAccess* GetDbAccessPtr() {
@@ -681,18 +722,24 @@ public:
     map<KeyType, ValueType>& GetMapData() { return mapData; };
 private:
     Iterator GetDataIt(const KeyType &key) const {
+        metrics::cache_reads.Inc();
+        return FindDataIt(key);
+    }
+
+    Iterator FindDataIt(const KeyType &key) const {
         Iterator it = mapData.find(key);
         if (it != mapData.end()) {
             return it;
         } else if (pBase != nullptr) {
             // find key-value at base cache
-            auto baseIt = pBase->GetDataIt(key);
+            auto baseIt = pBase->FindDataIt(key);
             if (baseIt != pBase->mapData.end()) {
                 // the found key-value add to current mapData
                 return AddDataToMap(key, baseIt->second);
             }
         } else if (pDbAccess != NULL) {
             // TODO: need to save the empty value to mapData for search performance?
+            metrics::cache_db_reads.Inc();
             auto pDbValue = db_util::MakeEmptyValue<ValueType>();
             if (pDbAccess->GetData(PREFIX_TYPE, key, *pDbValue)) {
                 return AddDataToMap(key, *pDbValue);
@@ -830,6 +877,9 @@ private:
                 dbOpLog.Set(key, oldValue);
             #endif
             pDbOpLogMap->AddOpLog(PREFIX_TYPE, dbOpLog);
+            if (fRecordStateDeltas)
+                pDbOpLogMap->AddStateDelta(PREFIX_TYPE, dbk::GenDbKey(PREFIX_TYPE, key),
+                                           db_util::SerializeValue(pNewValue));
         }
 
     }
@@ -912,7 +962,7 @@ public:
         if (!ptrData) {
             ptrData = db_util::MakeEmptyValue<ValueType>();
         }
-        AddOpLog(*ptrData);
+        AddOpLog(*ptrData, &value);
         *ptrData = value;
         return true;
     }
@@ -925,7 +975,7 @@ public:
     bool EraseData() {
         auto ptr = GetDataPtr();
         if (ptr && !db_util::IsEmpty(*ptr)) {
-            AddOpLog(*ptr);
+            AddOpLog(*ptr, nullptr);
             db_util::SetEmpty(*ptr);
         }
         return true;
@@ -966,6 +1016,19 @@ public:
         undoDataFuncMap[GetPrefixType()] = std::bind(&CSimpleKVCache::UndoDataList, this, std::placeholders::_1);
     }
 
+    bool GetDbValue(const string &dbKey, string &value) const {
+        auto ptr = GetDataPtr();
+        if (!ptr || dbKey != dbk::GetKeyPrefix(PREFIX_TYPE))
+            return false;
+        value = db_util::SerializeValue(ptr.get());
+        return true;
+    }
+
+    void RegisterDbValueFunc(DbValueFuncMap &dbValueFuncMap) {
+        dbValueFuncMap[GetPrefixType()] = std::bind(&CSimpleKVCache::GetDbValue, this, std::placeholders::_1,
+                                                    std::placeholders::_2);
+    }
+
     dbk::PrefixType GetPrefixType() const { return PREFIX_TYPE; }
 
     std::shared_ptr<ValueType> GetDataPtr() const {
@@ -991,11 +1054,14 @@ public:
     }
 
 private:
-    inline void AddOpLog(const ValueType &oldValue) {
+    inline void AddOpLog(const ValueType &oldValue, const ValueType *pNewValue) {
         if (pDbOpLogMap != nullptr) {
             CDbOpLog dbOpLog;
             dbOpLog.Set(oldValue);
             pDbOpLogMap->AddOpLog(PREFIX_TYPE, dbOpLog);
+            if (fRecordStateDeltas)
+                pDbOpLogMap->AddStateDelta(PREFIX_TYPE, dbk::GetKeyPrefix(PREFIX_TYPE),
+                                           db_util::SerializeValue(pNewValue));
         }
 
     }
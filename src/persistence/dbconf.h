@@ -34,6 +34,8 @@ typedef leveldb::Slice Slice;
     DEFINE( RECEIPT,            "receipts",       (100 << 10) )     /* tx receipt */ \
     DEFINE( UTXO,               "utxo",           (50  << 20) )     /* tx receipt */ \
     DEFINE( SYSGOVERN,          "governs",        (100 << 10) )           \
+    DEFINE( BLOCKFILTER,        "filters",        (1   << 20) )     /* block filter index */ \
+    DEFINE( STATECOMMIT,        "statecommit",    (1   << 20) )     /* state commitment */ \
     /*                                                                  */  \
     /* Add new Enum elements above, DB_NAME_COUNT Must be the last one */ \
     DEFINE( DB_NAME_COUNT,        "",               0)                  /* enum count, must be the last one */
@@ -81,6 +83,7 @@ namespace dbk {
         DEFINE( ASSET_TRADING_PAIR,   "atdp",   ASSET )          /* asst{$AssetName} --> $Asset */ \
         /**** block db                                                                          */ \
         DEFINE( BLOCK_INDEX,          "bidx",   BLOCK )         /* pbfl --> $nFile */ \
+        DEFINE( BLOCK_SUMMARY,        "bsum",   BLOCK )         /* [prefix]{$BlockHash} --> $BlockSummary */ \
         DEFINE( BLOCKFILE_NUM_INFO,   "bfni",   BLOCK )         /* BlockFileNum --> $BlockFileInfo */ \
         DEFINE( LAST_BLOCKFILE,       "ltbf",   BLOCK )         /* [prefix] --> $LastBlockFile */ \
         DEFINE( MEDIAN_PRICES,        "mdps",   BLOCK )         /* [prefix] --> median prices */ \
@@ -92,7 +95,10 @@ namespace dbk {
         /**** account db                                                                      */ \
         DEFINE( REGID_KEYID,          "rkey",   ACCOUNT )       /* rkey{$RegID} --> $KeyId */ \
         DEFINE( NICKID_KEYID,         "nkey",   ACCOUNT )       /* nkey{$NickID} --> $KeyId */ \
-        DEFINE( KEYID_ACCOUNT,        "idac",   ACCOUNT )       /* idac{$KeyID} --> $CAccount */ \
+        DEFINE( KEYID_ACCOUNT,        "idac",   ACCOUNT )       /* idac{$KeyID} --> $CAccount, legacy with the tokens inline */ \
+        DEFINE( KEYID_ACCOUNT_INFO,   "idai",   ACCOUNT )       /* idai{$KeyID} --> $CAccountInfo */ \
+        DEFINE( KEYID_ACCOUNT_TOKEN,  "idat",   ACCOUNT )       /* idat{$KeyID}{$TokenSymbol} --> $CAccountToken */ \
+        DEFINE( ACCOUNT_STATS,        "acst",   ACCOUNT )       /* acst --> $CAccountStats */ \
         /**** contract db                                                                      */ \
         DEFINE( CONTRACT_DEF,         "cdef",   CONTRACT )      /* cdef{$ContractRegId} --> $ContractContent */ \
         DEFINE( CONTRACT_DATA,        "cdat",   CONTRACT )      /* cdat{$RegId}{$DataKey} --> $Data */ \
@@ -127,6 +133,16 @@ namespace dbk {
         DEFINE( TX_RECEIPT,           "txrc",   RECEIPT )       /* [prefix]{txid} --> {receipts} */ \
         /**** tx coinutxo db                                                                    */ \
         DEFINE( TX_UTXO,              "utxo",   UTXO )          /* [prefix]{txid} --> {receipts} */ \
+        /**** block filter db                                                                   */ \
+        DEFINE( BLOCK_FILTER,         "bflt",   BLOCKFILTER )   /* [prefix]{$BlockHash} --> $BlockFilter */ \
+        DEFINE( BLOCK_FILTER_HEADER,  "bfhd",   BLOCKFILTER )   /* [prefix]{$BlockHash} --> $FilterHeader */ \
+        DEFINE( BLOCK_FILTER_TIP,     "bftp",   BLOCKFILTER )   /* [prefix] --> $BlockHash of the last indexed block */ \
+        /**** state commitment db                                                             */ \
+        DEFINE( STATE_BUCKET,         "stbk",   STATECOMMIT )   /* [prefix]{$BucketId} --> $StateBucket */ \
+        DEFINE( STATE_BUCKET_HASH,    "stbh",   STATECOMMIT )   /* [prefix]{$BucketId} --> $BucketHash */ \
+        DEFINE( STATE_ROOT,           "strt",   STATECOMMIT )   /* [prefix]{$BlockHash} --> $StateRoot */ \
+        DEFINE( STATE_UNDO,           "stud",   STATECOMMIT )   /* [prefix]{$height} --> $StateCommitUndo */ \
+        DEFINE( STATE_TIP,            "sttp",   STATECOMMIT )   /* [prefix] --> $BlockHash of the committed state */ \
         /*                                                                             */ \
         /* Add new Enum elements above, PREFIX_COUNT Must be the last one              */ \
         DEFINE( PREFIX_COUNT,         "",       DB_NAME_NONE)   /* enum count, must be the last one */
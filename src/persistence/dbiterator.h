@@ -427,4 +427,61 @@ public:
     }
 };
 
+/**
+ * Reads a table page by page with a merged iterator over the cache layers and the db, so the
+ * readers hold only one page in memory instead of all the elements of the table.
+ * The page after lastKey is read, or the first page when lastKey is empty. The last_key of a page
+ * is the cursor of the next page, and is passed to the rpc clients as the hex of its serialization.
+ */
+template<typename IteratorType>
+class CDBPageGetter {
+public:
+    typedef typename IteratorType::KeyType KeyType;
+    typedef typename IteratorType::ValueType ValueType;
+
+    vector<pair<KeyType, ValueType>> data_list;
+    bool has_more = false;
+    KeyType last_key;
+
+public:
+    CDBPageGetter(IteratorType &itIn) : it(itIn) {}
+
+    void Execute(const KeyType &lastKey, uint32_t maxCount) {
+        data_list.clear();
+        has_more = false;
+        last_key = lastKey;
+        for (it.SeekUpper(&lastKey); it.IsValid(); it.Next()) {
+            if (data_list.size() >= maxCount) {
+                has_more = true;
+                break;
+            }
+            data_list.emplace_back(it.GetKey(), it.GetValue());
+        }
+        if (!data_list.empty())
+            last_key = data_list.back().first;
+    }
+
+    static bool ParseLastPos(const string &lastPosInfo, KeyType &lastKey) {
+        db_util::SetEmpty(lastKey);
+        if (lastPosInfo.empty())
+            return true;
+        try {
+            CDataStream ds(lastPosInfo, SER_DISK, CLIENT_VERSION);
+            ds >> lastKey;
+            return ds.empty();
+        } catch (std::exception &e) {
+            return false;
+        }
+    }
+
+    static string MakeLastPos(const KeyType &lastKey) {
+        CDataStream ds(SER_DISK, CLIENT_VERSION);
+        ds << lastKey;
+        return ds.str();
+    }
+
+private:
+    IteratorType &it;
+};
+
 #endif //PERSIST_DB_ITERATOR_H
\ No newline at end of file
@@ -86,6 +86,14 @@ public:
         pending_delegates_cache.RegisterUndoFunc(undoDataFuncMap);
         active_delegates_cache.RegisterUndoFunc(undoDataFuncMap);
     }
+
+    void RegisterDbValueFunc(DbValueFuncMap &dbValueFuncMap) {
+        voteRegIdCache.RegisterDbValueFunc(dbValueFuncMap);
+        regId2VoteCache.RegisterDbValueFunc(dbValueFuncMap);
+        last_vote_height_cache.RegisterDbValueFunc(dbValueFuncMap);
+        pending_delegates_cache.RegisterDbValueFunc(dbValueFuncMap);
+        active_delegates_cache.RegisterDbValueFunc(dbValueFuncMap);
+    }
 public:
 /*  CCompositeKVCache  prefixType     key                              value                   variable       */
 /*  -------------------- -------------- --------------------------  ----------------------- -------------- */
@@ -161,6 +161,15 @@ public:
         operator_trade_pair_cache.RegisterUndoFunc(undoDataFuncMap);
     }
 
+    void RegisterDbValueFunc(DbValueFuncMap &dbValueFuncMap) {
+        activeOrderCache.RegisterDbValueFunc(dbValueFuncMap);
+        blockOrdersCache.RegisterDbValueFunc(dbValueFuncMap);
+        operator_detail_cache.RegisterDbValueFunc(dbValueFuncMap);
+        operator_owner_map_cache.RegisterDbValueFunc(dbValueFuncMap);
+        operator_last_id_cache.RegisterDbValueFunc(dbValueFuncMap);
+        operator_trade_pair_cache.RegisterDbValueFunc(dbValueFuncMap);
+    }
+
     shared_ptr<CDEXOrdersGetter> CreateOrdersGetter() {
         assert(blockOrdersCache.GetBasePtr() == nullptr && "only support top level cache");
         return make_shared<CDEXOrdersGetter>(blockOrdersCache);
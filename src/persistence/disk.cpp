@@ -62,3 +62,39 @@ FILE *OpenDiskFile(const CDiskBlockPos &pos, const char *prefix, bool fReadOnly)
 FILE *OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly) {
     return OpenDiskFile(pos, "blk", fReadOnly);
 }
+
+int32_t GetPruneHeight(int32_t tipHeight, uint32_t pruneDepth, int32_t finHeight) {
+    if (finHeight < 0)
+        return -1;
+
+    return std::min<int32_t>(tipHeight - (int32_t)pruneDepth, finHeight - 1);
+}
+
+void SelectBlockFilesToPrune(const vector<CBlockFileInfo> &infos, int32_t pruneHeight, int32_t &firstFile,
+                             set<int32_t> &prunedFiles) {
+    int32_t nFile    = firstFile;
+    bool fContinuous = true;
+    for (const auto &info : infos) {
+        if (info.nSize > 0 && (int32_t)info.nHeightLast > pruneHeight) {
+            fContinuous = false;
+        } else {
+            if (fContinuous)
+                firstFile = nFile + 1;
+            if (info.nSize > 0)
+                prunedFiles.insert(nFile);
+        }
+        nFile++;
+    }
+}
+
+void RemoveBlockFiles(int32_t nFile) {
+    for (const char *prefix : {"blk", "rev"}) {
+        boost::filesystem::path path = GetDataDir() / "blocks" / strprintf("%s%05u.dat", prefix, nFile);
+        boost::system::error_code ec;
+        boost::filesystem::remove(path, ec);
+        if (ec)
+            LogPrint(BCLog::ERROR, "Unable to remove file %s: %s\n", path.string(), ec.message());
+        else
+            LogPrint(BCLog::INFO, "Pruned file %s\n", path.string());
+    }
+}
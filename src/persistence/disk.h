@@ -9,6 +9,9 @@
 #include "commons/util/util.h"
 #include "commons/serialize.h"
 
+#include <set>
+#include <vector>
+
 struct CDiskBlockPos {
     int32_t nFile;
     uint32_t nPos;
@@ -124,4 +127,21 @@ FILE *OpenDiskFile(const CDiskBlockPos &pos, const char *prefix, bool fReadOnly)
 /** Open a block file (blk?????.dat) */
 FILE *OpenBlockFile(const CDiskBlockPos &pos, bool fReadOnly = false);
 
+/** Delete the block file and the undo file (rev?????.dat) of nFile */
+void RemoveBlockFiles(int32_t nFile);
+
+/**
+ * The height up to which the block files may be pruned: pruneDepth blocks below the tip, and
+ * below the global finality block, -1 if there is no finality block yet.
+ */
+int32_t GetPruneHeight(int32_t tipHeight, uint32_t pruneDepth, int32_t finHeight);
+
+/**
+ * Select the non empty files of which all the blocks are at or below pruneHeight, among the files
+ * [firstFile, firstFile + infos.size()). firstFile moves past the leading files which are all
+ * pruned, so the next call starts from the first file holding a block above pruneHeight.
+ */
+void SelectBlockFilesToPrune(const vector<CBlockFileInfo> &infos, int32_t pruneHeight, int32_t &firstFile,
+                             set<int32_t> &prunedFiles);
+
 #endif //PERSIST_DISK_H
\ No newline at end of file
@@ -5,6 +5,7 @@
 
 #include "leveldbwrapper.h"
 
+#include "commons/metrics.h"
 #include "commons/util/util.h"
 
 #include <leveldb/cache.h>
@@ -27,6 +28,8 @@ void ThrowError(const leveldb::Status &status) {
     throw leveldb_error("Unknown database error");
 }
 
+bool fRecordStateDeltas = false;
+
 std::string CDBOpLogMap::ToString() const {
     std::string str = "";
     for (auto itemOpLogs : mapDbOpLogs) {
@@ -86,6 +89,8 @@ CLevelDBWrapper::~CLevelDBWrapper() {
 }
 
 bool CLevelDBWrapper::WriteBatch(CLevelDBBatch &batch, bool fSync) {
+    CMetricTimer timer(metrics::leveldb_write);
+    metrics::leveldb_write_bytes.Inc(batch.GetSize());
     leveldb::Status status = pdb->Write(fSync ? syncoptions : writeoptions, &batch.batch);
     ThrowError(status);
     return true;
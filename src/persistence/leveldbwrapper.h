@@ -7,6 +7,7 @@
 #define PERSIST_LEVELDBWRAPPER_H
 
 #include "commons/json/json_spirit_value.h"
+#include "commons/metrics.h"
 #include "commons/serialize.h"
 #include "commons/util/util.h"
 #include "config/version.h"
@@ -84,6 +85,13 @@ public:
 
 typedef vector<CDbOpLog> CDbOpLogs;
 
+// db key -> the serialized value written last, empty if the key was erased
+typedef map<string, string> CDbStateDeltas;
+typedef map<dbk::PrefixType, CDbStateDeltas> CDbStateDeltaMap;
+
+// the op logs record the state deltas only for the state commitment and the account events, set on the start
+extern bool fRecordStateDeltas;
+
 class CDBOpLogMap {
 public:
     map<string, CDbOpLogs>& GetMap() { return mapDbOpLogs; }
@@ -104,7 +112,17 @@ public:
         mapDbOpLogs[prefix].push_back(dbOpLogIn);
     }
 
-    void Clear() { mapDbOpLogs.clear(); }
+    // the state commitment follows the new values, which the undo needs not
+    void AddStateDelta(dbk::PrefixType prefixType, const string &dbKey, const string &value) {
+        stateDeltas[prefixType][dbKey] = value;
+    }
+
+    const CDbStateDeltaMap& GetStateDeltas() const { return stateDeltas; }
+
+    void Clear() {
+        mapDbOpLogs.clear();
+        stateDeltas.clear();
+    }
 
     std::string ToString() const;
 public:
@@ -113,6 +131,7 @@ public:
 	)
 private:
     mutable map<string, CDbOpLogs> mapDbOpLogs; // dbName -> dbOpLogs
+    CDbStateDeltaMap stateDeltas;               // not serialized, memory only
 };
 
 class leveldb_error : public runtime_error
@@ -129,6 +148,7 @@ class CLevelDBBatch {
 
 private:
     leveldb::WriteBatch batch;
+    size_t size = 0;    //!< bytes of the keys and values put in the batch
 
 public:
     template<typename V>
@@ -139,12 +159,22 @@ public:
         ssValue << value;
         leveldb::Slice slValue(&ssValue[0], ssValue.size());
         batch.Put(slKey, slValue);
+        size += slKey.size() + slValue.size();
     }
 
     void Erase(const std::string &key) {
         batch.Delete(key);
+        size += key.size();
     }
 
+    //! the value is serialized already
+    void WriteRaw(const std::string &key, const std::string &value) {
+        batch.Put(key, value);
+        size += key.size() + value.size();
+    }
+
+    size_t GetSize() const { return size; }
+
  };
 
 class CLevelDBWrapper {
@@ -180,6 +210,8 @@ public:
 
         string strValue;
         leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+        metrics::leveldb_reads.Inc();
+        metrics::leveldb_read_bytes.Inc(strValue.size());
         if (!status.ok()) {
             if (status.IsNotFound())
                 return false;
@@ -206,6 +238,8 @@ public:
     	leveldb::Slice slKey(key);
         string strValue;
         leveldb::Status status = pdb->Get(readoptions, slKey, &strValue);
+        metrics::leveldb_reads.Inc();
+        metrics::leveldb_read_bytes.Inc(strValue.size());
         if (!status.ok()) {
             if (status.IsNotFound())
                 return false;
@@ -237,6 +271,16 @@ public:
     leveldb::Iterator *NewIterator() {
         return pdb->NewIterator(iteroptions);
     }
+
+    //! iterate over the db as it was when the snapshot was taken
+    leveldb::Iterator *NewIterator(const leveldb::Snapshot *pSnapshot) {
+        leveldb::ReadOptions options = iteroptions;
+        options.snapshot             = pSnapshot;
+        return pdb->NewIterator(options);
+    }
+
+    const leveldb::Snapshot *GetSnapshot() { return pdb->GetSnapshot(); }
+    void ReleaseSnapshot(const leveldb::Snapshot *pSnapshot) { pdb->ReleaseSnapshot(pSnapshot); }
     int64_t GetDbCount();
    // Object ToJsonObj();
 };
@@ -4,6 +4,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "logdb.h"
+#include "dbiterator.h"
 #include "config/chainparams.h"
 
 bool CLogDBCache::SetExecuteFail(const int32_t blockHeight, const uint256 txid, const uint8_t errorCode,
@@ -18,16 +19,20 @@ bool CLogDBCache::GetExecuteFail(const int32_t blockHeight, vector<std::tuple<ui
     if (!SysCfg().IsLogFailures())
         return true;
 
-    map<string, std::pair<uint8_t, string> > elements;
-    if (!executeFailCache.GetAllElements(std::to_string(blockHeight) + "_", elements)) {
-        return false;
-    }
+    // the keys of a height have the same size, so they are adjacent in the db as well as in the cache
+    // layers, and all of them follow the key of the zero txid
+    const string prefix   = std::to_string(blockHeight) + "_";
+    const string firstKey = prefix + uint256().GetHex();
+
+    CDBIterator<decltype(executeFailCache)> dbIt(executeFailCache);
+    for (dbIt.SeekUpper(&firstKey); dbIt.IsValid(); dbIt.Next()) {
+        const string &key = dbIt.GetKey();
+        if (key.compare(0, prefix.size(), prefix) != 0)
+            break;
 
-    size_t prefixLen = string(std::to_string(blockHeight) + "_").size();
-    for (const auto &item : elements) {
-        result.push_back(std::make_tuple(uint256S(item.first.substr(prefixLen)) /* txid */,
-                                         std::get<0>(item.second) /* error code */,
-                                         std::get<1>(item.second) /* error message */));
+        result.push_back(std::make_tuple(uint256S(key.substr(prefix.size())) /* txid */,
+                                         std::get<0>(dbIt.GetValue()) /* error code */,
+                                         std::get<1>(dbIt.GetValue()) /* error message */));
     }
 
     return true;
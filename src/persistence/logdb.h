@@ -41,6 +41,10 @@ public:
     void RegisterUndoFunc(UndoDataFuncMap &undoDataFuncMap) {
         executeFailCache.RegisterUndoFunc(undoDataFuncMap);
     }
+
+    void RegisterDbValueFunc(DbValueFuncMap &dbValueFuncMap) {
+        executeFailCache.RegisterDbValueFunc(dbValueFuncMap);
+    }
 public:
 /*  CCompositeKVCache    prefixType             key                 value                        variable      */
 /*  -------------------- --------------------- ------------------  ---------------------------  -------------- */
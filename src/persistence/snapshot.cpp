@@ -0,0 +1,65 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "snapshot.h"
+
+#include "commons/util/util.h"
+
+const std::vector<DBNameType> kSnapshotDbNames = {
+    DBNameType::SYSPARAM, DBNameType::ACCOUNT, DBNameType::ASSET,     DBNameType::BLOCK,
+    DBNameType::CONTRACT, DBNameType::DELEGATE, DBNameType::CDP,      DBNameType::CLOSEDCDP,
+    DBNameType::DEX,      DBNameType::UTXO,     DBNameType::SYSGOVERN};
+
+bool IsSnapshotKey(DBNameType dbName, const leveldb::Slice &key) {
+    switch (dbName) {
+        case DBNameType::BLOCK:
+            // the tx index and the block files are local, the finality comes with the pbft messages again
+            return key == leveldb::Slice(dbk::GetKeyPrefix(dbk::MEDIAN_PRICES)) ||
+                   key == leveldb::Slice(dbk::GetKeyPrefix(dbk::BEST_BLOCKHASH));
+        case DBNameType::ACCOUNT:
+            // the stats are derived from the accounts with no undo log, they are summed again on the start
+            return key != leveldb::Slice(dbk::GetKeyPrefix(dbk::ACCOUNT_STATS));
+        case DBNameType::CONTRACT:
+            // the traces are rendered again from the blocks
+            return !key.starts_with(dbk::GetKeyPrefix(dbk::CONTRACT_TRACES));
+        default:
+            return true;
+    }
+}
+
+bool GetSnapshotBestBlockHash(const CSnapshotEntry &entry, uint256 &bestBlockHash) {
+    if (entry.db_name != DBNameType::BLOCK || entry.key != dbk::GetKeyPrefix(dbk::BEST_BLOCKHASH))
+        return false;
+
+    CDataStream ds(entry.value.data(), entry.value.data() + entry.value.size(), SER_DISK, CLIENT_VERSION);
+    ds >> bestBlockHash;
+    return true;
+}
+
+uint256 CSnapshotWriter::Finish() {
+    uint256 stateHash = stateHasher.GetHash();
+    *this << stateHash;
+    uint256 checksum = fileHasher.GetHash();
+    file << checksum;
+
+    FileCommit(file);
+    file.fclose();
+    return stateHash;
+}
+
+bool CSnapshotReader::Finish(uint256 &stateHash) {
+    *this >> stateHash;
+    uint256 checksum = fileHasher.GetHash();
+    uint256 fileChecksum;
+    file >> fileChecksum;
+    file.fclose();
+
+    if (checksum != fileChecksum)
+        return ERRORMSG("%s() : the checksum of the snapshot mismatches", __func__);
+
+    if (stateHash != stateHasher.GetHash())
+        return ERRORMSG("%s() : the state hash of the snapshot mismatches its entries", __func__);
+
+    return true;
+}
@@ -0,0 +1,157 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PERSIST_SNAPSHOT_H
+#define PERSIST_SNAPSHOT_H
+
+#include "commons/serialize.h"
+#include "commons/uint256.h"
+#include "crypto/hash.h"
+#include "dbconf.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * A state snapshot file is, in order:
+ *   CSnapshotHeader
+ *   the CSnapshotEntry of the state dbs in key order, ended by an entry of IsEnd()
+ *   the CDiskBlockIndex of the active chain from the genesis block on, with no data positions
+ *   block_count times the CBlock and CBlockUndo of the tip blocks
+ *   the state hash: the hash of the entries, the block hashes of the chain and the undo of the tip
+ *     blocks, which any node at the same block reproduces
+ *   the checksum: the hash of all the above
+ * The data of the tip blocks is bound by their hashes, so the state hash covers all the file but the
+ * local fields of the block index.
+ */
+static const uint32_t SNAPSHOT_VERSION = 2;
+
+/** The dbs of the chain state in the order of a snapshot */
+extern const std::vector<DBNameType> kSnapshotDbNames;
+
+/** Whether the entry of the db is chain state, the indexes and the local data are left out */
+bool IsSnapshotKey(DBNameType dbName, const leveldb::Slice &key);
+
+class CSnapshotEntry;
+
+/** Whether the entry is the best block hash of the state, which is read into bestBlockHash */
+bool GetSnapshotBestBlockHash(const CSnapshotEntry &entry, uint256 &bestBlockHash);
+
+class CSnapshotHeader {
+public:
+    uint32_t version     = SNAPSHOT_VERSION;
+    int32_t network      = 0;
+    int32_t height       = 0;
+    uint256 block_hash;
+    uint32_t block_count = 0;  //!< the tip blocks carried with their data and undo
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(VARINT(version));
+        READWRITE(VARINT(network));
+        READWRITE(VARINT(height));
+        READWRITE(block_hash);
+        READWRITE(VARINT(block_count));)
+};
+
+/** A raw entry of a state db */
+class CSnapshotEntry {
+public:
+    uint8_t db_name = DBNameType::DB_NAME_COUNT;
+    std::string key;
+    std::string value;
+
+    CSnapshotEntry() {}
+    CSnapshotEntry(DBNameType dbNameIn, const std::string &keyIn, const std::string &valueIn)
+        : db_name(dbNameIn), key(keyIn), value(valueIn) {}
+
+    bool IsEnd() const { return db_name == DBNameType::DB_NAME_COUNT; }
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(db_name);
+        READWRITE(key);
+        READWRITE(value);)
+};
+
+/** Writes the objects of a snapshot and hashes them on the way */
+class CSnapshotWriter {
+public:
+    explicit CSnapshotWriter(FILE *fileIn)
+        : file(fileIn, SER_DISK, CLIENT_VERSION), stateHasher(SER_DISK, CLIENT_VERSION),
+          fileHasher(SER_DISK, CLIENT_VERSION) {}
+
+    bool operator!() { return !file; }
+
+    template <typename T>
+    CSnapshotWriter &operator<<(const T &obj) {
+        file << obj;
+        fileHasher << obj;
+        return *this;
+    }
+
+    void WriteEntry(const CSnapshotEntry &entry) {
+        *this << entry;
+        if (!entry.IsEnd())
+            stateHasher << entry;
+    }
+
+    //! write an object of the state, which goes to the state hash too
+    template <typename T>
+    void WriteState(const T &obj) {
+        *this << obj;
+        stateHasher << obj;
+    }
+
+    //! add the hash of an object written apart to the state hash
+    void AddStateHash(const uint256 &hash) { stateHasher << hash; }
+
+    //! write the hashes at the end of the file, the writer can't be used any more
+    uint256 Finish();
+
+private:
+    CAutoFile file;
+    CHashWriter stateHasher;
+    CHashWriter fileHasher;
+};
+
+/** Reads the objects of a snapshot and hashes them the same way as the writer */
+class CSnapshotReader {
+public:
+    explicit CSnapshotReader(FILE *fileIn)
+        : file(fileIn, SER_DISK, CLIENT_VERSION), stateHasher(SER_DISK, CLIENT_VERSION),
+          fileHasher(SER_DISK, CLIENT_VERSION) {}
+
+    bool operator!() { return !file; }
+
+    template <typename T>
+    CSnapshotReader &operator>>(T &obj) {
+        file >> obj;
+        fileHasher << obj;
+        return *this;
+    }
+
+    void ReadEntry(CSnapshotEntry &entry) {
+        *this >> entry;
+        if (!entry.IsEnd())
+            stateHasher << entry;
+    }
+
+    template <typename T>
+    void ReadState(T &obj) {
+        *this >> obj;
+        stateHasher << obj;
+    }
+
+    void AddStateHash(const uint256 &hash) { stateHasher << hash; }
+
+    //! read the hashes at the end of the file and check them, the reader can't be used any more
+    bool Finish(uint256 &stateHash);
+
+private:
+    CAutoFile file;
+    CHashWriter stateHasher;
+    CHashWriter fileHasher;
+};
+
+#endif  // PERSIST_SNAPSHOT_H
@@ -0,0 +1,118 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "statecommitdb.h"
+
+#include "crypto/hash.h"
+
+uint256 GetStateKeyHash(const string &dbKey) {
+    return Hash(dbKey.begin(), dbKey.end());
+}
+
+uint256 GetStateLeafHash(const string &dbKey, const string &value) {
+    CHashWriter hasher(SER_GETHASH, 0);
+    hasher << dbKey << value;
+    return hasher.GetHash();
+}
+
+uint32_t GetStateBucketIndex(const uint256 &keyHash) {
+    return ((uint32_t)keyHash.begin()[0] << 8 | keyHash.begin()[1]) >> (16 - STATE_BUCKET_BITS);
+}
+
+string GetStateBucketId(uint32_t index) {
+    return string{(char)(index >> 8), (char)(index & 0xff)};
+}
+
+uint256 CStateBucket::GetHash() const {
+    if (leaves.empty())
+        return uint256();
+
+    CHashWriter hasher(SER_GETHASH, 0);
+    hasher << leaves;
+    return hasher.GetHash();
+}
+
+static uint256 HashStateNodes(const uint256 &left, const uint256 &right) {
+    if (left.IsNull() && right.IsNull())
+        return uint256();
+
+    return Hash(left.begin(), left.end(), right.begin(), right.end());
+}
+
+void CStateBucketTree::SetBucketHash(uint32_t index, const uint256 &hash) {
+    uint32_t pos = STATE_BUCKET_COUNT + index;
+    nodes[pos]   = hash;
+    for (pos >>= 1; pos > 0; pos >>= 1)
+        nodes[pos] = HashStateNodes(nodes[2 * pos], nodes[2 * pos + 1]);
+}
+
+void CStateBucketTree::SetBucketHashes(const map<uint32_t, uint256> &bucketHashes) {
+    std::fill(nodes.begin(), nodes.end(), uint256());
+    for (const auto &item : bucketHashes)
+        nodes[STATE_BUCKET_COUNT + item.first] = item.second;
+
+    for (uint32_t pos = STATE_BUCKET_COUNT - 1; pos > 0; pos--)
+        nodes[pos] = HashStateNodes(nodes[2 * pos], nodes[2 * pos + 1]);
+}
+
+vector<uint256> CStateBucketTree::GetBranch(uint32_t index) const {
+    vector<uint256> branch;
+    for (uint32_t pos = STATE_BUCKET_COUNT + index; pos > 1; pos >>= 1)
+        branch.push_back(nodes[pos ^ 1]);
+
+    return branch;
+}
+
+uint256 CStateBucketTree::ComputeRoot(uint32_t index, const uint256 &bucketHash, const vector<uint256> &branch) {
+    uint256 hash = bucketHash;
+    uint32_t pos = STATE_BUCKET_COUNT + index;
+    for (const auto &sibling : branch) {
+        hash = (pos & 1) ? HashStateNodes(sibling, hash) : HashStateNodes(hash, sibling);
+        pos >>= 1;
+    }
+    return hash;
+}
+
+bool CStateProof::Verify(const uint256 &root) const {
+    if (branch.size() != STATE_BUCKET_BITS)
+        return false;
+
+    uint256 keyHash = GetStateKeyHash(key);
+    auto it         = bucket.leaves.find(keyHash);
+    if (value.empty()) {
+        if (it != bucket.leaves.end())
+            return false;
+    } else if (it == bucket.leaves.end() || it->second != GetStateLeafHash(key, value)) {
+        return false;
+    }
+
+    return CStateBucketTree::ComputeRoot(GetStateBucketIndex(keyHash), bucket.GetHash(), branch) == root;
+}
+
+bool CStateCommitDBCache::GetBucket(const string &bucketId, CStateBucket &bucket) const {
+    return bucketCache.GetData(bucketId, bucket);
+}
+
+bool CStateCommitDBCache::SetBucket(const string &bucketId, const CStateBucket &bucket) {
+    if (bucket.IsEmpty())
+        return bucketCache.EraseData(bucketId) && bucketHashCache.EraseData(bucketId);
+
+    return bucketCache.SetData(bucketId, bucket) && bucketHashCache.SetData(bucketId, bucket.GetHash());
+}
+
+void CStateCommitDBCache::Clear() {
+    bucketCache.Clear();
+    bucketHashCache.Clear();
+    rootCache.Clear();
+    undoCache.Clear();
+    tipCache.Clear();
+}
+
+void CStateCommitDBCache::Flush() {
+    bucketCache.Flush();
+    bucketHashCache.Flush();
+    rootCache.Flush();
+    undoCache.Flush();
+    tipCache.Flush();
+}
@@ -0,0 +1,149 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef PERSIST_STATECOMMITDB_H
+#define PERSIST_STATECOMMITDB_H
+
+#include "commons/serialize.h"
+#include "commons/uint256.h"
+#include "dbaccess.h"
+#include "dbconf.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * The state commitment hashes each state entry into a leaf, Hash(key, value), which goes to the
+ * bucket of the first STATE_BUCKET_BITS bits of Hash(key). The bucket hashes are the leaves of a
+ * merkle tree, whose root commits to the whole state. A write touches one bucket and one path.
+ */
+static const uint32_t STATE_BUCKET_BITS  = 16;
+static const uint32_t STATE_BUCKET_COUNT = 1 << STATE_BUCKET_BITS;
+
+uint256 GetStateKeyHash(const string &dbKey);
+uint256 GetStateLeafHash(const string &dbKey, const string &value);
+uint32_t GetStateBucketIndex(const uint256 &keyHash);
+// the db key of the bucket, big endian to keep the buckets in order
+string GetStateBucketId(uint32_t index);
+
+/** The leaves of the state entries whose key hashes fall in a bucket */
+class CStateBucket {
+public:
+    map<uint256, uint256> leaves;  //!< key hash -> leaf hash
+
+    // null for the empty bucket
+    uint256 GetHash() const;
+
+    bool IsEmpty() const { return leaves.empty(); }
+    void SetEmpty() { leaves.clear(); }
+    string ToString() const { return strprintf("leaves=%u", leaves.size()); }
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(leaves);)
+};
+
+/** The merkle tree of the bucket hashes, a subtree of empty buckets hashes to null */
+class CStateBucketTree {
+public:
+    CStateBucketTree() : nodes(2 * STATE_BUCKET_COUNT) {}
+
+    const uint256 &GetRoot() const { return nodes[1]; }
+    const uint256 &GetBucketHash(uint32_t index) const { return nodes[STATE_BUCKET_COUNT + index]; }
+
+    // set the hash of a bucket and update its path to the root
+    void SetBucketHash(uint32_t index, const uint256 &hash);
+    // set the hashes of all the buckets, the missing ones are empty
+    void SetBucketHashes(const map<uint32_t, uint256> &bucketHashes);
+
+    // the sibling hashes from the bucket up to the root
+    vector<uint256> GetBranch(uint32_t index) const;
+    static uint256 ComputeRoot(uint32_t index, const uint256 &bucketHash, const vector<uint256> &branch);
+
+private:
+    vector<uint256> nodes;  //!< nodes[1] is the root, the children of nodes[i] are nodes[2i] and nodes[2i + 1]
+};
+
+/** The proof of the value of a key, or of its absence, against a state root */
+class CStateProof {
+public:
+    string key;              //!< the db key
+    string value;            //!< the serialized value, empty if the key has no entry
+    CStateBucket bucket;     //!< all the leaves of the bucket of the key
+    vector<uint256> branch;  //!< the sibling hashes from the bucket up to the root
+
+    bool Verify(const uint256 &root) const;
+};
+
+/** The leaves a block replaced, to take the commitment back when the block is disconnected */
+class CStateCommitUndo {
+public:
+    uint256 block_hash;
+    vector<pair<uint256, uint256>> leaves;  //!< key hash -> the previous leaf hash, null if none
+
+    bool IsEmpty() const { return block_hash.IsNull(); }
+    void SetEmpty() {
+        block_hash.SetNull();
+        leaves.clear();
+    }
+    string ToString() const { return strprintf("block_hash=%s, leaves=%u", block_hash.GetHex(), leaves.size()); }
+
+    IMPLEMENT_SERIALIZE(
+        READWRITE(block_hash);
+        READWRITE(leaves);)
+};
+
+class CStateCommitDBCache {
+public:
+    CStateCommitDBCache() {}
+    CStateCommitDBCache(CDBAccess *pDbAccess)
+        : bucketCache(pDbAccess), bucketHashCache(pDbAccess), rootCache(pDbAccess), undoCache(pDbAccess),
+          tipCache(pDbAccess) {}
+
+public:
+    bool GetBucket(const string &bucketId, CStateBucket &bucket) const;
+    bool SetBucket(const string &bucketId, const CStateBucket &bucket);
+
+    bool GetRoot(const uint256 &blockHash, uint256 &root) const { return rootCache.GetData(blockHash, root); }
+    bool SetRoot(const uint256 &blockHash, const uint256 &root) { return rootCache.SetData(blockHash, root); }
+
+    bool GetUndo(int32_t height, CStateCommitUndo &undo) const { return undoCache.GetData(height, undo); }
+    bool SetUndo(int32_t height, const CStateCommitUndo &undo) { return undoCache.SetData(height, undo); }
+    bool EraseUndo(int32_t height) { return undoCache.EraseData(height); }
+
+    bool GetTip(uint256 &blockHash) const { return tipCache.GetData(blockHash); }
+    bool SetTip(const uint256 &blockHash) { return tipCache.SetData(blockHash); }
+
+    // bucketid -> hash of the non-empty buckets
+    bool GetBucketHashes(map<string, uint256> &bucketHashes) { return bucketHashCache.GetAllElements(bucketHashes); }
+
+    void Clear();
+    void Flush();
+
+    uint32_t GetCacheSize() const {
+        return bucketCache.GetCacheSize() + bucketHashCache.GetCacheSize() + rootCache.GetCacheSize() +
+               undoCache.GetCacheSize();
+    }
+
+public:
+/*  CCompositeKVCache     prefixType                  key                 value                 variable      */
+/*  -------------------- --------------------------- ------------------  -------------------  -------------- */
+    // [prefix]{bucketid} --> the leaves of the bucket
+    CCompositeKVCache< dbk::STATE_BUCKET,             string,             CStateBucket >        bucketCache;
+    // [prefix]{bucketid} --> bucket hash
+    CCompositeKVCache< dbk::STATE_BUCKET_HASH,        string,             uint256 >             bucketHashCache;
+    // [prefix]{blockhash} --> state root after the block
+    CCompositeKVCache< dbk::STATE_ROOT,               uint256,            uint256 >             rootCache;
+    // [prefix]{height} --> the leaves replaced by the block
+    CCompositeKVCache< dbk::STATE_UNDO,               int32_t,            CStateCommitUndo >    undoCache;
+
+/*  CSimpleKVCache        prefixType                  value               variable           */
+/*  -------------------- --------------------------- ------------------  ------------------ */
+    // [prefix] --> hash of the block of the committed state
+    CSimpleKVCache< dbk::STATE_TIP,                   uint256>            tipCache;
+};
+
+#endif // PERSIST_STATECOMMITDB_H
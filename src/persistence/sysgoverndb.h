@@ -125,6 +125,12 @@ public:
         proposalsCache.RegisterUndoFunc(undoDataFuncMap);
         secondsCache.RegisterUndoFunc(undoDataFuncMap);
     }
+
+    void RegisterDbValueFunc(DbValueFuncMap &dbValueFuncMap) {
+        governersCache.RegisterDbValueFunc(dbValueFuncMap);
+        proposalsCache.RegisterDbValueFunc(dbValueFuncMap);
+        secondsCache.RegisterDbValueFunc(dbValueFuncMap);
+    }
 private:
 /*  CSimpleKVCache          prefixType             value           variable           */
 /*  -------------------- --------------------   -------------   --------------------- */
@@ -0,0 +1,78 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "sysparamdb.h"
+#include "commons/metrics.h"
+
+bool CSysParamSnapshot::GetCdpParam(const CCdpCoinPair &coinPair, const CdpParamType &paramType,
+                                    uint64_t &paramValue) const {
+    if (!cdpParamDefined[paramType])
+        return false;
+
+    auto it = cdpParams.find(std::make_pair(coinPair, (uint8_t)paramType));
+    paramValue = it != cdpParams.end() ? it->second : cdpParamDefaults[paramType];
+    return true;
+}
+
+bool CSysParamSnapshot::GetMinerFee(const uint8_t txType, const string &feeSymbol, uint64_t &feeSawiAmount) const {
+    auto it = minerFees.find(std::make_pair(txType, feeSymbol));
+    if (it == minerFees.end())
+        return false;
+
+    feeSawiAmount = it->second;
+    return true;
+}
+
+uint8_t CSysParamSnapshot::GetBpCount(uint32_t height) const {
+    if (hasNewBpCount && height >= newBpCountHeight)
+        return newBpCount;
+
+    if (hasCurrentBpCount)
+        return currentBpCount;
+
+    return 11;
+}
+
+shared_ptr<const CSysParamSnapshot> CSysParamDBCache::BuildSnapshot() {
+    metrics::sysparam_snapshot_builds.Inc();
+    auto spNewSnapshot = make_shared<CSysParamSnapshot>();
+
+    for (const auto &item : SysParamTable) {
+        spNewSnapshot->paramDefined[item.first] = true;
+        spNewSnapshot->params[item.first]       = std::get<1>(item.second);
+    }
+    for (const auto &item : CdpParamTable) {
+        spNewSnapshot->cdpParamDefined[item.first]  = true;
+        spNewSnapshot->cdpParamDefaults[item.first] = std::get<1>(item.second);
+    }
+
+    map<uint8_t, CVarIntValue<uint64_t>> sysParams;
+    map<pair<uint8_t, string>, CVarIntValue<uint64_t>> minerFees;
+    map<pair<CCdpCoinPair, uint8_t>, CVarIntValue<uint64_t>> cdpParams;
+    if (!sysParamCache.GetAllElements(sysParams) || !minerFeeCache.GetAllElements(minerFees) ||
+        !cdpParamCache.GetAllElements(cdpParams)) {
+        LogPrint(BCLog::ERROR, "%s() : failed to read the sys params\n", __func__);
+        return nullptr;
+    }
+
+    // only the params of the table are read, as before
+    for (const auto &item : sysParams) {
+        if (spNewSnapshot->paramDefined[item.first])
+            spNewSnapshot->params[item.first] = item.second.get();
+    }
+    for (const auto &item : minerFees)
+        spNewSnapshot->minerFees.emplace(item.first, item.second.get());
+    for (const auto &item : cdpParams)
+        spNewSnapshot->cdpParams.emplace(item.first, item.second.get());
+
+    spNewSnapshot->hasCurrentBpCount = currentBpCountCache.GetData(spNewSnapshot->currentBpCount);
+    pair<CVarIntValue<uint32_t>, uint8_t> newBpCount;
+    if (newBpCountCache.GetData(newBpCount)) {
+        spNewSnapshot->hasNewBpCount    = true;
+        spNewSnapshot->newBpCountHeight = newBpCount.first.get();
+        spNewSnapshot->newBpCount       = newBpCount.second;
+    }
+
+    return spNewSnapshot;
+}
@@ -3,6 +3,9 @@
 // Distributed under the MIT/X11 software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#ifndef PERSIST_SYSPARAMDB_H
+#define PERSIST_SYSPARAMDB_H
+
 #include "commons/serialize.h"
 #include "persistence/dbaccess.h"
 #include "persistence/dbconf.h"
@@ -11,7 +14,10 @@
 #include <unordered_map>
 #include <string>
 #include <cstdint>
+#include <memory>
+#include "config/scoin.h"
 #include "config/sysparams.h"
+#include "config/txbase.h"
 
 using namespace std;
 
@@ -40,6 +46,41 @@ struct CCdpInterestParamChange {
     uint64_t param_b = 0;
 };
 
+/**
+ * The governed params of a state resolved at once: the sys params and the cdp param defaults
+ * indexed by their type, the miner fees, the cdp params and the bp counts. It's immutable, a
+ * write to the params drops it and the next read builds a new one.
+ */
+class CSysParamSnapshot {
+public:
+    bool GetParam(const SysParamType &paramType, uint64_t &paramValue) const {
+        if (!paramDefined[paramType])
+            return false;
+
+        paramValue = params[paramType];
+        return true;
+    }
+
+    bool GetCdpParam(const CCdpCoinPair &coinPair, const CdpParamType &paramType, uint64_t &paramValue) const;
+    bool GetMinerFee(const uint8_t txType, const string &feeSymbol, uint64_t &feeSawiAmount) const;
+    uint8_t GetBpCount(uint32_t height) const;
+
+private:
+    friend class CSysParamDBCache;
+
+    uint64_t params[256]                 = {0};
+    bool paramDefined[256]               = {false};
+    uint64_t cdpParamDefaults[256]       = {0};
+    bool cdpParamDefined[256]            = {false};
+    map<pair<uint8_t, string>, uint64_t> minerFees;
+    map<pair<CCdpCoinPair, uint8_t>, uint64_t> cdpParams;
+    bool hasCurrentBpCount               = false;
+    uint8_t currentBpCount               = 0;
+    bool hasNewBpCount                   = false;
+    uint32_t newBpCountHeight            = 0;
+    uint8_t newBpCount                   = 0;
+};
+
 class CSysParamDBCache {
 public:
     CSysParamDBCache() {}
@@ -55,49 +96,36 @@ public:
                                                   cdpParamCache(pBaseIn->cdpParamCache),
                                                   cdpInterestParamChangesCache(pBaseIn->cdpInterestParamChangesCache),
                                                   currentBpCountCache(pBaseIn->currentBpCountCache),
-                                                  newBpCountCache(pBaseIn->newBpCountCache){}
+                                                  newBpCountCache(pBaseIn->newBpCountCache),
+                                                  pBase(pBaseIn){}
 
     bool GetParam(const SysParamType &paramType, uint64_t& paramValue) {
-        if (SysParamTable.count(paramType) == 0)
-            return false;
-
-        auto iter = SysParamTable.find(paramType);
-        string keyPostfix = std::get<0>(iter->second);
-        CVarIntValue<uint64_t > value ;
-        if (!sysParamCache.GetData(paramType, value)) {
-            paramValue = std::get<1>(iter->second);
-        } else{
-            paramValue = value.get();
-        }
-
-        return true;
+        auto spSnapshot = GetSnapshot();
+        return spSnapshot != nullptr && spSnapshot->GetParam(paramType, paramValue);
     }
 
     bool GetCdpParam(const CCdpCoinPair& coinPair, const CdpParamType &paramType, uint64_t& paramValue) {
-        if (CdpParamTable.count(paramType) == 0)
-            return false;
-
-        auto iter = CdpParamTable.find(paramType);
-        auto key = std::make_pair(coinPair, paramType);
-        CVarIntValue<uint64_t > value ;
-        if (!cdpParamCache.GetData(key, value)) {
-            paramValue = std::get<1>(iter->second);
-        } else{
-            paramValue = value.get();
-        }
-
-        return true;
+        auto spSnapshot = GetSnapshot();
+        return spSnapshot != nullptr && spSnapshot->GetCdpParam(coinPair, paramType, paramValue);
     }
 
     bool Flush() {
         sysParamCache.Flush();
         minerFeeCache.Flush();
+
+        // the writes are the base's now, this cache reads through the base's snapshot again
+        if (fModified && pBase != nullptr) {
+            pBase->SetModified();
+            fModified = false;
+            spSnapshot.reset();
+        }
         return true;
     }
 
     uint32_t GetCacheSize() const { return sysParamCache.GetCacheSize() + minerFeeCache.GetCacheSize(); }
 
     void SetBaseViewPtr(CSysParamDBCache *pBaseIn) {
+        pBase = pBaseIn;
         sysParamCache.SetBase(&pBaseIn->sysParamCache);
         minerFeeCache.SetBase(&pBaseIn->minerFeeCache);
         cdpParamCache.SetBase(&pBaseIn->cdpParamCache);
@@ -123,23 +151,45 @@ public:
         cdpInterestParamChangesCache.RegisterUndoFunc(undoDataFuncMap);
         currentBpCountCache.RegisterUndoFunc(undoDataFuncMap);
         newBpCountCache.RegisterUndoFunc(undoDataFuncMap);
+
+        // the undo writes the caches directly, the snapshot goes with it
+        for (auto prefixType : {dbk::SYS_PARAM, dbk::MINER_FEE, dbk::CDP_PARAM, dbk::CDP_INTEREST_PARAMS,
+                                dbk::BP_COUNT, dbk::NEW_BP_COUNT}) {
+            auto undoDataFunc = undoDataFuncMap[prefixType];
+            undoDataFuncMap[prefixType] = [this, undoDataFunc](const CDbOpLogs &dbOpLogs) {
+                undoDataFunc(dbOpLogs);
+                SetModified();
+            };
+        }
+    }
+
+    void RegisterDbValueFunc(DbValueFuncMap &dbValueFuncMap) {
+        sysParamCache.RegisterDbValueFunc(dbValueFuncMap);
+        minerFeeCache.RegisterDbValueFunc(dbValueFuncMap);
+        cdpParamCache.RegisterDbValueFunc(dbValueFuncMap);
+        cdpInterestParamChangesCache.RegisterDbValueFunc(dbValueFuncMap);
+        currentBpCountCache.RegisterDbValueFunc(dbValueFuncMap);
+        newBpCountCache.RegisterDbValueFunc(dbValueFuncMap);
     }
     bool SetParam(const SysParamType& key, const uint64_t& value){
+        SetModified();
         return sysParamCache.SetData(key, CVarIntValue(value)) ;
     }
 
     bool SetCdpParam(const CCdpCoinPair& coinPair, const CdpParamType& paramkey, const uint64_t& value) {
+        SetModified();
         auto key = std::make_pair(coinPair,paramkey);
         return cdpParamCache.SetData(key, value);
     }
     bool SetMinerFee( const TxType txType, const string feeSymbol, const uint64_t feeSawiAmount) {
-
+        SetModified();
         auto pa = std::make_pair(txType, feeSymbol) ;
         return minerFeeCache.SetData(pa , CVarIntValue(feeSawiAmount)) ;
 
     }
 
     bool SetCdpInterestParam(CCdpCoinPair& coinPair, CdpParamType paramType, int32_t height , uint64_t value){
+        SetModified();
 
         CCdpInterestParamChangeMap changeMap;
         cdpInterestParamChangesCache.GetData(coinPair, changeMap);
@@ -205,46 +255,43 @@ public:
     }
 
     bool GetMinerFee( const uint8_t txType, const string feeSymbol, uint64_t& feeSawiAmount) {
+        auto spSnapshot = GetSnapshot();
+        return spSnapshot != nullptr && spSnapshot->GetMinerFee(txType, feeSymbol, feeSawiAmount);
+    }
 
-        auto pa = std::make_pair(txType, feeSymbol) ;
-        CVarIntValue<uint64_t > value ;
-        bool result =  minerFeeCache.GetData(pa , value) ;
+    // the params of the state of this cache, the base's snapshot while this cache has no writes of its own
+    shared_ptr<const CSysParamSnapshot> GetSnapshot() {
+        if (!fModified && pBase != nullptr)
+            return pBase->GetSnapshot();
 
-        if(result)
-            feeSawiAmount = value.get();
-        return result ;
+        if (spSnapshot == nullptr)
+            spSnapshot = BuildSnapshot();
+        return spSnapshot;
     }
 
 
 public:
     bool SetNewBpCount(uint8_t newBpCount, uint32_t launchHeight) {
+        SetModified();
         return newBpCountCache.SetData(std::make_pair(CVarIntValue(launchHeight), newBpCount)) ;
     }
     bool SetCurrentBpCount(uint8_t bpCount) {
-
+        SetModified();
         return currentBpCountCache.SetData(bpCount) ;
     }
     uint8_t GetBpCount(uint32_t height) {
-
-        pair<CVarIntValue<uint32_t>,uint8_t> value ;
-        if(newBpCountCache.GetData(value)){
-            auto launchHeight = std::get<0>(value);
-            if(height >= launchHeight.get()) {
-                return std::get<1>(value) ;
-            }
-        }
-
-        uint8_t bpCount ;
-        if(currentBpCountCache.GetData(bpCount)){
-            return bpCount;
-        }
-
-        return 11 ;
-
+        auto spSnapshot = GetSnapshot();
+        return spSnapshot != nullptr ? spSnapshot->GetBpCount(height) : 11;
     }
 
 private:
+    void SetModified() {
+        fModified = true;
+        spSnapshot.reset();
+    }
 
+    // nullptr if the params can't be read
+    shared_ptr<const CSysParamSnapshot> BuildSnapshot();
 
 /*       type               prefixType               key                     value                 variable               */
 /*  ----------------   -------------------------   -----------------------  ------------------   ------------------------ */
@@ -257,4 +304,11 @@ private:
     CCompositeKVCache< dbk::CDP_INTEREST_PARAMS, CCdpCoinPair, CCdpInterestParamChangeMap> cdpInterestParamChangesCache;
     CSimpleKVCache<dbk:: BP_COUNT, uint8_t>             currentBpCountCache ;
     CSimpleKVCache<dbk:: NEW_BP_COUNT, pair<CVarIntValue<uint32_t>,uint8_t>>  newBpCountCache ;
-};
\ No newline at end of file
+
+    CSysParamDBCache *pBase = nullptr;
+    // whether the params of this cache differ from the ones of the base
+    bool fModified = false;
+    shared_ptr<const CSysParamSnapshot> spSnapshot;
+};
+
+#endif  // PERSIST_SYSPARAMDB_H
@@ -38,6 +38,10 @@ public:
     void RegisterUndoFunc(UndoDataFuncMap &undoDataFuncMap) {
         txReceiptCache.RegisterUndoFunc(undoDataFuncMap);
     }
+
+    void RegisterDbValueFunc(DbValueFuncMap &dbValueFuncMap) {
+        txReceiptCache.RegisterDbValueFunc(dbValueFuncMap);
+    }
 public:
 /*       type               prefixType               key                     value                 variable               */
 /*  ----------------   -------------------------   -----------------------  ------------------   ------------------------ */
@@ -6,21 +6,49 @@
 #include "txutxodb.h"
 #include "config/chainparams.h"
 
-bool CTxUTXODBCache::SetUtxoTx(const pair<TxID, uint16_t> &utxoIndex) {
-    return txUtxoCache.SetData(utxoIndex, 1);
+bool CTxUTXODBCache::SetUtxoTx(const pair<TxID, uint16_t> &utxoIndex, const CUtxoEntry &utxoEntry) {
+    return txUtxoCache.SetData(utxoIndex, utxoEntry);
+}
+
+bool CTxUTXODBCache::GetUtxoTx(const pair<TxID, uint16_t> &utxoIndex, CUtxoEntry &utxoEntry) {
+    return txUtxoCache.GetData(utxoIndex, utxoEntry);
 }
 
 bool CTxUTXODBCache::GetUtxoTx(const pair<TxID, uint16_t> &utxoIndex) {
-    uint8_t data;
-    bool result = txUtxoCache.GetData(utxoIndex, data);
-    if (!result)
-        return false;
-    
-    return true;
+    return txUtxoCache.HaveData(utxoIndex);
 }
 
 bool CTxUTXODBCache::DelUtoxTx(const pair<TxID, uint16_t> &utxoIndex) {
     return txUtxoCache.EraseData(utxoIndex);
 }
 
+bool CTxUTXODBCache::MigrateLegacyUtxos(uint32_t &migratedCount) {
+    migratedCount = 0;
+
+    map<pair<TxID, uint16_t>, CUtxoEntry> elements;
+    if (!txUtxoCache.GetAllElements(elements))
+        return ERRORMSG("MigrateLegacyUtxos() : get all utxo entries failed");
+
+    for (const auto &item : elements) {
+        if (!item.second.IsLegacy())
+            continue;
+
+        CUtxoEntry utxoEntry;
+        if (!GetUtxoEntryFromChain(item.first, utxoEntry))
+            return ERRORMSG("MigrateLegacyUtxos() : load utxo %s-%d from chain failed",
+                            item.first.first.ToString(), item.first.second);
+
+        if (!txUtxoCache.SetData(item.first, utxoEntry))
+            return ERRORMSG("MigrateLegacyUtxos() : save utxo %s-%d failed",
+                            item.first.first.ToString(), item.first.second);
+
+        migratedCount++;
+    }
+
+    if (migratedCount > 0)
+        Flush();
+
+    return true;
+}
+
 void CTxUTXODBCache::Flush() { txUtxoCache.Flush(); }
@@ -24,7 +24,8 @@ public:
     CTxUTXODBCache(CTxUTXODBCache* pBaseIn): txUtxoCache(pBaseIn->txUtxoCache) {} ;
 
 public:
-    bool SetUtxoTx(const pair<TxID, uint16_t> &utoxIndex);
+    bool SetUtxoTx(const pair<TxID, uint16_t> &utoxIndex, const CUtxoEntry &utxoEntry);
+    bool GetUtxoTx(const pair<TxID, uint16_t> &utoxIndex, CUtxoEntry &utxoEntry);
     bool GetUtxoTx(const pair<TxID, uint16_t> &utoxIndex);
     bool DelUtoxTx(const pair<TxID, uint16_t> &utoxIndex);
 
@@ -39,12 +40,19 @@ public:
     void RegisterUndoFunc(UndoDataFuncMap &undoDataFuncMap) {
         txUtxoCache.RegisterUndoFunc(undoDataFuncMap);
     }
+
+    void RegisterDbValueFunc(DbValueFuncMap &dbValueFuncMap) {
+        txUtxoCache.RegisterDbValueFunc(dbValueFuncMap);
+    }
+
+    // rewrite the legacy entries with the utxo vout data loaded from chain, requires -txindex
+    bool MigrateLegacyUtxos(uint32_t &migratedCount);
 public:
 /*       type               prefixType               key                     value                 variable               */
 /*  ----------------   -------------------------   -----------------------  ------------------   ------------------------ */
     /////////// UTXO DB
-    // $txid$vout_index -> 1
-    CCompositeKVCache<   dbk::TX_UTXO,            pair<TxID, uint16_t>,      uint8_t >             txUtxoCache;
+    // $txid$vout_index -> utxo entry
+    CCompositeKVCache<   dbk::TX_UTXO,            pair<TxID, uint16_t>,      CUtxoEntry >          txUtxoCache;
 };
 
 #endif // PERSIST_TXUTXODB_H
\ No newline at end of file
@@ -128,6 +128,11 @@ public:
             (*i)();
         }
     }
+    /** Return the number of waiting items */
+    size_t Depth() {
+        STD_LOCK(cs);
+        return queue.size();
+    }
     /** Interrupt and exit loops */
     void Interrupt() {
         STD_LOCK(cs);
@@ -639,6 +644,10 @@ void RegisterHTTPHandler(const std::string& prefix, bool exactMatch,
     pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
 }
 
+size_t GetHTTPWorkQueueDepth() {
+    return workQueue ? workQueue->Depth() : 0;
+}
+
 void UnregisterHTTPHandler(const std::string& prefix, bool exactMatch) {
     std::vector<HTTPPathHandler>::iterator i    = pathHandlers.begin();
     std::vector<HTTPPathHandler>::iterator iend = pathHandlers.end();
@@ -46,6 +46,9 @@ void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPR
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
+/** Return the number of requests waiting for an HTTP worker */
+size_t GetHTTPWorkQueueDepth();
+
 /** Return evhttp event base. This can be used by submodules to
  * queue timers or custom events.
  */
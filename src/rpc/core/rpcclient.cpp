@@ -140,6 +140,7 @@ Array RPCConvertValues(const string &strMethod, const vector<string> &strParams)
     if (strMethod == "verifychain"            && n > 1) ConvertTo<int64_t>(params[1]);
     if (strMethod == "getrawmempool"          && n > 0) ConvertTo<bool>(params[0]);
     if (strMethod == "getnewaddr"             && n > 0) ConvertTo<bool>(params[0]);
+    if (strMethod == "gettotalcoins"          && n > 0) ConvertTo<bool>(params[0]);
 
 
     if (strMethod == "submitdelegatevotetx"         && n > 1) ConvertTo<Array>(params[1]);
@@ -158,14 +159,18 @@ Array RPCConvertValues(const string &strMethod, const vector<string> &strParams)
     if (strMethod == "disconnectblock"        && n > 0) ConvertTo<int32_t>(params[0]);
 
     if (strMethod == "listcontracts"          && n > 0) ConvertTo<bool>(params[0]);
+    if (strMethod == "listcontracts"          && n > 1) ConvertTo<int64_t>(params[1]);
     if (strMethod == "getblock"               && n > 0) { if (params[0].get_str().size() < 32) ConvertTo<int32_t>(params[0]); }
     if (strMethod == "getblockundo"           && n > 0) { if (params[0].get_str().size() < 32) ConvertTo<int32_t>(params[0]); }
+    if (strMethod == "getstateroot"           && n > 0) { if (params[0].get_str().size() < 32) ConvertTo<int32_t>(params[0]); }
 
     /********************************************************************************************************************/
     if (strMethod == "getcontractdata"        && n > 2) ConvertTo<bool>(params[2]);
 
     if (strMethod == "listtx"                 && n > 0) ConvertTo<int32_t>(params[0]);
     if (strMethod == "listtx"                 && n > 1) ConvertTo<int32_t>(params[1]);
+    if (strMethod == "listtx"                 && n > 2) ConvertTo<Object>(params[2]);
+    if (strMethod == "submitbatchsendtx"      && n > 1) ConvertTo<Array>(params[1]);
     if (strMethod == "listdelegates"          && n > 0) ConvertTo<int32_t>(params[0]);
 
     if (strMethod == "invalidateblock"        && n > 0) { if (params[0].get_str().size() < 32) ConvertTo<int32_t>(params[0]); }
@@ -261,6 +261,9 @@ Object GetTxDetailJSON(const uint256& txid) {
         if (SysCfg().IsTxIndex()) {
             CDiskTxPos postx;
             if (pCdMan->pBlockCache->ReadTxIndex(txid, postx)) {
+                if (IsBlockFilePruned(postx.nFile))
+                    throw JSONRPCError(RPC_MISC_ERROR, "Transaction not available (pruned data)");
+
                 CAutoFile file(OpenBlockFile(postx, true), SER_DISK, CLIENT_VERSION);
                 CBlockHeader header;
 
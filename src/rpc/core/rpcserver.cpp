@@ -8,6 +8,7 @@
 
 #include "logging.h"
 #include "commons/base58.h"
+#include "commons/metrics.h"
 #include "commons/util/util.h"
 #include "init.h"
 #include "main.h"
@@ -70,6 +71,7 @@ std::unique_ptr<T> MakeUnique(Args&&... args) {
 }
 
 static bool JsonRPCHandler(HTTPRequest* req, const std::string&);
+static bool MetricsHandler(HTTPRequest* req, const std::string&);
 
 void RPCTypeCheck(const Array& params, const list<Value_type>& typesExpected, bool fAllowNull) {
     unsigned int i = 0;
@@ -326,6 +328,10 @@ bool StartRPCServer() {
     }
 
     RegisterHTTPHandler("/", true, JsonRPCHandler);
+    if (SysCfg().GetBoolArg("-metrics", false))
+        RegisterHTTPHandler("/metrics", true, MetricsHandler);
+    GetMetricsRegistry().AddGauge("coind_http_work_queue_depth", "HTTP requests waiting for a worker",
+                                  []() -> int64_t { return GetHTTPWorkQueueDepth(); });
 
     struct event_base* eventBase = EventBase();
     assert(eventBase);
@@ -344,6 +350,7 @@ void InterruptRPCServer() {
 void StopRPCServer() {
     LogPrint(BCLog::INFO, "Stopping HTTP RPC server\n");
     UnregisterHTTPHandler("/", true);
+    UnregisterHTTPHandler("/metrics", true);
 
     if (httpRPCTimerInterface) {
         RPCUnsetTimerInterface(httpRPCTimerInterface.get());
@@ -466,6 +473,7 @@ json_spirit::Value CRPCTable::execute(const string& strMethod,
         }
     }
 
+    CMetricTimer timer(metrics::rpc_call);
     try {
         // Execute
         Value result;
@@ -482,7 +490,11 @@ json_spirit::Value CRPCTable::execute(const string& strMethod,
         }
 
         return result;
+    } catch (Object& objError) {
+        metrics::rpc_errors.Inc();
+        throw;
     } catch (std::exception& e) {
+        metrics::rpc_errors.Inc();
         throw JSONRPCError(RPC_MISC_ERROR, e.what());
     }
 }
@@ -568,6 +580,18 @@ static bool JsonRPCHandler(HTTPRequest* req, const std::string&) {
     return true;
 }
 
+/** metrics handler registered to http server with -metrics, in the Prometheus text format */
+static bool MetricsHandler(HTTPRequest* req, const std::string&) {
+    if (req->GetRequestMethod() != HTTPRequest::GET) {
+        req->WriteReply(HTTP_BAD_METHOD, "Metrics are served only to GET requests");
+        return false;
+    }
+
+    req->WriteHeader("Content-Type", "text/plain; version=0.0.4");
+    req->WriteReply(HTTP_OK, GetMetricsRegistry().ToText());
+    return true;
+}
+
 void RPCSetTimerInterface(RPCTimerInterface* iface) {
     timerInterface = iface;
 }
@@ -161,6 +161,7 @@ extern Value getnetworkinfo(const json_spirit::Array& params, bool fHelp);
 extern Value signmessage(const json_spirit::Array& params, bool fHelp);
 extern Value getcontractassets(const json_spirit:: Array& params, bool fHelp);
 extern Value submitsendtx(const json_spirit::Array& params, bool fHelp);
+extern Value submitbatchsendtx(const json_spirit::Array& params, bool fHelp);
 extern Value submitcreateutxotx(const json_spirit::Array& params, bool fHelp);
 extern Value submitutxospendtx(const Array& params, bool fHelp) ;
 extern Value genmulsigtx(const json_spirit::Array& params, bool fHelp);
@@ -184,6 +185,10 @@ extern Value startcommontpstest(const json_spirit::Array& params, bool fHelp);
 extern Value startcontracttpstest(const json_spirit::Array& params, bool fHelp);
 extern Value getblockfailures(const json_spirit::Array& params, bool fHelp);
 extern Value getblockundo(const json_spirit::Array& params, bool fHelp);
+extern Value getblockfilter(const json_spirit::Array& params, bool fHelp);
+extern Value exportsnapshot(const json_spirit::Array& params, bool fHelp);
+extern Value getstateroot(const json_spirit::Array& params, bool fHelp);
+extern Value getstateproof(const json_spirit::Array& params, bool fHelp);
 
 extern Value submitpricefeedtx(const json_spirit::Array& params, bool fHelp);
 extern Value submitcoinstaketx(const json_spirit::Array& params, bool fHelp);
@@ -236,5 +241,6 @@ extern Value getminminerfee(const Array& params, bool fHelp) ;
 
 // debug
 Value dumpdb(const Array& params, bool fHelp);
+Value getmetrics(const Array& params, bool fHelp);
 
 #endif /* RPC_API_H_ */
@@ -39,6 +39,10 @@ static const CRPCCommand vRPCCommands[] =
     { "getrawmempool",                  &getrawmempool,                     true,      false,       false   },
     { "verifychain",                    &verifychain,                       true,      false,       false   },
     { "getblockundo",                   &getblockundo,                      true,      false,       false   },
+    { "getblockfilter",                 &getblockfilter,                    true,      false,       false   },
+    { "exportsnapshot",                 &exportsnapshot,                    true,      true,        false   },
+    { "getstateroot",                   &getstateroot,                      true,      false,       false   },
+    { "getstateproof",                  &getstateproof,                     true,      false,       false   },
 
     { "gettotalcoins",                  &gettotalcoins,                     true,      false,       false   },
     { "invalidateblock",                &invalidateblock,                   true,      true,        false   },
@@ -92,6 +96,7 @@ static const CRPCCommand vRPCCommands[] =
     { "submittxraw",                    &submittxraw,                       true,       false,      false   },
     /* basic tx */
     { "submitsendtx",                   &submitsendtx,                      false,      false,      true    },
+    { "submitbatchsendtx",              &submitbatchsendtx,                 false,      false,      true    },
     { "submitcreateutxotx",             &submitcreateutxotx,                false,      false,      true    },
     { "submitutxospendtx",              &submitutxospendtx,                 false,      false,      true    },
     { "submitaccountregistertx",        &submitaccountregistertx,           false,      false,      true    },
@@ -171,6 +176,7 @@ static const CRPCCommand vRPCCommands[] =
 
     /* debug */
     { "dumpdb",                         &dumpdb,                            true,       true,       true    },
+    { "getmetrics",                     &getmetrics,                        true,       true,       false   },
 };
 
 #endif //RPC_APICONF_H_
\ No newline at end of file
@@ -20,6 +20,10 @@
 #include "tx/coinrewardtx.h"
 #include "wallet/wallet.h"
 #include "persistence/blockundo.h"
+#include "persistence/snapshot.h"
+#include "chain/statecommitment.h"
+#include "chain/blockfilterindex.h"
+#include "rpc/core/rpccommons.h"
 
 using namespace json_spirit;
 using namespace std;
@@ -231,6 +235,9 @@ Value getblock(const Array& params, bool fHelp) {
 
     CBlock block;
     CBlockIndex* pBlockIndex = mapBlockIndex[hash];
+    if (IsBlockPruned(pBlockIndex))
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
+
     if (!ReadBlockFromDisk(pBlockIndex, block)) {
         throw JSONRPCError(RPC_INTERNAL_ERROR, "Can't read block from disk");
     }
@@ -292,6 +299,9 @@ Value getcontractregid(const Array& params, bool fHelp) {
         throw runtime_error("tx unconfirmed");
     }
     CBlockIndex* pIndex = chainActive[nBlockHeight];
+    if (IsBlockPruned(pIndex))
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
+
     CBlock block;
     if (!ReadBlockFromDisk(pIndex, block))
         return false;
@@ -796,4 +806,257 @@ Value getblockundo(const Array& params, bool fHelp) {
     obj.push_back(Pair("tx_undos", txArray));
 
     return obj;
-}
\ No newline at end of file
+}
+
+Value getblockfilter(const Array& params, bool fHelp) {
+    if (fHelp || params.size() < 1 || params.size() > 2) {
+        throw runtime_error(
+            "getblockfilter \"hash or height\" [\"addresses\"]\n"
+            "\nReturns the compact filter of the block, requires -blockfilterindex.\n"
+            "\nArguments:\n"
+            "1.\"hash or height\"   (string or numeric, required) string for the block hash, or numeric for the block "
+            "height\n"
+            "2.\"addresses\"        (array of string, optional) the addresses or regids to match against the filter\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"block_hash\" : \"hash\",   (string) the block hash\n"
+            "  \"block_height\" : n,      (numeric) the block height\n"
+            "  \"element_count\" : n,     (numeric) the number of the elements of the filter\n"
+            "  \"filter\" : \"hex\",        (string) the hex-encoded filter data\n"
+            "  \"header\" : \"hex\",        (string) the filter header\n"
+            "  \"matched\" : true|false   (boolean) whether any of the addresses matches, only with the addresses\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getblockfilter", "\"d640d051704155b1fd3ec8d0331497448c259b0ab0499e109da7ae2bc7423bc2\"") +
+            "\nAs json rpc\n" +
+            HelpExampleRpc("getblockfilter", "\"d640d051704155b1fd3ec8d0331497448c259b0ab0499e109da7ae2bc7423bc2\""));
+    }
+
+    if (pBlockFilterIndex == nullptr)
+        throw JSONRPCError(RPC_MISC_ERROR, "Block filter index is disabled, restart with -blockfilterindex");
+
+    std::string strHash;
+    if (int_type == params[0].type()) {
+        int height = params[0].get_int();
+        if (height < 0 || height > chainActive.Height())
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range.");
+
+        strHash = chainActive[height]->GetBlockHash().GetHex();
+    } else {
+        strHash = params[0].get_str();
+    }
+    uint256 hash(uint256S(strHash));
+
+    auto mapIt = mapBlockIndex.find(hash);
+    if (mapIt == mapBlockIndex.end())
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+
+    CBlockIndex* pBlockIndex = mapIt->second;
+    CBlockFilter filter;
+    uint256 header;
+    if (!pBlockFilterIndex->LookupFilter(pBlockIndex, filter, header))
+        throw JSONRPCError(RPC_MISC_ERROR, strprintf("Block filter not indexed yet, index height=%d",
+                                                     pBlockFilterIndex->GetHeight()));
+
+    Object obj;
+    obj.push_back(Pair("block_hash",    pBlockIndex->GetBlockHash().GetHex()));
+    obj.push_back(Pair("block_height",  pBlockIndex->height));
+    obj.push_back(Pair("element_count", (int64_t)filter.filter.GetN()));
+    obj.push_back(Pair("filter",        HexStr(filter.filter.GetEncoded())));
+    obj.push_back(Pair("header",        header.GetHex()));
+
+    if (params.size() > 1) {
+        GCSElementSet elements;
+        // the txs carry either the key id or the regid of an account
+        for (const auto &item : params[1].get_array()) {
+            CUserID uid = RPC_PARAM::GetUserId(item);
+            CAccount account;
+            if (pCdMan->pAccountCache->GetAccount(uid, account)) {
+                elements.insert(GCSElement(account.keyid.begin(), account.keyid.end()));
+                if (!account.regid.IsEmpty())
+                    elements.insert(account.regid.GetRegIdRaw());
+            } else if (uid.is<CRegID>()) {
+                elements.insert(uid.get<CRegID>().GetRegIdRaw());
+            } else {
+                CKeyID keyId = RPC_PARAM::GetUserKeyId(uid);
+                elements.insert(GCSElement(keyId.begin(), keyId.end()));
+            }
+        }
+        obj.push_back(Pair("matched", filter.filter.MatchAny(elements)));
+    }
+
+    return obj;
+}
+
+Value exportsnapshot(const Array& params, bool fHelp) {
+    if (fHelp || params.size() != 1) {
+        throw runtime_error(
+            "exportsnapshot \"file\"\n"
+            "\nExport the chain state at the tip to a snapshot file, which a new node bootstraps from with\n"
+            "-loadsnapshot and -snapshothash. It carries the block index and the last " +
+            strprintf("%u", SNAPSHOT_BLOCK_DEPTH) + " blocks, so the node is a pruned one.\n"
+            "The block processing only pauses to flush the caches, the file is written after.\n"
+            "\nArguments:\n"
+            "1.\"file\"          (string, required) the file to create, relative to the data directory unless absolute\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"file\" : \"file\",         (string) the snapshot file\n"
+            "  \"block_height\" : n,      (numeric) the height of the block of the state\n"
+            "  \"block_hash\" : \"hash\",   (string) the hash of the block of the state\n"
+            "  \"block_count\" : n,       (numeric) the tip blocks carried with their data\n"
+            "  \"state_hash\" : \"hash\"    (string) the hash of the state, the same on any node at the block\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("exportsnapshot", "\"snapshot.dat\"") +
+            "\nAs json rpc\n" +
+            HelpExampleRpc("exportsnapshot", "\"snapshot.dat\""));
+    }
+
+    boost::filesystem::path path(params[0].get_str());
+    if (!path.is_complete())
+        path = GetDataDir() / path;
+
+    if (boost::filesystem::exists(path))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("The file %s exists already", path.string()));
+
+    CSnapshotHeader header;
+    uint256 stateHash;
+    if (!ExportStateSnapshot(path.string(), header, stateHash)) {
+        boost::filesystem::remove(path);
+        throw JSONRPCError(RPC_MISC_ERROR, "Failed to export the snapshot, see the log for the details");
+    }
+
+    Object obj;
+    obj.push_back(Pair("file",          path.string()));
+    obj.push_back(Pair("block_height",  header.height));
+    obj.push_back(Pair("block_hash",    header.block_hash.GetHex()));
+    obj.push_back(Pair("block_count",   (int64_t)header.block_count));
+    obj.push_back(Pair("state_hash",    stateHash.GetHex()));
+    return obj;
+}
+
+Value getstateroot(const Array& params, bool fHelp) {
+    if (fHelp || params.size() > 1) {
+        throw runtime_error(
+            "getstateroot ( \"hash or height\" )\n"
+            "\nReturns the root of the commitment to the chain state after the block, requires -statecommitment.\n"
+            "The root is not part of the consensus, it's the same on any node at the block.\n"
+            "\nArguments:\n"
+            "1.\"hash or height\"   (string or numeric, optional) string for the block hash, or numeric for the block "
+            "height, default is the tip\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"block_hash\" : \"hash\",   (string) the block hash\n"
+            "  \"block_height\" : n,      (numeric) the block height\n"
+            "  \"state_root\" : \"hash\"    (string) the root of the state commitment\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getstateroot", "100") +
+            "\nAs json rpc\n" +
+            HelpExampleRpc("getstateroot", "100"));
+    }
+
+    if (pStateCommitment == nullptr)
+        throw JSONRPCError(RPC_MISC_ERROR, "State commitment is disabled, restart with -statecommitment");
+
+    CBlockIndex* pBlockIndex = chainActive.Tip();
+    if (params.size() > 0) {
+        if (int_type == params[0].type()) {
+            int height = params[0].get_int();
+            if (height < 0 || height > chainActive.Height())
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Block height out of range.");
+
+            pBlockIndex = chainActive[height];
+        } else {
+            auto mapIt = mapBlockIndex.find(uint256S(params[0].get_str()));
+            if (mapIt == mapBlockIndex.end())
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Block not found");
+
+            pBlockIndex = mapIt->second;
+        }
+    }
+
+    uint256 root;
+    if (!pCdMan->pStateCommitCache->GetRoot(pBlockIndex->GetBlockHash(), root))
+        throw JSONRPCError(RPC_MISC_ERROR, "No state root of the block, it was connected before the commitment was built");
+
+    Object obj;
+    obj.push_back(Pair("block_hash",    pBlockIndex->GetBlockHash().GetHex()));
+    obj.push_back(Pair("block_height",  pBlockIndex->height));
+    obj.push_back(Pair("state_root",    root.GetHex()));
+    return obj;
+}
+
+Value getstateproof(const Array& params, bool fHelp) {
+    if (fHelp || params.size() != 1) {
+        throw runtime_error(
+            "getstateproof \"key\"\n"
+            "\nReturns the proof of a state entry at the tip against the state root, requires -statecommitment.\n"
+            "The leaf of an entry is Hash(key, value) in a bucket of the first 16 bits of Hash(key), the leaves\n"
+            "of the bucket hash to its node of the merkle tree of the buckets.\n"
+            "\nArguments:\n"
+            "1.\"key\"         (string, required) an address for its account info entry, or the hex of a db key,\n"
+            "                   the token balances of an account are entries of their own\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"block_hash\" : \"hash\",   (string) the tip block hash\n"
+            "  \"block_height\" : n,      (numeric) the tip block height\n"
+            "  \"state_root\" : \"hash\",   (string) the root of the state commitment\n"
+            "  \"key\" : \"hex\",           (string) the db key\n"
+            "  \"value\" : \"hex\",         (string) the serialized value, empty if the key has no entry\n"
+            "  \"bucket\" : n,            (numeric) the bucket of the key\n"
+            "  \"leaves\" : [             (array) the leaves of the bucket\n"
+            "     { \"key_hash\" : \"hash\", \"leaf_hash\" : \"hash\" }, ...\n"
+            "  ],\n"
+            "  \"branch\" : [\"hash\", ...],  (array) the sibling hashes from the bucket up to the root\n"
+            "  \"verified\" : true|false  (boolean) whether the proof leads to the state root\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("getstateproof", "\"wLKf2NqwtHk3BfzK5wMDfbKYN1SC3weyR4\"") +
+            "\nAs json rpc\n" +
+            HelpExampleRpc("getstateproof", "\"wLKf2NqwtHk3BfzK5wMDfbKYN1SC3weyR4\""));
+    }
+
+    if (pStateCommitment == nullptr)
+        throw JSONRPCError(RPC_MISC_ERROR, "State commitment is disabled, restart with -statecommitment");
+
+    string dbKey;
+    const string &strKey = params[0].get_str();
+    CKeyID keyId;
+    if (IsHex(strKey)) {
+        vector<unsigned char> keyData = ParseHex(strKey);
+        dbKey.assign(keyData.begin(), keyData.end());
+    } else if (RPC_PARAM::GetKeyId(params[0], keyId)) {
+        dbKey = dbk::GenDbKey(dbk::KEYID_ACCOUNT_INFO, keyId);
+    } else {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid address or db key");
+    }
+
+    CStateProof proof;
+    if (!pStateCommitment->GetProof(dbKey, proof))
+        throw JSONRPCError(RPC_MISC_ERROR, "Failed to get the proof, see the log for the details");
+
+    Array leaves;
+    for (const auto &item : proof.bucket.leaves) {
+        Object leaf;
+        leaf.push_back(Pair("key_hash",     item.first.GetHex()));
+        leaf.push_back(Pair("leaf_hash",    item.second.GetHex()));
+        leaves.push_back(leaf);
+    }
+    Array branch;
+    for (const auto &hash : proof.branch)
+        branch.push_back(hash.GetHex());
+
+    const uint256 &root = pStateCommitment->GetRoot();
+    Object obj;
+    obj.push_back(Pair("block_hash",    chainActive.Tip()->GetBlockHash().GetHex()));
+    obj.push_back(Pair("block_height",  chainActive.Height()));
+    obj.push_back(Pair("state_root",    root.GetHex()));
+    obj.push_back(Pair("key",           HexStr(proof.key)));
+    obj.push_back(Pair("value",         HexStr(proof.value)));
+    obj.push_back(Pair("bucket",        (int64_t)GetStateBucketIndex(GetStateKeyHash(proof.key))));
+    obj.push_back(Pair("leaves",        leaves));
+    obj.push_back(Pair("branch",        branch));
+    obj.push_back(Pair("verified",      proof.Verify(root)));
+    return obj;
+}
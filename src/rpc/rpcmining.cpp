@@ -196,6 +196,8 @@ Value getminedblocks(const Array& params, bool fHelp) {
             "    \"blocksize\": n          (numeric) block size (bytes)\n"
             "    \"hash\": xxx             (string) block hash\n"
             "    \"preblockhash\": xxx     (string) pre block hash\n"
+            "    \"prebuilt_tx_count\": n  (numeric) transaction count packed into the block template before the slot\n"
+            "    \"pack_time_ms\": n       (numeric) time used from the slot start to the block accepted (ms)\n"
             "  }\n"
             "]\n"
             "\nExamples:\n" +
@@ -221,6 +223,8 @@ Value getminedblocks(const Array& params, bool fHelp) {
         obj.push_back(Pair("block_size",    blockInfo.totalBlockSize));
         obj.push_back(Pair("txid",          blockInfo.hash.ToString()));
         obj.push_back(Pair("preblockhash",  blockInfo.hashPrevBlock.ToString()));
+        obj.push_back(Pair("prebuilt_tx_count", blockInfo.prebuiltTxCount));
+        obj.push_back(Pair("pack_time_ms",  blockInfo.packTimeMs));
         ret.push_back(obj);
     }
 
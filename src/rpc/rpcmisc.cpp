@@ -4,6 +4,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "commons/base58.h"
+#include "commons/metrics.h"
 #include "init.h"
 #include "main.h"
 #include "net.h"
@@ -220,7 +221,9 @@ Value verifymessage(const Array& params, bool fHelp) {
     /**** account db                                                                      */ \
     DEFINE( REGID_KEYID,          pAccountCache,  regId2KeyIdCache)\
     DEFINE( NICKID_KEYID,         pAccountCache,  nickId2KeyIdCache) \
-    DEFINE( KEYID_ACCOUNT,        pAccountCache,  accountCache) \
+    DEFINE( KEYID_ACCOUNT,        pAccountCache,  legacyAccountCache) \
+    DEFINE( KEYID_ACCOUNT_INFO,   pAccountCache,  accountCache) \
+    DEFINE( KEYID_ACCOUNT_TOKEN,  pAccountCache,  accountTokenCache) \
     /**** contract db                                                                      */ \
     DEFINE( CONTRACT_DEF,         pContractCache,  contractCache ) \
     DEFINE( CONTRACT_DATA,        pContractCache,  contractDataCache) \
@@ -355,3 +358,54 @@ Value dumpdb(const Array& params, bool fHelp) {
 
     return Object();
 }
+
+Value getmetrics(const Array& params, bool fHelp) {
+    if (fHelp || params.size() > 1)
+        throw runtime_error(
+            "getmetrics [\"format\"]\n"
+            "\nget the latencies of the hot paths and the resource counters of the node\n"
+            "\nArguments:\n"
+            "1. \"format\"   (string, optional) json or text, text is the Prometheus text format served at\n"
+            "               /metrics with -metrics, default is json\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"name\": n,              (numeric) a counter or gauge\n"
+            "  \"name\": {               (object) a latency histogram\n"
+            "    \"count\": n,           (numeric) the observations\n"
+            "    \"sum\": n,             (numeric) the total seconds\n"
+            "    \"buckets\": {...}      (object) the cumulative observations up to each bound in seconds\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getmetrics", "") + "\nAs json rpc\n" + HelpExampleRpc("getmetrics", "")
+        );
+
+    string format = params.size() > 0 ? params[0].get_str() : "json";
+    if (format == "text")
+        return GetMetricsRegistry().ToText();
+    if (format != "json")
+        throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("unsupported format=%s", format));
+
+    Object obj;
+    for (const auto &sample : GetMetricsRegistry().GetSamples()) {
+        if (sample.type != MetricType::HISTOGRAM) {
+            obj.push_back(Pair(sample.name, sample.value));
+            continue;
+        }
+
+        Object bucketObj;
+        uint64_t cumulative = 0;
+        for (uint32_t i = 0; i < CMetricHistogram::BUCKET_COUNT; i++) {
+            cumulative += sample.buckets[i];
+            bucketObj.push_back(Pair(strprintf("%g", CMetricHistogram::kBucketBounds[i] / 1000000.0), cumulative));
+        }
+        bucketObj.push_back(Pair("+Inf", sample.count));
+
+        Object histogramObj;
+        histogramObj.push_back(Pair("count",   sample.count));
+        histogramObj.push_back(Pair("sum",     sample.sum / 1000000.0));
+        histogramObj.push_back(Pair("buckets", bucketObj));
+        obj.push_back(Pair(sample.name, histogramObj));
+    }
+    return obj;
+}
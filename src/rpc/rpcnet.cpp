@@ -388,6 +388,13 @@ Value getchaininfo(const Array& params, bool fHelp) {
             "    \"fuel\": n,           (numeric) The fuel consumed in the block\n"
             "    \"fuel_rate\":n,       (numeric) The fuel rate in the block\n"
             "    \"miner\": n,          (string) The miner\n"
+            "    \"size\": n,           (numeric) The block size, the fields below are absent for the blocks\n"
+            "                            connected by an old version\n"
+            "    \"fees\": {},          (object) The tx fees per fee symbol\n"
+            "    \"reward_fees\": {},   (object) The fees minus the fuel, rewarded to the miner, per symbol\n"
+            "    \"inflated_bcoins\": n, (numeric) The inflation profits of the miner\n"
+            "    \"run_steps\": n,      (numeric) The total run steps of the contract txs\n"
+            "    \"tx_types\": {},      (object) The tx count per tx type\n"
             "  },\n"
             "  ...\n"
             "]\n"
@@ -407,9 +414,9 @@ Value getchaininfo(const Array& params, bool fHelp) {
         throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("The input count out of range! count=%d, height=%d, max_count=%d",
             count, height, MAX_RECENT_BLOCK_COUNT));
 
+    // answered from the block indexes, no block is read from disk
     CBlockIndex* pBlockIndex = chainActive[height];
     Array array;
-    CBlock block;
 
     for (int32_t i = 0; (i < count) && (pBlockIndex != nullptr); i++) {
         Object object;
@@ -418,10 +425,24 @@ Value getchaininfo(const Array& params, bool fHelp) {
         object.push_back(Pair("tx_count",   (int32_t)pBlockIndex->nTx));
         object.push_back(Pair("fuel",       (int64_t)pBlockIndex->nFuel));
         object.push_back(Pair("fuel_rate",  (int32_t)pBlockIndex->nFuelRate));
-
-        block.SetNull();
-        if (ReadBlockFromDisk(pBlockIndex, block)) {
-            object.push_back(Pair("miner",  block.vptx[0]->txUid.ToString()));
+        object.push_back(Pair("miner",      pBlockIndex->GetMiner().ToString()));
+
+        CBlockSummary summary = pBlockIndex->GetSummary();
+        if (!summary.IsEmpty()) {
+            Object fees, rewardFees, txTypes;
+            for (const auto &item : summary.fees)
+                fees.push_back(Pair(item.first, item.second));
+            for (const auto &item : summary.reward_fees)
+                rewardFees.push_back(Pair(item.first, item.second));
+            for (const auto &item : summary.tx_type_counts)
+                txTypes.push_back(Pair(GetTxTypeName((TxType)item.first), (int64_t)item.second));
+
+            object.push_back(Pair("size",               (int64_t)summary.block_size));
+            object.push_back(Pair("fees",               fees));
+            object.push_back(Pair("reward_fees",        rewardFees));
+            object.push_back(Pair("inflated_bcoins",    summary.inflated_bcoins));
+            object.push_back(Pair("run_steps",          summary.run_steps));
+            object.push_back(Pair("tx_types",           txTypes));
         }
 
         array.push_back(object);
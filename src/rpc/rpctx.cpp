@@ -711,19 +711,41 @@ Value listaddr(const Array& params, bool fHelp) {
     return retArray;
 }
 
+static TxType ParseTxTypeName(const string &txTypeName) {
+    for (const auto &item : kTxFeeTable) {
+        if (std::get<0>(item.second) == txTypeName)
+            return item.first;
+    }
+    throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("Invalid tx type: %s", txTypeName));
+}
+
 Value listtx(const Array& params, bool fHelp) {
-if (fHelp || params.size() > 2) {
-        throw runtime_error("listtx\n"
-                "\nget all confirmed transactions and all unconfirmed transactions from wallet.\n"
+if (fHelp || params.size() > 3) {
+        throw runtime_error("listtx [count] [from] [filters]\n"
+                "\nget the confirmed transactions from the newest block, and all unconfirmed transactions from wallet.\n"
                 "\nArguments:\n"
                 "1. count          (numeric, optional, default=10) The number of transactions to return\n"
                 "2. from           (numeric, optional, default=0) The number of transactions to skip\n"
+                "3. filters        (object, optional) The page cursor and the filters\n"
+                "  {\n"
+                "    \"cursor\": \"height:txid\", (string, optional) list after the cursor, the next_cursor of a result\n"
+                "    \"address\": \"addr\",       (string, optional) only the txs involving the wallet address\n"
+                "    \"tx_type\": \"type\",       (string, optional) only the txs of the type, e.g. UCOIN_TRANSFER_TX\n"
+                "    \"symbol\": \"symbol\",      (string, optional) only the txs paying fees or transferring the symbol\n"
+                "  }\n"
                 "\nResult:\n"
+                "{\n"
+                "  \"confirmed_tx\": [\"txid\", ...], (array) The confirmed txids of the page\n"
+                "  \"next_cursor\": \"height:txid\", (string) The cursor of the next page, absent on the last page\n"
+                "  \"unconfirmed_tx\": [\"txid\", ...] (array) The unconfirmed txids\n"
+                "}\n"
                 "\nExamples:\n"
                 "\nList the most recent 10 transactions in the system\n"
                 + HelpExampleCli("listtx", "") +
                 "\nList transactions 100 to 120\n"
-                + HelpExampleCli("listtx", "20 100")
+                + HelpExampleCli("listtx", "20 100") +
+                "\nList the next 20 WUSD transactions after a page\n"
+                + HelpExampleCli("listtx", "20 0 '{\"cursor\":\"1000:d640...3bc2\", \"symbol\":\"WUSD\"}'")
             );
     }
 
@@ -737,33 +759,47 @@ if (fHelp || params.size() > 2) {
     if (params.size() > 1) {
         nFrom = params[1].get_int();
     }
+
+    if (nDefCount < 0 || nFrom < 0)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "count and from must not be negative");
+
+    CWalletTxFilter filter;
+    CWalletTxPos cursor;
+    bool hasCursor = false;
+    if (params.size() > 2) {
+        const Object &filters = params[2].get_obj();
+        const Value &cursorValue = find_value(filters, "cursor");
+        if (cursorValue.type() != null_type) {
+            if (!CWalletTxPos::Parse(cursorValue.get_str(), cursor))
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor, expected \"height:txid\"");
+            hasCursor = true;
+        }
+
+        const Value &addressValue = find_value(filters, "address");
+        if (addressValue.type() != null_type)
+            filter.key_id = RPC_PARAM::GetKeyId(addressValue);
+
+        const Value &txTypeValue = find_value(filters, "tx_type");
+        if (txTypeValue.type() != null_type)
+            filter.tx_type = ParseTxTypeName(txTypeValue.get_str());
+
+        const Value &symbolValue = find_value(filters, "symbol");
+        if (symbolValue.type() != null_type)
+            filter.symbol = symbolValue.get_str();
+    }
     assert(pWalletMain != nullptr);
 
+    LOCK(pWalletMain->cs_wallet);
+
     Array confirmedTxArray;
-    int32_t nCount = 0;
-    map<int32_t, uint256, std::greater<int32_t> > blockInfoMap;
-    for (auto const &wtx : pWalletMain->mapInBlockTx) {
-        auto it = mapBlockIndex.find(wtx.first);
-        if (it != mapBlockIndex.end())
-            blockInfoMap.insert(make_pair(it->second->height, wtx.first));
-    }
-    bool bUpLimited = false;
-    for (auto const &blockInfo : blockInfoMap) {
-        CAccountTx accountTx = pWalletMain->mapInBlockTx[blockInfo.second];
-        for (auto const & item : accountTx.mapAccountTx) {
-            if (nFrom-- > 0)
-                continue;
-            if (++nCount > nDefCount) {
-                bUpLimited = true;
-                break;
-            }
-            confirmedTxArray.push_back(item.first.GetHex());
-        }
-        if (bUpLimited) {
-            break;
-        }
+    vector<const CWalletTxEntry *> page;
+    bool hasMore = pWalletMain->txIndex.List(hasCursor ? &cursor : nullptr, filter, nFrom, nDefCount, page);
+    for (const auto pEntry : page) {
+        confirmedTxArray.push_back(pEntry->pos.txid.GetHex());
     }
     retObj.push_back(Pair("confirmed_tx", confirmedTxArray));
+    if (hasMore && !page.empty())
+        retObj.push_back(Pair("next_cursor", page.back()->pos.ToString()));
 
     Array unconfirmedTxArray;
     for (auto const &tx : pWalletMain->unconfirmedTx) {
@@ -915,28 +951,48 @@ Value disconnectblock(const Array& params, bool fHelp) {
 }
 
 Value listcontracts(const Array& params, bool fHelp) {
-    if (fHelp || params.size() != 1) {
+    if (fHelp || params.size() < 1 || params.size() > 3) {
         throw runtime_error(
-            "listcontracts \"show detail\"\n"
-            "\nget the list of all contracts\n"
+            "listcontracts \"show detail\" [\"max_count\"] [\"last_pos_info\"]\n"
+            "\nget the list of contracts page by page\n"
             "\nArguments:\n"
-            "1. show detail  (boolean, required) show contract in detail if true.\n"
-            "\nReturn an object contains all contracts\n"
+            "1. show detail      (boolean, required) show contract in detail if true.\n"
+            "2. \"max_count\"      (numeric, optional) the max contract count to get, default is 500\n"
+            "3. \"last_pos_info\"  (string, optional) the last position info to get more contracts, default is empty\n"
+            "\nReturn an object contains the contracts of the page\n"
             "\nResult:\n"
+            "\"has_more\"           (bool) has more contracts in db.\n"
+            "\"last_pos_info\"      (string) the last position info to get more contracts.\n"
+            "\"count\"              (numeric) the count of returned contracts.\n"
+            "\"contracts\"          (array) the contracts of the page.\n"
             "\nExamples:\n" +
             HelpExampleCli("listcontracts", "true") + "\nAs json rpc call\n" + HelpExampleRpc("listcontracts", "true"));
     }
 
     bool showDetail = params[0].get_bool();
 
-    map<CRegIDKey, CUniversalContract> contracts;
-    if (!pCdMan->pContractCache->GetContracts(contracts)) {
-        throw JSONRPCError(RPC_DATABASE_ERROR, "Failed to acquire contracts from db.");
+    int64_t maxCount = 500;
+    if (params.size() > 1) {
+        maxCount = params[1].get_int64();
+        if (maxCount < 0)
+            throw JSONRPCError(RPC_INVALID_PARAMS, strprintf("max_count=%d must >= 0", maxCount));
+    }
+
+    DBContractCache::KeyType lastKey;
+    if (params.size() > 2) {
+        string lastPosInfo = RPC_PARAM::GetBinStrFromHex(params[2], "last_pos_info");
+        if (!CDBPageGetter<CDBContractIterator>::ParseLastPos(lastPosInfo, lastKey))
+            throw JSONRPCError(RPC_INVALID_PARAMS, "Invalid last_pos_info!");
     }
 
+    LOCK(cs_main);
+    auto pContractIt = pCdMan->pContractCache->CreateContractIterator();
+    CDBPageGetter<CDBContractIterator> getter(*pContractIt);
+    getter.Execute(lastKey, maxCount);
+
     Object obj;
     Array contractArray;
-    for (const auto &item : contracts) {
+    for (const auto &item : getter.data_list) {
         Object contractObject;
         const CUniversalContract &contract = item.second;
         contractObject.push_back(Pair("contract_regid", item.first.regid.ToString()));
@@ -952,8 +1008,14 @@ Value listcontracts(const Array& params, bool fHelp) {
         contractArray.push_back(contractObject);
     }
 
-    obj.push_back(Pair("count",     contracts.size()));
-    obj.push_back(Pair("contracts", contractArray));
+    string newLastPosInfo;
+    if (getter.has_more)
+        newLastPosInfo = CDBPageGetter<CDBContractIterator>::MakeLastPos(getter.last_key);
+
+    obj.push_back(Pair("has_more",      getter.has_more));
+    obj.push_back(Pair("last_pos_info", HexStr(newLastPosInfo)));
+    obj.push_back(Pair("count",         getter.data_list.size()));
+    obj.push_back(Pair("contracts",     contractArray));
 
     return obj;
 }
@@ -1101,6 +1163,9 @@ Value saveblocktofile(const Array& params, bool fHelp) {
         throw JSONRPCError(RPC_MISC_ERROR, "block hash is not exist!");
     }
     CBlockIndex *pIndex = mapBlockIndex[blockHash];
+    if (pIndex && IsBlockPruned(pIndex))
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not available (pruned data)");
+
     CBlock blockInfo;
     if (!pIndex || !ReadBlockFromDisk(pIndex, blockInfo))
         throw runtime_error(_("Failed to read block"));
@@ -1541,31 +1606,73 @@ Value validateaddr(const Array& params, bool fHelp) {
     return obj;
 }
 
+static Object GetAccountStatsJson(const CAccountStats &stats) {
+    auto getTotal = [&](const TokenSymbol &symbol) -> uint64_t {
+        auto it = stats.supplies.find(symbol);
+        return it == stats.supplies.end() ? 0 : it->second.GetTotal();
+    };
+
+    Object obj;
+    obj.push_back(Pair("total_accounts", stats.account_count));
+    obj.push_back(Pair("total_regids",   stats.regid_count));
+    obj.push_back(Pair("total_bcoins",   ValueFromAmount(getTotal(SYMB::WICC))));
+    obj.push_back(Pair("total_scoins",   ValueFromAmount(getTotal(SYMB::WUSD))));
+    obj.push_back(Pair("total_fcoins",   ValueFromAmount(getTotal(SYMB::WGRT))));
+
+    Object supplyObj;
+    for (const auto &item : stats.supplies) {
+        Object tokenObj;
+        tokenObj.push_back(Pair("free_amount",   item.second.free_amount));
+        tokenObj.push_back(Pair("voted_amount",  item.second.voted_amount));
+        tokenObj.push_back(Pair("frozen_amount", item.second.frozen_amount));
+        tokenObj.push_back(Pair("staked_amount", item.second.staked_amount));
+        tokenObj.push_back(Pair("total_amount",  item.second.GetTotal()));
+        supplyObj.push_back(Pair(item.first, tokenObj));
+    }
+    obj.push_back(Pair("supplies", supplyObj));
+
+    return obj;
+}
+
 Value gettotalcoins(const Array& params, bool fHelp) {
-    if (fHelp || params.size() != 0) {
+    if (fHelp || params.size() > 1) {
         throw runtime_error(
-            "gettotalcoins \n"
-            "\nget the total number of circulating coins excluding those locked for votes\n"
-            "\nand the total number of registered addresses\n"
+            "gettotalcoins [verify]\n"
+            "\nget the total number of coins held by all accounts, including those locked for votes,\n"
+            "\nDEX orders and staking, and the total number of accounts and registered accounts\n"
             "\nArguments:\n"
+            "1.\"verify\":   (bool, optional) recompute the stats from all the accounts and check them against\n"
+            "                  the kept ones, it iterates the whole account db, default is false\n"
             "\nResult:\n"
+            "{\n"
+            "  \"total_accounts\": n,   (numeric) the number of accounts\n"
+            "  \"total_regids\": n,     (numeric) the number of registered accounts\n"
+            "  \"total_bcoins\": n,     (numeric) the total WICC\n"
+            "  \"total_scoins\": n,     (numeric) the total WUSD\n"
+            "  \"total_fcoins\": n,     (numeric) the total WGRT\n"
+            "  \"supplies\": {...},     (object) the amounts of every token with a non-zero supply\n"
+            "  \"verified\": true|false (bool, only with verify) whether the recomputed stats equal the kept ones\n"
+            "}\n"
             "\nExamples:\n" +
             HelpExampleCli("gettotalcoins", "") + "\nAs json rpc call\n" + HelpExampleRpc("gettotalcoins", ""));
     }
 
-    Object obj;
+    bool fVerify = params.size() > 0 ? params[0].get_bool() : false;
+
+    LOCK(cs_main);
+    CAccountStats stats;
+    pCdMan->pAccountCache->GetAccountStats(stats);
+    Object obj = GetAccountStatsJson(stats);
 
-    uint64_t totalRegIds(0);
-    uint64_t totalBCoins(0);
-    uint64_t totalSCoins(0);
-    uint64_t totalFCoins(0);
-    std::tie(totalRegIds, totalBCoins, totalSCoins, totalFCoins) = pCdMan->pAccountCache->TraverseAccount();
-    // auto [totalCoins, totalRegIds] = pCdMan->pAccountCache->TraverseAccount(); //C++17
-
-    obj.push_back(Pair("total_regids", totalRegIds));
-    obj.push_back(Pair("total_bcoins",  ValueFromAmount(totalBCoins)));
-    obj.push_back(Pair("total_scoins",  ValueFromAmount(totalSCoins)));
-    obj.push_back(Pair("total_fcoins",  ValueFromAmount(totalFCoins)));
+    if (fVerify) {
+        CAccountStats computedStats;
+        if (!pCdMan->pAccountCache->ComputeAccountStats(computedStats))
+            throw JSONRPCError(RPC_MISC_ERROR, "compute the account stats failed");
+
+        obj.push_back(Pair("verified", computedStats == stats));
+        if (!(computedStats == stats))
+            obj.push_back(Pair("computed", GetAccountStatsJson(computedStats)));
+    }
 
     return obj;
 }
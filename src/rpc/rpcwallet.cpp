@@ -15,9 +15,11 @@
 #include "rpc/core/rpccommons.h"
 #include "rpc/core/rpcserver.h"
 #include "vm/luavm/appaccount.h"
+#include "wallet/batchpayout.h"
 #include "wallet/wallet.h"
 #include "wallet/walletdb.h"
 #include "tx/mulsigtx.h"
+#include "commons/SafeInt3.hpp"
 
 #include <stdint.h>
 #include <boost/assign/list_of.hpp>
@@ -350,6 +352,133 @@ Value submitsendtx(const Array& params, bool fHelp) {
 
 
 
+Value submitbatchsendtx(const Array& params, bool fHelp) {
+    if (fHelp || params.size() < 2 || params.size() > 4)
+        throw runtime_error(
+            "submitbatchsendtx \"from\" [{\"to\":\"addr\", \"coin\":\"symbol:coin:unit\"},...] [\"symbol:fee:unit\"] [\"memo\"]\n"
+            "\nSend coins to many addresses. The payouts are grouped into the fewest transfer txs, "
+            + strprintf("%u", MAX_TRANSFER_SIZE) + " payouts per tx in order,\n"
+            "signed in parallel and committed to the mempool together.\n" +
+            HelpRequiringPassphrase() +
+            "\nArguments:\n"
+            "1.\"from\":                (string, required) The address where coins are sent from\n"
+            "2.\"payouts\":             (array, required) The payouts, at most " + strprintf("%u", MAX_BATCH_PAYOUT_SIZE) + "\n"
+            "  [\n"
+            "    {\n"
+            "      \"to\":              (string, required) The address where coins are received\n"
+            "      \"coin\":            (symbol:amount:unit, required) transferred coins\n"
+            "    }\n"
+            "  ]\n"
+            "3.\"symbol:fee:unit\":     (symbol:amount:unit, optional) fee paid to miner per payout, default is the min fee\n"
+            "4.\"memo\":                (string, optional) The memo of every tx\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"txs\": [                 (array) The txs in order, the payout i is in the tx i / "
+            + strprintf("%u", MAX_TRANSFER_SIZE) + "\n"
+            "    {\n"
+            "      \"txid\": \"txid\",      (string) The transaction id\n"
+            "      \"payout_count\": n,   (numeric) The payouts of the tx\n"
+            "      \"accepted\": true|false, (bool) Whether the tx is accepted by the mempool\n"
+            "      \"reason\": \"xxx\"      (string) The reject reason of a tx not accepted\n"
+            "    }\n"
+            "  ],\n"
+            "  \"accepted_payout_count\": n (numeric) The payouts of the accepted txs\n"
+            "}\n"
+            "\nExamples:\n" +
+            HelpExampleCli("submitbatchsendtx",
+                           "\"wLKf2NqwtHk3BfzK5wMDfbKYN1SC3weyR4\" "
+                           "\"[{\\\"to\\\":\\\"wNDue1jHcgRSioSDL4o1AzXz3D72gCMkP6\\\", \\\"coin\\\":\\\"WICC:1000000:sawi\\\"}]\" "
+                           "\"WICC:10000:sawi\"") +
+            "\nAs json rpc call\n" +
+            HelpExampleRpc("submitbatchsendtx",
+                           "\"wLKf2NqwtHk3BfzK5wMDfbKYN1SC3weyR4\", "
+                           "[{\"to\":\"wNDue1jHcgRSioSDL4o1AzXz3D72gCMkP6\", \"coin\":\"WICC:1000000:sawi\"}], "
+                           "\"WICC:10000:sawi\""));
+
+    EnsureWalletIsUnlocked();
+
+    int32_t height = chainActive.Height();
+    if (GetFeatureForkVersion(height) < MAJOR_VER_R2)
+        throw JSONRPCError(REJECT_INVALID, strprintf("Unsupported before height=%u! current height=%d",
+                                                     SysCfg().GetFeatureForkHeight(), height));
+
+    CUserID sendUserId    = RPC_PARAM::GetUserId(params[0], true);
+    const Array &payoutArr = params[1].get_array();
+    ComboMoney cmFee      = RPC_PARAM::GetFee(params, 2, UCOIN_TRANSFER_TX);
+    string memo           = params.size() > 3 ? params[3].get_str() : "";
+
+    if (payoutArr.empty() || payoutArr.size() > MAX_BATCH_PAYOUT_SIZE)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("The payout count=%u must be in [1, %u]",
+                                                            payoutArr.size(), MAX_BATCH_PAYOUT_SIZE));
+
+    vector<SingleTransfer> payouts;
+    payouts.reserve(payoutArr.size());
+    map<TokenSymbol, uint64_t> totalAmounts;
+    for (size_t i = 0; i < payoutArr.size(); i++) {
+        const Object &payoutObj = payoutArr[i].get_obj();
+        CUserID recvUserId      = RPC_PARAM::GetUserId(find_value(payoutObj, "to"));
+        ComboMoney cmCoin       = RPC_PARAM::GetComboMoney(find_value(payoutObj, "coin"), SYMB::WICC);
+
+        auto pSymbolErr = pCdMan->pAssetCache->CheckTransferCoinSymbol(cmCoin.symbol);
+        if (pSymbolErr)
+            throw JSONRPCError(REJECT_INVALID, strprintf("payouts[%u], invalid coin symbol=%s! %s", i,
+                                                         cmCoin.symbol, *pSymbolErr));
+
+        if (cmCoin.amount == 0)
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("payouts[%u], coins is zero!", i));
+
+        payouts.push_back(SingleTransfer(recvUserId, cmCoin.symbol, cmCoin.GetSawiAmount()));
+        uint64_t &totalAmount = totalAmounts[cmCoin.symbol];
+        if (!SafeAdd(totalAmount, cmCoin.GetSawiAmount(), totalAmount))
+            throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("payouts[%u], the total amount of %s overflows!", i,
+                                                                cmCoin.symbol));
+    }
+    uint64_t totalFees = 0;
+    uint64_t &totalFeeAmount = totalAmounts[cmFee.symbol];
+    if (!SafeMultiply(cmFee.GetSawiAmount(), (uint64_t)payouts.size(), totalFees) ||
+        !SafeAdd(totalFeeAmount, totalFees, totalFeeAmount))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("The total amount of %s with the fees overflows!",
+                                                            cmFee.symbol));
+
+    CAccount account = RPC_PARAM::GetUserAccount(*pCdMan->pAccountCache, sendUserId);
+    for (const auto &item : totalAmounts)
+        RPC_PARAM::CheckAccountBalance(account, item.first, SUB_FREE, item.second);
+
+    CKey key;
+    if (!pWalletMain->GetKey(account.keyid, key))
+        throw JSONRPCError(RPC_WALLET_ERROR, "Sender address not found in wallet");
+
+    auto spTxs = BuildPayoutTxs(sendUserId, height, payouts, cmFee.symbol, cmFee.GetSawiAmount(), memo);
+    vector<CBaseTx *> txs;
+    for (const auto &spTx : spTxs)
+        txs.push_back(spTx.get());
+
+    uint32_t threadCount = std::min<uint32_t>(MAX_BATCH_SIGN_THREADS, std::max(1U, boost::thread::hardware_concurrency()));
+    if (!SignTxsParallel(key, txs, threadCount))
+        throw JSONRPCError(RPC_WALLET_ERROR, "Sign failed");
+
+    auto results = pWalletMain->CommitTxs(txs);
+
+    Array txArr;
+    uint32_t acceptedCount = 0;
+    for (size_t i = 0; i < spTxs.size(); i++) {
+        Object txObj;
+        txObj.push_back(Pair("txid",            spTxs[i]->GetHash().GetHex()));
+        txObj.push_back(Pair("payout_count",    (int64_t)spTxs[i]->transfers.size()));
+        txObj.push_back(Pair("accepted",        std::get<0>(results[i])));
+        if (std::get<0>(results[i]))
+            acceptedCount += spTxs[i]->transfers.size();
+        else
+            txObj.push_back(Pair("reason",      std::get<1>(results[i])));
+        txArr.push_back(txObj);
+    }
+
+    Object obj;
+    obj.push_back(Pair("txs",                   txArr));
+    obj.push_back(Pair("accepted_payout_count", (int64_t)acceptedCount));
+    return obj;
+}
+
 Value genmulsigtx(const Array& params, bool fHelp) {
     if (fHelp || (params.size() != 4 && params.size() != 5))
         throw runtime_error(
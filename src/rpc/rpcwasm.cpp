@@ -67,6 +67,23 @@ using std::chrono::microseconds;
         throw runtime_error( msg);      \
     }
 
+// renders the packed trace of a tx in the mempool or on the chain, the abis are resolved in the same view
+static bool get_tx_trace_json(const uint256& trx_id, json_spirit::Value& value_json){
+
+    LOCK(cs_main);
+    auto database = std::make_shared<CCacheWrapper>(mempool.cw.get());
+    auto resolver = make_resolver(database);
+
+    string trace_string;
+    if (!database->contractCache.GetContractTraces(trx_id, trace_string))
+        return false;
+
+    std::vector<char> trace_bytes = std::vector<char>(trace_string.begin(), trace_string.end());
+    transaction_trace trace       = wasm::unpack<transaction_trace>(trace_bytes);
+    to_variant(trace, value_json, resolver);
+    return true;
+}
+
 void read_file_limit(const string& path, string& data, uint64_t max_size){
 
     // try {
@@ -203,26 +220,8 @@ Value submitwasmcontractdeploytx( const Array &params, bool fHelp ) {
         std::tuple<bool, string> ret = wallet->CommitTx((CBaseTx * ) & tx);
         JSON_RPC_ASSERT(std::get<0>(ret), RPC_WALLET_ERROR, std::get<1>(ret))
 
-        // Object obj_return;
-        // json_spirit::Config::add(obj_return, "txid", std::get<1>(ret) );
-        // return obj_return;
-
         Object obj_return;
-        Value  v_trx_id, value_json;
-        json_spirit::read(std::get<1>(ret), value_json);
-
-        //if (value_json.type() == json_spirit::obj_type) {
-        auto o = value_json.get_obj();
-        for (json_spirit::Object::const_iterator iter = o.begin(); iter != o.end(); ++iter) {
-            string name = Config_type::get_name(*iter);
-            if (name == "trx_id") {
-                v_trx_id = Config_type::get_value(*iter);
-                break;
-            }
-        }
-        //}    
-
-        json_spirit::Config::add(obj_return, "trx_id", v_trx_id );
+        json_spirit::Config::add(obj_return, "trx_id", std::get<1>(ret) );
         return obj_return;
 
     } JSON_RPC_CAPTURE_AND_RETHROW;
@@ -289,7 +288,10 @@ Value submitwasmcontractcalltx( const Array &params, bool fHelp ) {
 
         Object obj_return;
         Value  value_json;
-        json_spirit::read(std::get<1>(ret), value_json);
+        CHAIN_ASSERT( get_tx_trace_json(tx.GetHash(), value_json),
+                      wasm_chain::transaction_trace_access_exception,
+                      "get tx '%s' trace failed",
+                      tx.GetHash().ToString())
         json_spirit::Config::add(obj_return, "result", value_json );
         return obj_return;
 
@@ -498,22 +500,14 @@ Value gettxtrace( const Array &params, bool fHelp ) {
     RPCTypeCheck(params, list_of(str_type));
 
     try{
-        auto database  = std::make_shared<CCacheWrapper>(pCdMan);
-        auto resolver  = make_resolver(database);
-        auto trx_id    = uint256S(params[0].get_str());
+        auto trx_id = uint256S(params[0].get_str());
 
-        string  trace_string;
-        CHAIN_ASSERT( database->contractCache.GetContractTraces(trx_id, trace_string),
+        json_spirit::Object object_return;
+        json_spirit::Value  value_json;
+        CHAIN_ASSERT( get_tx_trace_json(trx_id, value_json),
                       wasm_chain::transaction_trace_access_exception,
                       "get tx '%s' trace failed",
                       trx_id.ToString())
-
-        json_spirit::Object object_return;
-        json_spirit::Value  value_json;
-        std::vector<char>   trace_bytes = std::vector<char>(trace_string.begin(), trace_string.end());
-        transaction_trace   trace       = wasm::unpack<transaction_trace>(trace_bytes);
-
-        to_variant(trace, value_json, resolver);
         object_return.push_back(Pair("tx_trace", value_json));
 
         return object_return;
@@ -0,0 +1,180 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <boost/test/unit_test.hpp>
+#include "commons/tinyformat.h"
+#include "commons/util/time.h"
+#include "crypto/hash.h"
+#include "persistence/accountdb.h"
+#include "tests/testutil.h"
+
+using namespace std;
+
+static TokenSymbol GetTestSymbol(uint32_t i) { return strprintf("TK%03u", i); }
+
+// an account holding tokenCount tokens
+static CAccount GetTestAccount(uint32_t i, uint32_t tokenCount) {
+    CAccount account(GetTestKeyId(i));
+    account.regid = CRegID(100, i);
+    for (uint32_t j = 0; j < tokenCount; j++) {
+        account.tokens[GetTestSymbol(j)].free_amount   = 1000 + j;
+        account.tokens[GetTestSymbol(j)].frozen_amount = j;
+    }
+    return account;
+}
+
+static bool IsSameAccount(const CAccount &account1, const CAccount &account2) {
+    return ::SerializeHash(account1) == ::SerializeHash(account2);
+}
+
+static size_t GetOpLogCount(CDBOpLogMap &dbOpLogMap, dbk::PrefixType prefixType) {
+    auto it = dbOpLogMap.GetMap().find(dbk::GetKeyPrefix(prefixType));
+    return it == dbOpLogMap.GetMap().end() ? 0 : it->second.size();
+}
+
+static void UndoOpLogs(CAccountDBCache &cache, CDBOpLogMap &dbOpLogMap) {
+    UndoDataFuncMap undoDataFuncMap;
+    cache.RegisterUndoFunc(undoDataFuncMap);
+    for (const auto &item : dbOpLogMap.GetMap())
+        undoDataFuncMap[dbk::ParseKeyPrefixType(item.first)](item.second);
+}
+
+BOOST_AUTO_TEST_SUITE(accountdb_tests)
+
+BOOST_AUTO_TEST_CASE(account_token_entries_test)
+{
+    CDBAccess dbAccess("", DBNameType::ACCOUNT, true, true);
+    CAccountDBCache rootCache(&dbAccess);
+
+    CAccount account = GetTestAccount(1, 20);
+    account.tokens[GetTestSymbol(99)];  // a held token of no balance
+    BOOST_CHECK(rootCache.SaveAccount(account));
+    rootCache.Flush();
+
+    CAccount loaded;
+    BOOST_CHECK(rootCache.GetAccount(account.keyid, loaded));
+    BOOST_CHECK(IsSameAccount(loaded, account));
+    BOOST_CHECK_EQUAL(rootCache.GetAccountFreeAmount(account.keyid, GetTestSymbol(3)), 1003U);
+
+    // a balance change writes the token only, and is undone by token
+    CAccountDBCache txCache;
+    txCache.SetBaseViewPtr(&rootCache);
+    CDBOpLogMap dbOpLogMap;
+    txCache.SetDbOpLogMap(&dbOpLogMap);
+    CAccount changed = loaded;
+    changed.tokens[GetTestSymbol(5)].free_amount -= 100;
+    BOOST_CHECK(txCache.SetAccount(changed.keyid, changed));
+    BOOST_CHECK_EQUAL(GetOpLogCount(dbOpLogMap, dbk::KEYID_ACCOUNT_TOKEN), 1U);
+    BOOST_CHECK_EQUAL(GetOpLogCount(dbOpLogMap, dbk::KEYID_ACCOUNT_INFO), 0U);
+
+    // a new token adds its symbol to the info, a dropped one erases its entry
+    changed.tokens[GetTestSymbol(50)].free_amount = 7;
+    changed.tokens.erase(GetTestSymbol(0));
+    BOOST_CHECK(txCache.SetAccount(changed.keyid, changed));
+    BOOST_CHECK_EQUAL(GetOpLogCount(dbOpLogMap, dbk::KEYID_ACCOUNT_TOKEN), 3U);
+    BOOST_CHECK_EQUAL(GetOpLogCount(dbOpLogMap, dbk::KEYID_ACCOUNT_INFO), 1U);
+    BOOST_CHECK(txCache.GetAccount(changed.keyid, loaded));
+    BOOST_CHECK(IsSameAccount(loaded, changed));
+    txCache.Flush();
+
+    CAccountDBCache undoCache;
+    undoCache.SetBaseViewPtr(&rootCache);
+    UndoOpLogs(undoCache, dbOpLogMap);
+    BOOST_CHECK(undoCache.GetAccount(account.keyid, loaded));
+    BOOST_CHECK(IsSameAccount(loaded, account));
+
+    // the stats follow the tokens
+    CAccountStats stats, computedStats;
+    BOOST_CHECK(rootCache.GetAccountStats(stats));
+    BOOST_CHECK(rootCache.ComputeAccountStats(computedStats));
+    BOOST_CHECK(stats == computedStats);
+    BOOST_CHECK_EQUAL(stats.supplies[GetTestSymbol(50)].free_amount, 7U);
+
+    BOOST_CHECK(rootCache.EraseAccount(account.keyid));
+    BOOST_CHECK(!rootCache.GetAccount(account.keyid, loaded));
+    BOOST_CHECK_EQUAL(rootCache.GetAccountFreeAmount(account.keyid, GetTestSymbol(3)), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(legacy_account_migration_test)
+{
+    CDBAccess dbAccess("", DBNameType::ACCOUNT, true, true);
+    CAccountDBCache rootCache(&dbAccess);
+
+    // the accounts of the legacy format, and the undo of a block connected before the migration
+    const uint32_t kAccountCount = ACCOUNT_MIGRATION_BATCH_SIZE + 10;
+    for (uint32_t i = 0; i < kAccountCount; i++)
+        rootCache.legacyAccountCache.SetData(GetTestKeyId(i), GetTestAccount(i, i % 5));
+    rootCache.Flush();
+
+    CDBOpLogMap dbOpLogMap;
+    rootCache.legacyAccountCache.SetDbOpLogMap(&dbOpLogMap);
+    rootCache.legacyAccountCache.SetData(GetTestKeyId(0), GetTestAccount(0, 8));
+    rootCache.legacyAccountCache.SetData(GetTestKeyId(kAccountCount), GetTestAccount(kAccountCount, 2));
+    rootCache.legacyAccountCache.SetDbOpLogMap(nullptr);
+    rootCache.Flush();
+
+    uint32_t migratedCount = 0;
+    BOOST_CHECK(rootCache.MigrateLegacyAccounts(migratedCount));
+    BOOST_CHECK_EQUAL(migratedCount, kAccountCount + 1);
+    BOOST_CHECK(!rootCache.legacyAccountCache.HaveData(GetTestKeyId(0)));
+
+    CAccount loaded;
+    BOOST_CHECK(rootCache.GetAccount(GetTestKeyId(7), loaded));
+    BOOST_CHECK(IsSameAccount(loaded, GetTestAccount(7, 2)));
+    BOOST_CHECK(rootCache.GetAccount(GetTestKeyId(0), loaded));
+    BOOST_CHECK(IsSameAccount(loaded, GetTestAccount(0, 8)));
+
+    // migrated again, nothing is left
+    BOOST_CHECK(rootCache.MigrateLegacyAccounts(migratedCount));
+    BOOST_CHECK_EQUAL(migratedCount, 0U);
+
+    // the legacy undo restores the accounts in the new format
+    UndoOpLogs(rootCache, dbOpLogMap);
+    BOOST_CHECK(rootCache.GetAccount(GetTestKeyId(0), loaded));
+    BOOST_CHECK(IsSameAccount(loaded, GetTestAccount(0, 0)));
+    BOOST_CHECK(!rootCache.GetAccount(GetTestKeyId(kAccountCount), loaded));
+    BOOST_CHECK(!rootCache.legacyAccountCache.HaveData(GetTestKeyId(0)));
+}
+
+BOOST_AUTO_TEST_CASE(account_token_write_benchmark)
+{
+    const uint32_t kTransferCount = 10000;
+    for (uint32_t tokenCount : {1U, 10U, 50U}) {
+        CDBAccess dbAccess("", DBNameType::ACCOUNT, true, true);
+        CAccountDBCache rootCache(&dbAccess);
+        CAccount account = GetTestAccount(1, tokenCount);
+        rootCache.SaveAccount(account);
+        rootCache.Flush();
+
+        // the transfers of one token, each one read, changed and written in a cache of its own like a tx;
+        // the legacy format logged the whole account for the undo, the new one logs every entry written
+        size_t legacyBytes = 0;
+        size_t writtenBytes = 0;
+        int64_t nStart = GetTimeMicros();
+        for (uint32_t i = 0; i < kTransferCount; i++) {
+            CAccountDBCache txCache;
+            txCache.SetBaseViewPtr(&rootCache);
+            CDBOpLogMap dbOpLogMap;
+            txCache.SetDbOpLogMap(&dbOpLogMap);
+            CAccount txAccount;
+            txCache.GetAccount(account.keyid, txAccount);
+            txAccount.tokens[GetTestSymbol(i % tokenCount)].free_amount += 1;
+            txCache.SetAccount(txAccount.keyid, txAccount);
+            txCache.Flush();
+
+            legacyBytes += ::GetSerializeSize(txAccount, SER_DISK, CLIENT_VERSION);
+            for (const auto &item : dbOpLogMap.GetMap()) {
+                for (const auto &dbOpLog : item.second)
+                    writtenBytes += dbOpLog.GetKey().size() + dbOpLog.GetValue().size();
+            }
+        }
+        int64_t nElapsed = GetTimeMicros() - nStart;
+        BOOST_CHECK(writtenBytes < legacyBytes || tokenCount == 1);
+
+        BOOST_TEST_MESSAGE(strprintf("%u transfers of an account of %u tokens in %dus, undo bytes %u vs %u legacy",
+                                     kTransferCount, tokenCount, nElapsed, writtenBytes, legacyBytes));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
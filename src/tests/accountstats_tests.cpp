@@ -0,0 +1,156 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <boost/test/unit_test.hpp>
+#include "commons/tinyformat.h"
+#include "persistence/accountdb.h"
+#include "tests/testutil.h"
+
+using namespace std;
+
+static void UndoOpLogs(CAccountDBCache &cache, CDBOpLogMap &dbOpLogMap) {
+    UndoDataFuncMap undoDataFuncMap;
+    cache.RegisterUndoFunc(undoDataFuncMap);
+    for (const auto &item : dbOpLogMap.GetMap())
+        undoDataFuncMap[dbk::ParseKeyPrefixType(item.first)](item.second);
+}
+
+// the kept stats of the cache match the ones summed from its accounts
+static void CheckAccountStats(CAccountDBCache &cache, CAccountStats &stats) {
+    CAccountStats computedStats;
+    BOOST_CHECK(cache.GetAccountStats(stats));
+    BOOST_CHECK(cache.ComputeAccountStats(computedStats));
+    BOOST_CHECK(stats == computedStats);
+    BOOST_CHECK(!stats.needs_rebuild);
+}
+
+// a block of txs over the root cache, each tx with its own undo log
+class CTestBlock {
+public:
+    CTestBlock(CAccountDBCache &rootCache) { blockCache.SetBaseViewPtr(&rootCache); }
+
+    void WriteAccounts(const vector<CAccount> &accounts) {
+        CAccountDBCache txCache;
+        txCache.SetBaseViewPtr(&blockCache);
+        dbOpLogMaps.emplace_back();
+        txCache.SetDbOpLogMap(&dbOpLogMaps.back());
+        for (const auto &account : accounts)
+            BOOST_CHECK(txCache.SaveAccount(account));
+        txCache.Flush();
+    }
+
+    void Undo(CAccountDBCache &rootCache) {
+        CAccountDBCache undoCache;
+        undoCache.SetBaseViewPtr(&rootCache);
+        for (auto it = dbOpLogMaps.rbegin(); it != dbOpLogMaps.rend(); it++)
+            UndoOpLogs(undoCache, *it);
+        undoCache.Flush();
+    }
+
+    CAccountDBCache blockCache;
+    list<CDBOpLogMap> dbOpLogMaps;
+};
+
+BOOST_AUTO_TEST_SUITE(accountstats_tests)
+
+BOOST_AUTO_TEST_CASE(accountstats_delta_test)
+{
+    const uint32_t kAccountCount = 1000;
+    CDBAccess dbAccess("", DBNameType::ACCOUNT, true, true);
+    CAccountDBCache rootCache(&dbAccess);
+
+    vector<CAccount> accounts;
+    for (uint32_t i = 0; i < kAccountCount; i++) {
+        accounts.emplace_back(GetTestKeyId(i));
+        accounts.back().OperateBalance(SYMB::WICC, BalanceOpType::ADD_FREE, 1000 + i);
+    }
+    CTestBlock block1(rootCache);
+    block1.WriteAccounts(accounts);
+
+    // the stats of a cache include the accounts not flushed yet
+    CAccountStats stats;
+    CheckAccountStats(block1.blockCache, stats);
+    BOOST_CHECK_EQUAL(stats.account_count, kAccountCount);
+    block1.blockCache.Flush();
+    CheckAccountStats(rootCache, stats);
+    rootCache.Flush();
+    CheckAccountStats(rootCache, stats);
+    CAccountStats stats1 = stats;
+
+    // register, vote, freeze and move the coins around in a tx each
+    CTestBlock block2(rootCache);
+    for (uint32_t i = 0; i < kAccountCount; i++) {
+        CAccount &account = accounts[i];
+        if (i % 2 == 0)
+            account.regid = CRegID(100, i);
+        if (i % 3 == 0)
+            account.OperateBalance(SYMB::WICC, BalanceOpType::VOTE, 500);
+        if (i % 5 == 0)
+            account.OperateBalance(SYMB::WICC, BalanceOpType::FREEZE, 100);
+        if (i % 7 == 0)
+            account.OperateBalance(SYMB::WUSD, BalanceOpType::ADD_FREE, 10);
+        block2.WriteAccounts({account});
+    }
+    block2.blockCache.Flush();
+    rootCache.Flush();
+    CheckAccountStats(rootCache, stats);
+    BOOST_CHECK_EQUAL(stats.regid_count, kAccountCount / 2);
+    BOOST_CHECK_EQUAL(stats.supplies.size(), 2U);
+
+    // the coins keep their total however they are held
+    uint64_t totalWicc = 0;
+    for (uint32_t i = 0; i < kAccountCount; i++)
+        totalWicc += 1000 + i;
+    BOOST_CHECK_EQUAL(stats.supplies[SYMB::WICC].GetTotal(), totalWicc);
+
+    // the stats have no undo log of their own, whatever the number of tokens
+    for (auto &dbOpLogMap : block2.dbOpLogMaps)
+        BOOST_CHECK(dbOpLogMap.GetMap().count(dbk::GetKeyPrefix(dbk::ACCOUNT_STATS)) == 0);
+
+    // the undo of the block gives the stats of the block before
+    block2.Undo(rootCache);
+    CheckAccountStats(rootCache, stats);
+    BOOST_CHECK(stats == stats1);
+    rootCache.Flush();
+    CheckAccountStats(rootCache, stats);
+    BOOST_CHECK(stats == stats1);
+
+    block1.Undo(rootCache);
+    rootCache.Flush();
+    CheckAccountStats(rootCache, stats);
+    BOOST_CHECK(stats.IsEmpty());
+}
+
+BOOST_AUTO_TEST_CASE(accountstats_rebuild_test)
+{
+    // a delta not matching the kept stats is clamped and marks them
+    CAccount account(GetTestKeyId(0));
+    account.regid = CRegID(100, 0);
+    account.OperateBalance(SYMB::WICC, BalanceOpType::ADD_FREE, 1000);
+    CAccountStats stats;
+    stats.Sub(account);
+    BOOST_CHECK(stats.needs_rebuild);
+    BOOST_CHECK_EQUAL(stats.account_count, 0U);
+    BOOST_CHECK(stats.supplies.empty());
+
+    CDBAccess dbAccess("", DBNameType::ACCOUNT, true, true);
+    CAccountDBCache rootCache(&dbAccess);
+    for (uint32_t i = 0; i < 10; i++) {
+        CAccount other(GetTestKeyId(i));
+        other.OperateBalance(SYMB::WICC, BalanceOpType::ADD_FREE, 1000);
+        BOOST_CHECK(rootCache.SaveAccount(other));
+    }
+    rootCache.Flush();
+
+    // the marked stats are summed again from the accounts, the right ones are kept
+    rootCache.accountStatsCache.SetData(stats);
+    rootCache.Flush();
+    BOOST_CHECK(rootCache.BuildAccountStats());
+    CheckAccountStats(rootCache, stats);
+    BOOST_CHECK_EQUAL(stats.account_count, 10U);
+    BOOST_CHECK(rootCache.BuildAccountStats());
+    CheckAccountStats(rootCache, stats);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
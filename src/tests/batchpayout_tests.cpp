@@ -0,0 +1,83 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <boost/test/unit_test.hpp>
+#include "commons/tinyformat.h"
+#include "commons/util/time.h"
+#include "tests/testutil.h"
+#include "wallet/batchpayout.h"
+
+using namespace std;
+
+static vector<SingleTransfer> GetTestPayouts(uint32_t count) {
+    vector<SingleTransfer> payouts;
+    for (uint32_t i = 0; i < count; i++)
+        payouts.push_back(SingleTransfer(GetTestKeyId(i), SYMB::WICC, 10000 + i));
+    return payouts;
+}
+
+struct ECCSetup {
+    ECCVerifyHandle handle;
+    ECCSetup() { ECC_Start(); }
+    ~ECCSetup() { ECC_Stop(); }
+};
+
+BOOST_FIXTURE_TEST_SUITE(batchpayout_tests, ECCSetup)
+
+BOOST_AUTO_TEST_CASE(batchpayout_build_test)
+{
+    CKey key;
+    key.MakeNewKey();
+    CUserID sender(key.GetPubKey());
+
+    vector<SingleTransfer> payouts = GetTestPayouts(2 * MAX_TRANSFER_SIZE + 1);
+    auto txs = BuildPayoutTxs(sender, 100, payouts, SYMB::WUSD, 1000, "payout");
+    BOOST_CHECK_EQUAL(txs.size(), 3U);
+    BOOST_CHECK_EQUAL(txs[0]->transfers.size(), MAX_TRANSFER_SIZE);
+    BOOST_CHECK_EQUAL(txs[2]->transfers.size(), 1U);
+    BOOST_CHECK_EQUAL(txs[2]->llFees, 1000U);
+    BOOST_CHECK_EQUAL(txs[1]->llFees, 1000U * MAX_TRANSFER_SIZE);
+    BOOST_CHECK(txs[1]->fee_symbol == SYMB::WUSD && txs[1]->memo == "payout" && txs[1]->valid_height == 100);
+
+    // the payout i is in the tx i / MAX_TRANSFER_SIZE, in order
+    for (size_t i = 0; i < payouts.size(); i++) {
+        const SingleTransfer &transfer = txs[i / MAX_TRANSFER_SIZE]->transfers[i % MAX_TRANSFER_SIZE];
+        BOOST_CHECK(transfer.to_uid == payouts[i].to_uid && transfer.coin_amount == payouts[i].coin_amount);
+    }
+    BOOST_CHECK(txs[0]->GetHash() != txs[1]->GetHash());
+    BOOST_CHECK(BuildPayoutTxs(sender, 100, vector<SingleTransfer>(), SYMB::WICC, 1000, "").empty());
+}
+
+BOOST_AUTO_TEST_CASE(batchpayout_sign_benchmark)
+{
+    CKey key;
+    key.MakeNewKey();
+    CPubKey pubKey = key.GetPubKey();
+
+    // the max payouts of a batch
+    auto txs = BuildPayoutTxs(CUserID(pubKey), 100, GetTestPayouts(MAX_BATCH_PAYOUT_SIZE), SYMB::WICC, 1000, "");
+    vector<CBaseTx *> pTxs;
+    for (const auto &spTx : txs)
+        pTxs.push_back(spTx.get());
+
+    int64_t nSerial = 0;
+    for (uint32_t threadCount : {1U, 2U, 4U, MAX_BATCH_SIGN_THREADS}) {
+        for (auto pTx : pTxs)
+            pTx->signature.clear();
+
+        int64_t nStart = GetTimeMicros();
+        BOOST_CHECK(SignTxsParallel(key, pTxs, threadCount));
+        int64_t nElapsed = std::max<int64_t>(GetTimeMicros() - nStart, 1);
+        if (threadCount == 1)
+            nSerial = nElapsed;
+
+        for (auto pTx : pTxs)
+            BOOST_CHECK(pubKey.Verify(pTx->GetHash(), pTx->signature));
+
+        BOOST_TEST_MESSAGE(strprintf("signed %u txs of %u payouts on %u threads in %dus, %.2fx", pTxs.size(),
+                                     MAX_BATCH_PAYOUT_SIZE, threadCount, nElapsed, (double)nSerial / nElapsed));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
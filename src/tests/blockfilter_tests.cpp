@@ -0,0 +1,150 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <boost/test/unit_test.hpp>
+#include "chain/blockfilter.h"
+#include "chain/blockfilterindex.h"
+#include "commons/tinyformat.h"
+#include "commons/util/time.h"
+#include "config/version.h"
+#include "persistence/block.h"
+#include "tests/testutil.h"
+#include "tx/cointransfertx.h"
+
+using namespace std;
+
+// 20 bytes like a key id
+static GCSElement GetTestElement(const string &tag, uint32_t i) {
+    uint256 hash = GetTestHash(tag, i);
+    return GCSElement(hash.begin(), hash.begin() + 20);
+}
+
+static GCSElementSet GetTestElements(const string &tag, uint32_t start, uint32_t count) {
+    GCSElementSet elements;
+    for (uint32_t i = start; i < start + count; i++)
+        elements.insert(GetTestElement(tag, i));
+    return elements;
+}
+
+BOOST_AUTO_TEST_SUITE(blockfilter_tests)
+
+BOOST_AUTO_TEST_CASE(gcsfilter_match_test)
+{
+    GCSElementSet elements = GetTestElements("member", 0, 1000);
+    CBlockFilter filter(GetTestHash("block", 0), elements);
+    BOOST_CHECK_EQUAL(filter.filter.GetN(), 1000U);
+
+    for (const auto &element : elements)
+        BOOST_CHECK(filter.filter.Match(element));
+    BOOST_CHECK(filter.filter.MatchAny(GetTestElements("member", 990, 20)));
+
+    // ~P + 2 bits per element
+    BOOST_CHECK(filter.filter.GetEncoded().size() * 8 < 1000U * (BLOCK_FILTER_P + 3));
+
+    // the filter decoded from the stream matches the same elements
+    CDataStream ss(SER_DISK, CLIENT_VERSION);
+    ss << filter;
+    CBlockFilter decodedFilter;
+    ss >> decodedFilter;
+    BOOST_CHECK(decodedFilter.block_hash == filter.block_hash);
+    BOOST_CHECK(decodedFilter.GetHash() == filter.GetHash());
+    BOOST_CHECK_EQUAL(decodedFilter.filter.GetN(), 1000U);
+    for (const auto &element : elements)
+        BOOST_CHECK(decodedFilter.filter.Match(element));
+
+    // the filters of another block hash the elements with another key
+    CBlockFilter otherFilter(GetTestHash("block", 1), elements);
+    BOOST_CHECK(otherFilter.GetHash() != filter.GetHash());
+    BOOST_CHECK(filter.ComputeHeader(uint256()) != filter.ComputeHeader(otherFilter.ComputeHeader(uint256())));
+}
+
+BOOST_AUTO_TEST_CASE(gcsfilter_empty_and_bad_data_test)
+{
+    CBlockFilter emptyFilter(GetTestHash("block", 0), GCSElementSet());
+    BOOST_CHECK_EQUAL(emptyFilter.filter.GetN(), 0U);
+    BOOST_CHECK_EQUAL(emptyFilter.filter.GetEncoded().size(), 1U);
+    BOOST_CHECK(!emptyFilter.filter.Match(GetTestElement("member", 0)));
+
+    // a truncated filter never matches past the end of the data
+    CBlockFilter filter(GetTestHash("block", 0), GetTestElements("member", 0, 100));
+    vector<uint8_t> truncated(filter.filter.GetEncoded().begin(), filter.filter.GetEncoded().begin() + 10);
+    CBlockFilter truncatedFilter(filter.block_hash, truncated);
+    BOOST_CHECK_EQUAL(truncatedFilter.filter.GetN(), 100U);
+    BOOST_CHECK(!truncatedFilter.filter.Match(GetTestElement("member", 99)));
+
+    CBlockFilter noDataFilter(filter.block_hash, vector<uint8_t>());
+    BOOST_CHECK_EQUAL(noDataFilter.filter.GetN(), 0U);
+    BOOST_CHECK(!noDataFilter.filter.Match(GetTestElement("member", 0)));
+}
+
+BOOST_AUTO_TEST_CASE(blockfilter_receiver_test)
+{
+    // the senders and the receivers are taken both by key id and by regid
+    CKeyID senderKeyId = GetTestKeyId(1), receiverKeyId = GetTestKeyId(2), otherKeyId = GetTestKeyId(3);
+    CRegID senderRegId(100, 1), receiverRegId(100, 2), otherRegId(100, 3);
+    CBlock block;
+    block.vptx.push_back(make_shared<CBaseCoinTransferTx>(CUserID(senderKeyId), CUserID(receiverRegId), 100,
+                                                          COIN, 10000, ""));
+    block.vptx.push_back(make_shared<CCoinTransferTx>(CUserID(senderRegId), CUserID(receiverKeyId), 100,
+                                                      SYMB::WUSD, COIN, SYMB::WICC, 10000, ""));
+
+    GCSElementSet elements;
+    GetBlockFilterElements(block, elements);
+    BOOST_CHECK_EQUAL(elements.size(), 4U);
+    CBlockFilter filter(GetTestHash("block", 0), elements);
+
+    // a recipient that never sent finds the block with its own key only
+    BOOST_CHECK(filter.filter.Match(GCSElement(receiverKeyId.begin(), receiverKeyId.end())));
+    BOOST_CHECK(filter.filter.Match(receiverRegId.GetRegIdRaw()));
+    BOOST_CHECK(filter.filter.Match(GCSElement(senderKeyId.begin(), senderKeyId.end())));
+    BOOST_CHECK(filter.filter.Match(senderRegId.GetRegIdRaw()));
+    BOOST_CHECK(!filter.filter.Match(GCSElement(otherKeyId.begin(), otherKeyId.end())));
+    BOOST_CHECK(!filter.filter.Match(otherRegId.GetRegIdRaw()));
+}
+
+BOOST_AUTO_TEST_CASE(gcsfilter_false_positive_rate_test)
+{
+    // 1000 filters of 100 elements, each queried with 1000 other elements:
+    // 1M queries with a false positive rate of 1/M, ~1.3 false positives expected
+    const uint32_t filterCount = 1000;
+    const uint32_t queryCount  = 1000;
+    uint32_t falsePositives = 0;
+    for (uint32_t i = 0; i < filterCount; i++) {
+        CBlockFilter filter(GetTestHash("block", i), GetTestElements(strprintf("member%u", i), 0, 100));
+        if (filter.filter.MatchAny(GetTestElements(strprintf("query%u", i), 0, queryCount)))
+            falsePositives++;
+    }
+
+    BOOST_TEST_MESSAGE(strprintf("false positives: %u of %u queries, expected %.2f", falsePositives,
+                                 filterCount * queryCount, (double)filterCount * queryCount / BLOCK_FILTER_M));
+    BOOST_CHECK(falsePositives <= 10);
+}
+
+BOOST_AUTO_TEST_CASE(gcsfilter_build_throughput_test)
+{
+    // blocks of 200 involved accounts
+    const uint32_t blockCount   = 2000;
+    const uint32_t elementCount = 200;
+    vector<GCSElementSet> blockElements;
+    for (uint32_t i = 0; i < blockCount; i++)
+        blockElements.push_back(GetTestElements(strprintf("member%u", i), 0, elementCount));
+
+    int64_t nStart    = GetTimeMicros();
+    uint64_t nBytes   = 0;
+    uint256 header;
+    for (uint32_t i = 0; i < blockCount; i++) {
+        CBlockFilter filter(GetTestHash("block", i), blockElements[i]);
+        header = filter.ComputeHeader(header);
+        nBytes += filter.filter.GetEncoded().size();
+    }
+    int64_t nElapsed = std::max<int64_t>(GetTimeMicros() - nStart, 1);
+
+    BOOST_TEST_MESSAGE(strprintf("built %u filters of %u elements in %dus, %.0f filters/s, %.2f bytes/element",
+                                 blockCount, elementCount, nElapsed, blockCount * 1000000.0 / nElapsed,
+                                 (double)nBytes / (blockCount * elementCount)));
+    BOOST_CHECK(!header.IsNull());
+    BOOST_CHECK(nBytes < (uint64_t)blockCount * elementCount * 3);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
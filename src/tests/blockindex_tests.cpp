@@ -0,0 +1,142 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <boost/test/unit_test.hpp>
+#include "commons/tinyformat.h"
+#include "commons/util/time.h"
+#include "commons/util/util.h"
+#include "persistence/block.h"
+#include "tests/testutil.h"
+
+using namespace std;
+
+static vector<uint256> GetTestHashes(uint32_t count) {
+    vector<uint256> hashes;
+    hashes.reserve(count);
+    for (uint32_t i = 0; i < count; i++)
+        hashes.push_back(GetTestHash("block", i));
+    return hashes;
+}
+
+BOOST_AUTO_TEST_SUITE(blockindex_tests)
+
+BOOST_AUTO_TEST_CASE(blockindex_arena_test)
+{
+    const uint32_t kBlockCount = 500000;
+    vector<uint256> hashes = GetTestHashes(kBlockCount);
+
+    // the arena goes first, its slabs are given back to the system when cleared
+    uint64_t nMemStart = GetResidentMemory();
+    int64_t nStart     = GetTimeMicros();
+    CBlockIndexArena arena;
+    BlockMap mapIndex;
+    CBlockIndex *pprev = nullptr;
+    for (uint32_t i = 0; i < kBlockCount; i++) {
+        CBlockIndex *pIndex = arena.New();
+        pIndex->blockHash   = hashes[i];
+        pIndex->pprev       = pprev;
+        pIndex->height      = i;
+        BOOST_CHECK(mapIndex.insert(pIndex));
+        pprev = pIndex;
+    }
+    int64_t nArena     = GetTimeMicros() - nStart;
+    uint64_t nArenaMem = GetResidentMemory() - nMemStart;
+
+    BOOST_CHECK_EQUAL(arena.Size(), kBlockCount);
+    BOOST_CHECK_EQUAL(mapIndex.size(), kBlockCount);
+
+    // the indexes stay in place while the map grows
+    for (uint32_t i = 0; i < kBlockCount; i += 997) {
+        CBlockIndex *pIndex = mapIndex[hashes[i]];
+        BOOST_CHECK(pIndex->GetBlockHash() == hashes[i] && pIndex->height == (int32_t)i);
+        BOOST_CHECK(i == 0 || pIndex->pprev->GetBlockHash() == hashes[i - 1]);
+    }
+
+    nStart = GetTimeMicros();
+    mapIndex.clear();
+    arena.Clear();
+    int64_t nArenaClear = GetTimeMicros() - nStart;
+    BOOST_CHECK_EQUAL(arena.Size(), 0U);
+
+    // what the loading did before: one allocation per index in a tree, keyed by a copy of the hash
+    nMemStart = GetResidentMemory();
+    nStart    = GetTimeMicros();
+    map<uint256, CBlockIndex *> mapTree;
+    pprev = nullptr;
+    for (const auto &hash : hashes) {
+        CBlockIndex *pIndex = new CBlockIndex();
+        pIndex->blockHash   = hash;
+        pIndex->pprev       = pprev;
+        mapTree.emplace(hash, pIndex);
+        pprev = pIndex;
+    }
+    int64_t nTree    = GetTimeMicros() - nStart;
+    uint64_t nTreeMem = GetResidentMemory() - nMemStart;
+
+    nStart = GetTimeMicros();
+    for (auto &item : mapTree)
+        delete item.second;
+    map<uint256, CBlockIndex *>().swap(mapTree);
+    int64_t nTreeClear = GetTimeMicros() - nStart;
+
+    BOOST_TEST_MESSAGE(strprintf("%u block indexes: map of heap indexes %dus, clear %dus, %lluKB resident", kBlockCount,
+                                 nTree, nTreeClear, nTreeMem >> 10));
+    BOOST_TEST_MESSAGE(strprintf("%u block indexes: arena with hash map %dus, clear %dus, %lluKB resident", kBlockCount,
+                                 nArena, nArenaClear, nArenaMem >> 10));
+    BOOST_TEST_MESSAGE(strprintf("sizeof(CBlockIndex)=%u", sizeof(CBlockIndex)));
+}
+
+BOOST_AUTO_TEST_CASE(blockmap_test)
+{
+    // the hashes of a group share the low 64 bits, so they probe the same slots
+    const uint32_t kGroupCount = 64;
+    const uint32_t kGroupSize  = 8;
+    vector<uint256> hashes = GetTestHashes(kGroupCount * kGroupSize);
+    for (uint32_t i = 0; i < hashes.size(); i++) {
+        if (i % kGroupSize != 0)
+            memcpy(hashes[i].begin(), hashes[i - i % kGroupSize].begin(), 8);
+    }
+
+    CBlockIndexArena arena;
+    BlockMap mapIndex;
+    for (const auto &hash : hashes) {
+        CBlockIndex *pIndex = arena.New();
+        pIndex->blockHash   = hash;
+        BOOST_CHECK(mapIndex.insert(pIndex));
+        BOOST_CHECK(!mapIndex.insert(pIndex));
+    }
+    BOOST_CHECK_EQUAL(mapIndex.size(), hashes.size());
+    BOOST_CHECK(mapIndex[uint256()] == nullptr);
+    BOOST_CHECK(mapIndex.find(uint256()) == mapIndex.end());
+
+    // erase every other one of the groups, the rest of the probe sequences is still found
+    set<uint256> erased;
+    for (uint32_t i = 0; i < hashes.size(); i += 2) {
+        BOOST_CHECK_EQUAL(mapIndex.erase(hashes[i]), 1U);
+        BOOST_CHECK_EQUAL(mapIndex.erase(hashes[i]), 0U);
+        erased.insert(hashes[i]);
+    }
+    BOOST_CHECK_EQUAL(mapIndex.size(), hashes.size() / 2);
+    for (const auto &hash : hashes) {
+        BOOST_CHECK_EQUAL(mapIndex.count(hash), erased.count(hash) ? 0U : 1U);
+        BOOST_CHECK(erased.count(hash) || mapIndex[hash]->GetBlockHash() == hash);
+    }
+
+    // the iteration lists each entry once
+    set<uint256> listed;
+    for (const auto &item : mapIndex) {
+        BOOST_CHECK(item.first == item.second->GetBlockHash());
+        BOOST_CHECK(listed.insert(item.first).second);
+    }
+    BOOST_CHECK_EQUAL(listed.size(), mapIndex.size());
+
+    mapIndex.reserve(100000);
+    for (const auto &hash : hashes)
+        BOOST_CHECK_EQUAL(mapIndex.count(hash), erased.count(hash) ? 0U : 1U);
+
+    mapIndex.clear();
+    BOOST_CHECK(mapIndex.empty() && mapIndex.begin() == mapIndex.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
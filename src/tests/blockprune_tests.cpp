@@ -0,0 +1,65 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <boost/test/unit_test.hpp>
+#include "persistence/disk.h"
+
+using namespace std;
+
+// a block file holding the blocks [heightFirst, heightLast], empty once pruned
+static CBlockFileInfo GetTestFileInfo(uint32_t heightFirst, uint32_t heightLast, bool fPruned = false) {
+    CBlockFileInfo info;
+    if (!fPruned) {
+        info.nBlocks      = heightLast - heightFirst + 1;
+        info.nSize        = info.nBlocks * 1000;
+        info.nHeightFirst = heightFirst;
+        info.nHeightLast  = heightLast;
+    }
+    return info;
+}
+
+BOOST_AUTO_TEST_SUITE(blockprune_tests)
+
+BOOST_AUTO_TEST_CASE(prune_height_test)
+{
+    // the retention depth below the tip
+    BOOST_CHECK_EQUAL(GetPruneHeight(10000, 2880, 9990), 10000 - 2880);
+    // never reaching the global finality block
+    BOOST_CHECK_EQUAL(GetPruneHeight(10000, 2880, 5000), 4999);
+    // nothing before a finality block or when the chain is shorter than the depth
+    BOOST_CHECK_EQUAL(GetPruneHeight(10000, 2880, -1), -1);
+    BOOST_CHECK(GetPruneHeight(1000, 2880, 990) < 0);
+}
+
+BOOST_AUTO_TEST_CASE(prune_file_selection_test)
+{
+    // the files 0-1 are pruned already, the file 3 was written out of order by a reorg
+    vector<CBlockFileInfo> infos = {GetTestFileInfo(0, 99, true), GetTestFileInfo(100, 199, true),
+                                    GetTestFileInfo(200, 299),    GetTestFileInfo(300, 650),
+                                    GetTestFileInfo(400, 499),    GetTestFileInfo(500, 599)};
+
+    // only the whole files at or below the height, the first unpruned file stops at the file 3
+    int32_t firstFile = 0;
+    set<int32_t> prunedFiles;
+    SelectBlockFilesToPrune(infos, 550, firstFile, prunedFiles);
+    BOOST_CHECK(prunedFiles == set<int32_t>({2, 4}));
+    BOOST_CHECK_EQUAL(firstFile, 3);
+
+    // the next call starts from the first unpruned file
+    infos.erase(infos.begin(), infos.begin() + firstFile);
+    infos[1] = GetTestFileInfo(400, 499, true);
+    prunedFiles.clear();
+    SelectBlockFilesToPrune(infos, 700, firstFile, prunedFiles);
+    BOOST_CHECK(prunedFiles == set<int32_t>({3, 5}));
+    BOOST_CHECK_EQUAL(firstFile, 6);
+
+    // nothing below the first block
+    firstFile = 0;
+    prunedFiles.clear();
+    SelectBlockFilesToPrune({GetTestFileInfo(0, 99)}, -1, firstFile, prunedFiles);
+    BOOST_CHECK(prunedFiles.empty());
+    BOOST_CHECK_EQUAL(firstFile, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -9,6 +9,7 @@
 #include <map>
 #include <boost/test/unit_test.hpp>
 #include "persistence/dbaccess.h"
+#include "persistence/dbiterator.h"
 
 using namespace std;
 
@@ -144,6 +145,43 @@ BOOST_AUTO_TEST_CASE(dbcache_scalar_value_Level3_test)
     BOOST_CHECK( value1 == "keyid-1" );
 }
 
+BOOST_AUTO_TEST_CASE(dbcache_db_value_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::ACCOUNT, false, isWipe);
+
+    auto pDBCache1 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBAccess.get());
+    auto pDBCache2 = make_shared< CCompositeKVCache<prefix, string, string> >(pDBCache1.get());
+    pDBCache1->SetData("regid-1", "keyid-1");
+    pDBCache1->Flush();
+    pDBCache2->SetData("regid-2", "keyid-2");
+
+    // the values are read through the caches as the db keeps them, the unflushed ones too
+    DbValueFuncMap dbValueFuncMap;
+    pDBCache2->RegisterDbValueFunc(dbValueFuncMap);
+    string value1 = "keyid-1", value2 = "keyid-2", value;
+    BOOST_CHECK(dbValueFuncMap[prefix](dbk::GenDbKey(prefix, string("regid-1")), value));
+    BOOST_CHECK(value == db_util::SerializeValue(&value1));
+    BOOST_CHECK(dbValueFuncMap[prefix](dbk::GenDbKey(prefix, string("regid-2")), value));
+    BOOST_CHECK(value == db_util::SerializeValue(&value2));
+    BOOST_CHECK(!pDBAccess->GetData(prefix, string("regid-2"), value));
+    BOOST_CHECK(!dbValueFuncMap[prefix](dbk::GenDbKey(prefix, string("regid-3")), value));
+    BOOST_CHECK(!dbValueFuncMap[prefix](dbk::GenDbKey(dbk::KEYID_ACCOUNT, string("regid-1")), value));
+
+    // the op logs record the state deltas only when they are asked for
+    CDBOpLogMap dbOpLogMap;
+    pDBCache2->SetDbOpLogMap(&dbOpLogMap);
+    pDBCache2->SetData("regid-3", "keyid-3");
+    BOOST_CHECK(dbOpLogMap.GetStateDeltas().empty());
+    fRecordStateDeltas = true;
+    pDBCache2->SetData("regid-4", "keyid-4");
+    fRecordStateDeltas = false;
+    BOOST_CHECK(dbOpLogMap.GetStateDeltas().at(prefix).size() == 1);
+    BOOST_CHECK(dbOpLogMap.GetDbOpLogsPtr(prefix)->size() == 2);
+}
+
 template <typename T>
 static uint32_t GetSerSize(const T &t) {
     return ::GetSerializeSize(t, SER_DISK, CLIENT_VERSION);
@@ -181,4 +219,48 @@ BOOST_AUTO_TEST_CASE(dbcache_cache_size_test)
     BOOST_CHECK(!pDBCache2->IsCalcSize() && pDBCache2->GetCacheSize() == 0);
 }
 
+BOOST_AUTO_TEST_CASE(dbcache_page_getter_test)
+{
+    const bool isWipe = true;
+    const dbk::PrefixType prefix = dbk::REGID_KEYID;
+    typedef CCompositeKVCache<prefix, string, string> CacheType;
+    shared_ptr<CDBAccess> pDBAccess = make_shared<CDBAccess>(
+        db_dir, DBNameType::ACCOUNT, false, isWipe);
+
+    auto pDBCache1 = make_shared<CacheType>(pDBAccess.get());
+    for (int32_t i = 0; i < 10; i++)
+        pDBCache1->SetData(strprintf("regid-%d", i), strprintf("keyid-%d", i));
+    pDBCache1->Flush();
+
+    // the upper layer overrides, erases and adds elements over the db; the keys are of one size,
+    // the db orders the serialized strings by their size first
+    auto pDBCache2 = make_shared<CacheType>(pDBCache1.get());
+    pDBCache2->SetData("regid-2", "keyid-2b");
+    pDBCache2->EraseData("regid-5");
+    pDBCache2->SetData("regid-A", "keyid-A");
+
+    vector<pair<string, string>> pages;
+    CDBIterator<CacheType> it(*pDBCache2);
+    CDBPageGetter<CDBIterator<CacheType>> getter(it);
+    string lastPosInfo;
+    do {
+        string lastKey;
+        BOOST_CHECK(CDBPageGetter<CDBIterator<CacheType>>::ParseLastPos(lastPosInfo, lastKey));
+        getter.Execute(lastKey, 3);
+        BOOST_CHECK(getter.data_list.size() <= 3);
+        pages.insert(pages.end(), getter.data_list.begin(), getter.data_list.end());
+        lastPosInfo = CDBPageGetter<CDBIterator<CacheType>>::MakeLastPos(getter.last_key);
+    } while (getter.has_more);
+
+    BOOST_CHECK_EQUAL(pages.size(), 10U);
+    BOOST_CHECK(pages[2].first == "regid-2" && pages[2].second == "keyid-2b");
+    BOOST_CHECK(pages[5].first == "regid-6");
+    BOOST_CHECK(pages[9].first == "regid-A" && pages[9].second == "keyid-A");
+    for (size_t i = 1; i < pages.size(); i++)
+        BOOST_CHECK(pages[i - 1].first < pages[i].first);
+
+    string lastKey;
+    BOOST_CHECK(!CDBPageGetter<CDBIterator<CacheType>>::ParseLastPos("\xff", lastKey));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
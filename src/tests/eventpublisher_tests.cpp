@@ -0,0 +1,117 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <boost/test/unit_test.hpp>
+#include "chain/eventpublisher.h"
+#include "commons/json/json_spirit_reader_template.h"
+#include "commons/json/json_spirit_utils.h"
+
+using namespace std;
+
+// the json of the front frame queued for the subscriber
+static Object PopFrame(CEventSubscriber &subscriber) {
+    string payload;
+    BOOST_REQUIRE(!subscriber.sendQueue.empty());
+    const string &frame = *subscriber.sendQueue.front();
+    BOOST_CHECK_EQUAL(ReadEventFrame(frame, payload), (int64_t)frame.size());
+    subscriber.queuedBytes -= frame.size();
+    subscriber.sendQueue.pop_front();
+
+    Value value;
+    BOOST_REQUIRE(read_string(payload, value) && value.type() == obj_type);
+    return value.get_obj();
+}
+
+BOOST_AUTO_TEST_SUITE(eventpublisher_tests)
+
+BOOST_AUTO_TEST_CASE(eventpublisher_topic_test)
+{
+    EventTopic topic;
+    for (uint8_t i = 0; i < EVENT_TOPIC_COUNT; i++) {
+        BOOST_CHECK(ParseEventTopic(GetEventTopicName((EventTopic)i), topic));
+        BOOST_CHECK_EQUAL(topic, i);
+    }
+    BOOST_CHECK(!ParseEventTopic("dropped", topic));
+    BOOST_CHECK(!ParseEventTopic("", topic));
+}
+
+BOOST_AUTO_TEST_CASE(eventpublisher_frame_test)
+{
+    string payload;
+    string frame = WriteEventFrame("{\"topics\":[]}");
+    BOOST_CHECK_EQUAL(frame.size(), 17U);
+    BOOST_CHECK_EQUAL(frame.substr(0, 4), string("\0\0\0\x0d", 4));
+
+    // the size comes first, the payload waits for all of its bytes
+    for (size_t size = 0; size < frame.size(); size++)
+        BOOST_CHECK_EQUAL(ReadEventFrame(frame.substr(0, size), payload), 0);
+    BOOST_CHECK_EQUAL(ReadEventFrame(frame + frame, payload), 17);
+    BOOST_CHECK_EQUAL(payload, "{\"topics\":[]}");
+
+    BOOST_CHECK_EQUAL(ReadEventFrame(WriteEventFrame(string(MAX_EVENT_REQUEST_SIZE, ' ')), payload),
+                      4 + MAX_EVENT_REQUEST_SIZE);
+    BOOST_CHECK_EQUAL(ReadEventFrame(string("\0\x01\0\x01", 4), payload), -1);
+}
+
+BOOST_AUTO_TEST_CASE(eventpublisher_request_test)
+{
+    CEventSubscriber subscriber(INVALID_SOCKET, "test");
+    BOOST_CHECK(CEventPublisher::ProcessRequest(
+        subscriber, "{\"topics\":[\"txremoved\",\"accountchanged\"],\"addresses\":[\"addr1\",\"addr2\"]}"));
+    BOOST_CHECK_EQUAL(subscriber.topicMask, (1U << EVENT_TX_REMOVED) | (1U << EVENT_ACCOUNT_CHANGED));
+    BOOST_CHECK_EQUAL(subscriber.addresses.size(), 2U);
+
+    // a bad request keeps the subscription
+    for (const string &request : {"", "[]", "{\"topics\":\"txremoved\"}", "{\"topics\":[1]}", "{\"topics\":[\"other\"]}"})
+        BOOST_CHECK(!CEventPublisher::ProcessRequest(subscriber, request));
+    BOOST_CHECK_EQUAL(subscriber.topicMask, (1U << EVENT_TX_REMOVED) | (1U << EVENT_ACCOUNT_CHANGED));
+
+    // a later request replaces the subscription
+    BOOST_CHECK(CEventPublisher::ProcessRequest(subscriber, "{\"topics\":[\"blockconnected\"]}"));
+    BOOST_CHECK_EQUAL(subscriber.topicMask, 1U << EVENT_BLOCK_CONNECTED);
+    BOOST_CHECK(subscriber.addresses.empty());
+}
+
+BOOST_AUTO_TEST_CASE(eventpublisher_dispatch_test)
+{
+    CEventPublisher publisher;
+    auto spRemoved = make_shared<CEventSubscriber>(INVALID_SOCKET, "removed");
+    auto spBlocks  = make_shared<CEventSubscriber>(INVALID_SOCKET, "blocks");
+    BOOST_CHECK(CEventPublisher::ProcessRequest(*spRemoved, "{\"topics\":[\"txremoved\"]}"));
+    BOOST_CHECK(CEventPublisher::ProcessRequest(*spBlocks, "{\"topics\":[\"blockconnected\"]}"));
+    publisher.AddSubscriber(spRemoved);
+    publisher.AddSubscriber(spBlocks);
+    BOOST_CHECK(publisher.HasSubscribers(EVENT_TX_REMOVED));
+    BOOST_CHECK(!publisher.HasSubscribers(EVENT_TX_ACCEPTED));
+
+    // seq counts the frames of each subscriber, the events of the others leave no gap
+    publisher.TxRemoved(uint256(), "expired");
+    publisher.TxRemoved(uint256(), "conflict");
+    publisher.DispatchEvents();
+    BOOST_CHECK(spBlocks->sendQueue.empty());
+    BOOST_CHECK_EQUAL(spRemoved->sendQueue.size(), 2U);
+    for (uint64_t seq = 0; seq < 2; seq++) {
+        Object obj = PopFrame(*spRemoved);
+        BOOST_CHECK_EQUAL(find_value(obj, "seq").get_uint64(), seq);
+        BOOST_CHECK_EQUAL(find_value(obj, "topic").get_str(), "txremoved");
+    }
+
+    // the events dropped from a full queue are told before the ones kept
+    const uint32_t kDroppedCount = 5;
+    for (uint32_t i = 0; i < MAX_EVENT_QUEUE_SIZE + kDroppedCount; i++)
+        publisher.TxRemoved(uint256(), "expired");
+    publisher.DispatchEvents();
+    BOOST_CHECK(spBlocks->sendQueue.empty());
+    BOOST_CHECK_EQUAL(spRemoved->sendQueue.size(), MAX_EVENT_QUEUE_SIZE + 1);
+    Object obj = PopFrame(*spRemoved);
+    BOOST_CHECK_EQUAL(find_value(obj, "seq").get_uint64(), 2U);
+    BOOST_CHECK_EQUAL(find_value(obj, "topic").get_str(), "dropped");
+    BOOST_CHECK_EQUAL(find_value(find_value(obj, "data").get_obj(), "count").get_uint64(), kDroppedCount);
+    obj = PopFrame(*spRemoved);
+    BOOST_CHECK_EQUAL(find_value(obj, "seq").get_uint64(), 3U);
+    BOOST_CHECK_EQUAL(find_value(obj, "topic").get_str(), "txremoved");
+    BOOST_CHECK(!spRemoved->fDisconnect);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,81 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <boost/test/unit_test.hpp>
+#include <boost/thread.hpp>
+#include "commons/metrics.h"
+#include "commons/tinyformat.h"
+#include "commons/util/time.h"
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(metrics_tests)
+
+BOOST_AUTO_TEST_CASE(metrics_histogram_test)
+{
+    static CMetricHistogram histogram;
+    static CMetricCounter counter;
+    CMetricsRegistry registry;
+    registry.AddHistogram("test_latency_seconds", "Test latency", histogram);
+    registry.AddCounter("test_total", "Test counter", counter);
+    registry.AddGauge("test_gauge", "Test gauge", []() -> int64_t { return -7; });
+
+    // the bounds are inclusive, the last bucket holds what exceeds all of them
+    for (int64_t micros : {0, 50, 51, 1000, 20000000})
+        histogram.Observe(micros);
+    counter.Inc(3);
+
+    BOOST_CHECK_EQUAL(histogram.GetBucket(0), 2U);
+    BOOST_CHECK_EQUAL(histogram.GetBucket(1), 1U);
+    BOOST_CHECK_EQUAL(histogram.GetBucket(4), 1U);
+    BOOST_CHECK_EQUAL(histogram.GetBucket(CMetricHistogram::BUCKET_COUNT), 1U);
+    BOOST_CHECK_EQUAL(histogram.GetSum(), 20001101);
+
+    vector<CMetricSample> samples = registry.GetSamples();
+    BOOST_CHECK_EQUAL(samples.size(), 3U);
+    BOOST_CHECK_EQUAL(samples[0].count, 5U);
+    BOOST_CHECK_EQUAL(samples[1].value, 3);
+    BOOST_CHECK_EQUAL(samples[2].value, -7);
+
+    string text = registry.ToText();
+    BOOST_CHECK(text.find("# TYPE test_latency_seconds histogram\n") != string::npos);
+    BOOST_CHECK(text.find("test_latency_seconds_bucket{le=\"5e-05\"} 2\n") != string::npos);
+    BOOST_CHECK(text.find("test_latency_seconds_bucket{le=\"0.001\"} 4\n") != string::npos);
+    BOOST_CHECK(text.find("test_latency_seconds_bucket{le=\"+Inf\"} 5\n") != string::npos);
+    BOOST_CHECK(text.find("test_latency_seconds_count 5\n") != string::npos);
+    BOOST_CHECK(text.find("test_total 3\n") != string::npos);
+    BOOST_CHECK(text.find("test_gauge -7\n") != string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(metrics_overhead_benchmark)
+{
+    static CMetricHistogram histogram;
+    const uint32_t kOpCount   = 1000000;
+    const uint32_t kThreadCount = 4;
+
+    // a timed scope on each of the threads at once, the worst case of the shared cache lines
+    int64_t nStart = GetTimeMicros();
+    boost::thread_group workers;
+    for (uint32_t i = 0; i < kThreadCount; i++) {
+        workers.create_thread([&]() {
+            for (uint32_t n = 0; n < kOpCount; n++) {
+                CMetricTimer timer(histogram);
+            }
+        });
+    }
+    workers.join_all();
+    int64_t nElapsed = GetTimeMicros() - nStart;
+
+    uint64_t count = 0;
+    for (uint32_t i = 0; i <= CMetricHistogram::BUCKET_COUNT; i++)
+        count += histogram.GetBucket(i);
+    BOOST_CHECK_EQUAL(count, (uint64_t)kOpCount * kThreadCount);
+
+    // a connected block or an accepted tx takes hundreds of microseconds, the timer is to stay well
+    // under 1% of that; reported only, the wall clock of a shared builder is no pass criterion
+    double nsPerOp = nElapsed * 1000.0 / kOpCount;
+    BOOST_TEST_MESSAGE(strprintf("timed scope on %u threads: %.1fns", kThreadCount, nsPerOp));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
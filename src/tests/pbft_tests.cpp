@@ -0,0 +1,116 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "main.h"
+
+#include <set>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "miner/pbftcontext.h"
+#include "p2p/protocol.h"
+#include "tests/testutil.h"
+
+using namespace std;
+
+static const uint32_t DELEGATE_COUNT = 11;
+static const uint32_t BLOCK_COUNT    = 200;
+
+static DelegateSetPtr GetTestDelegates() {
+    auto spDelegates = std::make_shared<set<CRegID>>();
+    for (uint32_t i = 0; i < DELEGATE_COUNT; i++)
+        spDelegates->insert(CRegID(1, i));
+    return spDelegates;
+}
+
+// the even miners are delegates, the odd ones are not
+static CRegID GetTestMiner(uint32_t i) {
+    return (i % 2 == 0) ? CRegID(1, (i / 2) % DELEGATE_COUNT) : CRegID(2, (i / 2) % DELEGATE_COUNT);
+}
+
+template <typename MsgType>
+static void FloodMessages(CPBFTMessageMan<MsgType> &msgMan, const DelegateSetPtr &spDelegates, uint32_t rounds) {
+    for (uint32_t round = 0; round < rounds; round++) {
+        for (uint32_t height = 1; height <= BLOCK_COUNT; height++) {
+            for (uint32_t i = 0; i < DELEGATE_COUNT * 2; i++) {
+                MsgType msg(height, GetTestHash("block", height), GetTestHash("block", height - 1));
+                msg.miner = GetTestMiner(i);
+                uint32_t voteCount = msgMan.SaveMessageByBlock(msg.blockHash, msg, spDelegates);
+                BOOST_CHECK(voteCount <= DELEGATE_COUNT);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(pbft_tests)
+
+BOOST_AUTO_TEST_CASE(block_tally_test)
+{
+    DelegateSetPtr spDelegates = GetTestDelegates();
+
+    CPBFTBlockTally tally;
+    BOOST_CHECK(tally.AddVote(CRegID(1, 0)));
+    BOOST_CHECK(tally.AddVote(CRegID(2, 0)));
+    BOOST_CHECK(!tally.AddVote(CRegID(1, 0)));
+    // the delegates are unknown yet
+    BOOST_CHECK_EQUAL(tally.delegateVoteCount, 0U);
+
+    tally.SetDelegates(spDelegates);
+    BOOST_CHECK_EQUAL(tally.delegateVoteCount, 1U);
+
+    BOOST_CHECK(tally.AddVote(CRegID(1, 1)));
+    BOOST_CHECK(tally.AddVote(CRegID(2, 1)));
+    BOOST_CHECK_EQUAL(tally.delegateVoteCount, 2U);
+    BOOST_CHECK_EQUAL(tally.voters.size(), 4U);
+
+    // the delegates are counted only once
+    tally.SetDelegates(GetTestDelegates());
+    BOOST_CHECK_EQUAL(tally.delegateVoteCount, 2U);
+}
+
+BOOST_AUTO_TEST_CASE(flood_confirm_messages_test)
+{
+    DelegateSetPtr spDelegates = GetTestDelegates();
+    CPBFTMessageMan<CBlockConfirmMessage> msgMan(BLOCK_COUNT);
+
+    // 200 blocks * 22 miners * 5 rounds, most of them are duplicated
+    FloodMessages(msgMan, spDelegates, 5);
+
+    for (uint32_t height = 1; height <= BLOCK_COUNT; height++) {
+        uint256 blockHash = GetTestHash("block", height);
+        BOOST_CHECK_EQUAL(msgMan.GetVoterCount(blockHash), DELEGATE_COUNT * 2);
+        BOOST_CHECK_EQUAL(msgMan.GetVoteCount(blockHash, spDelegates), DELEGATE_COUNT);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(flood_finality_messages_before_delegates_test)
+{
+    DelegateSetPtr spDelegates = GetTestDelegates();
+    CPBFTMessageMan<CBlockFinalityMessage> msgMan(BLOCK_COUNT);
+
+    // the delegates of the blocks are unknown when the messages arrive
+    FloodMessages(msgMan, nullptr, 3);
+
+    for (uint32_t height = 1; height <= BLOCK_COUNT; height++) {
+        uint256 blockHash = GetTestHash("block", height);
+        BOOST_CHECK_EQUAL(msgMan.GetVoteCount(blockHash, nullptr), 0U);
+        BOOST_CHECK_EQUAL(msgMan.GetVoteCount(blockHash, spDelegates), DELEGATE_COUNT);
+        BOOST_CHECK_EQUAL(msgMan.GetVoteCount(blockHash, nullptr), DELEGATE_COUNT);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(tally_limit_test)
+{
+    DelegateSetPtr spDelegates = GetTestDelegates();
+    CPBFTMessageMan<CBlockConfirmMessage> msgMan(BLOCK_COUNT / 2);
+
+    FloodMessages(msgMan, spDelegates, 1);
+
+    // only the latest blocks are kept
+    BOOST_CHECK_EQUAL(msgMan.GetVoterCount(GetTestHash("block", 1)), 0U);
+    BOOST_CHECK_EQUAL(msgMan.GetVoteCount(GetTestHash("block", BLOCK_COUNT / 2), spDelegates), 0U);
+    BOOST_CHECK_EQUAL(msgMan.GetVoteCount(GetTestHash("block", BLOCK_COUNT / 2 + 1), spDelegates), DELEGATE_COUNT);
+    BOOST_CHECK_EQUAL(msgMan.GetVoteCount(GetTestHash("block", BLOCK_COUNT), spDelegates), DELEGATE_COUNT);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,130 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+#include "persistence/snapshot.h"
+#include "tests/testutil.h"
+
+using namespace std;
+
+// the parts of a snapshot as ExportStateSnapshot() writes them, with byte strings for the undo
+struct CTestSnapshot {
+    CSnapshotHeader header;
+    vector<CSnapshotEntry> entries;
+    vector<uint256> blockHashes;
+    vector<vector<unsigned char>> undos;
+
+    CTestSnapshot() {
+        header.height      = 9;
+        header.block_hash  = GetTestHash("block", 9);
+        header.block_count = 3;
+
+        CDataStream ds(SER_DISK, CLIENT_VERSION);
+        ds << header.block_hash;
+        entries.emplace_back(DBNameType::ACCOUNT, "acct1", "value1");
+        entries.emplace_back(DBNameType::ACCOUNT, "acct2", "value2");
+        entries.emplace_back(DBNameType::BLOCK, dbk::GetKeyPrefix(dbk::BEST_BLOCKHASH), ds.str());
+        for (uint32_t i = 0; i <= 9; i++)
+            blockHashes.push_back(GetTestHash("block", i));
+        for (uint32_t i = 0; i < header.block_count; i++)
+            undos.push_back(vector<unsigned char>(100, i));
+    }
+
+    uint256 Write(const string &fileName) const {
+        CSnapshotWriter writer(fopen(fileName.c_str(), "wb"));
+        writer << header;
+        for (const auto &entry : entries)
+            writer.WriteEntry(entry);
+        writer.WriteEntry(CSnapshotEntry());
+        for (const auto &hash : blockHashes) {
+            writer << hash;
+            writer.AddStateHash(hash);
+        }
+        for (const auto &undo : undos)
+            writer.WriteState(undo);
+        return writer.Finish();
+    }
+
+    bool Read(const string &fileName, uint256 &stateHash) {
+        CSnapshotReader reader(fopen(fileName.c_str(), "rb"));
+        reader >> header;
+        entries.clear();
+        CSnapshotEntry entry;
+        for (reader.ReadEntry(entry); !entry.IsEnd(); reader.ReadEntry(entry))
+            entries.push_back(entry);
+        for (auto &hash : blockHashes) {
+            reader >> hash;
+            reader.AddStateHash(hash);
+        }
+        for (auto &undo : undos)
+            reader.ReadState(undo);
+        return reader.Finish(stateHash);
+    }
+};
+
+BOOST_AUTO_TEST_SUITE(snapshot_tests)
+
+BOOST_AUTO_TEST_CASE(snapshot_export_import_test)
+{
+    string fileName = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+    CTestSnapshot snapshot;
+    uint256 stateHash = snapshot.Write(fileName);
+
+    CTestSnapshot imported;
+    imported.entries.clear();
+    imported.undos.assign(snapshot.undos.size(), vector<unsigned char>());
+    uint256 importedHash;
+    BOOST_CHECK(imported.Read(fileName, importedHash));
+    BOOST_CHECK(importedHash == stateHash);
+    BOOST_CHECK(imported.header.block_hash == snapshot.header.block_hash);
+    BOOST_CHECK_EQUAL(imported.entries.size(), snapshot.entries.size());
+    BOOST_CHECK(imported.undos == snapshot.undos);
+
+    // the state is of the block in the header
+    uint256 bestBlockHash;
+    BOOST_CHECK(!GetSnapshotBestBlockHash(imported.entries[0], bestBlockHash));
+    BOOST_CHECK(GetSnapshotBestBlockHash(imported.entries.back(), bestBlockHash));
+    BOOST_CHECK(bestBlockHash == imported.header.block_hash);
+
+    boost::filesystem::remove(fileName);
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_tamper_test)
+{
+    string fileName = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path()).string();
+    CTestSnapshot snapshot;
+    uint256 stateHash = snapshot.Write(fileName);
+
+    // a flipped byte breaks the checksum
+    {
+        FILE *file = fopen(fileName.c_str(), "r+b");
+        fseek(file, 20, SEEK_SET);
+        int c = fgetc(file);
+        fseek(file, 20, SEEK_SET);
+        fputc(c ^ 0xff, file);
+        fclose(file);
+    }
+    CTestSnapshot tampered;
+    uint256 tamperedHash;
+    BOOST_CHECK(!tampered.Read(fileName, tamperedHash));
+
+    // a file written again with its checksum still misses the expected state hash, whichever part changed
+    tampered = CTestSnapshot();
+    tampered.undos[1][50] ^= 1;
+    BOOST_CHECK(tampered.Write(fileName) != stateHash);
+
+    tampered = CTestSnapshot();
+    tampered.blockHashes[4] = GetTestHash("other", 4);
+    BOOST_CHECK(tampered.Write(fileName) != stateHash);
+
+    tampered = CTestSnapshot();
+    tampered.entries[1].value = "value3";
+    BOOST_CHECK(tampered.Write(fileName) != stateHash);
+
+    BOOST_CHECK(CTestSnapshot().Write(fileName) == stateHash);
+    boost::filesystem::remove(fileName);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,123 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <boost/test/unit_test.hpp>
+#include "persistence/statecommitdb.h"
+#include "commons/tinyformat.h"
+#include "tests/testutil.h"
+
+using namespace std;
+
+static string GetTestKey(uint32_t i) { return strprintf("idac%08u", i); }
+static string GetTestValue(uint32_t i) { return strprintf("value-%u", i); }
+
+// the buckets and the tree of the entries 0..count-1
+static void BuildTestState(uint32_t count, map<uint32_t, CStateBucket> &buckets, CStateBucketTree &tree) {
+    for (uint32_t i = 0; i < count; i++) {
+        uint256 keyHash = GetStateKeyHash(GetTestKey(i));
+        buckets[GetStateBucketIndex(keyHash)].leaves[keyHash] = GetStateLeafHash(GetTestKey(i), GetTestValue(i));
+    }
+
+    map<uint32_t, uint256> bucketHashes;
+    for (const auto &item : buckets)
+        bucketHashes[item.first] = item.second.GetHash();
+    tree.SetBucketHashes(bucketHashes);
+}
+
+static CStateProof GetTestProof(const string &key, const string &value, const map<uint32_t, CStateBucket> &buckets,
+                                const CStateBucketTree &tree) {
+    CStateProof proof;
+    proof.key      = key;
+    proof.value    = value;
+    uint32_t index = GetStateBucketIndex(GetStateKeyHash(key));
+    auto it        = buckets.find(index);
+    if (it != buckets.end())
+        proof.bucket = it->second;
+    proof.branch = tree.GetBranch(index);
+    return proof;
+}
+
+BOOST_AUTO_TEST_SUITE(statecommit_tests)
+
+BOOST_AUTO_TEST_CASE(bucket_tree_incremental_test)
+{
+    CStateBucketTree tree;
+    BOOST_CHECK(tree.GetRoot().IsNull());
+
+    // the root of the updates one by one is the one of all the buckets at once
+    map<uint32_t, uint256> bucketHashes;
+    for (uint32_t i = 0; i < 1000; i++) {
+        uint32_t index = GetTestHash("index", i).GetCheapHash() % STATE_BUCKET_COUNT;
+        uint256 hash   = GetTestHash("bucket", i);
+        bucketHashes[index] = hash;
+        tree.SetBucketHash(index, hash);
+    }
+
+    CStateBucketTree fullTree;
+    fullTree.SetBucketHashes(bucketHashes);
+    BOOST_CHECK(!tree.GetRoot().IsNull());
+    BOOST_CHECK(tree.GetRoot() == fullTree.GetRoot());
+
+    for (const auto &item : bucketHashes) {
+        vector<uint256> branch = tree.GetBranch(item.first);
+        BOOST_CHECK_EQUAL(branch.size(), STATE_BUCKET_BITS);
+        BOOST_CHECK(CStateBucketTree::ComputeRoot(item.first, item.second, branch) == tree.GetRoot());
+        BOOST_CHECK(CStateBucketTree::ComputeRoot(item.first ^ 1, item.second, branch) != tree.GetRoot());
+    }
+
+    // emptied buckets leave no trace
+    for (const auto &item : bucketHashes)
+        tree.SetBucketHash(item.first, uint256());
+    BOOST_CHECK(tree.GetRoot().IsNull());
+}
+
+BOOST_AUTO_TEST_CASE(state_proof_test)
+{
+    map<uint32_t, CStateBucket> buckets;
+    CStateBucketTree tree;
+    BuildTestState(100000, buckets, tree);
+    const uint256 root = tree.GetRoot();
+
+    for (uint32_t i = 0; i < 100; i++) {
+        // the entry and its value
+        BOOST_CHECK(GetTestProof(GetTestKey(i), GetTestValue(i), buckets, tree).Verify(root));
+        BOOST_CHECK(!GetTestProof(GetTestKey(i), GetTestValue(i + 1), buckets, tree).Verify(root));
+        // the entry claimed absent
+        BOOST_CHECK(!GetTestProof(GetTestKey(i), "", buckets, tree).Verify(root));
+
+        // the absent entry, and claimed present
+        BOOST_CHECK(GetTestProof(GetTestKey(200000 + i), "", buckets, tree).Verify(root));
+        BOOST_CHECK(!GetTestProof(GetTestKey(200000 + i), GetTestValue(i), buckets, tree).Verify(root));
+    }
+
+    // a leaf dropped from the bucket
+    CStateProof proof = GetTestProof(GetTestKey(0), GetTestValue(0), buckets, tree);
+    for (auto it = proof.bucket.leaves.begin(); it != proof.bucket.leaves.end(); it++) {
+        if (it->first != GetStateKeyHash(GetTestKey(0))) {
+            proof.bucket.leaves.erase(it);
+            break;
+        }
+    }
+    BOOST_CHECK(!proof.Verify(root));
+
+    // the bucket update of a write changes the root the same way as the full build
+    uint256 keyHash = GetStateKeyHash(GetTestKey(7));
+    uint32_t index  = GetStateBucketIndex(keyHash);
+    buckets[index].leaves[keyHash] = GetStateLeafHash(GetTestKey(7), "new value");
+    tree.SetBucketHash(index, buckets[index].GetHash());
+    BOOST_CHECK(tree.GetRoot() != root);
+    BOOST_CHECK(GetTestProof(GetTestKey(7), "new value", buckets, tree).Verify(tree.GetRoot()));
+
+    map<uint32_t, CStateBucket> fullBuckets;
+    CStateBucketTree fullTree;
+    BuildTestState(100000, fullBuckets, fullTree);
+    fullBuckets[index].leaves[keyHash] = GetStateLeafHash(GetTestKey(7), "new value");
+    map<uint32_t, uint256> bucketHashes;
+    for (const auto &item : fullBuckets)
+        bucketHashes[item.first] = item.second.GetHash();
+    fullTree.SetBucketHashes(bucketHashes);
+    BOOST_CHECK(fullTree.GetRoot() == tree.GetRoot());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,152 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <boost/test/unit_test.hpp>
+#include "commons/tinyformat.h"
+#include "commons/util/time.h"
+#include "persistence/sysparamdb.h"
+
+using namespace std;
+
+typedef CCompositeKVCache<dbk::SYS_PARAM, uint8_t, CVarIntValue<uint64_t>> SysParamKVCache;
+typedef CCompositeKVCache<dbk::MINER_FEE, pair<uint8_t, string>, CVarIntValue<uint64_t>> MinerFeeKVCache;
+
+// the reads before the snapshot: each one walks the cache layers and copies the varint value
+static bool GetLayeredParam(SysParamKVCache &cache, const SysParamType &paramType, uint64_t &paramValue) {
+    auto iter = SysParamTable.find(paramType);
+    if (iter == SysParamTable.end())
+        return false;
+
+    CVarIntValue<uint64_t> value;
+    paramValue = cache.GetData(paramType, value) ? value.get() : std::get<1>(iter->second);
+    return true;
+}
+
+static bool GetLayeredMinerFee(MinerFeeKVCache &cache, const uint8_t txType, const string &feeSymbol,
+                               uint64_t &feeSawiAmount) {
+    CVarIntValue<uint64_t> value;
+    if (!cache.GetData(make_pair(txType, feeSymbol), value))
+        return false;
+
+    feeSawiAmount = value.get();
+    return true;
+}
+
+BOOST_AUTO_TEST_SUITE(sysparam_tests)
+
+BOOST_AUTO_TEST_CASE(sysparam_snapshot_test)
+{
+    CDBAccess dbAccess("", DBNameType::SYSPARAM, true, true);
+    CSysParamDBCache rootCache(&dbAccess);
+    uint64_t value = 0;
+
+    // the defaults of the table
+    BOOST_CHECK(rootCache.GetParam(ASSET_ISSUE_FEE, value));
+    BOOST_CHECK_EQUAL(value, std::get<1>(SysParamTable.at(ASSET_ISSUE_FEE)));
+    BOOST_CHECK(!rootCache.GetParam(NULL_SYS_PARAM_TYPE, value));
+    BOOST_CHECK(!rootCache.GetMinerFee(BCOIN_TRANSFER_TX, "WICC", value));
+    BOOST_CHECK_EQUAL(rootCache.GetBpCount(100), 11);
+
+    CSysParamDBCache blockCache;
+    blockCache.SetBaseViewPtr(&rootCache);
+    CSysParamDBCache txCache;
+    txCache.SetBaseViewPtr(&blockCache);
+    BOOST_CHECK(txCache.GetSnapshot() == rootCache.GetSnapshot());
+
+    // a write is seen by the cache and the ones on it only
+    CDBOpLogMap dbOpLogMap;
+    txCache.SetDbOpLogMap(&dbOpLogMap);
+    BOOST_CHECK(txCache.SetParam(ASSET_ISSUE_FEE, 100));
+    BOOST_CHECK(txCache.SetMinerFee(BCOIN_TRANSFER_TX, "WICC", 20000));
+    BOOST_CHECK(txCache.SetNewBpCount(21, 200));
+    BOOST_CHECK(txCache.GetParam(ASSET_ISSUE_FEE, value));
+    BOOST_CHECK_EQUAL(value, 100);
+    BOOST_CHECK(txCache.GetMinerFee(BCOIN_TRANSFER_TX, "WICC", value));
+    BOOST_CHECK_EQUAL(value, 20000);
+    BOOST_CHECK_EQUAL(txCache.GetBpCount(199), 11);
+    BOOST_CHECK_EQUAL(txCache.GetBpCount(200), 21);
+    BOOST_CHECK(blockCache.GetParam(ASSET_ISSUE_FEE, value));
+    BOOST_CHECK_EQUAL(value, std::get<1>(SysParamTable.at(ASSET_ISSUE_FEE)));
+
+    // flushed to the base, the snapshot of the base is rebuilt
+    auto spOldSnapshot = rootCache.GetSnapshot();
+    txCache.Flush();
+    BOOST_CHECK(blockCache.GetParam(ASSET_ISSUE_FEE, value));
+    BOOST_CHECK_EQUAL(value, 100);
+    BOOST_CHECK(blockCache.GetSnapshot() != spOldSnapshot);
+    BOOST_CHECK(rootCache.GetSnapshot() == spOldSnapshot);
+    BOOST_CHECK(txCache.GetSnapshot() == blockCache.GetSnapshot());
+
+    blockCache.Flush();
+    BOOST_CHECK(rootCache.GetSnapshot() != spOldSnapshot);
+    BOOST_CHECK(rootCache.GetMinerFee(BCOIN_TRANSFER_TX, "WICC", value));
+    BOOST_CHECK_EQUAL(value, 20000);
+
+    // the undo of the writes
+    CSysParamDBCache undoCache;
+    undoCache.SetBaseViewPtr(&rootCache);
+    UndoDataFuncMap undoDataFuncMap;
+    undoCache.RegisterUndoFunc(undoDataFuncMap);
+    for (const auto &item : dbOpLogMap.GetMap())
+        undoDataFuncMap[dbk::ParseKeyPrefixType(item.first)](item.second);
+    BOOST_CHECK(undoCache.GetParam(ASSET_ISSUE_FEE, value));
+    BOOST_CHECK_EQUAL(value, std::get<1>(SysParamTable.at(ASSET_ISSUE_FEE)));
+    BOOST_CHECK(!undoCache.GetMinerFee(BCOIN_TRANSFER_TX, "WICC", value));
+    BOOST_CHECK(rootCache.GetParam(ASSET_ISSUE_FEE, value));
+    BOOST_CHECK_EQUAL(value, 100);
+}
+
+BOOST_AUTO_TEST_CASE(sysparam_read_benchmark)
+{
+    const uint32_t kTxCount = 100000;
+    vector<SysParamType> paramTypes;
+    for (auto it = SysParamTable.begin(); it != SysParamTable.end() && paramTypes.size() < 3; ++it)
+        paramTypes.push_back(it->first);
+
+    // the params as a tx reads them: a few params and its miner fee, on a layer of its own over the block
+    CDBAccess dbAccess("", DBNameType::SYSPARAM, true, true);
+    CSysParamDBCache rootCache(&dbAccess);
+    BOOST_CHECK(rootCache.SetParam(paramTypes[0], 100));
+    BOOST_CHECK(rootCache.SetMinerFee(BCOIN_TRANSFER_TX, "WICC", 20000));
+    rootCache.Flush();
+    CSysParamDBCache blockCache;
+    blockCache.SetBaseViewPtr(&rootCache);
+
+    uint64_t sum = 0, value = 0;
+    int64_t nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < kTxCount; i++) {
+        CSysParamDBCache txCache;
+        txCache.SetBaseViewPtr(&blockCache);
+        for (const auto &paramType : paramTypes) {
+            txCache.GetParam(paramType, value);
+            sum += value;
+        }
+        txCache.GetMinerFee(BCOIN_TRANSFER_TX, "WICC", value);
+        sum += value;
+    }
+    int64_t nSnapshot = GetTimeMicros() - nStart;
+
+    SysParamKVCache rootParamCache(&dbAccess), blockParamCache(&rootParamCache);
+    MinerFeeKVCache rootFeeCache(&dbAccess), blockFeeCache(&rootFeeCache);
+    uint64_t layeredSum = 0;
+    nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < kTxCount; i++) {
+        SysParamKVCache txParamCache(&blockParamCache);
+        MinerFeeKVCache txFeeCache(&blockFeeCache);
+        for (const auto &paramType : paramTypes) {
+            GetLayeredParam(txParamCache, paramType, value);
+            layeredSum += value;
+        }
+        GetLayeredMinerFee(txFeeCache, BCOIN_TRANSFER_TX, "WICC", value);
+        layeredSum += value;
+    }
+    int64_t nLayered = GetTimeMicros() - nStart;
+
+    BOOST_CHECK_EQUAL(sum, layeredSum);
+    BOOST_TEST_MESSAGE(strprintf("%u txs reading %u params and a miner fee: snapshot %.1fns/tx, layered %.1fns/tx",
+                                 kTxCount, paramTypes.size(), nSnapshot * 1000.0 / kTxCount,
+                                 nLayered * 1000.0 / kTxCount));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
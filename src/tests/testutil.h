@@ -0,0 +1,27 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef TESTS_TESTUTIL_H
+#define TESTS_TESTUTIL_H
+
+#include "commons/uint256.h"
+#include "crypto/hash.h"
+#include "entities/key.h"
+
+#include <string>
+
+/** A hash fixed by the tag and the index, for the test data */
+inline uint256 GetTestHash(const std::string &tag, uint32_t i) {
+    CHashWriter ss(SER_GETHASH, 0);
+    ss << tag << i;
+    return ss.GetHash();
+}
+
+/** A key id fixed by the index, for the test accounts */
+inline CKeyID GetTestKeyId(uint32_t i) {
+    uint256 hash = GetTestHash("key", i);
+    return CKeyID(Hash160(hash.begin(), hash.end()));
+}
+
+#endif  // TESTS_TESTUTIL_H
@@ -0,0 +1,115 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <boost/test/unit_test.hpp>
+#include "config/errorcode.h"
+#include "tx/cointransfertx.h"
+#include "tx/txorphanpool.h"
+
+using namespace std;
+
+// a transfer of a distinct hash to a regid not registered yet
+static std::shared_ptr<CBaseTx> GetTestTx(uint32_t i) {
+    return std::make_shared<CBaseCoinTransferTx>(CUserID(CRegID(1000, i)), CUserID(CRegID(2000, i)), 100, 1, 10000,
+                                                 strprintf("orphan %u", i));
+}
+
+static vector<COrphanTxDependency> GetTestDependencies(uint32_t regidHeight) {
+    return {COrphanTxDependency(ORPHAN_DEPEND_REGID, CRegID(regidHeight, 1))};
+}
+
+BOOST_AUTO_TEST_SUITE(txorphanpool_tests)
+
+BOOST_AUTO_TEST_CASE(orphan_tx_limits_test)
+{
+    COrphanTxPool pool;
+    pool.SetLimits(20, 1000000);
+    const int64_t kNow = 1000;
+
+    // a peer holds at most a quarter of the pool
+    for (uint32_t i = 0; i < 10; i++)
+        BOOST_CHECK_EQUAL(pool.AddTx(GetTestTx(i), 1, GetTestDependencies(i), kNow + i), i < 5);
+    BOOST_CHECK(!pool.AddTx(GetTestTx(0), 2, GetTestDependencies(0), kNow));
+    BOOST_CHECK(!pool.AddTx(GetTestTx(100), 2, {}, kNow));
+    BOOST_CHECK_EQUAL(pool.Size(), 5U);
+
+    // full, the oldest orphan of the peer holding the most is evicted
+    for (uint32_t i = 10; i < 25; i++)
+        BOOST_CHECK(pool.AddTx(GetTestTx(i), 2 + (i - 10) / 5, GetTestDependencies(i), kNow + i));
+    BOOST_CHECK_EQUAL(pool.Size(), 20U);
+    BOOST_CHECK(pool.AddTx(GetTestTx(25), 5, GetTestDependencies(25), kNow + 25));
+    BOOST_CHECK_EQUAL(pool.Size(), 20U);
+    BOOST_CHECK(!pool.Exists(GetTestTx(0)->GetHash()));
+    BOOST_CHECK(pool.Exists(GetTestTx(1)->GetHash()));
+
+    // by size too
+    uint64_t totalBytes = pool.GetTotalBytes();
+    pool.SetLimits(20, totalBytes - 1);
+    BOOST_CHECK_EQUAL(pool.Size(), 19U);
+    BOOST_CHECK(!pool.Exists(GetTestTx(10)->GetHash()));
+
+    BOOST_CHECK_EQUAL(pool.EraseForPeer(2), 4U);
+    BOOST_CHECK_EQUAL(pool.Size(), 15U);
+
+    // expired
+    BOOST_CHECK_EQUAL(pool.Expire(kNow + 4), 4U);
+    BOOST_CHECK_EQUAL(pool.Expire(kNow + 100), 11U);
+    BOOST_CHECK_EQUAL(pool.Size(), 0U);
+    BOOST_CHECK_EQUAL(pool.GetTotalBytes(), 0U);
+}
+
+BOOST_AUTO_TEST_CASE(orphan_tx_resolve_test)
+{
+    COrphanTxPool pool;
+    const uint32_t kOrphanCount = 90;
+
+    // 3 dependencies, the orphans wait for one or both of the first two
+    for (uint32_t i = 0; i < kOrphanCount; i++) {
+        vector<COrphanTxDependency> dependencies;
+        if (i % 3 != 1)
+            dependencies.emplace_back(ORPHAN_DEPEND_REGID, CRegID(10, 1));
+        if (i % 3 != 0)
+            dependencies.emplace_back(ORPHAN_DEPEND_CONTRACT, CRegID(20, 1));
+        BOOST_CHECK(pool.AddTx(GetTestTx(i), i % 4, dependencies, 1000));
+    }
+    BOOST_CHECK(pool.AddTx(GetTestTx(kOrphanCount), 0, {COrphanTxDependency(CKeyID())}, 1000));
+
+    // each dependency is checked once, the orphans missing nothing else are taken
+    set<COrphanTxDependency> metDependencies = {COrphanTxDependency(ORPHAN_DEPEND_REGID, CRegID(10, 1))};
+    uint32_t checkCount = 0;
+    auto isMet = [&](const COrphanTxDependency &dependency) {
+        checkCount++;
+        return metDependencies.count(dependency) > 0;
+    };
+
+    vector<COrphanTx> resolved;
+    pool.TakeResolved(isMet, resolved);
+    BOOST_CHECK_EQUAL(checkCount, 3U);
+    BOOST_CHECK_EQUAL(resolved.size(), kOrphanCount / 3);
+    for (const auto &orphan : resolved)
+        BOOST_CHECK_EQUAL(orphan.dependencies.size(), 1U);
+
+    metDependencies.emplace(ORPHAN_DEPEND_CONTRACT, CRegID(20, 1));
+    resolved.clear();
+    pool.TakeResolved(isMet, resolved);
+    BOOST_CHECK_EQUAL(resolved.size(), kOrphanCount * 2 / 3);
+    BOOST_CHECK_EQUAL(pool.Size(), 1U);
+
+    resolved.clear();
+    pool.TakeResolved(isMet, resolved);
+    BOOST_CHECK(resolved.empty());
+}
+
+BOOST_AUTO_TEST_CASE(orphan_tx_reject_test)
+{
+    // only a tx which reads a missing account, regid or contract waits as an orphan
+    BOOST_CHECK(IsMissingDependencyReject(REJECT_INVALID, "bad-getaccount"));
+    BOOST_CHECK(IsMissingDependencyReject(READ_ACCOUNT_FAIL, "bad-read-accountdb"));
+    BOOST_CHECK(IsMissingDependencyReject(READ_SCRIPT_FAIL, "bad-read-script"));
+    BOOST_CHECK(!IsMissingDependencyReject(REJECT_INVALID, "bad-signscript-check"));
+    BOOST_CHECK(!IsMissingDependencyReject(REJECT_DUST, "invalid-coin-amount"));
+    BOOST_CHECK(!IsMissingDependencyReject(UPDATE_ACCOUNT_FAIL, "bad-read-accountdb"));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,274 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+#include <boost/test/unit_test.hpp>
+#include "p2p/protocol.h"
+#include "p2p/txreconciliation.h"
+#include "tests/testutil.h"
+
+using namespace std;
+
+static const uint32_t NODE_COUNT     = 16;
+static const uint32_t OUTBOUND_COUNT = 4;
+static const uint32_t TX_COUNT       = 400;
+
+struct SimInv {
+    NodeId from;
+    NodeId to;
+    uint256 txid;
+};
+
+struct SimNode {
+    CTxReconTracker tracker;
+    set<uint256> txs;
+    vector<NodeId> outboundPeers;
+    set<NodeId> peers;
+    map<NodeId, set<uint256>> knownTxs;  // txs announced by or to the peer
+};
+
+/**
+ * In-process network of NODE_COUNT nodes, the node ids are the indexes of the nodes.
+ * Messages are delivered in order and the bytes of the announcements are counted.
+ */
+class CSimNetwork {
+public:
+    vector<std::shared_ptr<SimNode>> nodes;
+    std::deque<SimInv> invQueue;
+    uint64_t announceBytes = 0;
+    uint64_t reconFailures = 0;
+
+    explicit CSimNetwork(bool fReconcile) {
+        for (uint32_t i = 0; i < NODE_COUNT; i++)
+            nodes.push_back(std::make_shared<SimNode>());
+
+        for (NodeId i = 0; i < (NodeId)NODE_COUNT; i++) {
+            for (uint32_t k = 0; k < OUTBOUND_COUNT; k++) {
+                NodeId j = (i + 2 * k + 1) % NODE_COUNT;
+
+                nodes[i]->peers.insert(j);
+                nodes[i]->outboundPeers.push_back(j);
+                nodes[j]->peers.insert(i);
+                if (fReconcile)
+                    Connect(i, j);
+            }
+        }
+    }
+
+    void Connect(NodeId outbound, NodeId inbound) {
+        // sendrecon in both directions before verack
+        uint64_t outboundSalt = nodes[outbound]->tracker.PreRegister(inbound);
+        uint64_t inboundSalt  = nodes[inbound]->tracker.PreRegister(outbound);
+        BOOST_CHECK(nodes[outbound]->tracker.Register(inbound, false, TXRECON_VERSION, inboundSalt));
+        BOOST_CHECK(nodes[inbound]->tracker.Register(outbound, true, TXRECON_VERSION, outboundSalt));
+    }
+
+    void Relay(NodeId nodeId, const uint256 &txid) {
+        SimNode &node = *nodes[nodeId];
+        for (auto peerId : node.peers) {
+            if (node.knownTxs[peerId].count(txid) || node.tracker.AddToPending(peerId, txid))
+                continue;
+
+            Announce(nodeId, peerId, {txid});
+        }
+    }
+
+    void Announce(NodeId from, NodeId to, const vector<uint256> &txids) {
+        if (txids.empty())
+            return;
+
+        vector<CInv> vInv;
+        for (const auto &txid : txids) {
+            nodes[from]->knownTxs[to].insert(txid);
+            vInv.push_back(CInv(MSG_TX, txid));
+            invQueue.push_back({from, to, txid});
+        }
+        announceBytes += ::GetSerializeSize(vInv, SER_NETWORK, PROTOCOL_VERSION);
+    }
+
+    void AddTx(NodeId nodeId, const uint256 &txid) {
+        if (nodes[nodeId]->txs.insert(txid).second)
+            Relay(nodeId, txid);
+    }
+
+    // the receiver fetches the unknown txs and relays them
+    void DeliverInvs() {
+        while (!invQueue.empty()) {
+            SimInv inv = invQueue.front();
+            invQueue.pop_front();
+
+            nodes[inv.to]->knownTxs[inv.from].insert(inv.txid);
+            AddTx(inv.to, inv.txid);
+        }
+    }
+
+    void Reconcile(int64_t nNow) {
+        for (NodeId i = 0; i < (NodeId)NODE_COUNT; i++) {
+            for (auto j : nodes[i]->outboundPeers) {
+                SimNode &initiator = *nodes[i];
+                SimNode &responder = *nodes[j];
+
+                uint32_t setSize;
+                uint16_t q;
+                if (!initiator.tracker.InitiateRecon(j, nNow, setSize, q))
+                    continue;
+                announceBytes += sizeof(setSize) + sizeof(q);
+
+                CTxReconSketch sketch;
+                BOOST_CHECK(responder.tracker.HandleReqRecon(i, setSize, q, sketch));
+
+                CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+                ss << sketch;
+                announceBytes += ss.size();
+                CTxReconSketch receivedSketch;
+                ss >> receivedSketch;
+
+                bool fSuccess = false;
+                vector<uint256> initiatorTxids;
+                vector<uint32_t> askShortIds;
+                BOOST_CHECK(initiator.tracker.HandleSketch(j, receivedSketch, fSuccess, initiatorTxids, askShortIds));
+                if (!fSuccess)
+                    reconFailures++;
+                Announce(i, j, initiatorTxids);
+                announceBytes += 1 + ::GetSerializeSize(askShortIds, SER_NETWORK, PROTOCOL_VERSION);
+
+                vector<uint256> responderTxids;
+                BOOST_CHECK(responder.tracker.HandleReconDiff(i, fSuccess, askShortIds, responderTxids));
+                Announce(j, i, responderTxids);
+
+                DeliverInvs();
+            }
+        }
+    }
+
+    bool IsSynced(uint32_t txCount) const {
+        for (const auto &spNode : nodes) {
+            if (spNode->txs.size() != txCount)
+                return false;
+        }
+        return true;
+    }
+
+    // submit the txs to random nodes, reconciling every 10 txs
+    void Run(uint32_t txCount) {
+        int64_t nNow = 0;
+        for (uint32_t i = 0; i < txCount; i++) {
+            AddTx(GetTestHash("tx", i).GetCheapHash() % NODE_COUNT, GetTestHash("tx", i));
+            DeliverInvs();
+            if (i % 10 == 9) {
+                nNow += TXRECON_INTERVAL;
+                Reconcile(nNow);
+            }
+        }
+
+        for (uint32_t round = 0; round < 10 && !IsSynced(txCount); round++) {
+            nNow += TXRECON_INTERVAL;
+            Reconcile(nNow);
+        }
+    }
+};
+
+BOOST_AUTO_TEST_SUITE(txreconciliation_tests)
+
+BOOST_AUTO_TEST_CASE(sketch_decode_test)
+{
+    const uint32_t diffCount = 50;
+    CTxReconSketch localSketch(CTxReconSketch::GetCellCount(diffCount));
+    CTxReconSketch remoteSketch(CTxReconSketch::GetCellCount(diffCount));
+
+    // 500 shared ids, 30 local only and 20 remote only
+    for (uint64_t id = 1; id <= 500; id++) {
+        localSketch.Add(id);
+        remoteSketch.Add(id);
+    }
+    for (uint64_t id = 1001; id <= 1030; id++)
+        localSketch.Add(id);
+    for (uint64_t id = 2001; id <= 2020; id++)
+        remoteSketch.Add(id);
+
+    BOOST_CHECK(localSketch.Subtract(remoteSketch));
+
+    vector<uint32_t> localOnlyIds;
+    vector<uint32_t> remoteOnlyIds;
+    BOOST_CHECK(localSketch.Decode(localOnlyIds, remoteOnlyIds));
+    BOOST_CHECK_EQUAL(localOnlyIds.size(), 30U);
+    BOOST_CHECK_EQUAL(remoteOnlyIds.size(), 20U);
+    for (auto id : localOnlyIds)
+        BOOST_CHECK(id > 1000 && id <= 1030);
+    for (auto id : remoteOnlyIds)
+        BOOST_CHECK(id > 2000 && id <= 2020);
+}
+
+BOOST_AUTO_TEST_CASE(sketch_overflow_test)
+{
+    CTxReconSketch localSketch(CTxReconSketch::GetCellCount(10));
+    CTxReconSketch remoteSketch(CTxReconSketch::GetCellCount(10));
+    for (uint64_t id = 1; id <= 200; id++)
+        localSketch.Add(id);
+
+    BOOST_CHECK(localSketch.Subtract(remoteSketch));
+    vector<uint32_t> localOnlyIds;
+    vector<uint32_t> remoteOnlyIds;
+    BOOST_CHECK(!localSketch.Decode(localOnlyIds, remoteOnlyIds));
+
+    // the cell counts must match
+    CTxReconSketch otherSketch(CTxReconSketch::GetCellCount(20));
+    BOOST_CHECK(!localSketch.Subtract(otherSketch));
+}
+
+BOOST_AUTO_TEST_CASE(protocol_state_test)
+{
+    CTxReconTracker tracker;
+    // not offered to the peer
+    BOOST_CHECK(!tracker.Register(1, false, TXRECON_VERSION, 1234));
+
+    tracker.PreRegister(1);
+    BOOST_CHECK(tracker.Register(1, false, TXRECON_VERSION, 1234));
+    BOOST_CHECK(!tracker.Register(1, false, TXRECON_VERSION, 1234));
+    BOOST_CHECK(tracker.IsFloodPeer(1));
+
+    tracker.PreRegister(2);
+    BOOST_CHECK(tracker.Register(2, true, TXRECON_VERSION, 5678));
+    BOOST_CHECK(!tracker.IsFloodPeer(2));
+    BOOST_CHECK(tracker.AddToPending(2, GetTestHash("tx", 0)));
+    BOOST_CHECK(!tracker.AddToPending(1, GetTestHash("tx", 0)));
+
+    // the inbound peer initiates the reconciliation, we never do
+    uint32_t setSize;
+    uint16_t q;
+    BOOST_CHECK(!tracker.InitiateRecon(2, TXRECON_INTERVAL, setSize, q));
+
+    CTxReconSketch sketch;
+    BOOST_CHECK(tracker.HandleReqRecon(2, 0, DEFAULT_TXRECON_Q, sketch));
+    BOOST_CHECK(!tracker.HandleReqRecon(2, 0, DEFAULT_TXRECON_Q, sketch));
+
+    vector<uint256> txids;
+    BOOST_CHECK(tracker.HandleReconDiff(2, false, {}, txids));
+    BOOST_CHECK_EQUAL(txids.size(), 1U);
+    BOOST_CHECK(!tracker.HandleReconDiff(2, false, {}, txids));
+
+    tracker.Forget(2);
+    BOOST_CHECK(!tracker.IsRegistered(2));
+}
+
+BOOST_AUTO_TEST_CASE(network_simulation_test)
+{
+    CSimNetwork floodNetwork(false);
+    floodNetwork.Run(TX_COUNT);
+    BOOST_CHECK(floodNetwork.IsSynced(TX_COUNT));
+
+    CSimNetwork reconNetwork(true);
+    reconNetwork.Run(TX_COUNT);
+    BOOST_CHECK(reconNetwork.IsSynced(TX_COUNT));
+
+    BOOST_TEST_MESSAGE(strprintf("announcement bytes, flood: %llu, reconciliation: %llu, failures: %llu",
+                                 floodNetwork.announceBytes, reconNetwork.announceBytes, reconNetwork.reconFailures));
+    BOOST_CHECK(reconNetwork.announceBytes < floodNetwork.announceBytes);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
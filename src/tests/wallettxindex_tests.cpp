@@ -0,0 +1,147 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <boost/test/unit_test.hpp>
+#include "commons/tinyformat.h"
+#include "commons/util/time.h"
+#include "wallet/wallettxindex.h"
+#include "tests/testutil.h"
+
+using namespace std;
+
+// txsPerBlock txs in each of the blocks [1, blockCount], the keys, types and symbols alternate
+static void AddTestTxs(CWalletTxIndex &index, int32_t blockCount, uint32_t txsPerBlock) {
+    for (int32_t height = 1; height <= blockCount; height++) {
+        for (uint32_t i = 0; i < txsPerBlock; i++) {
+            CWalletTxEntry entry;
+            entry.pos        = CWalletTxPos(height, GetTestHash("tx", height * txsPerBlock + i));
+            entry.block_hash = GetTestHash("block", height);
+            entry.tx_type    = (i % 2 == 0) ? UCOIN_TRANSFER_TX : LCONTRACT_INVOKE_TX;
+            entry.key_ids.insert(GetTestKeyId(i % 3));
+            entry.symbols.insert(i % 2 == 0 ? SYMB::WUSD : SYMB::WICC);
+            index.Add(entry);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE(wallettxindex_tests)
+
+BOOST_AUTO_TEST_CASE(wallettxindex_cursor_test)
+{
+    CWalletTxIndex index;
+    AddTestTxs(index, 100, 4);
+    BOOST_CHECK_EQUAL(index.Size(), 400U);
+
+    // the pages chained by the cursors list every tx once, the newest block first
+    vector<CWalletTxPos> listed;
+    CWalletTxPos cursor;
+    bool hasMore = true;
+    while (hasMore) {
+        vector<const CWalletTxEntry *> page;
+        hasMore = index.List(listed.empty() ? nullptr : &cursor, CWalletTxFilter(), 0, 7, page);
+        BOOST_CHECK(!page.empty() && page.size() <= 7);
+        for (const auto pEntry : page)
+            listed.push_back(pEntry->pos);
+        cursor = page.back()->pos;
+    }
+    BOOST_CHECK_EQUAL(listed.size(), 400U);
+    BOOST_CHECK_EQUAL(listed.front().height, 100);
+    BOOST_CHECK_EQUAL(listed.back().height, 1);
+    for (size_t i = 1; i < listed.size(); i++)
+        BOOST_CHECK(listed[i - 1] < listed[i]);
+
+    // the cursor strings round trip
+    CWalletTxPos parsed;
+    BOOST_CHECK(CWalletTxPos::Parse(cursor.ToString(), parsed));
+    BOOST_CHECK(parsed == cursor);
+    BOOST_CHECK(!CWalletTxPos::Parse("12", parsed));
+    BOOST_CHECK(!CWalletTxPos::Parse("-1:" + cursor.txid.GetHex(), parsed));
+    BOOST_CHECK(!CWalletTxPos::Parse("12:xyz", parsed));
+
+    // skip from the newest one
+    vector<const CWalletTxEntry *> page;
+    BOOST_CHECK(index.List(nullptr, CWalletTxFilter(), 10, 5, page));
+    BOOST_CHECK(page.size() == 5 && page[0]->pos == listed[10]);
+}
+
+BOOST_AUTO_TEST_CASE(wallettxindex_filter_test)
+{
+    CWalletTxIndex index;
+    AddTestTxs(index, 100, 4);
+
+    CWalletTxFilter filter;
+    filter.key_id = GetTestKeyId(1);
+    filter.symbol = SYMB::WICC;
+    vector<const CWalletTxEntry *> page;
+    BOOST_CHECK(!index.List(nullptr, filter, 0, 1000, page));
+    // the tx 1 of each block
+    BOOST_CHECK_EQUAL(page.size(), 100U);
+    for (const auto pEntry : page)
+        BOOST_CHECK(filter.Match(*pEntry) && pEntry->tx_type == LCONTRACT_INVOKE_TX);
+
+    CWalletTxFilter typeFilter;
+    typeFilter.tx_type = UCOIN_TRANSFER_TX;
+    page.clear();
+    BOOST_CHECK(!index.List(nullptr, typeFilter, 0, 1000, page));
+    BOOST_CHECK_EQUAL(page.size(), 200U);
+
+    CWalletTxFilter unknownFilter;
+    unknownFilter.key_id = GetTestKeyId(3);
+    page.clear();
+    BOOST_CHECK(!index.List(nullptr, unknownFilter, 0, 1000, page));
+    BOOST_CHECK(page.empty());
+
+    // a disconnected block leaves the secondary indexes
+    for (uint32_t i = 0; i < 4; i++)
+        index.Remove(CWalletTxPos(100, GetTestHash("tx", 100 * 4 + i)));
+    page.clear();
+    BOOST_CHECK(!index.List(nullptr, filter, 0, 1000, page));
+    BOOST_CHECK_EQUAL(page.size(), 99U);
+    BOOST_CHECK_EQUAL(page[0]->pos.height, 99);
+}
+
+BOOST_AUTO_TEST_CASE(wallettxindex_page_time_test)
+{
+    // the last full page of a large wallet walks as many entries as the first one
+    CWalletTxIndex index;
+    AddTestTxs(index, 50000, 4);
+
+    vector<const CWalletTxEntry *> page;
+    index.List(nullptr, CWalletTxFilter(), 0, 50, page);
+    CWalletTxPos firstCursor = page.back()->pos;
+    // followed by the txs of the blocks [1, 13] and some of the block 14
+    CWalletTxPos lastCursor(14, GetTestHash("tx", 14 * 4));
+
+    uint32_t firstVisited = 0, lastVisited = 0;
+    int64_t nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < 1000; i++) {
+        page.clear();
+        index.List(&firstCursor, CWalletTxFilter(), 0, 50, page, &firstVisited);
+    }
+    int64_t nFirst = GetTimeMicros() - nStart;
+
+    nStart = GetTimeMicros();
+    for (uint32_t i = 0; i < 1000; i++) {
+        page.clear();
+        index.List(&lastCursor, CWalletTxFilter(), 0, 50, page, &lastVisited);
+    }
+    int64_t nLast = GetTimeMicros() - nStart;
+
+    BOOST_TEST_MESSAGE(strprintf("1000 pages of 50 from 200000 txs: first %dus, last %dus", nFirst, nLast));
+    BOOST_CHECK_EQUAL(page.size(), 50U);
+    // the page and the entry which tells there are more
+    BOOST_CHECK_EQUAL(firstVisited, 51U);
+    BOOST_CHECK_EQUAL(lastVisited, 51U);
+
+    // a filtered page walks the positions of the filter only, not the half of the txs of other types
+    CWalletTxFilter filter;
+    filter.tx_type = UCOIN_TRANSFER_TX;
+    uint32_t filteredVisited = 0;
+    page.clear();
+    index.List(&firstCursor, filter, 0, 50, page, &filteredVisited);
+    BOOST_CHECK_EQUAL(page.size(), 50U);
+    BOOST_CHECK_EQUAL(filteredVisited, 51U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,86 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <boost/test/unit_test.hpp>
+#include "commons/tinyformat.h"
+#include "commons/util/time.h"
+#include "commons/json/json_spirit_writer.h"
+#include "tests/testutil.h"
+#include "wasm/wasm_variant_trace.hpp"
+
+using namespace std;
+using namespace wasm;
+
+// a bank transfer with inlineCount notifications, each one transferring on again
+static transaction_trace GetTestTrace(uint32_t inlineCount) {
+    inline_transaction trx;
+    trx.contract      = wasmio_bank;
+    trx.action        = N(transfer);
+    trx.authorization = {{N(alice), wasmio_owner}};
+    trx.data          = wasm::pack(std::tuple(N(alice), N(bob), asset(100000000, symbol(SYMB::WICC, 8)),
+                                              string("payout")));
+
+    transaction_trace trace;
+    trace.trx_id    = GetTestHash("trace", inlineCount);
+    trace.fuel_rate = 1;
+    trace.run_cost  = 1000;
+    trace.traces.emplace_back();
+    trace.traces.back().trx_id   = trace.trx_id;
+    trace.traces.back().receiver = wasmio_bank;
+    trace.traces.back().trx      = trx;
+    for (uint32_t i = 0; i < inlineCount; i++) {
+        inline_transaction_trace inline_trace;
+        inline_trace.trx_id   = trace.trx_id;
+        inline_trace.receiver = (i % 2 == 0) ? N(alice) : N(bob);
+        inline_trace.trx      = trx;
+        trace.traces.back().inline_traces.push_back(inline_trace);
+    }
+    return trace;
+}
+
+BOOST_AUTO_TEST_SUITE(wasmtrace_tests)
+
+BOOST_AUTO_TEST_CASE(wasmtrace_render_on_demand_test)
+{
+    // the resolver the rpcs use for the native contracts, the abi is parsed for each action
+    auto resolver = [](const uint64_t &account) -> std::vector<char> {
+        std::vector<char> abi;
+        get_native_contract_abi(account, abi);
+        return abi;
+    };
+
+    for (uint32_t inlineCount : {0U, 10U, 100U}) {
+        transaction_trace trace = GetTestTrace(inlineCount);
+        const uint32_t kTxCount = 100;
+
+        // the cost left in the execution of a tx
+        int64_t nStart = GetTimeMicros();
+        std::vector<char> trace_bytes;
+        for (uint32_t i = 0; i < kTxCount; i++)
+            trace_bytes = wasm::pack<transaction_trace>(trace);
+        int64_t nPacked = GetTimeMicros() - nStart;
+
+        // the cost moved to the rpcs
+        nStart = GetTimeMicros();
+        string trace_json;
+        for (uint32_t i = 0; i < kTxCount; i++) {
+            json_spirit::Value value_json;
+            to_variant(wasm::unpack<transaction_trace>(trace_bytes), value_json, resolver);
+            trace_json = json_spirit::write(value_json);
+        }
+        int64_t nRendered = GetTimeMicros() - nStart;
+
+        // the packed trace keeps all that the rpcs render
+        transaction_trace unpacked = wasm::unpack<transaction_trace>(trace_bytes);
+        BOOST_CHECK(unpacked.trx_id == trace.trx_id);
+        BOOST_CHECK_EQUAL(unpacked.traces.back().inline_traces.size(), inlineCount);
+        BOOST_CHECK(trace_json.find(trace.trx_id.ToString()) != string::npos);
+        BOOST_CHECK(trace_json.find("\"memo\":\"payout\"") != string::npos);
+
+        BOOST_TEST_MESSAGE(strprintf("%u inline actions per tx: pack %.1fus/tx, render %.1fus/tx", inlineCount,
+                                     (double)nPacked / kTxCount, (double)nRendered / kTxCount));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
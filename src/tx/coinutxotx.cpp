@@ -9,12 +9,16 @@
 #include <string>
 #include <cstdarg>
 
-bool GetUtxoTxFromChain(TxID &txid, std::shared_ptr<CCoinUtxoTx> pTx) {
+bool GetUtxoTxFromChain(const TxID &txid, std::shared_ptr<CCoinUtxoTx> &pTx) {
     if (!SysCfg().IsTxIndex()) 
         return false;
     
     CDiskTxPos txPos;
-    if (pCdMan->pBlockCache->ReadTxIndex(txid, txPos)) {
+    if (!pCdMan->pBlockCache->ReadTxIndex(txid, txPos))
+        return false;
+
+    std::shared_ptr<CBaseTx> pBaseTx;
+    {
         LOCK(cs_main);
         CAutoFile file(OpenBlockFile(txPos, true), SER_DISK, CLIENT_VERSION);
         CBlockHeader header;
@@ -22,12 +26,41 @@ bool GetUtxoTxFromChain(TxID &txid, std::shared_ptr<CCoinUtxoTx> pTx) {
         try {
             file >> header;
             fseek(file, txPos.nTxOffset, SEEK_CUR);
-            file >> pTx;
+            file >> pBaseTx;
             
         } catch (std::exception &e) {
             throw runtime_error(tfm::format("%s : Deserialize or I/O error - %s", __func__, e.what()).c_str());
         }
     }
+
+    pTx = std::dynamic_pointer_cast<CCoinUtxoTx>(pBaseTx);
+    return pTx != nullptr;
+}
+
+bool GetUtxoEntryFromChain(const pair<TxID, uint16_t> &utxoIndex, CUtxoEntry &utxoEntry) {
+    std::shared_ptr<CCoinUtxoTx> pUtxoTx;
+    if (!GetUtxoTxFromChain(utxoIndex.first, pUtxoTx))
+        return false;
+
+    if (pUtxoTx->vouts.size() < utxoIndex.second + 1)
+        return false;
+
+    utxoEntry = CUtxoEntry(pUtxoTx->txUid, pUtxoTx->coin_symbol, pUtxoTx->vouts[utxoIndex.second]);
+    return true;
+}
+
+/**
+ * load the unspent prev utxo of the input from the utxo set,
+ * only the legacy entries without vout data need to be loaded from chain
+ */
+static bool GetPrevUtxoEntry(CCacheWrapper &cw, const CUtxoInput &input, CUtxoEntry &utxoEntry) {
+    auto utxoIndex = std::make_pair(input.prev_utxo_txid, input.prev_utxo_out_index);
+    if (!cw.txUtxoCache.GetUtxoTx(utxoIndex, utxoEntry))
+        return false;
+
+    if (utxoEntry.IsLegacy())
+        return GetUtxoEntryFromChain(utxoIndex, utxoEntry);
+
     return true;
 }
 
@@ -211,22 +244,17 @@ bool CCoinUtxoTx::CheckTx(CTxExecuteContext &context) {
     uint64_t totalInAmount = 0;
     uint64_t totalOutAmount = 0;
     for (auto input : vins) {
-        //load prevUtxoTx from blockchain
-        std::shared_ptr<CCoinUtxoTx> pPrevUtxoTx;
-        if (!GetUtxoTxFromChain(input.prev_utxo_txid, pPrevUtxoTx))
-            return state.DoS(100, ERRORMSG("CCoinUtxoTx::CheckTx, failed to load prev utxo from chain!"), REJECT_INVALID, 
+        CUtxoEntry prevUtxo;
+        if (!GetPrevUtxoEntry(cw, input, prevUtxo))
+            return state.DoS(100, ERRORMSG("CCoinUtxoTx::CheckTx, prev utxo not found or already spent!"), REJECT_INVALID, 
                             "failed-to-load-prev-utxo-err");
 
-        if (pPrevUtxoTx->vouts.size() < input.prev_utxo_out_index + 1)
-            return state.DoS(100, ERRORMSG("CCoinUtxoTx::CheckTx, prev utxo index OOR error!"), REJECT_INVALID, 
-                            "prev-utxo-index-OOR-err");
-
         //enumerate the prev tx out conditions to check if current input meets 
         //the output conditions of the previous Tx
-        for (auto cond : pPrevUtxoTx->vouts[input.prev_utxo_out_index].conds)
-            CheckUtxoOutCondition(context, true, pPrevUtxoTx->txUid, txUid, input, cond);
+        for (auto cond : prevUtxo.conds)
+            CheckUtxoOutCondition(context, true, prevUtxo.owner_uid, txUid, input, cond);
     
-        totalInAmount += pPrevUtxoTx->vouts[input.prev_utxo_out_index].coin_amount;
+        totalInAmount += prevUtxo.coin_amount;
     }
 
     for (auto output : vouts) {
@@ -274,17 +302,12 @@ bool CCoinUtxoTx::ExecuteTx(CTxExecuteContext &context) {
     uint64_t totalInAmount = 0;
     uint64_t totalOutAmount = 0;
     for (auto input : vins) {
-        if (!context.pCw->txUtxoCache.GetUtxoTx(std::make_pair(input.prev_utxo_txid, input.prev_utxo_out_index)))
+        CUtxoEntry prevUtxo;
+        if (!GetPrevUtxoEntry(cw, input, prevUtxo))
             return state.DoS(100, ERRORMSG("CCoinUtxoTx::CheckTx, prev utxo already spent error!"), REJECT_INVALID, 
                             "double-spend-prev-utxo-err");
 
-        //load prevUtxoTx from blockchain
-        std::shared_ptr<CCoinUtxoTx> pPrevUtxoTx;
-        if (!GetUtxoTxFromChain(input.prev_utxo_txid, pPrevUtxoTx))
-            return state.DoS(100, ERRORMSG("CCoinUtxoTx::CheckTx, failed to load prev utxo from chain!"), REJECT_INVALID, 
-                            "failed-to-load-prev-utxo-err");
-
-        totalInAmount += pPrevUtxoTx->vouts[input.prev_utxo_out_index].coin_amount;
+        totalInAmount += prevUtxo.coin_amount;
 
         if (!context.pCw->txUtxoCache.DelUtoxTx(std::make_pair(input.prev_utxo_txid, input.prev_utxo_out_index)))
             return state.DoS(100, ERRORMSG("CCoinUtxoTx::CheckTx, del prev utxo error!"), REJECT_INVALID, 
@@ -295,7 +318,7 @@ bool CCoinUtxoTx::ExecuteTx(CTxExecuteContext &context) {
         CUtxoOutput output = vouts[i];
         totalOutAmount += output.coin_amount;
 
-        if (!context.pCw->txUtxoCache.SetUtxoTx(std::make_pair(GetHash(), i)))
+        if (!context.pCw->txUtxoCache.SetUtxoTx(std::make_pair(GetHash(), i), CUtxoEntry(txUid, coin_symbol, output)))
             return state.DoS(100, ERRORMSG("CCoinUtxoTx::CheckTx, set utxo error!"), REJECT_INVALID, 
                             "set-utxo-err");
     }
@@ -70,4 +70,7 @@ public:
 
 };
 
+bool GetUtxoTxFromChain(const TxID &txid, std::shared_ptr<CCoinUtxoTx> &pTx);
+bool GetUtxoEntryFromChain(const pair<TxID, uint16_t> &utxoIndex, CUtxoEntry &utxoEntry);
+
 #endif // TX_COIN_UTXO_H
\ No newline at end of file
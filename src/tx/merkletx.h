@@ -82,7 +82,7 @@ public:
         }
 
         // Is the tx in a block that's in the main chain
-        map<uint256, CBlockIndex *>::iterator mi = mapBlockIndex.find(blockHash);
+        BlockMap::iterator mi = mapBlockIndex.find(blockHash);
         if (mi == mapBlockIndex.end())
             return 0;
         CBlockIndex *pIndex = (*mi).second;
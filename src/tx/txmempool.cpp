@@ -9,6 +9,7 @@
 #include "persistence/txdb.h"
 #include "tx/tx.h"
 #include "miner/miner.h"
+#include "chain/eventpublisher.h"
 
 using namespace std;
 
@@ -18,9 +19,11 @@ CTxMemPoolEntry::CTxMemPoolEntry() {
 
     nTime   = 0;
     height = 0;
+    sequence = 0;
 }
 
-CTxMemPoolEntry::CTxMemPoolEntry(CBaseTx *pBaseTx, int64_t time, uint32_t height) : nTime(time), height(height) {
+CTxMemPoolEntry::CTxMemPoolEntry(CBaseTx *pBaseTx, int64_t time, uint32_t height)
+    : nTime(time), height(height), sequence(0) {
     pTx       = pBaseTx->GetNewInstance();
     nFees     = pTx->GetFees();
     nTxSize   = ::GetSerializeSize(*pTx, SER_NETWORK, PROTOCOL_VERSION);
@@ -33,8 +36,9 @@ CTxMemPoolEntry::CTxMemPoolEntry(const CTxMemPoolEntry &other) {
     this->nTxSize   = other.nTxSize;
     this->dPriority = other.dPriority;
 
-    this->nTime  = other.nTime;
-    this->height = other.height;
+    this->nTime    = other.nTime;
+    this->height   = other.height;
+    this->sequence = other.sequence;
 }
 
 CTxMemPool::CTxMemPool() {
@@ -42,6 +46,7 @@ CTxMemPool::CTxMemPool() {
     // accepting transactions becomes O(N^2) where N is the number
     // of transactions in the pool
     fSanityCheck         = false;
+    nextSequence         = 0;
 }
 
 void CTxMemPool::Remove(CBaseTx *pBaseTx, list<std::shared_ptr<CBaseTx> > &removed, bool fRecursive) {
@@ -50,8 +55,11 @@ void CTxMemPool::Remove(CBaseTx *pBaseTx, list<std::shared_ptr<CBaseTx> > &remov
     uint256 txid = pBaseTx->GetHash();
     if (memPoolTxs.count(txid)) {
         removed.push_front(std::shared_ptr<CBaseTx>(memPoolTxs[txid].GetTransaction()));
+        txidsBySequence.erase(memPoolTxs[txid].GetSequence());
         memPoolTxs.erase(txid);
         EraseTransaction(txid);
+        if (pEventPublisher != nullptr)
+            pEventPublisher->TxRemoved(txid, "removed");
     }
 }
 
@@ -64,11 +72,24 @@ bool CTxMemPool::AddUnchecked(const uint256 &txid, const CTxMemPoolEntry &entry,
         if (!CheckTxInMemPool(txid, entry, state))
             return false;
 
-        memPoolTxs.insert(make_pair(txid, entry));
+        auto ret = memPoolTxs.insert(make_pair(txid, entry));
+        if (ret.second) {
+            ret.first->second.SetSequence(nextSequence);
+            txidsBySequence[nextSequence++] = txid;
+        }
     }
     return true;
 }
 
+void CTxMemPool::Erase(const uint256 &txid) {
+    LOCK(cs);
+    auto it = memPoolTxs.find(txid);
+    if (it != memPoolTxs.end()) {
+        txidsBySequence.erase(it->second.GetSequence());
+        memPoolTxs.erase(it);
+    }
+}
+
 void CTxMemPool::QueryHash(vector<uint256> &txids) {
     LOCK(cs);
 
@@ -124,8 +145,11 @@ void CTxMemPool::ReScanMemPoolTx() {
     for (map<uint256, CTxMemPoolEntry>::iterator iterTx = memPoolTxs.begin(); iterTx != memPoolTxs.end();) {
         if (!CheckTxInMemPool(iterTx->first, iterTx->second, state, true)) {
             uint256 txid = iterTx->first;
+            txidsBySequence.erase(iterTx->second.GetSequence());
             iterTx       = memPoolTxs.erase(iterTx++);
             EraseTransaction(txid);
+            if (pEventPublisher != nullptr)
+                pEventPublisher->TxRemoved(txid, "invalid");
             continue;
         }
         ++iterTx;
@@ -136,6 +160,7 @@ void CTxMemPool::Clear() {
     LOCK(cs);
 
     memPoolTxs.clear();
+    txidsBySequence.clear();
     cw.reset(new CCacheWrapper(pCdMan));
 }
 
@@ -33,6 +33,7 @@ private:
 
     int64_t nTime;     // Local time when entering the mempool
     uint32_t height;  // Chain height when entering the mempool
+    uint64_t sequence; // Order of entering the mempool
 
 public:
     CTxMemPoolEntry(CBaseTx *ptx, int64_t time, uint32_t height);
@@ -47,6 +48,8 @@ public:
 
     inline int64_t GetTime() const { return nTime; }
     inline uint32_t GetHeight() const { return height; }
+    inline uint64_t GetSequence() const { return sequence; }
+    inline void SetSequence(uint64_t sequenceIn) { sequence = sequenceIn; }
 };
 
 /*
@@ -63,6 +66,8 @@ class CTxMemPool {
 public:
     mutable CCriticalSection cs;
     map<uint256, CTxMemPoolEntry > memPoolTxs;
+    map<uint64_t, uint256> txidsBySequence;  // the txids in the order they entered, read from a cursor
+    uint64_t nextSequence;
     std::shared_ptr<CCacheWrapper> cw;
 
 public:
@@ -72,6 +77,8 @@ public:
     void SetSanityCheck(bool fSanityCheckIn) { fSanityCheck = fSanityCheckIn; }
     bool AddUnchecked(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state);
     void Remove(CBaseTx *pBaseTx, list<std::shared_ptr<CBaseTx> > &removed, bool fRecursive = false);
+    // erase the tx packed into the connected block
+    void Erase(const uint256 &txid);
     void QueryHash(vector<uint256> &txids);
     bool CheckTxInMemPool(const uint256 &txid, const CTxMemPoolEntry &entry, CValidationState &state,
                           bool bExecute = true);
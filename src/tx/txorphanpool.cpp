@@ -0,0 +1,284 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "txorphanpool.h"
+
+#include "commons/metrics.h"
+#include "config/errorcode.h"
+#include "config/version.h"
+#include "logging.h"
+#include "persistence/cachewrapper.h"
+#include "tx/cointransfertx.h"
+#include "tx/contracttx.h"
+#include "tx/mulsigtx.h"
+
+COrphanTxPool orphanTxPool;
+
+string COrphanTxDependency::ToString() const {
+    switch (type) {
+        case ORPHAN_DEPEND_ACCOUNT:  return strprintf("account %s", keyid.ToAddress());
+        case ORPHAN_DEPEND_REGID:    return strprintf("regid %s", regid.ToString());
+        case ORPHAN_DEPEND_CONTRACT: return strprintf("contract %s", regid.ToString());
+        default:                     return "unknown";
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// class COrphanTxPool
+
+COrphanTxPool::COrphanTxPool()
+    : totalBytes(0), maxCount(DEFAULT_MAX_ORPHAN_TRANSACTIONS), maxBytes(DEFAULT_MAX_ORPHAN_TX_SIZE * 1000) {}
+
+void COrphanTxPool::SetLimits(uint32_t maxCountIn, uint64_t maxBytesIn) {
+    LOCK(cs_orphans);
+    maxCount = maxCountIn;
+    maxBytes = maxBytesIn;
+    while (mapTxs.size() > maxCount || totalBytes > maxBytes) {
+        EvictTx();
+    }
+}
+
+bool COrphanTxPool::AddTx(const std::shared_ptr<CBaseTx> &pTx, NodeId fromPeer,
+                          const vector<COrphanTxDependency> &dependencies, int64_t nExpireTime) {
+    uint256 txid    = pTx->GetHash();
+    uint32_t txSize = pTx->GetSerializeSize(SER_NETWORK, PROTOCOL_VERSION);
+    uint32_t maxPeerCount = std::max<uint32_t>(maxCount / ORPHAN_TX_PEER_SHARE, 1);
+    uint64_t maxPeerBytes = maxBytes / ORPHAN_TX_PEER_SHARE;
+
+    LOCK(cs_orphans);
+    if (mapTxs.count(txid) || dependencies.empty())
+        return false;
+
+    if (txSize > maxPeerBytes)
+        return ERRORMSG("COrphanTxPool::AddTx, orphan tx %s of %u bytes is too large", txid.ToString(), txSize);
+
+    auto peerIt = mapTxsByPeer.find(fromPeer);
+    if (peerIt != mapTxsByPeer.end() &&
+        (peerIt->second.size() >= maxPeerCount || mapBytesByPeer[fromPeer] + txSize > maxPeerBytes)) {
+        LogPrint(BCLog::NET, "COrphanTxPool::AddTx, peer=%d holds its share of orphan txs, ignore %s\n", fromPeer,
+                 txid.ToString());
+        return false;
+    }
+
+    COrphanTx &orphan  = mapTxs[txid];
+    orphan.pTx         = pTx;
+    orphan.fromPeer    = fromPeer;
+    orphan.nExpireTime = nExpireTime;
+    orphan.nTxSize     = txSize;
+    orphan.dependencies.assign(dependencies.begin(), dependencies.end());
+
+    for (const auto &dependency : orphan.dependencies)
+        mapTxsByDependency.emplace(dependency, txid);
+    setTxsByExpireTime.emplace(nExpireTime, txid);
+    mapTxsByPeer[fromPeer].emplace(nExpireTime, txid);
+    mapBytesByPeer[fromPeer] += txSize;
+    totalBytes += txSize;
+
+    while (mapTxs.size() > maxCount || totalBytes > maxBytes) {
+        EvictTx();
+    }
+
+    return mapTxs.count(txid) > 0;
+}
+
+bool COrphanTxPool::Exists(const uint256 &txid) const {
+    LOCK(cs_orphans);
+    return mapTxs.count(txid) > 0;
+}
+
+void COrphanTxPool::EraseTx(const uint256 &txid) {
+    LOCK(cs_orphans);
+    auto it = mapTxs.find(txid);
+    if (it != mapTxs.end())
+        EraseTx(it);
+}
+
+void COrphanTxPool::EraseTx(OrphanTxIterator it) {
+    const uint256 &txid = it->first;
+    const COrphanTx &orphan = it->second;
+
+    for (const auto &dependency : orphan.dependencies) {
+        auto range = mapTxsByDependency.equal_range(dependency);
+        for (auto depIt = range.first; depIt != range.second; ++depIt) {
+            if (depIt->second == txid) {
+                mapTxsByDependency.erase(depIt);
+                break;
+            }
+        }
+    }
+
+    setTxsByExpireTime.erase(make_pair(orphan.nExpireTime, txid));
+
+    auto peerIt = mapTxsByPeer.find(orphan.fromPeer);
+    peerIt->second.erase(make_pair(orphan.nExpireTime, txid));
+    if (peerIt->second.empty()) {
+        mapTxsByPeer.erase(peerIt);
+        mapBytesByPeer.erase(orphan.fromPeer);
+    } else {
+        mapBytesByPeer[orphan.fromPeer] -= orphan.nTxSize;
+    }
+
+    totalBytes -= orphan.nTxSize;
+    mapTxs.erase(it);
+}
+
+bool COrphanTxPool::EvictTx() {
+    // the oldest orphan of the peer holding the most
+    auto peerIt = mapTxsByPeer.end();
+    for (auto it = mapTxsByPeer.begin(); it != mapTxsByPeer.end(); ++it) {
+        if (peerIt == mapTxsByPeer.end() || it->second.size() > peerIt->second.size())
+            peerIt = it;
+    }
+    if (peerIt == mapTxsByPeer.end())
+        return false;
+
+    uint256 txid = peerIt->second.begin()->second;
+    LogPrint(BCLog::NET, "COrphanTxPool::EvictTx, evict orphan tx %s of peer=%d\n", txid.ToString(), peerIt->first);
+    EraseTx(mapTxs.find(txid));
+    metrics::orphan_txs_evicted.Inc();
+
+    return true;
+}
+
+uint32_t COrphanTxPool::EraseForPeer(NodeId peer) {
+    LOCK(cs_orphans);
+    auto peerIt = mapTxsByPeer.find(peer);
+    if (peerIt == mapTxsByPeer.end())
+        return 0;
+
+    vector<uint256> txids;
+    for (const auto &item : peerIt->second)
+        txids.push_back(item.second);
+
+    for (const auto &txid : txids)
+        EraseTx(mapTxs.find(txid));
+
+    return txids.size();
+}
+
+uint32_t COrphanTxPool::Expire(int64_t nNow) {
+    LOCK(cs_orphans);
+    uint32_t count = 0;
+    while (!setTxsByExpireTime.empty() && setTxsByExpireTime.begin()->first <= nNow) {
+        EraseTx(mapTxs.find(setTxsByExpireTime.begin()->second));
+        count++;
+    }
+
+    if (count > 0)
+        LogPrint(BCLog::NET, "COrphanTxPool::Expire, %u orphan txs expired\n", count);
+
+    return count;
+}
+
+void COrphanTxPool::TakeResolved(const function<bool(const COrphanTxDependency &)> &isMet,
+                                 vector<COrphanTx> &resolved) {
+    LOCK(cs_orphans);
+
+    // each pending dependency is checked once, however many orphans wait for it
+    set<uint256> candidates;
+    set<COrphanTxDependency> unmetDependencies;
+    for (auto it = mapTxsByDependency.begin(); it != mapTxsByDependency.end();) {
+        const COrphanTxDependency &dependency = it->first;
+        auto end = mapTxsByDependency.upper_bound(dependency);
+        if (isMet(dependency)) {
+            for (; it != end; ++it)
+                candidates.insert(it->second);
+        } else {
+            unmetDependencies.insert(dependency);
+        }
+        it = end;
+    }
+
+    for (const auto &txid : candidates) {
+        auto it = mapTxs.find(txid);
+        bool fResolved = true;
+        for (const auto &dependency : it->second.dependencies) {
+            if (unmetDependencies.count(dependency)) {
+                fResolved = false;
+                break;
+            }
+        }
+
+        if (fResolved) {
+            resolved.push_back(it->second);
+            EraseTx(it);
+        }
+    }
+}
+
+size_t COrphanTxPool::Size() const {
+    LOCK(cs_orphans);
+    return mapTxs.size();
+}
+
+uint64_t COrphanTxPool::GetTotalBytes() const {
+    LOCK(cs_orphans);
+    return totalBytes;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// dependencies of the txs
+
+static void AddMissingRegId(const CUserID &uid, CCacheWrapper &cw, vector<COrphanTxDependency> &dependencies) {
+    CKeyID keyId;
+    if (uid.is<CRegID>() && !cw.accountCache.GetKeyId(uid, keyId))
+        dependencies.emplace_back(ORPHAN_DEPEND_REGID, uid.get<CRegID>());
+}
+
+void GetMissingDependencies(CBaseTx &tx, CCacheWrapper &cw, vector<COrphanTxDependency> &dependencies) {
+    if (tx.txUid.is<CRegID>()) {
+        AddMissingRegId(tx.txUid, cw, dependencies);
+    } else if (tx.txUid.is<CPubKey>() || tx.txUid.is<CKeyID>()) {
+        // the sender to be funded before it pays the fees
+        CKeyID keyId = tx.txUid.is<CPubKey>() ? tx.txUid.get<CPubKey>().GetKeyId() : tx.txUid.get<CKeyID>();
+        if (!cw.accountCache.HaveAccount(keyId))
+            dependencies.emplace_back(keyId);
+    }
+
+    switch (tx.nTxType) {
+        case BCOIN_TRANSFER_TX:
+            AddMissingRegId(((CBaseCoinTransferTx &)tx).toUid, cw, dependencies);
+            break;
+        case UCOIN_TRANSFER_TX:
+            for (const auto &transfer : ((CCoinTransferTx &)tx).transfers)
+                AddMissingRegId(transfer.to_uid, cw, dependencies);
+            break;
+        case UCOIN_TRANSFER_MTX:
+            for (const auto &signaturePair : ((CMulsigTx &)tx).signaturePairs)
+                AddMissingRegId(CUserID(signaturePair.regid), cw, dependencies);
+            break;
+        case LCONTRACT_INVOKE_TX: {
+            const CUserID &appUid = ((CLuaContractInvokeTx &)tx).app_uid;
+            if (appUid.is<CRegID>() && !cw.contractCache.HaveContract(appUid.get<CRegID>()))
+                dependencies.emplace_back(ORPHAN_DEPEND_CONTRACT, appUid.get<CRegID>());
+            break;
+        }
+        case UCONTRACT_INVOKE_TX: {
+            const CUserID &appUid = ((CUniversalContractInvokeTx &)tx).app_uid;
+            if (appUid.is<CRegID>() && !cw.contractCache.HaveContract(appUid.get<CRegID>()))
+                dependencies.emplace_back(ORPHAN_DEPEND_CONTRACT, appUid.get<CRegID>());
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+bool IsDependencyMet(const COrphanTxDependency &dependency, CCacheWrapper &cw) {
+    CKeyID keyId;
+    switch (dependency.type) {
+        case ORPHAN_DEPEND_ACCOUNT:  return cw.accountCache.HaveAccount(dependency.keyid);
+        case ORPHAN_DEPEND_REGID:    return cw.accountCache.GetKeyId(dependency.regid, keyId);
+        case ORPHAN_DEPEND_CONTRACT: return cw.contractCache.HaveContract(dependency.regid);
+        default:                     return false;
+    }
+}
+
+bool IsMissingDependencyReject(uint8_t rejectCode, const string &rejectReason) {
+    static const set<string> kMissingDependencyReasons = {"bad-getaccount", "bad-account-unregistered",
+                                                          "account-unregistered-or-immature", "account-not-registered",
+                                                          "bad-read-script"};
+    return rejectCode == READ_ACCOUNT_FAIL || rejectCode == READ_SCRIPT_FAIL ||
+           kMissingDependencyReasons.count(rejectReason) > 0;
+}
@@ -0,0 +1,123 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef TX_TXORPHANPOOL_H
+#define TX_TXORPHANPOOL_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <vector>
+
+#include "commons/uint256.h"
+#include "entities/id.h"
+#include "entities/key.h"
+#include "sync.h"
+
+using namespace std;
+
+class CBaseTx;
+class CCacheWrapper;
+
+typedef int32_t NodeId;
+
+/** Default for -maxorphantx, the max number of orphan txs kept in memory */
+static const uint32_t DEFAULT_MAX_ORPHAN_TRANSACTIONS = 100;
+/** Default for -maxorphantxsize, the max KB of orphan txs kept in memory */
+static const uint32_t DEFAULT_MAX_ORPHAN_TX_SIZE = 5000;
+/** A peer holds at most 1/ORPHAN_TX_PEER_SHARE of the orphan txs, by count and by size */
+static const uint32_t ORPHAN_TX_PEER_SHARE = 4;
+/** Seconds an orphan tx waits for its dependencies before it is dropped */
+static const int64_t ORPHAN_TX_EXPIRE_TIME = 20 * 60;
+
+enum OrphanTxDependType : uint8_t {
+    ORPHAN_DEPEND_ACCOUNT  = 1,  // the account of a keyid, made by a tx of the mempool or a block
+    ORPHAN_DEPEND_REGID    = 2,  // the account of a regid, registered by a tx of a block
+    ORPHAN_DEPEND_CONTRACT = 3,  // the contract of a regid, deployed by a tx of a block
+};
+
+struct COrphanTxDependency {
+    OrphanTxDependType type;
+    CRegID regid;  // of ORPHAN_DEPEND_REGID and ORPHAN_DEPEND_CONTRACT
+    CKeyID keyid;  // of ORPHAN_DEPEND_ACCOUNT
+
+    COrphanTxDependency(OrphanTxDependType typeIn, const CRegID &regidIn) : type(typeIn), regid(regidIn) {}
+    explicit COrphanTxDependency(const CKeyID &keyidIn) : type(ORPHAN_DEPEND_ACCOUNT), keyid(keyidIn) {}
+
+    bool operator<(const COrphanTxDependency &other) const {
+        if (type != other.type)
+            return type < other.type;
+        if (!(regid == other.regid))
+            return regid < other.regid;
+        return keyid < other.keyid;
+    }
+
+    string ToString() const;
+};
+
+struct COrphanTx {
+    std::shared_ptr<CBaseTx> pTx;
+    NodeId fromPeer;
+    int64_t nExpireTime;
+    uint32_t nTxSize;
+    vector<COrphanTxDependency> dependencies;
+};
+
+/**
+ * Pool of the txs received before the accounts, regids or contracts they depend on.
+ *
+ * The orphans are indexed by their missing dependencies, so a new tx of the mempool or a new
+ * block checks each pending dependency once instead of executing the orphans again, and only
+ * the orphans of which all the dependencies are met are taken out to be resubmitted. The pool
+ * is bounded by count and by size, a peer holds at most a share of it, and the orphans expire
+ * after ORPHAN_TX_EXPIRE_TIME. When full, the oldest orphan of the peer holding the most is
+ * evicted, so a flooding peer pushes out its own orphans first.
+ */
+class COrphanTxPool {
+public:
+    COrphanTxPool();
+
+    void SetLimits(uint32_t maxCountIn, uint64_t maxBytesIn);
+
+    // false if the tx is known already, larger than a peer's share, or the peer holds its share
+    bool AddTx(const std::shared_ptr<CBaseTx> &pTx, NodeId fromPeer, const vector<COrphanTxDependency> &dependencies,
+               int64_t nExpireTime);
+    bool Exists(const uint256 &txid) const;
+    void EraseTx(const uint256 &txid);
+    uint32_t EraseForPeer(NodeId peer);
+    uint32_t Expire(int64_t nNow);
+
+    // take out the orphans of which all the dependencies are met now
+    void TakeResolved(const function<bool(const COrphanTxDependency &)> &isMet, vector<COrphanTx> &resolved);
+
+    size_t Size() const;
+    uint64_t GetTotalBytes() const;
+
+private:
+    typedef map<uint256, COrphanTx>::iterator OrphanTxIterator;
+
+    void EraseTx(OrphanTxIterator it);
+    bool EvictTx();
+
+    mutable CCriticalSection cs_orphans;
+    map<uint256, COrphanTx> mapTxs;
+    multimap<COrphanTxDependency, uint256> mapTxsByDependency;
+    set<pair<int64_t, uint256>> setTxsByExpireTime;
+    map<NodeId, set<pair<int64_t, uint256>>> mapTxsByPeer;
+    map<NodeId, uint64_t> mapBytesByPeer;
+    uint64_t totalBytes;
+    uint32_t maxCount;
+    uint64_t maxBytes;
+};
+
+// the dependencies of the tx missing from the view, none if the tx is no orphan
+void GetMissingDependencies(CBaseTx &tx, CCacheWrapper &cw, vector<COrphanTxDependency> &dependencies);
+bool IsDependencyMet(const COrphanTxDependency &dependency, CCacheWrapper &cw);
+// whether the tx was rejected for an account, a regid or a contract it reads, the only rejects an orphan waits out
+bool IsMissingDependencyReject(uint8_t rejectCode, const string &rejectReason);
+
+extern COrphanTxPool orphanTxPool;
+
+#endif  // TX_TXORPHANPOOL_H
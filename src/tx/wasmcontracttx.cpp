@@ -355,15 +355,9 @@ bool CWasmContractTx::ExecuteTx(CTxExecuteContext &context) {
         //set runstep for block fuel sum
         nRunStep = run_cost;
 
-        auto database = std::make_shared<CCacheWrapper>(context.pCw);
-        auto resolver = make_resolver(database);
-
-        json_spirit::Value value_json;
-        to_variant(trx_trace, value_json, resolver);
-        string string_return = json_spirit::write(value_json);
-
-        //execute_tx_to_return.SetReturn(GetHash().ToString());
-        execute_tx_to_return.SetReturn(string_return);
+        // the trace is rendered to json on demand by the rpcs from the packed one saved above,
+        // so that no validating node pays for the abi lookups and the json of every action
+        execute_tx_to_return.SetReturn(GetHash().ToString());
     } catch (wasm_chain::exception &e) { 
 
         string trx_current_str("inline_tx:");
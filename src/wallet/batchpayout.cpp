@@ -0,0 +1,52 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "batchpayout.h"
+
+#include <atomic>
+#include <boost/thread.hpp>
+
+vector<std::shared_ptr<CCoinTransferTx>> BuildPayoutTxs(const CUserID &senderUid, int32_t validHeight,
+                                                        const vector<SingleTransfer> &payouts,
+                                                        const TokenSymbol &feeSymbol, uint64_t feePerTransfer,
+                                                        const string &memo, uint32_t maxTransfers) {
+    assert(maxTransfers > 0);
+
+    vector<std::shared_ptr<CCoinTransferTx>> txs;
+    txs.reserve((payouts.size() + maxTransfers - 1) / maxTransfers);
+    for (size_t begin = 0; begin < payouts.size(); begin += maxTransfers) {
+        size_t end = std::min(payouts.size(), begin + maxTransfers);
+
+        auto pTx          = std::make_shared<CCoinTransferTx>();
+        pTx->txUid        = senderUid;
+        pTx->valid_height = validHeight;
+        pTx->fee_symbol   = feeSymbol;
+        pTx->llFees       = feePerTransfer * (end - begin);
+        pTx->memo         = memo;
+        pTx->transfers.assign(payouts.begin() + begin, payouts.begin() + end);
+        txs.push_back(pTx);
+    }
+    return txs;
+}
+
+bool SignTxsParallel(const CKey &key, const vector<CBaseTx *> &txs, uint32_t threadCount) {
+    threadCount = std::max<uint32_t>(1, std::min<uint32_t>(threadCount, txs.size()));
+
+    std::atomic<bool> fSigned(true);
+    // the worker i signs the txs i, i + threadCount, ...
+    auto signTxs = [&](uint32_t worker) {
+        for (size_t i = worker; i < txs.size() && fSigned; i += threadCount) {
+            if (!key.Sign(txs[i]->GetHash(), txs[i]->signature))
+                fSigned = false;
+        }
+    };
+
+    boost::thread_group workers;
+    for (uint32_t worker = 1; worker < threadCount; worker++)
+        workers.create_thread(boost::bind<void>(signTxs, worker));
+    signTxs(0);
+    workers.join_all();
+
+    return fSigned;
+}
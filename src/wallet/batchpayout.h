@@ -0,0 +1,40 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef COIN_BATCHPAYOUT_H
+#define COIN_BATCHPAYOUT_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "config/const.h"
+#include "entities/key.h"
+#include "tx/cointransfertx.h"
+
+using namespace std;
+
+/** The max payouts of a bulk payout */
+static const uint32_t MAX_BATCH_PAYOUT_SIZE  = 10000;
+/** The max threads to sign the txs of a bulk payout */
+static const uint32_t MAX_BATCH_SIGN_THREADS = 8;
+
+/**
+ * Groups the payouts of a sender into the minimum number of UCOIN_TRANSFER_TXs. The payouts are
+ * packed in order, maxTransfers per tx, so the payout i is in the tx i / maxTransfers.
+ * Every tx pays feePerTransfer for each of its transfers, the min fee of the transfer txs.
+ */
+vector<std::shared_ptr<CCoinTransferTx>> BuildPayoutTxs(const CUserID &senderUid, int32_t validHeight,
+                                                        const vector<SingleTransfer> &payouts,
+                                                        const TokenSymbol &feeSymbol, uint64_t feePerTransfer,
+                                                        const string &memo,
+                                                        uint32_t maxTransfers = MAX_TRANSFER_SIZE);
+
+/**
+ * Signs the txs with the key on up to threadCount threads. The key is read-only and the
+ * signing context of secp256k1 is shared safely between the threads.
+ */
+bool SignTxsParallel(const CKey &key, const vector<CBaseTx *> &txs, uint32_t threadCount);
+
+#endif  // COIN_BATCHPAYOUT_H
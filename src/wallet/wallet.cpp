@@ -105,6 +105,26 @@ bool CWallet::ChangeWalletPassphrase(const SecureString &strOldWalletPassphrase,
     return false;
 }
 
+static CWalletTxEntry GetWalletTxEntry(const CWallet &wallet, CCacheWrapper &cw, int32_t height,
+                                       const uint256 &blockHash, const uint256 &txid, CBaseTx *pTx) {
+    CWalletTxEntry entry;
+    entry.pos        = CWalletTxPos(height, txid);
+    entry.block_hash = blockHash;
+    entry.tx_type    = pTx->nTxType;
+    wallet.GetMyKeyIds(pTx, cw, entry.key_ids);
+
+    if (!pTx->IsBlockRewardTx())
+        entry.symbols.insert(std::get<0>(pTx->GetFees()));
+    if (pTx->nTxType == UCOIN_TRANSFER_TX) {
+        for (const auto &transfer : ((CCoinTransferTx *)pTx)->transfers)
+            entry.symbols.insert(transfer.coin_symbol);
+    } else if (pTx->nTxType == BCOIN_TRANSFER_TX) {
+        entry.symbols.insert(SYMB::WICC);
+    }
+
+    return entry;
+}
+
 void CWallet::SetBestChain(const CBlockLocator &loc) {
     AssertLockHeld(cs_wallet);
     bestBlock = loc;
@@ -133,6 +153,11 @@ void CWallet::SyncTransaction(const uint256 &hash, CBaseTx *pTx, const CBlock *p
             if (netTx.GetTxSize() > 0) {          // write to disk
                 mapInBlockTx[blockhash] = netTx;  // add to map
                 netTx.WriteToDisk();
+
+                CCacheWrapper cw(pCdMan);
+                for (const auto &item : netTx.mapAccountTx)
+                    txIndex.Add(GetWalletTxEntry(*this, cw, netTx.blockHeight, blockhash, item.first,
+                                                 item.second.get()));
             }
         };
 
@@ -146,9 +171,13 @@ void CWallet::SyncTransaction(const uint256 &hash, CBaseTx *pTx, const CBlock *p
                     CWalletDB(strWalletFile).WriteUnconfirmedTx(sptx.get()->GetHash(), unconfirmedTx[sptx.get()->GetHash()]);
                 }
             }
-            if (mapInBlockTx.count(blockhash)) {
+            auto it = mapInBlockTx.find(blockhash);
+            if (it != mapInBlockTx.end()) {
+                for (const auto &item : it->second.mapAccountTx)
+                    txIndex.Remove(CWalletTxPos(it->second.blockHeight, item.first));
+
                 CWalletDB(strWalletFile).EraseBlockTx(blockhash);
-                mapInBlockTx.erase(blockhash);
+                mapInBlockTx.erase(it);
             }
         };
 
@@ -212,8 +241,6 @@ std::tuple<bool, string> CWallet::CommitTx(CBaseTx *pTx) {
     LOCK2(cs_main, cs_wallet);
     LogPrint(BCLog::INFO, "CommitTx() : %s\n", pTx->ToString(*pCdMan->pAccountCache));
 
-    string ret;
-
     {
         CValidationState state;
         if (!::AcceptToMemoryPool(mempool, state, pTx, true)) {
@@ -221,9 +248,6 @@ std::tuple<bool, string> CWallet::CommitTx(CBaseTx *pTx) {
             LogPrint(BCLog::INFO, "CommitTx() : invalid transaction %s\n", state.GetRejectReason());
             return std::make_tuple(false, state.GetRejectReason());
         }
-
-        ret =  state.GetReturn();
-
     }
 
     uint256 txid        = pTx->GetHash();
@@ -237,14 +261,43 @@ std::tuple<bool, string> CWallet::CommitTx(CBaseTx *pTx) {
 
     ::RelayTransaction(pTx, txid);
 
-    //xiaoyu 20191106
-    if(pTx->nTxType == WASM_CONTRACT_TX){
-        message = ret;
-    }
     return std::make_tuple(flag, message);
 
 }
 
+vector<std::tuple<bool, string>> CWallet::CommitTxs(const vector<CBaseTx *> &txs) {
+    vector<std::tuple<bool, string>> results;
+    results.reserve(txs.size());
+
+    LOCK2(cs_main, cs_wallet);
+    CWalletDB walletdb(strWalletFile);
+    bool fTxn = walletdb.TxnBegin();
+    for (auto pTx : txs) {
+        CValidationState state;
+        if (!::AcceptToMemoryPool(mempool, state, pTx, true)) {
+            LogPrint(BCLog::INFO, "CommitTxs() : invalid transaction %s, %s\n", pTx->GetHash().GetHex(),
+                     state.GetRejectReason());
+            results.push_back(std::make_tuple(false, state.GetRejectReason()));
+            continue;
+        }
+
+        uint256 txid        = pTx->GetHash();
+        unconfirmedTx[txid] = pTx->GetNewInstance();
+        if (!walletdb.WriteUnconfirmedTx(txid, unconfirmedTx[txid])) {
+            results.push_back(std::make_tuple(false, strprintf("write unconfirmed tx failed: %s, corrupted wallet?",
+                                                               txid.GetHex())));
+        } else {
+            results.push_back(std::make_tuple(true, txid.ToString()));
+        }
+
+        ::RelayTransaction(pTx, txid);
+    }
+    if (fTxn && !walletdb.TxnCommit())
+        LogPrint(BCLog::ERROR, "CommitTxs() : commit the unconfirmed txs to the wallet db failed\n");
+
+    return results;
+}
+
 DBErrors CWallet::LoadWallet(bool fFirstRunRet) {
     // fFirstRunRet = false;
     return CWalletDB(strWalletFile, "cr+").LoadWallet(this);
@@ -465,20 +518,45 @@ uint256 CWallet::GetCheckSum() const {
 }
 
 bool CWallet::IsMine(CBaseTx *pTx) const {
+    set<CKeyID> keyIds;
+    return GetMyKeyIds(pTx, keyIds) && !keyIds.empty();
+}
+
+bool CWallet::GetMyKeyIds(CBaseTx *pTx, set<CKeyID> &keyIds) const {
     auto spCW = std::make_shared<CCacheWrapper>(pCdMan);
+    return GetMyKeyIds(pTx, *spCW, keyIds);
+}
 
-    set<CKeyID> keyIds;
-    if (!pTx->GetInvolvedKeyIds(*spCW, keyIds)) {
+bool CWallet::GetMyKeyIds(CBaseTx *pTx, CCacheWrapper &cw, set<CKeyID> &keyIds) const {
+    set<CKeyID> involvedKeyIds;
+    if (!pTx->GetInvolvedKeyIds(cw, involvedKeyIds)) {
         return false;
     }
 
-    for (auto &keyid : keyIds) {
+    for (auto &keyid : involvedKeyIds) {
         if (HaveKey(keyid) > 0) {
-            return true;
+            keyIds.insert(keyid);
         }
     }
 
-    return false;
+    return true;
+}
+
+void CWallet::BuildTxIndex() {
+    LOCK2(cs_main, cs_wallet);
+    int64_t nStart = GetTimeMillis();
+
+    // one view over the state for all the txs, they only read it
+    CCacheWrapper cw(pCdMan);
+    txIndex.Clear();
+    for (const auto &blockTx : mapInBlockTx) {
+        for (const auto &item : blockTx.second.mapAccountTx)
+            txIndex.Add(GetWalletTxEntry(*this, cw, blockTx.second.blockHeight, blockTx.first, item.first,
+                                         item.second.get()));
+    }
+
+    LogPrint(BCLog::INFO, "CWallet::BuildTxIndex, %u txs of %u blocks indexed (%dms)\n", txIndex.Size(),
+             mapInBlockTx.size(), GetTimeMillis() - nStart);
 }
 
 bool CWallet::CleanAll() {
@@ -491,6 +569,7 @@ bool CWallet::CleanAll() {
     for_each(mapInBlockTx.begin(), mapInBlockTx.end(),
              [&](std::map<uint256, CAccountTx>::reference a) { CWalletDB(strWalletFile).EraseUnconfirmedTx(a.first); });
     mapInBlockTx.clear();
+    txIndex.Clear();
 
     bestBlock.SetNull();
 
@@ -21,6 +21,7 @@
 #include "entities/keystore.h"
 #include "commons/util/util.h"
 #include "walletdb.h"
+#include "wallettxindex.h"
 #include "main.h"
 #include "commons/serialize.h"
 #include "tx/cointransfertx.h"
@@ -57,6 +58,7 @@ public:
 
     map<uint256, CAccountTx> mapInBlockTx;
     map<uint256, std::shared_ptr<CBaseTx> > unconfirmedTx;
+    CWalletTxIndex txIndex;  // (memory only) of mapInBlockTx, built by BuildTxIndex
     mutable CCriticalSection cs_wallet;
 
     typedef std::map<uint32_t, CMasterKey> MasterKeyMap;
@@ -118,6 +120,13 @@ public:
     void ResendWalletTransactions();
 
     bool IsMine(CBaseTx*pTx)const;
+    // the wallet keys involved in the tx
+    bool GetMyKeyIds(CBaseTx *pTx, set<CKeyID> &keyIds) const;
+    // the same, read from cw, which the callers of many txs share
+    bool GetMyKeyIds(CBaseTx *pTx, CCacheWrapper &cw, set<CKeyID> &keyIds) const;
+
+    // rebuilds the tx index from mapInBlockTx, must be called after the chain state is loaded
+    void BuildTxIndex();
 
     void SetBestChain(const CBlockLocator& loc);
 
@@ -137,6 +146,8 @@ public:
     static CWallet* GetInstance();
 
     std::tuple<bool,string>  CommitTx(CBaseTx *pTx);
+    // commits the signed txs under one lock and one wallet db txn, the results are in the order of the txs
+    vector<std::tuple<bool, string>> CommitTxs(const vector<CBaseTx *> &txs);
 };
 
 /** Private key that includes an expiration date in case it never gets used. */
@@ -0,0 +1,136 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "wallettxindex.h"
+
+#include "commons/tinyformat.h"
+#include "commons/util/util.h"
+
+string CWalletTxPos::ToString() const {
+    return strprintf("%d:%s", height, txid.GetHex());
+}
+
+bool CWalletTxPos::Parse(const string &str, CWalletTxPos &pos) {
+    size_t sep = str.find(':');
+    if (sep == string::npos || sep == 0 || str.size() - sep - 1 != 64)
+        return false;
+
+    string hexTxid = str.substr(sep + 1);
+    if (!IsHex(hexTxid))
+        return false;
+
+    int32_t height;
+    if (!ParseInt32(str.substr(0, sep), &height) || height < 0)
+        return false;
+
+    pos = CWalletTxPos(height, uint256S(hexTxid));
+    return true;
+}
+
+bool CWalletTxFilter::Match(const CWalletTxEntry &entry) const {
+    return (key_id.IsNull() || entry.key_ids.count(key_id)) &&
+           (tx_type == NULL_TX || entry.tx_type == tx_type) &&
+           (symbol.empty() || entry.symbols.count(symbol));
+}
+
+void CWalletTxIndex::Add(const CWalletTxEntry &entry) {
+    if (entries.count(entry.pos))
+        Remove(entry.pos);
+
+    entries[entry.pos] = entry;
+    for (const auto &keyId : entry.key_ids)
+        keyIdIndex[keyId].insert(entry.pos);
+    for (const auto &symbol : entry.symbols)
+        symbolIndex[symbol].insert(entry.pos);
+    txTypeIndex[entry.tx_type].insert(entry.pos);
+}
+
+template <typename Container>
+void CWalletTxIndex::Erase(Container &index, const typename Container::key_type &key, const CWalletTxPos &pos) {
+    auto it = index.find(key);
+    if (it == index.end())
+        return;
+
+    it->second.erase(pos);
+    if (it->second.empty())
+        index.erase(it);
+}
+
+void CWalletTxIndex::Remove(const CWalletTxPos &pos) {
+    auto it = entries.find(pos);
+    if (it == entries.end())
+        return;
+
+    const CWalletTxEntry &entry = it->second;
+    for (const auto &keyId : entry.key_ids)
+        Erase(keyIdIndex, keyId, pos);
+    for (const auto &symbol : entry.symbols)
+        Erase(symbolIndex, symbol, pos);
+    Erase(txTypeIndex, entry.tx_type, pos);
+    entries.erase(it);
+}
+
+void CWalletTxIndex::Clear() {
+    entries.clear();
+    keyIdIndex.clear();
+    symbolIndex.clear();
+    txTypeIndex.clear();
+}
+
+bool CWalletTxIndex::List(const CWalletTxPos *pCursor, const CWalletTxFilter &filter, uint32_t skip,
+                          uint32_t count, vector<const CWalletTxEntry *> &page, uint32_t *pVisited) const {
+    // walks the positions of the most selective filter, the other filters are checked per entry
+    static const set<CWalletTxPos> kEmptyPositions;
+    const set<CWalletTxPos> *pPositions = nullptr;
+    auto narrow = [&](const set<CWalletTxPos> *pCandidate) {
+        if (pPositions == nullptr || pCandidate->size() < pPositions->size())
+            pPositions = pCandidate;
+    };
+    if (!filter.key_id.IsNull()) {
+        auto it = keyIdIndex.find(filter.key_id);
+        narrow(it != keyIdIndex.end() ? &it->second : &kEmptyPositions);
+    }
+    if (!filter.symbol.empty()) {
+        auto it = symbolIndex.find(filter.symbol);
+        narrow(it != symbolIndex.end() ? &it->second : &kEmptyPositions);
+    }
+    if (filter.tx_type != NULL_TX) {
+        auto it = txTypeIndex.find(filter.tx_type);
+        narrow(it != txTypeIndex.end() ? &it->second : &kEmptyPositions);
+    }
+
+    // returns false when the page is full
+    if (pVisited != nullptr)
+        *pVisited = 0;
+    auto addEntry = [&](const CWalletTxEntry &entry) {
+        if (pVisited != nullptr)
+            (*pVisited)++;
+        if (!filter.Match(entry))
+            return true;
+        if (skip > 0) {
+            skip--;
+            return true;
+        }
+        if (page.size() >= count)
+            return false;
+
+        page.push_back(&entry);
+        return true;
+    };
+
+    if (pPositions == nullptr) {
+        auto it = pCursor ? entries.upper_bound(*pCursor) : entries.begin();
+        for (; it != entries.end(); ++it) {
+            if (!addEntry(it->second))
+                return true;
+        }
+    } else {
+        auto it = pCursor ? pPositions->upper_bound(*pCursor) : pPositions->begin();
+        for (; it != pPositions->end(); ++it) {
+            if (!addEntry(entries.at(*it)))
+                return true;
+        }
+    }
+    return false;
+}
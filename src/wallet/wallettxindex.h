@@ -0,0 +1,89 @@
+// Copyright (c) 2017-2019 The WaykiChain Developers
+// Distributed under the MIT/X11 software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef COIN_WALLETTXINDEX_H
+#define COIN_WALLETTXINDEX_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "commons/types.h"
+#include "commons/uint256.h"
+#include "config/txbase.h"
+#include "entities/key.h"
+
+using namespace std;
+
+/** Position of a confirmed wallet tx. Ordered from the newest block, by txid within a block */
+struct CWalletTxPos {
+    int32_t height;
+    uint256 txid;
+
+    CWalletTxPos() : height(0) {}
+    CWalletTxPos(int32_t heightIn, const uint256 &txidIn) : height(heightIn), txid(txidIn) {}
+
+    bool operator<(const CWalletTxPos &other) const {
+        if (height != other.height)
+            return height > other.height;
+        return txid < other.txid;
+    }
+    bool operator==(const CWalletTxPos &other) const { return height == other.height && txid == other.txid; }
+
+    // the cursor of the pagination, "height:txid"
+    string ToString() const;
+    static bool Parse(const string &str, CWalletTxPos &pos);
+};
+
+struct CWalletTxEntry {
+    CWalletTxPos pos;
+    uint256 block_hash;
+    TxType tx_type;
+    set<CKeyID> key_ids;        // the wallet keys involved in the tx
+    set<TokenSymbol> symbols;   // the fee symbol and the transferred symbols
+
+    CWalletTxEntry() : tx_type(NULL_TX) {}
+};
+
+/** The empty fields match any tx */
+struct CWalletTxFilter {
+    CKeyID key_id;
+    TxType tx_type = NULL_TX;
+    TokenSymbol symbol;
+
+    bool Match(const CWalletTxEntry &entry) const;
+};
+
+/**
+ * (memory only) Index of the confirmed wallet txs, in the order of CWalletTxPos.
+ * A page is listed from a cursor in O(log(n) + page size). The filtered pages walk
+ * the secondary index of the address, the symbol or the tx type.
+ */
+class CWalletTxIndex {
+public:
+    void Add(const CWalletTxEntry &entry);
+    void Remove(const CWalletTxPos &pos);
+    void Clear();
+    size_t Size() const { return entries.size(); }
+
+    /**
+     * Lists up to count entries after the cursor (from the newest one if null), skipping
+     * the first skip matched ones. Returns whether there are more entries after the page.
+     * pVisited gets the count of the index entries walked for the page.
+     */
+    bool List(const CWalletTxPos *pCursor, const CWalletTxFilter &filter, uint32_t skip, uint32_t count,
+              vector<const CWalletTxEntry *> &page, uint32_t *pVisited = nullptr) const;
+
+private:
+    map<CWalletTxPos, CWalletTxEntry> entries;
+    map<CKeyID, set<CWalletTxPos>> keyIdIndex;
+    map<TokenSymbol, set<CWalletTxPos>> symbolIndex;
+    map<uint8_t, set<CWalletTxPos>> txTypeIndex;
+
+    template <typename Container>
+    void Erase(Container &index, const typename Container::key_type &key, const CWalletTxPos &pos);
+};
+
+#endif  // COIN_WALLETTXINDEX_H